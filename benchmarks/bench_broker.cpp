@@ -0,0 +1,244 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include <QTest>
+#include <QSemaphore>
+#include <QTemporaryDir>
+#include <QThread>
+
+#include <qudev.h>
+#include <qudev_broker.h>
+#include <qudev_broker_backend.h>
+#include <qudev_device.h>
+#include <qudev_memory_backend.h>
+
+#include "qudev_benchmark.h"
+
+#include <functional>
+
+
+namespace {
+
+/// Broker with its own event loop, standing in for qudevd.
+class BrokerThread : public QThread
+{
+public:
+    using BackendFactory = std::function<std::unique_ptr<QudevBackend>()>;
+
+    BrokerThread(const QString& path, BackendFactory factory)
+        : path_(path), factory_(std::move(factory))
+    {}
+
+    ~BrokerThread() override
+    {
+        quit();
+        wait();
+    }
+
+    bool startAndWait()
+    {
+        start();
+        ready_.acquire();
+        return listening_;
+    }
+
+    QudevBackend* backend() const { return backend_; }
+
+protected:
+    void run() override
+    {
+        std::unique_ptr<QudevBackend> owned = factory_ ? factory_() : nullptr;
+        backend_ = owned.get();
+
+        auto broker = owned ? std::make_unique<QudevBroker>(std::move(owned)) : std::make_unique<QudevBroker>();
+        listening_ = broker->listen(path_);
+        ready_.release();
+        if (listening_) {
+            exec();
+        }
+    }
+
+private:
+    QString path_;
+    BackendFactory factory_;
+    QudevBackend* backend_ = nullptr;
+    bool listening_ = false;
+    QSemaphore ready_;
+};
+
+/// Lets several standalone agents monitor one memory backend, as several
+/// processes share the kernel's netlink multicast.
+class SharedBackend final : public QudevBackend
+{
+public:
+    explicit SharedBackend(QudevBackend& target) : target_(target) {}
+
+    bool enumerate(const QudevFilters& filters, const Visitor& visit) noexcept override
+    {
+        return target_.enumerate(filters, visit);
+    }
+
+    std::unique_ptr<MonitorSource> createMonitor(MonitorChannel channel,
+                                                 const QudevFilters& filters) noexcept override
+    {
+        return target_.createMonitor(channel, filters);
+    }
+
+private:
+    QudevBackend& target_;
+};
+
+} // namespace
+
+// N agents each enumerating and monitoring on their own ("standalone")
+// versus the same agents served by one broker ("brokered"). Enumeration
+// runs against the host through libudev; events come from a memory
+// backend so every agent sees the same stream.
+class BenchBroker : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void enumerate_data();
+    void enumerate();
+
+    void events_data();
+    void events();
+
+private:
+    static void addRows();
+
+    QTemporaryDir dir_;
+};
+
+void BenchBroker::initTestCase()
+{
+    QVERIFY(dir_.isValid());
+}
+
+void BenchBroker::addRows()
+{
+    QTest::addColumn<bool>("brokered");
+    QTest::addColumn<int>("agents");
+
+    for (int agents : { 1, 4, 12 }) {
+        const QByteArray suffix = '/' + QByteArray::number(agents);
+        QTest::newRow("standalone" + suffix) << false << agents;
+        QTest::newRow("brokered" + suffix)   << true << agents;
+    }
+}
+
+void BenchBroker::enumerate_data()
+{
+    addRows();
+}
+
+void BenchBroker::enumerate()
+{
+    QFETCH(bool, brokered);
+    QFETCH(int, agents);
+
+    if (!QudevBackend::createLibudev()) {
+        QSKIP("libudev context unavailable");
+    }
+
+    const QString path = dir_.filePath(QStringLiteral("enumerate.sock"));
+    std::unique_ptr<BrokerThread> broker;
+    if (brokered) {
+        broker = std::make_unique<BrokerThread>(path, nullptr);
+        QVERIFY(broker->startAndWait());
+    }
+
+    std::vector<std::unique_ptr<Qudev>> clients;
+    for (int i = 0; i < agents; ++i) {
+        clients.push_back(brokered ? std::make_unique<Qudev>(std::make_unique<QudevBrokerBackend>(path))
+                                   : std::make_unique<Qudev>());
+    }
+
+    qsizetype devices = 0;
+    QBENCHMARK {
+        devices = 0;
+        for (const auto& client : clients) {
+            devices += client->enumerate().size();
+        }
+    }
+    if (devices == 0) {
+        QSKIP("no devices visible to libudev");
+    }
+
+    // What the agents read from sysfs themselves; the broker's one scan
+    // happened before the measurement.
+    quint64 reads = 0;
+    quint64 scans = 0;
+    for (const auto& client : clients) {
+        const QudevStats stats = client->stats();
+        reads += stats.sysattrReads;
+        scans += stats.scans;
+    }
+    qInfo().nospace() << "[BenchBroker] " << QTest::currentDataTag() << ": " << devices / agents
+                      << " devices/agent, " << double(reads) / double(scans) << " sysattr reads/scan in agents";
+}
+
+void BenchBroker::events_data()
+{
+    addRows();
+}
+
+void BenchBroker::events()
+{
+    QFETCH(bool, brokered);
+    QFETCH(int, agents);
+    constexpr int Events = 5000;
+
+    const QString path = dir_.filePath(QStringLiteral("events.sock"));
+    std::unique_ptr<QudevMemoryBackend> local;
+    std::unique_ptr<BrokerThread> broker;
+    QudevMemoryBackend* source = nullptr;
+
+    if (brokered) {
+        broker = std::make_unique<BrokerThread>(path, [] {
+            return std::make_unique<QudevMemoryBackend>(QudevMemoryBackend::Options{ 1000 });
+        });
+        QVERIFY(broker->startAndWait());
+        source = static_cast<QudevMemoryBackend*>(broker->backend());
+    } else {
+        local = std::make_unique<QudevMemoryBackend>(QudevMemoryBackend::Options{ 1000 });
+        source = local.get();
+    }
+
+    qsizetype received = 0;
+    std::vector<std::unique_ptr<Qudev>> clients;
+    for (int i = 0; i < agents; ++i) {
+        std::unique_ptr<QudevBackend> backend;
+        if (brokered) {
+            backend = std::make_unique<QudevBrokerBackend>(path);
+        } else {
+            backend = std::make_unique<SharedBackend>(*source);
+        }
+        clients.push_back(std::make_unique<Qudev>(std::move(backend)));
+        connect(clients.back().get(), &Qudev::deviceFound, this, [&received] { ++received; });
+        QVERIFY(clients.back()->startMonitoring());
+    }
+    QTest::qWait(50);   // subscriptions reach the broker
+
+    QBENCHMARK_ONCE {
+        source->startEvents(0, Events);
+        QTRY_VERIFY_WITH_TIMEOUT(received >= qsizetype(agents) * Events, 120000);
+    }
+
+    for (const auto& client : clients) {
+        client->stopMonitoring();
+    }
+    source->stopEvents();
+}
+
+QUDEV_BENCHMARK(BenchBroker);
+
+#include "bench_broker.moc"
@@ -0,0 +1,130 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include <QTest>
+
+#include "qudev_device_model.h"
+#include "qudev_device_search_model.h"
+
+#include <qudev_memory_backend.h>
+#include "qudev_benchmark.h"
+
+
+// The udevviewer models: full rebuilds, incremental inserts and free-text
+// search over the resulting tree.
+class BenchDeviceModel : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void setDevices_data();
+    void setDevices();
+
+    void deviceAdded_data();
+    void deviceAdded();
+
+    void searchFilter_data();
+    void searchFilter();
+
+private:
+    static void sizes();
+    static int visitAll(const QAbstractItemModel& model, const QModelIndex& parent = {});
+};
+
+void BenchDeviceModel::sizes()
+{
+    QTest::addColumn<int>("devices");
+
+    QTest::newRow("1k")  << 1000;
+    QTest::newRow("10k") << 10000;
+}
+
+int BenchDeviceModel::visitAll(const QAbstractItemModel& model, const QModelIndex& parent)
+{
+    int rows = model.rowCount(parent);
+    for (int r = 0, n = rows; r < n; ++r) {
+        rows += visitAll(model, model.index(r, 0, parent));
+    }
+    return rows;
+}
+
+void BenchDeviceModel::setDevices_data()
+{
+    sizes();
+}
+
+void BenchDeviceModel::setDevices()
+{
+    QFETCH(int, devices);
+
+    const QList<QudevDevice> list = QudevMemoryBackend::generateDevices(devices);
+    QudevDeviceModel model;
+
+    QBENCHMARK {
+        model.setDevices(list);
+    }
+}
+
+void BenchDeviceModel::deviceAdded_data()
+{
+    sizes();
+}
+
+void BenchDeviceModel::deviceAdded()
+{
+    QFETCH(int, devices);
+
+    // One iteration = one hotplugged device inserted into a populated
+    // model, including the queued insertion the event loop would perform.
+    const QList<QudevDevice> added = QudevMemoryBackend::generateDevices(1000, 7);
+
+    QudevDeviceModel model;
+    model.setDevices(QudevMemoryBackend::generateDevices(devices));
+
+    qsizetype i = 0;
+    QBENCHMARK {
+        model.deviceAdded(added.at(i++ % added.size()));
+        model.drainPending();
+    }
+}
+
+void BenchDeviceModel::searchFilter_data()
+{
+    QTest::addColumn<int>("devices");
+    QTest::addColumn<QString>("needle");
+
+    QTest::newRow("1k/hit")   << 1000  << QStringLiteral("id_vendor");
+    QTest::newRow("1k/miss")  << 1000  << QStringLiteral("does-not-exist");
+    QTest::newRow("10k/hit")  << 10000 << QStringLiteral("id_vendor");
+    QTest::newRow("10k/miss") << 10000 << QStringLiteral("does-not-exist");
+}
+
+void BenchDeviceModel::searchFilter()
+{
+    QFETCH(int, devices);
+    QFETCH(QString, needle);
+
+    QudevDeviceModel model;
+    model.setDevices(QudevMemoryBackend::generateDevices(devices));
+
+    QudevDeviceSearchModel search;
+    search.setSourceModel(&model);
+
+    // Alternate the case so every iteration changes the filter text (and
+    // invalidates the proxy) while matching the same rows.
+    bool upper = false;
+    QBENCHMARK {
+        upper = !upper;
+        search.setFilterText(upper ? needle.toUpper() : needle);
+        visitAll(search);
+    }
+}
+
+QUDEV_BENCHMARK(BenchDeviceModel);
+
+#include "bench_device_model.moc"
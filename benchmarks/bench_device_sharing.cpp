@@ -0,0 +1,191 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include <QTest>
+
+#include <qudev.h>
+#include <qudev_device.h>
+#include <qudev_memory_backend.h>
+
+#include "qudev_benchmark.h"
+
+
+/// Carries a device across a queued connection, as QudevService does.
+class DeviceRelay : public QObject
+{
+    Q_OBJECT
+
+signals:
+    void plain(const QudevDevice& device);
+    void shared(const QudevSharedDevice& device);
+};
+
+// Cost of passing devices around by value versus sharing them: copies,
+// queued cross-thread style emissions and end-to-end delivery from the
+// monitor. Every row also logs heap allocations per device.
+class BenchDeviceSharing : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void copy_data();
+    void copy();
+
+    void queued_data();
+    void queued();
+
+    void delivery_data();
+    void delivery();
+
+private:
+    static void reportAllocations(quint64 allocations, qsizetype devices);
+
+    QList<QudevDevice> devices_;
+};
+
+void BenchDeviceSharing::initTestCase()
+{
+    devices_ = QudevMemoryBackend::generateDevices(1000);
+    QudevSharedDevice::registerMetaType();
+}
+
+void BenchDeviceSharing::reportAllocations(quint64 allocations, qsizetype devices)
+{
+    qInfo().nospace() << "[BenchDeviceSharing] " << QTest::currentDataTag() << ": "
+                      << double(allocations) / double(devices) << " allocations/device";
+}
+
+void BenchDeviceSharing::copy_data()
+{
+    QTest::addColumn<bool>("shared");
+
+    QTest::newRow("QudevDevice")       << false;
+    QTest::newRow("QudevSharedDevice") << true;
+}
+
+void BenchDeviceSharing::copy()
+{
+    QFETCH(bool, shared);
+
+    // Three copies per device: queue, model node, selection.
+    QList<QudevSharedDevice> sharedDevices;
+    for (const QudevDevice& d : devices_) {
+        sharedDevices << QudevSharedDevice(d);
+    }
+
+    QList<QudevDevice> plainCopies;
+    QList<QudevSharedDevice> sharedCopies;
+    plainCopies.reserve(devices_.size() * 3);
+    sharedCopies.reserve(devices_.size() * 3);
+
+    const quint64 before = qudevAllocations();
+    QBENCHMARK {
+        plainCopies.clear();
+        sharedCopies.clear();
+        for (qsizetype i = 0; i < devices_.size(); ++i) {
+            for (int c = 0; c < 3; ++c) {
+                if (shared) {
+                    sharedCopies << sharedDevices.at(i);
+                } else {
+                    plainCopies << devices_.at(i);
+                }
+            }
+        }
+    }
+    reportAllocations(qudevAllocations() - before, devices_.size());
+}
+
+void BenchDeviceSharing::queued_data()
+{
+    copy_data();
+}
+
+void BenchDeviceSharing::queued()
+{
+    QFETCH(bool, shared);
+
+    DeviceRelay relay;
+    QList<QudevDevice> plainKept;
+    QList<QudevSharedDevice> sharedKept;
+    connect(&relay, &DeviceRelay::plain, this, [&](const QudevDevice& d) { plainKept << d; },
+            Qt::QueuedConnection);
+    connect(&relay, &DeviceRelay::shared, this, [&](const QudevSharedDevice& d) { sharedKept << d; },
+            Qt::QueuedConnection);
+
+    quint64 allocations = 0;
+    qsizetype delivered = 0;
+    QBENCHMARK {
+        plainKept.clear();
+        sharedKept.clear();
+
+        const quint64 before = qudevAllocations();
+        for (const QudevDevice& d : devices_) {
+            if (shared) {
+                emit relay.shared(QudevDevice(d));   // what the monitor emits
+            } else {
+                emit relay.plain(d);
+            }
+        }
+        QCoreApplication::processEvents();
+        allocations += qudevAllocations() - before;
+        delivered += devices_.size();
+    }
+    reportAllocations(allocations, delivered);
+}
+
+void BenchDeviceSharing::delivery_data()
+{
+    QTest::addColumn<bool>("keepShared");
+
+    QTest::newRow("keep-copy")   << false;
+    QTest::newRow("keep-shared") << true;
+}
+
+void BenchDeviceSharing::delivery()
+{
+    QFETCH(bool, keepShared);
+    constexpr int Events = 20000;
+
+    auto owned = std::make_unique<QudevMemoryBackend>(devices_);
+    QudevMemoryBackend* backend = owned.get();
+    Qudev qudev(std::move(owned));
+
+    // "keep-copy" stores devices the way receivers did before devices were
+    // shared; "keep-shared" keeps the emitted handle.
+    QList<QudevDevice> copies;
+    QList<QudevSharedDevice> handles;
+    copies.reserve(Events);
+    handles.reserve(Events);
+    connect(&qudev, &Qudev::deviceFound, this, [&](const QudevSharedDevice& d) {
+        if (keepShared) {
+            handles << d;
+        } else {
+            copies << d.get();
+        }
+    });
+    QVERIFY(qudev.startMonitoring());
+
+    quint64 allocations = 0;
+    QBENCHMARK_ONCE {
+        const quint64 before = qudevAllocations();
+        backend->startEvents(0, Events);
+        QTRY_VERIFY_WITH_TIMEOUT(copies.size() + handles.size() + qsizetype(backend->eventsDropped()) >= Events,
+                                 60000);
+        allocations = qudevAllocations() - before;
+    }
+    reportAllocations(allocations, copies.size() + handles.size());
+
+    qudev.stopMonitoring();
+    backend->stopEvents();
+}
+
+QUDEV_BENCHMARK(BenchDeviceSharing);
+
+#include "bench_device_sharing.moc"
@@ -0,0 +1,104 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include <QTest>
+#include <QElapsedTimer>
+
+#include <qudev_device.h>
+#include <qudev_dispatcher.h>
+#include <qudev_memory_backend.h>
+
+#include "qudev_benchmark.h"
+
+
+// Delivery of a batch of change events to a handler that is either
+// trivial or spends ~20 µs per event (a probe, a D-Bus call), on one
+// worker, i.e. serial delivery, or sharded over several. Bounded queues
+// with a drop or coalesce policy trade completeness for latency.
+class BenchDispatcher : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void deliver_data();
+    void deliver();
+
+private:
+    static constexpr int Batch = 1024;
+
+    QList<QudevSharedDevice> events_;
+};
+
+void BenchDispatcher::initTestCase()
+{
+    // Several events per device, so coalescing has something to merge.
+    const QList<QudevDevice> devices = QudevMemoryBackend::generateDevices(Batch / 4);
+    for (int i = 0; i < Batch; ++i) {
+        QudevDevice e = devices.at(i % devices.size());
+        e.action = QStringLiteral("change");
+        e.seqnum = quint64(i + 1);
+        events_ << QudevSharedDevice(std::move(e));
+    }
+}
+
+void BenchDispatcher::deliver_data()
+{
+    QTest::addColumn<int>("workers");
+    QTest::addColumn<int>("handlerNs");
+    QTest::addColumn<QudevDispatcher::Overflow>("overflow");
+    QTest::addColumn<qsizetype>("capacity");
+
+    const auto block = QudevDispatcher::Overflow::Block;
+    QTest::newRow("1/fast") << 1 << 0 << block << qsizetype(Batch);
+    QTest::newRow("4/fast") << 4 << 0 << block << qsizetype(Batch);
+    QTest::newRow("1/slow") << 1 << 20000 << block << qsizetype(Batch);
+    QTest::newRow("4/slow") << 4 << 20000 << block << qsizetype(Batch);
+    QTest::newRow("8/slow") << 8 << 20000 << block << qsizetype(Batch);
+    QTest::newRow("4/slow/block-16") << 4 << 20000 << block << qsizetype(16);
+    QTest::newRow("4/slow/drop-oldest-16") << 4 << 20000 << QudevDispatcher::Overflow::DropOldest << qsizetype(16);
+    QTest::newRow("4/slow/coalesce-16") << 4 << 20000 << QudevDispatcher::Overflow::Coalesce << qsizetype(16);
+}
+
+void BenchDispatcher::deliver()
+{
+    QFETCH(int, workers);
+    QFETCH(int, handlerNs);
+    QFETCH(QudevDispatcher::Overflow, overflow);
+    QFETCH(qsizetype, capacity);
+
+    QudevDispatcher::Options options;
+    options.workers = workers;
+    options.queueCapacity = capacity;
+    options.overflow = overflow;
+    QudevDispatcher dispatcher([handlerNs](const QudevSharedDevice&) {
+        if (handlerNs > 0) {
+            QElapsedTimer t;
+            t.start();
+            while (t.nsecsElapsed() < handlerNs) {
+            }
+        }
+    }, options);
+
+    QBENCHMARK {
+        for (const QudevSharedDevice& e : std::as_const(events_)) {
+            dispatcher.post(e);
+        }
+        QVERIFY(dispatcher.waitForIdle());
+    }
+
+    const QudevDispatcher::Counters c = dispatcher.counters();
+    qInfo().nospace() << "[BenchDispatcher] " << QTest::currentDataTag() << ": posted " << c.posted
+                      << ", delivered " << c.delivered << ", dropped " << c.dropped << ", coalesced "
+                      << c.coalesced << ", blocked " << c.blocked;
+}
+
+QUDEV_BENCHMARK(BenchDispatcher);
+
+#include "bench_dispatcher.moc"
@@ -0,0 +1,156 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include <QTest>
+#include <libudev.h>
+
+#include "qudev_libudev_backend.h"
+#include "qudev_enumerator.h"
+#include "qudev_device.h"
+#include "qudev_filters.h"
+#include "qudev_stats_collector.h"
+
+#include "qudev_benchmark.h"
+
+
+// Enumeration and device construction against the host's udev database
+// (see BenchMemoryBackend for the deterministic counterpart).
+class BenchEnumerator : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void scan_data();
+    void scan();
+
+    void scanReadMode_data();
+    void scanReadMode();
+
+    void buildDevice();
+
+private:
+    std::unique_ptr<QudevLibudevBackend> backend_;
+    QList<QByteArray> syspaths_;
+};
+
+void BenchEnumerator::initTestCase()
+{
+    if (auto ctx = QudevContext::create()) {
+        backend_ = std::make_unique<QudevLibudevBackend>(std::move(*ctx));
+    }
+    if (!backend_) {
+        QSKIP("libudev context unavailable");
+    }
+
+    const QudevEnumerator enumerator(*backend_);
+    for (const auto& d : enumerator.scan({})) {
+        syspaths_ << d.syspath.toLocal8Bit();
+    }
+    if (syspaths_.isEmpty()) {
+        QSKIP("no devices visible to libudev");
+    }
+
+    qInfo() << "[BenchEnumerator] devices:" << syspaths_.size();
+}
+
+void BenchEnumerator::scan_data()
+{
+    QTest::addColumn<QudevFilters>("filters");
+
+    QudevFilters block;
+    block.subsystem = QStringLiteral("block");
+
+    QudevFilters tagged;
+    tagged.tags << QStringLiteral("systemd");
+
+    QudevFilters postOnly;
+    postOnly.syspathPrefix = QStringLiteral("/sys/devices/pci");
+
+    QTest::addColumn<bool>("cached");
+
+    for (bool cached : { false, true }) {
+        const QByteArray suffix = cached ? "/sysattr-cache" : "/uncached";
+        QTest::newRow("unfiltered" + suffix)     << QudevFilters{} << cached;
+        QTest::newRow("subsystem" + suffix)      << block << cached;
+        QTest::newRow("tag" + suffix)            << tagged << cached;
+        QTest::newRow("syspath-prefix" + suffix) << postOnly << cached;
+    }
+}
+
+void BenchEnumerator::scan()
+{
+    QFETCH(QudevFilters, filters);
+    QFETCH(bool, cached);
+
+    backend_->setSysattrPolicy(cached ? QudevSysattrPolicy::defaults() : QudevSysattrPolicy::disabled());
+
+    // Warm the cache, then count the sysfs reads a repeated scan still does.
+    QudevStatsCollector stats;
+    const QudevEnumerator enumerator(*backend_);
+    enumerator.scan(filters);
+    backend_->setStats(&stats);
+    enumerator.scan(filters);
+    backend_->setStats(nullptr);
+
+    qInfo().nospace() << "[BenchEnumerator] " << QTest::currentDataTag() << ": sysattr reads/scan "
+                      << stats.sysattrReads.load() << ", cache hits/scan " << stats.sysattrCacheHits.load();
+
+    QBENCHMARK {
+        enumerator.scan(filters);
+    }
+}
+
+void BenchEnumerator::scanReadMode_data()
+{
+    QTest::addColumn<QudevSysattrReadMode>("mode");
+
+    QTest::newRow("libudev")     << QudevSysattrReadMode::Libudev;
+    QTest::newRow("io_uring")    << QudevSysattrReadMode::IoUring;
+    QTest::newRow("thread-pool") << QudevSysattrReadMode::ThreadPool;
+}
+
+void BenchEnumerator::scanReadMode()
+{
+    QFETCH(QudevSysattrReadMode, mode);
+
+    // Uncached, so every scan reads every attribute of every device.
+    backend_->setSysattrPolicy(QudevSysattrPolicy::disabled());
+    backend_->setSysattrReadMode(mode);
+    if (mode != QudevSysattrReadMode::Libudev && !backend_->context().sysattrReader()) {
+        backend_->setSysattrPolicy(QudevSysattrPolicy::defaults());
+        QSKIP("io_uring not available");
+    }
+
+    const QudevEnumerator enumerator(*backend_);
+    QBENCHMARK {
+        enumerator.scan(QudevFilters{});
+    }
+
+    backend_->setSysattrReadMode(QudevSysattrReadMode::Libudev);
+    backend_->setSysattrPolicy(QudevSysattrPolicy::defaults());
+}
+
+void BenchEnumerator::buildDevice()
+{
+    // One iteration = one device, cycling through everything on the host.
+    qsizetype i = 0;
+    QBENCHMARK {
+        const QByteArray& path = syspaths_.at(i++ % syspaths_.size());
+        udev_device* d = udev_device_new_from_syspath(backend_->context().get(), path.constData());
+        if (d) {
+            ::buildDevice(backend_->context(), d);
+            udev_device_unref(d);
+        }
+    }
+}
+
+QUDEV_BENCHMARK(BenchEnumerator);
+
+#include "bench_enumerator.moc"
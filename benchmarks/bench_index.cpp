@@ -0,0 +1,180 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include <QTest>
+
+#include <qudev_filters.h>
+#include <qudev_index.h>
+#include <qudev_memory_backend.h>
+
+#include "qudev_benchmark.h"
+
+#include <algorithm>
+
+
+// Secondary indexes at 100k synthetic devices: building them, keeping them
+// current from change events, and lookups by devnode, device number,
+// ID_SERIAL and tag plus a filter query, each against a linear scan of the
+// same devices (an index without declared indexes).
+class BenchIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Lookup { Devnode, DevNumber, Serial, Tag, Filters };
+
+private slots:
+    void initTestCase();
+
+    void build_data();
+    void build();
+
+    void update_data();
+    void update();
+
+    void lookup_data();
+    void lookup();
+
+private:
+    static constexpr int Count = 100000;
+
+    QList<QudevSharedDevice> devices_;
+};
+Q_DECLARE_METATYPE(BenchIndex::Lookup)
+
+void BenchIndex::initTestCase()
+{
+    for (QudevDevice& d : QudevMemoryBackend::generateDevices(Count)) {
+        devices_ << std::move(d);
+    }
+}
+
+void BenchIndex::build_data()
+{
+    QTest::addColumn<bool>("indexed");
+    QTest::newRow("no-indexes") << false;
+    QTest::newRow("default-indexes") << true;
+}
+
+void BenchIndex::build()
+{
+    QFETCH(bool, indexed);
+
+    QBENCHMARK {
+        QudevIndex index;
+        if (indexed) {
+            index.addDefaultIndexes();
+        }
+        for (const auto& d : devices_) {
+            index.insert(d);
+        }
+    }
+}
+
+void BenchIndex::update_data()
+{
+    QTest::addColumn<bool>("rekey");
+    QTest::newRow("same-keys") << false;
+    QTest::newRow("new-serial") << true;
+}
+
+void BenchIndex::update()
+{
+    QFETCH(bool, rekey);
+
+    QudevIndex index;
+    index.addDefaultIndexes();
+    for (const auto& d : devices_) {
+        index.insert(d);
+    }
+
+    // Two change events per device of a fixed sample, applied in turn; when
+    // re-keying, the second one restores the original serial.
+    QList<QudevSharedDevice> events;
+    for (int i = 0; i < 1000; ++i) {
+        QudevDevice e = devices_.at(i * (Count / 1000));
+        e.action = QStringLiteral("change");
+        events << QudevSharedDevice(e);
+        if (rekey) {
+            e.properties.insert(QStringLiteral("ID_SERIAL"), QStringLiteral("Changed_%1").arg(i));
+        }
+        events << std::move(e);
+    }
+
+    qsizetype next = 0;
+    QBENCHMARK {
+        index.apply(events.at(next));
+        next = (next + 1) % events.size();
+    }
+}
+
+void BenchIndex::lookup_data()
+{
+    QTest::addColumn<Lookup>("lookup");
+    QTest::addColumn<bool>("indexed");
+
+    const QList<QPair<Lookup, QByteArray>> lookups = {
+        { Devnode, "devnode" }, { DevNumber, "devnum" }, { Serial, "serial" },
+        { Tag, "tag" }, { Filters, "filters" },
+    };
+    for (const auto& [lookup, name] : lookups) {
+        QTest::newRow(name + "/scan") << lookup << false;
+        QTest::newRow(name + "/index") << lookup << true;
+    }
+}
+
+void BenchIndex::lookup()
+{
+    QFETCH(Lookup, lookup);
+    QFETCH(bool, indexed);
+
+    QudevIndex index;
+    if (indexed) {
+        index.addDefaultIndexes();
+    }
+    for (const auto& d : devices_) {
+        index.insert(d);
+    }
+
+    // A device with a node, from the middle of the set.
+    const QudevDevice& target = *std::find_if(devices_.cbegin() + Count / 2, devices_.cend(),
+                                              [](const QudevSharedDevice& d) { return !d->devnode.isEmpty(); });
+    QudevFilters filters;
+    filters.subsystem = QStringLiteral("block");
+    filters.properties.insert(QStringLiteral("ID_PATH"), target.properties.value(QStringLiteral("ID_PATH")));
+    filters.tags << QStringLiteral("uaccess");
+
+    qsizetype found = 0;
+    QBENCHMARK {
+        switch (lookup) {
+        case Devnode:
+            found = index.findDevnode(target.devnode).isNull() ? 0 : 1;
+            break;
+        case DevNumber:
+            found = index.findDevNumber(target.major, target.minor).size();
+            break;
+        case Serial:
+            found = index.findProperty(QStringLiteral("ID_SERIAL"), target.properties.value(QStringLiteral("ID_SERIAL"))).size();
+            break;
+        case Tag:
+            found = index.find(QudevIndex::Field::Tag, QStringLiteral("uaccess")).size();
+            break;
+        case Filters:
+            found = index.select(filters).size();
+            break;
+        }
+    }
+
+    if (lookup != Filters) {
+        QVERIFY(found > 0);
+    }
+}
+
+QUDEV_BENCHMARK(BenchIndex);
+
+#include "bench_index.moc"
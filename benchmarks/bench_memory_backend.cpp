@@ -0,0 +1,167 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include <QTest>
+#include <QElapsedTimer>
+#include <QHash>
+
+#include <qudev.h>
+#include <qudev_device.h>
+#include <qudev_memory_backend.h>
+
+#include "qudev_benchmark.h"
+
+
+// Scan and monitoring throughput at sizes and rates real hardware cannot
+// provide on demand, using the in-memory backend.
+class BenchMemoryBackend : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void scan_data();
+    void scan();
+
+    void sharedScan_data();
+    void sharedScan();
+
+    void monitor_data();
+    void monitor();
+
+private:
+    const QList<QudevDevice>& devices(int count);
+
+    QHash<int, QList<QudevDevice>> devices_;
+};
+
+const QList<QudevDevice>& BenchMemoryBackend::devices(int count)
+{
+    auto it = devices_.find(count);
+    if (it == devices_.end()) {
+        it = devices_.insert(count, QudevMemoryBackend::generateDevices(count));
+    }
+    return it.value();
+}
+
+void BenchMemoryBackend::scan_data()
+{
+    QTest::addColumn<int>("count");
+    QTest::addColumn<QudevFilters>("filters");
+
+    QudevFilters block;
+    block.subsystem = QStringLiteral("block");
+
+    QudevFilters property;
+    property.properties.insert(QStringLiteral("ID_BUS"), QStringLiteral("usb"));
+
+    for (int count : { 10000, 100000 }) {
+        const QByteArray n = QByteArray::number(count / 1000) + "k";
+        QTest::newRow(n + "/unfiltered") << count << QudevFilters{};
+        QTest::newRow(n + "/subsystem")  << count << block;
+        QTest::newRow(n + "/property")   << count << property;
+    }
+}
+
+void BenchMemoryBackend::scan()
+{
+    QFETCH(int, count);
+    QFETCH(QudevFilters, filters);
+
+    Qudev qudev(std::make_unique<QudevMemoryBackend>(devices(count)));
+    qudev.setFilters(filters);
+
+    QBENCHMARK {
+        qudev.enumerate();
+    }
+}
+
+void BenchMemoryBackend::sharedScan_data()
+{
+    QTest::addColumn<int>("sets");
+    QTest::addColumn<bool>("shared");
+
+    for (int sets : { 4, 16 }) {
+        const QByteArray n = QByteArray::number(sets) + "-sets";
+        QTest::newRow(n + "/separate") << sets << false;
+        QTest::newRow(n + "/shared")   << sets << true;
+    }
+}
+
+void BenchMemoryBackend::sharedScan()
+{
+    QFETCH(int, sets);
+    QFETCH(bool, shared);
+
+    // Startup-style sets: a device model taking everything plus components
+    // watching one subsystem each. They share no criteria, so the shared
+    // scan costs about one unfiltered scan.
+    static const char* const subsystems[] = { "block", "tty", "net", "input", "usb", "pci", "hwmon", "thermal" };
+    QList<QudevFilters> filterSets(sets);
+    for (int i = 1; i < sets; ++i) {
+        filterSets[i].subsystem = QString::fromLatin1(subsystems[i % 8]);
+        if (i >= 8) {
+            filterSets[i].properties.insert(QStringLiteral("ID_BUS"), QStringLiteral("usb"));
+        }
+    }
+
+    Qudev qudev(std::make_unique<QudevMemoryBackend>(devices(100000)));
+
+    QBENCHMARK {
+        if (shared) {
+            qudev.enumerate(filterSets);
+        } else {
+            for (const QudevFilters& filters : std::as_const(filterSets)) {
+                qudev.setFilters(filters);
+                qudev.enumerate();
+            }
+        }
+    }
+}
+
+void BenchMemoryBackend::monitor_data()
+{
+    QTest::addColumn<double>("rate");
+    QTest::addColumn<int>("events");
+
+    QTest::newRow("10k/s") << 10000.0 << 20000;
+    QTest::newRow("50k/s") << 50000.0 << 100000;
+    QTest::newRow("max")   << 0.0     << 100000;
+}
+
+void BenchMemoryBackend::monitor()
+{
+    QFETCH(double, rate);
+    QFETCH(int, events);
+
+    auto owned = std::make_unique<QudevMemoryBackend>(devices(10000));
+    QudevMemoryBackend* backend = owned.get();
+    Qudev qudev(std::move(owned));
+
+    qsizetype received = 0;
+    connect(&qudev, &Qudev::deviceFound, this, [&received]() { ++received; });
+    QVERIFY(qudev.startMonitoring());
+
+    QElapsedTimer timer;
+    QBENCHMARK_ONCE {
+        timer.start();
+        backend->startEvents(rate, events);
+        QTRY_VERIFY_WITH_TIMEOUT(received + qsizetype(backend->eventsDropped()) >= events, 60000);
+    }
+
+    const double secs = timer.nsecsElapsed() / 1e9;
+    qInfo().nospace() << "[BenchMemoryBackend] target " << rate << " ev/s: delivered "
+                      << received << " in " << secs << " s (" << received / secs << " ev/s), dropped "
+                      << backend->eventsDropped();
+
+    qudev.stopMonitoring();
+    backend->stopEvents();
+}
+
+QUDEV_BENCHMARK(BenchMemoryBackend);
+
+#include "bench_memory_backend.moc"
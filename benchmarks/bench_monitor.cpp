@@ -0,0 +1,77 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include <QTest>
+
+#include "qudev_monitor.h"
+#include "qudev_device.h"
+#include "qudev_filters.h"
+
+#include <qudev_memory_backend.h>
+#include "qudev_benchmark.h"
+
+
+// Per-event cost of the monitor's user-space filter stage.
+class BenchMonitor : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void applyPostFilters_data();
+    void applyPostFilters();
+
+private:
+    QList<QudevDevice> events_;
+};
+
+void BenchMonitor::initTestCase()
+{
+    events_ = QudevMemoryBackend::generateDevices(4096);
+}
+
+void BenchMonitor::applyPostFilters_data()
+{
+    QTest::addColumn<QudevFilters>("filters");
+
+    QudevFilters subsystem;
+    subsystem.subsystem = QStringLiteral("block");
+    subsystem.devtype   = QStringLiteral("disk");
+
+    QudevFilters full;
+    full.subsystem = QStringLiteral("usb");
+    full.actions << QStringLiteral("add") << QStringLiteral("remove");
+    full.tags << QStringLiteral("systemd");
+    full.properties.insert(QStringLiteral("ID_BUS"), QStringLiteral("usb"));
+    full.sysattrs.insert(QStringLiteral("removable"), QStringLiteral("1"));
+    full.syspathPrefix = QStringLiteral("/sys/devices/pci0000:00");
+
+    QudevFilters miss;
+    miss.devnode = QStringLiteral("/dev/does-not-exist");
+
+    QTest::newRow("empty")     << QudevFilters{};
+    QTest::newRow("subsystem") << subsystem;
+    QTest::newRow("full")      << full;
+    QTest::newRow("miss")      << miss;
+}
+
+void BenchMonitor::applyPostFilters()
+{
+    QFETCH(QudevFilters, filters);
+
+    // One iteration = one event.
+    qsizetype i = 0;
+    QBENCHMARK {
+        QudevMonitor::applyPostFilters(events_.at(i++ % events_.size()), filters);
+    }
+}
+
+QUDEV_BENCHMARK(BenchMonitor);
+
+#include "bench_monitor.moc"
@@ -0,0 +1,132 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include <QTest>
+#include <QCoreApplication>
+
+#include <qudev.h>
+#include <qudev_device.h>
+#include <qudev_memory_backend.h>
+#include <qudev_monitor_hub.h>
+
+#include "qudev_benchmark.h"
+#include "qudev_monitor.h"
+
+#include <memory>
+#include <vector>
+
+
+// Event fan-out to 1, 100 and 1000 subscribers, each watching one
+// subsystem (half of them also a property), through one shared hub or
+// through a Qudev monitor per subscriber. One iteration delivers a batch
+// of change events to everyone they match. Own monitors stop at 100
+// subscribers: each holds a socket pair.
+class BenchMonitorHub : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void fanOut_data();
+    void fanOut();
+
+private:
+    // Small enough for default socket buffers, so nothing is dropped.
+    static constexpr int Batch = 64;
+
+    QList<QudevDevice> events_;
+};
+
+void BenchMonitorHub::initTestCase()
+{
+    events_ = QudevMemoryBackend::generateDevices(Batch);
+    for (QudevDevice& e : events_) {
+        e.action = QStringLiteral("change");
+        e.seqnum = 0;
+    }
+}
+
+void BenchMonitorHub::fanOut_data()
+{
+    QTest::addColumn<int>("subscribers");
+    QTest::addColumn<bool>("hub");
+
+    for (int n : { 1, 100, 1000 }) {
+        const QByteArray name = QByteArray::number(n);
+        QTest::newRow(name + "/hub") << n << true;
+        if (n <= 100) {
+            QTest::newRow(name + "/own-monitors") << n << false;
+        }
+    }
+}
+
+void BenchMonitorHub::fanOut()
+{
+    QFETCH(int, subscribers);
+    QFETCH(bool, hub);
+
+    static const char* const subsystems[] = {
+        "pci", "usb", "block", "net", "input", "tty", "power_supply", "thermal", "hwmon", "platform",
+    };
+    QList<QudevFilters> filters(subscribers);
+    for (int i = 0; i < subscribers; ++i) {
+        filters[i].subsystem = QString::fromLatin1(subsystems[i % 10]);
+        if (i % 2) {
+            filters[i].properties.insert(QStringLiteral("ID_BUS"), QStringLiteral("usb"));
+        }
+    }
+
+    qsizetype perBatch = 0;
+    for (const QudevDevice& e : std::as_const(events_)) {
+        for (const QudevFilters& f : std::as_const(filters)) {
+            perBatch += QudevMonitor::applyPostFilters(e, f) ? 1 : 0;
+        }
+    }
+
+    auto owned = std::make_unique<QudevMemoryBackend>(QList<QudevDevice>{});
+    QudevMemoryBackend* backend = owned.get();
+    QudevMonitorHub shared(std::move(owned));
+
+    // Own monitors each open a socket on the same backend.
+    qsizetype delivered = 0;
+    std::vector<std::unique_ptr<QudevMonitor>> monitors;
+    for (const QudevFilters& f : std::as_const(filters)) {
+        if (hub) {
+            shared.subscribe(f, [&delivered](const QudevSharedDevice&) { ++delivered; });
+        } else {
+            monitors.push_back(std::make_unique<QudevMonitor>(*backend, QudevMonitor::Channel::Udev));
+            connect(monitors.back().get(), &QudevMonitor::deviceFound, this,
+                    [&delivered](const QudevSharedDevice&) { ++delivered; });
+            QVERIFY(monitors.back()->start(f));
+        }
+    }
+
+    qsizetype expected = 0;
+    QBENCHMARK {
+        for (const QudevDevice& e : std::as_const(events_)) {
+            backend->inject(e);
+        }
+        expected += perBatch;
+        while (delivered < expected && backend->eventsDropped() == 0) {
+            QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+        }
+    }
+    QCOMPARE(backend->eventsDropped(), quint64(0));
+
+    qInfo().nospace() << "[BenchMonitorHub] " << QTest::currentDataTag() << ": " << perBatch
+                      << " deliveries per batch of " << Batch << ", dropped " << backend->eventsDropped();
+
+    for (auto& m : monitors) {
+        m->stop();
+    }
+}
+
+QUDEV_BENCHMARK(BenchMonitorHub);
+
+#include "bench_monitor_hub.moc"
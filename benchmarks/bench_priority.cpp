@@ -0,0 +1,113 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include <QTest>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+
+#include <qudev.h>
+#include <qudev_device.h>
+#include <qudev_memory_backend.h>
+#include <qudev_priority.h>
+
+#include "qudev_benchmark.h"
+
+
+// A burst of power_supply change events with a few block adds at its end,
+// delivered to a slot spending ~5 µs per event, in arrival order or
+// through the default priority lanes. The timed figure is the whole
+// burst, i.e. the lanes' overhead; the time until the block adds arrive is
+// printed per row.
+class BenchPriority : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void burst_data();
+    void burst();
+
+private:
+    // Small enough for default socket buffers, so nothing is dropped.
+    static constexpr int Noise = 96;
+    static constexpr int Urgent = 4;
+
+    QList<QudevDevice> events_;
+};
+
+void BenchPriority::initTestCase()
+{
+    for (int i = 0; i < Noise + Urgent; ++i) {
+        const bool urgent = i >= Noise;
+        QudevDevice e;
+        e.subsystem = urgent ? QStringLiteral("block") : QStringLiteral("power_supply");
+        e.sysname = urgent ? QStringLiteral("sd%1").arg(i) : QStringLiteral("BAT%1").arg(i);
+        e.syspath = QStringLiteral("/sys/devices/bench/%1/%2").arg(e.subsystem, e.sysname);
+        e.action = urgent ? QStringLiteral("add") : QStringLiteral("change");
+        events_ << e;
+    }
+}
+
+void BenchPriority::burst_data()
+{
+    QTest::addColumn<bool>("lanes");
+
+    QTest::newRow("fifo") << false;
+    QTest::newRow("lanes") << true;
+}
+
+void BenchPriority::burst()
+{
+    QFETCH(bool, lanes);
+
+    auto owned = std::make_unique<QudevMemoryBackend>(QList<QudevDevice>{});
+    QudevMemoryBackend* backend = owned.get();
+    Qudev qudev(std::move(owned));
+    if (lanes) {
+        qudev.setPriorityLanes(QudevPriorityLanes::defaults());
+    }
+
+    QElapsedTimer clock;
+    qsizetype delivered = 0;
+    qint64 urgentNs = 0;
+    connect(&qudev, &Qudev::deviceFound, this, [&](const QudevSharedDevice& d) {
+        ++delivered;
+        if (d->subsystem == QLatin1String("block")) {
+            urgentNs += clock.nsecsElapsed();
+        }
+        QElapsedTimer work;
+        work.start();
+        while (work.nsecsElapsed() < 5000) {
+        }
+    });
+    QVERIFY(qudev.startMonitoring());
+
+    qsizetype expected = 0;
+    int bursts = 0;
+    QBENCHMARK {
+        clock.start();
+        for (const QudevDevice& e : std::as_const(events_)) {
+            backend->inject(e);
+        }
+        expected += events_.size();
+        ++bursts;
+        while (delivered < expected && backend->eventsDropped() == 0) {
+            QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+        }
+    }
+    QCOMPARE(backend->eventsDropped(), quint64(0));
+
+    qInfo().nospace() << "[BenchPriority] " << QTest::currentDataTag() << ": block add delivered after "
+                      << double(urgentNs) / (bursts * Urgent) / 1000.0 << " us on average, lane 0 p99 "
+                      << qudev.stats().lanes[0].queueLatency.percentileNs(99) / 1000 << " us";
+}
+
+QUDEV_BENCHMARK(BenchPriority);
+
+#include "bench_priority.moc"
@@ -0,0 +1,113 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include <QTest>
+
+#include <qudev_device.h>
+#include <qudev_filters.h>
+#include <qudev_memory_backend.h>
+#include <qudev_query.h>
+
+#include "qudev_benchmark.h"
+#include "qudev_monitor.h"
+
+
+// Query language throughput: parsing and pushdown of typical query texts,
+// and evaluation over 10k synthetic devices. The conjunctive query is
+// also run as its pushed-down QudevFilters through the monitor's
+// post-filter, the path it takes when nothing is left in the residual.
+class BenchQuery : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Evaluator { Query, PostFilter };
+
+private slots:
+    void initTestCase();
+
+    void parse_data();
+    void parse();
+
+    void evaluate_data();
+    void evaluate();
+
+private:
+    static constexpr int Count = 10000;
+
+    QList<QudevDevice> devices_;
+};
+Q_DECLARE_METATYPE(BenchQuery::Evaluator)
+
+namespace {
+
+const char* const Conjunctive = "subsystem==block && devtype==partition && tag:uaccess && ID_BUS==usb";
+const char* const Disjunctive = "subsystem==block && (ID_BUS==usb || attr:removable==1) && !tag:uaccess";
+const char* const Globs = "sysname==tty[0-9]* || devnode==/dev/sd* || syspath==/sys/devices/pci0000:00/0000:00:1?.0/*";
+
+} // namespace
+
+void BenchQuery::initTestCase()
+{
+    devices_ = QudevMemoryBackend::generateDevices(Count);
+}
+
+void BenchQuery::parse_data()
+{
+    QTest::addColumn<QString>("text");
+    QTest::newRow("term") << QStringLiteral("subsystem==block");
+    QTest::newRow("conjunctive") << QString::fromLatin1(Conjunctive);
+    QTest::newRow("disjunctive") << QString::fromLatin1(Disjunctive);
+    QTest::newRow("globs") << QString::fromLatin1(Globs);
+}
+
+void BenchQuery::parse()
+{
+    QFETCH(QString, text);
+
+    bool valid = false;
+    QBENCHMARK {
+        valid = QudevQuery(text).isValid();
+    }
+    QVERIFY(valid);
+}
+
+void BenchQuery::evaluate_data()
+{
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<Evaluator>("evaluator");
+
+    QTest::newRow("conjunctive/post-filter") << QString::fromLatin1(Conjunctive) << PostFilter;
+    QTest::newRow("conjunctive/query") << QString::fromLatin1(Conjunctive) << Query;
+    QTest::newRow("disjunctive/query") << QString::fromLatin1(Disjunctive) << Query;
+    QTest::newRow("globs/query") << QString::fromLatin1(Globs) << Query;
+}
+
+void BenchQuery::evaluate()
+{
+    QFETCH(QString, text);
+    QFETCH(Evaluator, evaluator);
+
+    const QudevQuery query(text);
+    QVERIFY(query.isValid());
+    const QudevFilters filters = query.filters();
+
+    qsizetype matched = 0;
+    QBENCHMARK {
+        matched = 0;
+        for (const QudevDevice& d : devices_) {
+            const bool hit = evaluator == Query ? query.matches(d) : QudevMonitor::applyPostFilters(d, filters);
+            matched += hit ? 1 : 0;
+        }
+    }
+    QVERIFY(matched > 0);
+}
+
+QUDEV_BENCHMARK(BenchQuery);
+
+#include "bench_query.moc"
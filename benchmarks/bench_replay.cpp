@@ -0,0 +1,102 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include <QTest>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+
+#include <qudev.h>
+#include <qudev_device.h>
+#include <qudev_memory_backend.h>
+#include <qudev_replay_backend.h>
+
+#include "qudev_benchmark.h"
+
+
+// Replays one recorded event stream through the monitor pipeline at
+// different speeds. The stream is recorded once per run from the memory
+// backend; pointing QUDEV_BENCH_EVENT_LOG at a log captured on a real host
+// replays that instead.
+class BenchReplay : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void replay_data();
+    void replay();
+
+private:
+    QTemporaryDir dir_;
+    QString log_;
+};
+
+void BenchReplay::initTestCase()
+{
+    log_ = qEnvironmentVariable("QUDEV_BENCH_EVENT_LOG");
+    if (!log_.isEmpty()) {
+        return;
+    }
+
+    QVERIFY(dir_.isValid());
+    log_ = dir_.filePath(QStringLiteral("events.qudevlog"));
+
+    constexpr int Events = 20000;
+
+    auto owned = std::make_unique<QudevMemoryBackend>();
+    QudevMemoryBackend* backend = owned.get();
+    Qudev qudev(std::move(owned));
+
+    qsizetype received = 0;
+    connect(&qudev, &Qudev::deviceFound, this, [&received]() { ++received; });
+    QVERIFY(qudev.startRecording(log_));
+    QVERIFY(qudev.startMonitoring());
+
+    backend->startEvents(Events, Events);
+    QTRY_VERIFY_WITH_TIMEOUT(received >= Events, 30000);
+}
+
+void BenchReplay::replay_data()
+{
+    QTest::addColumn<double>("speed");
+
+    QTest::newRow("1x")  << 1.0;
+    QTest::newRow("10x") << 10.0;
+    QTest::newRow("max") << 0.0;
+}
+
+void BenchReplay::replay()
+{
+    QFETCH(double, speed);
+
+    auto owned = std::make_unique<QudevReplayBackend>(log_, speed);
+    QudevReplayBackend* backend = owned.get();
+    QVERIFY2(backend->isValid(), qPrintable(backend->errorString()));
+    const qsizetype events = backend->eventCount();
+
+    Qudev qudev(std::move(owned));
+    qsizetype received = 0;
+    connect(&qudev, &Qudev::deviceFound, this, [&received]() { ++received; });
+
+    QElapsedTimer timer;
+    QBENCHMARK_ONCE {
+        timer.start();
+        QVERIFY(qudev.startMonitoring());
+        QTRY_VERIFY_WITH_TIMEOUT(received >= events, 120000);
+    }
+
+    const double secs = timer.nsecsElapsed() / 1e9;
+    const double ideal = speed > 0 ? backend->durationNs() / 1e9 / speed : 0;
+    qInfo().nospace() << "[BenchReplay] speed " << speed << ": " << received << " events in "
+                      << secs << " s (" << received / secs << " ev/s, schedule " << ideal << " s)";
+}
+
+QUDEV_BENCHMARK(BenchReplay);
+
+#include "bench_replay.moc"
@@ -0,0 +1,172 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include <QTest>
+#include <QSemaphore>
+#include <QTemporaryDir>
+#include <QThread>
+
+#include <qudev_broker.h>
+#include <qudev_broker_backend.h>
+#include <qudev_device.h>
+#include <qudev_memory_backend.h>
+#include <qudev_shared_snapshot.h>
+
+#include "qudev_benchmark.h"
+
+
+namespace {
+
+/// Broker over synthetic devices publishing its shared snapshot.
+class SharedBrokerThread : public QThread
+{
+public:
+    SharedBrokerThread(const QString& path, int devices)
+        : path_(path), devices_(devices)
+    {}
+
+    ~SharedBrokerThread() override
+    {
+        quit();
+        wait();
+    }
+
+    bool startAndWait()
+    {
+        start();
+        ready_.acquire();
+        return listening_;
+    }
+
+protected:
+    void run() override
+    {
+        QudevBroker broker(std::make_unique<QudevMemoryBackend>(QudevMemoryBackend::Options{ devices_ }));
+        listening_ = broker.setSharedSnapshotEnabled(true) && broker.listen(path_);
+        ready_.release();
+        if (listening_) {
+            exec();
+        }
+    }
+
+private:
+    QString path_;
+    int devices_;
+    bool listening_ = false;
+    QSemaphore ready_;
+};
+
+} // namespace
+
+// A co-located reader asking "how many block devices are there?" of the
+// full inventory: through a broker round trip (socket, snapshot transfer,
+// decoding) versus in place in the broker's shared memory. The shared
+// reader validates a publication once, so repeated queries of an unchanged
+// inventory, the common case for high-frequency readers, skip straight to
+// the views; bench_snapshot's "snapshot-view" rows cover the validation.
+class BenchSharedSnapshot : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Mode { Broker, Shared };
+
+private slots:
+    void initTestCase();
+
+    void query_data();
+    void query();
+
+    void publish_data();
+    void publish();
+
+private:
+    QTemporaryDir dir_;
+};
+Q_DECLARE_METATYPE(BenchSharedSnapshot::Mode)
+
+void BenchSharedSnapshot::initTestCase()
+{
+    QVERIFY(dir_.isValid());
+}
+
+void BenchSharedSnapshot::query_data()
+{
+    QTest::addColumn<Mode>("mode");
+    QTest::addColumn<int>("count");
+
+    for (int count : { 1000, 10000 }) {
+        const QByteArray suffix = '/' + QByteArray::number(count);
+        QTest::newRow("broker" + suffix) << Broker << count;
+        QTest::newRow("shared" + suffix) << Shared << count;
+    }
+}
+
+void BenchSharedSnapshot::query()
+{
+    QFETCH(Mode, mode);
+    QFETCH(int, count);
+
+    const QString path = dir_.filePath(QStringLiteral("shared-%1.sock").arg(count));
+    SharedBrokerThread broker(path, count);
+    QVERIFY(broker.startAndWait());
+
+    const QUtf8StringView block("block");
+    qsizetype blocks = 0;
+
+    if (mode == Broker) {
+        QudevBrokerBackend backend(path);
+        QBENCHMARK {
+            blocks = 0;
+            backend.enumerate({}, [&](QudevDevice&& d) {
+                blocks += d.subsystem == QLatin1String("block") ? 1 : 0;
+                return true;
+            });
+        }
+    } else {
+        const auto shared = QudevSharedSnapshotReader::fromBroker(path);
+        QVERIFY(shared);
+        const auto countBlocks = [&](const QudevSnapshotReader& snapshot) {
+            blocks = 0;
+            for (qsizetype i = 0; i < snapshot.deviceCount(); ++i) {
+                blocks += snapshot.device(i).subsystem() == block ? 1 : 0;
+            }
+        };
+
+        QBENCHMARK {
+            shared->read(countBlocks);
+        }
+        QCOMPARE(shared->retries(), quint64(0));
+    }
+
+    QVERIFY(blocks > 0);
+}
+
+void BenchSharedSnapshot::publish_data()
+{
+    QTest::addColumn<int>("count");
+    QTest::newRow("1000") << 1000;
+    QTest::newRow("10000") << 10000;
+}
+
+void BenchSharedSnapshot::publish()
+{
+    QFETCH(int, count);
+
+    const QList<QudevDevice> devices = QudevMemoryBackend::generateDevices(count);
+    QudevSharedSnapshotWriter writer;
+    QVERIFY(writer.isValid());
+
+    QBENCHMARK {
+        writer.publish(qudevEncodeSnapshot(devices));
+    }
+}
+
+QUDEV_BENCHMARK(BenchSharedSnapshot);
+
+#include "bench_shared_snapshot.moc"
@@ -0,0 +1,251 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include <QTest>
+#include <QDataStream>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <qudev_memory_backend.h>
+#include <qudev_snapshot.h>
+
+#include "qudev_benchmark.h"
+
+
+// Serializing device inventories: JSON (QJsonDocument, compact), the
+// QDataStream operators and the binary snapshot format. Decoding the
+// snapshot is measured both fully materialized and as zero-copy views
+// reading a few fields per device. Sizes are logged once per row.
+class BenchSnapshot : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Format { Json, DataStream, Snapshot, SnapshotView };
+
+private slots:
+    void encode_data();
+    void encode();
+
+    void decode_data();
+    void decode();
+
+private:
+    static QByteArray encodeAs(Format format, const QList<QudevDevice>& devices);
+    static QJsonObject toJson(const QudevDevice& d);
+    static QudevDevice fromJson(const QJsonObject& o);
+};
+Q_DECLARE_METATYPE(BenchSnapshot::Format)
+
+namespace {
+
+QJsonObject mapToJson(const QMap<QString, QString>& map)
+{
+    QJsonObject o;
+    for (auto it = map.cbegin(); it != map.cend(); ++it) {
+        o.insert(it.key(), it.value());
+    }
+    return o;
+}
+
+QMap<QString, QString> mapFromJson(const QJsonObject& o)
+{
+    QMap<QString, QString> map;
+    for (auto it = o.constBegin(); it != o.constEnd(); ++it) {
+        map.insert(it.key(), it.value().toString());
+    }
+    return map;
+}
+
+QStringList listFromJson(const QJsonValue& v)
+{
+    QStringList list;
+    for (const QJsonValue& item : v.toArray()) {
+        list << item.toString();
+    }
+    return list;
+}
+
+void addRows()
+{
+    QTest::addColumn<BenchSnapshot::Format>("format");
+    QTest::addColumn<int>("count");
+
+    for (int count : { 1000, 10000 }) {
+        const QByteArray suffix = '/' + QByteArray::number(count);
+        QTest::newRow("json" + suffix)          << BenchSnapshot::Json << count;
+        QTest::newRow("datastream" + suffix)    << BenchSnapshot::DataStream << count;
+        QTest::newRow("snapshot" + suffix)      << BenchSnapshot::Snapshot << count;
+        QTest::newRow("snapshot-view" + suffix) << BenchSnapshot::SnapshotView << count;
+    }
+}
+
+} // namespace
+
+QJsonObject BenchSnapshot::toJson(const QudevDevice& d)
+{
+    return {
+        { QStringLiteral("syspath"), d.syspath },
+        { QStringLiteral("devnode"), d.devnode },
+        { QStringLiteral("subsystem"), d.subsystem },
+        { QStringLiteral("devtype"), d.devtype },
+        { QStringLiteral("sysname"), d.sysname },
+        { QStringLiteral("driver"), d.driver },
+        { QStringLiteral("major"), qint64(d.major) },
+        { QStringLiteral("minor"), qint64(d.minor) },
+        { QStringLiteral("properties"), mapToJson(d.properties) },
+        { QStringLiteral("sysattrs"), mapToJson(d.sysattrs) },
+        { QStringLiteral("devlinks"), QJsonArray::fromStringList(d.devlinks) },
+        { QStringLiteral("tags"), QJsonArray::fromStringList(d.tags) },
+        { QStringLiteral("parent_syspath"), d.parent_syspath },
+        { QStringLiteral("parent_subsystem"), d.parent_subsystem },
+        { QStringLiteral("action"), d.action },
+        { QStringLiteral("seqnum"), QString::number(d.seqnum) },
+        { QStringLiteral("isBlock"), d.isBlock },
+        { QStringLiteral("isChar"), d.isChar },
+    };
+}
+
+QudevDevice BenchSnapshot::fromJson(const QJsonObject& o)
+{
+    QudevDevice d;
+    d.syspath = o.value(QLatin1String("syspath")).toString();
+    d.devnode = o.value(QLatin1String("devnode")).toString();
+    d.subsystem = o.value(QLatin1String("subsystem")).toString();
+    d.devtype = o.value(QLatin1String("devtype")).toString();
+    d.sysname = o.value(QLatin1String("sysname")).toString();
+    d.driver = o.value(QLatin1String("driver")).toString();
+    d.major = quint32(o.value(QLatin1String("major")).toInteger());
+    d.minor = quint32(o.value(QLatin1String("minor")).toInteger());
+    d.properties = mapFromJson(o.value(QLatin1String("properties")).toObject());
+    d.sysattrs = mapFromJson(o.value(QLatin1String("sysattrs")).toObject());
+    d.devlinks = listFromJson(o.value(QLatin1String("devlinks")));
+    d.tags = listFromJson(o.value(QLatin1String("tags")));
+    d.parent_syspath = o.value(QLatin1String("parent_syspath")).toString();
+    d.parent_subsystem = o.value(QLatin1String("parent_subsystem")).toString();
+    d.action = o.value(QLatin1String("action")).toString();
+    d.seqnum = o.value(QLatin1String("seqnum")).toString().toULongLong();
+    d.isBlock = o.value(QLatin1String("isBlock")).toBool();
+    d.isChar = o.value(QLatin1String("isChar")).toBool();
+    return d;
+}
+
+QByteArray BenchSnapshot::encodeAs(Format format, const QList<QudevDevice>& devices)
+{
+    switch (format)
+    {
+    case Json: {
+        QJsonArray array;
+        for (const QudevDevice& d : devices) {
+            array.append(toJson(d));
+        }
+        return QJsonDocument(array).toJson(QJsonDocument::Compact);
+    }
+    case DataStream: {
+        QByteArray data;
+        QDataStream out(&data, QIODevice::WriteOnly);
+        out << devices;
+        return data;
+    }
+    case Snapshot:
+    case SnapshotView:
+        return qudevEncodeSnapshot(devices);
+    }
+    return {};
+}
+
+void BenchSnapshot::encode_data()
+{
+    addRows();
+}
+
+void BenchSnapshot::encode()
+{
+    QFETCH(Format, format);
+    QFETCH(int, count);
+
+    if (format == SnapshotView) {
+        QSKIP("Views only apply to decoding");
+    }
+
+    const QList<QudevDevice> devices = QudevMemoryBackend::generateDevices(count);
+
+    QByteArray data;
+    QBENCHMARK {
+        data = encodeAs(format, devices);
+    }
+
+    qInfo().nospace() << "[BenchSnapshot] " << QTest::currentDataTag() << ": " << data.size() << " bytes, "
+                      << double(data.size()) / count << " bytes/device";
+}
+
+void BenchSnapshot::decode_data()
+{
+    addRows();
+}
+
+void BenchSnapshot::decode()
+{
+    QFETCH(Format, format);
+    QFETCH(int, count);
+
+    const QByteArray data = encodeAs(format, QudevMemoryBackend::generateDevices(count));
+
+    qsizetype decoded = 0;
+    qsizetype matched = 0;
+    switch (format)
+    {
+    case Json:
+        QBENCHMARK {
+            const QJsonArray array = QJsonDocument::fromJson(data).array();
+            QList<QudevDevice> devices;
+            devices.reserve(array.size());
+            for (const QJsonValue& v : array) {
+                devices << fromJson(v.toObject());
+            }
+            decoded = devices.size();
+        }
+        break;
+    case DataStream:
+        QBENCHMARK {
+            QList<QudevDevice> devices;
+            QDataStream in(data);
+            in >> devices;
+            decoded = devices.size();
+        }
+        break;
+    case Snapshot:
+        QBENCHMARK {
+            decoded = QudevSnapshotReader(data).devices().size();
+        }
+        break;
+    case SnapshotView:
+        // What a filter pass over a stored inventory touches.
+        QBENCHMARK {
+            const QudevSnapshotReader reader(data);
+            matched = 0;
+            for (qsizetype i = 0; i < reader.deviceCount(); ++i) {
+                const QudevSnapshotReader::DeviceView d = reader.device(i);
+                if (d.isBlock() && !d.property(u8"ID_PATH").isNull()) {
+                    ++matched;
+                }
+            }
+            decoded = reader.deviceCount();
+        }
+        qInfo().nospace() << "[BenchSnapshot] " << QTest::currentDataTag() << ": "
+                          << matched << " block devices with ID_PATH";
+        break;
+    }
+
+    QCOMPARE(decoded, qsizetype(count));
+}
+
+QUDEV_BENCHMARK(BenchSnapshot);
+
+#include "bench_snapshot.moc"
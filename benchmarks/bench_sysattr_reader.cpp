@@ -0,0 +1,158 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include <QTest>
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "qudev_sysattr_reader.h"
+
+#include "qudev_benchmark.h"
+
+
+// Bulk sysattr reads over a generated tree of 50k attribute files
+// (2500 devices x 20 attributes). "libudev" is the per-attribute
+// lstat + open + read + close sequence udev_device_get_sysattr_value()
+// performs; libudev itself refuses syspaths outside /sys, see
+// BenchEnumerator::scanReadMode for the same comparison on the host.
+class BenchSysattrReader : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void read_data();
+    void read();
+
+private:
+    static constexpr int Devices = 2500;
+    static constexpr int AttributesPerDevice = 20;
+
+    static void readLikeLibudev(QudevSysattrReader::Request& request);
+
+    QTemporaryDir dir_;
+    std::vector<QudevSysattrReader::Request> requests_;
+};
+
+void BenchSysattrReader::initTestCase()
+{
+    QVERIFY(dir_.isValid());
+
+    requests_.reserve(Devices * AttributesPerDevice);
+    for (int d = 0; d < Devices; ++d)
+    {
+        const QString device = dir_.filePath(QStringLiteral("devices/dev%1").arg(d));
+        QVERIFY(QDir().mkpath(device));
+
+        for (int a = 0; a < AttributesPerDevice; ++a)
+        {
+            const QString path = device + QStringLiteral("/attr%1").arg(a);
+            QFile file(path);
+            QVERIFY(file.open(QIODevice::WriteOnly));
+            file.write(QByteArray::number(d * AttributesPerDevice + a) + '\n');
+
+            QudevSysattrReader::Request request;
+            request.path = QFile::encodeName(path);
+            requests_.push_back(std::move(request));
+        }
+    }
+
+    // Every implementation must agree with the libudev-style read.
+    for (QudevSysattrReadMode mode : { QudevSysattrReadMode::IoUring, QudevSysattrReadMode::ThreadPool })
+    {
+        auto reader = QudevSysattrReader::create(mode);
+        if (!reader) {
+            continue;
+        }
+
+        std::vector<QudevSysattrReader::Request> batch = requests_;
+        reader->read(batch.data(), qsizetype(batch.size()));
+        for (std::size_t i = 0; i < batch.size(); ++i) {
+            QCOMPARE(batch[i].value, QByteArray::number(qint64(i)));
+        }
+    }
+}
+
+void BenchSysattrReader::readLikeLibudev(QudevSysattrReader::Request& request)
+{
+    struct stat st;
+    if (::lstat(request.path.constData(), &st) < 0 || !S_ISREG(st.st_mode)) {
+        request.value.clear();
+        return;
+    }
+
+    const int fd = ::open(request.path.constData(), O_RDONLY | O_CLOEXEC | O_NOFOLLOW);
+    if (fd < 0) {
+        request.value.clear();
+        return;
+    }
+
+    request.value.resize(QudevSysattrReader::MaxValueSize);
+    const ssize_t n = ::read(fd, request.value.data(), size_t(request.value.size()));
+    request.value.truncate(n > 0 ? qsizetype(n) : 0);
+    ::close(fd);
+}
+
+void BenchSysattrReader::read_data()
+{
+    QTest::addColumn<QudevSysattrReadMode>("mode");
+    QTest::addColumn<int>("batchSize");
+
+    // Per device: what buildDevice() submits while monitoring; per group:
+    // one enumeration group; whole tree: upper bound of batching.
+    const QList<QPair<QByteArray, int>> batches = {
+        { "per-device", AttributesPerDevice },
+        { "per-group",  AttributesPerDevice * 64 },
+        { "whole-tree", Devices * AttributesPerDevice },
+    };
+
+    QTest::newRow("libudev") << QudevSysattrReadMode::Libudev << 1;
+    for (const auto& batch : batches) {
+        QTest::newRow("io_uring/" + batch.first)    << QudevSysattrReadMode::IoUring << batch.second;
+        QTest::newRow("thread-pool/" + batch.first) << QudevSysattrReadMode::ThreadPool << batch.second;
+    }
+}
+
+void BenchSysattrReader::read()
+{
+    QFETCH(QudevSysattrReadMode, mode);
+    QFETCH(int, batchSize);
+
+    std::vector<QudevSysattrReader::Request> requests = requests_;
+    const qsizetype count = qsizetype(requests.size());
+
+    if (mode == QudevSysattrReadMode::Libudev) {
+        QBENCHMARK {
+            for (auto& request : requests) {
+                readLikeLibudev(request);
+            }
+        }
+        return;
+    }
+
+    auto reader = QudevSysattrReader::create(mode);
+    if (!reader) {
+        QSKIP("io_uring not available");
+    }
+
+    QBENCHMARK {
+        for (qsizetype begin = 0; begin < count; begin += batchSize) {
+            reader->read(requests.data() + begin, qMin<qsizetype>(batchSize, count - begin));
+        }
+    }
+}
+
+QUDEV_BENCHMARK(BenchSysattrReader);
+
+#include "bench_sysattr_reader.moc"
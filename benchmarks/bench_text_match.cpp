@@ -0,0 +1,121 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include <QTest>
+#include <QStringList>
+
+#include <qudev.h>
+#include <qudev_device.h>
+#include <qudev_text_match.h>
+
+#include "qudev_benchmark.h"
+
+
+// Compares the viewer's former "toLower().contains()" search against
+// QudevTextMatcher over the strings the device tree actually displays.
+class BenchTextMatch : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void toLowerContains_data() { needles(); }
+    void toLowerContains();
+
+    void matcher_data() { needles(); }
+    void matcher();
+
+private:
+    void needles();
+    qsizetype countToLower(const QString& needle) const;
+
+    QStringList corpus_;
+};
+
+void BenchTextMatch::initTestCase()
+{
+    // Prefer the real property/sysattr corpus of this host; fall back to a
+    // synthetic one on machines without a usable udev (containers, CI).
+    Qudev qudev;
+    const QList<QudevDevice> devices = qudev.enumerate();
+    for (const auto& d : devices) {
+        corpus_ << d.syspath << d.devnode << d.subsystem;
+        for (auto it = d.properties.cbegin(); it != d.properties.cend(); ++it) {
+            corpus_ << it.key() + QStringLiteral(": ") + it.value();
+        }
+        for (auto it = d.sysattrs.cbegin(); it != d.sysattrs.cend(); ++it) {
+            corpus_ << it.key() + QStringLiteral(": ") + it.value();
+        }
+    }
+
+    if (corpus_.isEmpty()) {
+        for (int i = 0; i < 2000; ++i) {
+            corpus_ << QStringLiteral("/sys/devices/pci0000:00/0000:00:14.0/usb1/1-%1").arg(i)
+                    << QStringLiteral("ID_VENDOR_ID: %1").arg(0x8087 + i, 4, 16, QLatin1Char('0'))
+                    << QStringLiteral("ID_MODEL: Generic_Device_%1").arg(i)
+                    << QStringLiteral("DEVLINKS: /dev/disk/by-id/usb-Generic_%1-0:0").arg(i)
+                    << QStringLiteral("removable: %1").arg(i % 2);
+        }
+    }
+
+    qInfo() << "[BenchTextMatch] corpus strings:" << corpus_.size();
+}
+
+void BenchTextMatch::needles()
+{
+    QTest::addColumn<QString>("needle");
+
+    QTest::newRow("short")      << QStringLiteral("usb");
+    QTest::newRow("mixed-case") << QStringLiteral("Id_Vendor");
+    QTest::newRow("long")       << QStringLiteral("pci0000:00/0000:00:14.0");
+    QTest::newRow("miss")       << QStringLiteral("does-not-exist");
+}
+
+qsizetype BenchTextMatch::countToLower(const QString& needle) const
+{
+    const QString lower = needle.toLower();
+    qsizetype hits = 0;
+    for (const auto& s : corpus_) {
+        hits += s.toLower().contains(lower) ? 1 : 0;
+    }
+    return hits;
+}
+
+void BenchTextMatch::toLowerContains()
+{
+    QFETCH(QString, needle);
+
+    QBENCHMARK {
+        countToLower(needle);
+    }
+}
+
+void BenchTextMatch::matcher()
+{
+    QFETCH(QString, needle);
+
+    const QudevTextMatcher m(needle);
+    auto count = [&]() {
+        qsizetype hits = 0;
+        for (const auto& s : corpus_) {
+            hits += m.matches(s) ? 1 : 0;
+        }
+        return hits;
+    };
+
+    QCOMPARE(count(), countToLower(needle));
+
+    QBENCHMARK {
+        count();
+    }
+}
+
+QUDEV_BENCHMARK(BenchTextMatch);
+
+#include "bench_text_match.moc"
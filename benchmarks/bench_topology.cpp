@@ -0,0 +1,124 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include <QTest>
+#include <QMap>
+
+#include <qudev_memory_backend.h>
+#include <qudev_topology.h>
+
+#include "qudev_benchmark.h"
+
+
+// Selecting the devices below one PCI function (about 1/32 of the set) by
+// syspath prefix: scanning every device, a range of a syspath-ordered map
+// (what the broker used to do) and the topology's subtree walk. Building
+// the topology is measured separately; events update it one device at a time.
+class BenchTopology : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Mode { Scan, SortedMap, Topology };
+
+private slots:
+    void prefix_data();
+    void prefix();
+
+    void build_data();
+    void build();
+};
+Q_DECLARE_METATYPE(BenchTopology::Mode)
+
+void BenchTopology::prefix_data()
+{
+    QTest::addColumn<Mode>("mode");
+    QTest::addColumn<int>("count");
+
+    for (int count : { 10000, 100000 }) {
+        const QByteArray suffix = '/' + QByteArray::number(count);
+        QTest::newRow("scan" + suffix) << Scan << count;
+        QTest::newRow("sorted-map" + suffix) << SortedMap << count;
+        QTest::newRow("topology" + suffix) << Topology << count;
+    }
+}
+
+void BenchTopology::prefix()
+{
+    QFETCH(Mode, mode);
+    QFETCH(int, count);
+
+    QList<QudevSharedDevice> devices;
+    for (QudevDevice& d : QudevMemoryBackend::generateDevices(count)) {
+        devices << std::move(d);
+    }
+    const QString prefix = QStringLiteral("/sys/devices/pci0000:00/0000:00:1f.0/");
+    qsizetype found = 0;
+
+    if (mode == Scan) {
+        QBENCHMARK {
+            found = 0;
+            for (const auto& d : devices) {
+                found += d->syspath.startsWith(prefix) ? 1 : 0;
+            }
+        }
+    } else if (mode == SortedMap) {
+        QMap<QString, QudevSharedDevice> map;
+        for (const auto& d : devices) {
+            map.insert(d->syspath, d);
+        }
+        QBENCHMARK {
+            found = 0;
+            for (auto it = map.lowerBound(prefix); it != map.cend() && it.key().startsWith(prefix); ++it) {
+                ++found;
+            }
+        }
+    } else {
+        QudevTopology topology;
+        for (const auto& d : devices) {
+            topology.insert(d);
+        }
+        QBENCHMARK {
+            found = 0;
+            topology.visitPrefix(prefix, [&](const QudevSharedDevice&) {
+                ++found;
+                return true;
+            });
+        }
+    }
+
+    QVERIFY(found > 0);
+}
+
+void BenchTopology::build_data()
+{
+    QTest::addColumn<int>("count");
+    QTest::newRow("10000") << 10000;
+    QTest::newRow("100000") << 100000;
+}
+
+void BenchTopology::build()
+{
+    QFETCH(int, count);
+
+    QList<QudevSharedDevice> devices;
+    for (QudevDevice& d : QudevMemoryBackend::generateDevices(count)) {
+        devices << std::move(d);
+    }
+
+    QBENCHMARK {
+        QudevTopology topology;
+        for (const auto& d : devices) {
+            topology.insert(d);
+        }
+    }
+}
+
+QUDEV_BENCHMARK(BenchTopology);
+
+#include "bench_topology.moc"
@@ -0,0 +1,138 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include <QCoreApplication>
+#include <QTest>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <QXmlStreamReader>
+
+#include "qudev_benchmark.h"
+
+
+std::vector<QudevBenchmarkFactory>& qudevBenchmarks()
+{
+    static std::vector<QudevBenchmarkFactory> factories;
+    return factories;
+}
+
+/// Append every BenchmarkResult of a Qt Test XML log to @p results.
+static bool collectResults(const QString& xmlPath, QJsonArray& results)
+{
+    QFile file(xmlPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QXmlStreamReader xml(&file);
+    QString testCase;
+    QString function;
+
+    while (!xml.atEnd())
+    {
+        if (xml.readNext() != QXmlStreamReader::StartElement) {
+            continue;
+        }
+
+        const QXmlStreamAttributes attrs = xml.attributes();
+        if (xml.name() == QLatin1String("TestCase")) {
+            testCase = attrs.value(QLatin1String("name")).toString();
+        }
+        else if (xml.name() == QLatin1String("TestFunction")) {
+            function = attrs.value(QLatin1String("name")).toString();
+        }
+        else if (xml.name() == QLatin1String("BenchmarkResult")) {
+            const double value = attrs.value(QLatin1String("value")).toDouble();
+            const int iterations = attrs.value(QLatin1String("iterations")).toInt();
+
+            QJsonObject r;
+            r[QStringLiteral("benchmark")]    = testCase + QStringLiteral("::") + function;
+            r[QStringLiteral("tag")]          = attrs.value(QLatin1String("tag")).toString();
+            r[QStringLiteral("metric")]       = attrs.value(QLatin1String("metric")).toString();
+            r[QStringLiteral("value")]        = value;
+            r[QStringLiteral("iterations")]   = iterations;
+            r[QStringLiteral("perIteration")] = iterations > 0 ? value / iterations : value;
+            results.append(r);
+        }
+    }
+
+    return !xml.hasError();
+}
+
+static bool writeJson(const QString& path, const QJsonArray& results)
+{
+    QJsonObject root;
+    root[QStringLiteral("schema")]    = 1;
+    root[QStringLiteral("qtVersion")] = QString::fromLatin1(qVersion());
+    root[QStringLiteral("results")]   = results;
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qCritical() << "[qudev_benchmarks] Cannot write" << path;
+        return false;
+    }
+
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Indented));
+    return true;
+}
+
+// Usage: qudev_benchmarks [-json <file>] [Qt Test options...]
+//
+// With -json, every benchmark class additionally logs to a temporary
+// Qt Test XML file and all results are merged into one JSON document
+// suitable for regression tracking.
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+
+    QStringList args = app.arguments();
+    QString jsonPath;
+
+    const qsizetype jsonArg = args.indexOf(QStringLiteral("-json"));
+    if (jsonArg >= 0) {
+        if (jsonArg + 1 >= args.size()) {
+            qCritical() << "[qudev_benchmarks] -json requires a file name";
+            return 1;
+        }
+        jsonPath = args.at(jsonArg + 1);
+        args.remove(jsonArg, 2);
+    }
+
+    QTemporaryDir logDir;
+    QJsonArray results;
+    int failures = 0;
+    int index = 0;
+
+    for (const auto factory : qudevBenchmarks())
+    {
+        const std::unique_ptr<QObject> bench = factory();
+
+        QStringList runArgs = args;
+        QString xmlPath;
+        if (!jsonPath.isEmpty()) {
+            xmlPath = logDir.filePath(QStringLiteral("%1.xml").arg(index++));
+            runArgs << QStringLiteral("-o") << xmlPath + QStringLiteral(",xml")
+                    << QStringLiteral("-o") << QStringLiteral("-,txt");
+        }
+
+        failures += QTest::qExec(bench.get(), runArgs);
+
+        if (!xmlPath.isEmpty() && !collectResults(xmlPath, results)) {
+            qWarning() << "[qudev_benchmarks] Failed to parse" << xmlPath;
+        }
+    }
+
+    if (!jsonPath.isEmpty() && !writeJson(jsonPath, results)) {
+        ++failures;
+    }
+
+    return failures;
+}
@@ -0,0 +1,45 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <QObject>
+
+/**
+ * @file qudev_benchmark.h
+ * @brief Registration helpers for the qudev_benchmarks executable.
+ *
+ * Every benchmark is a regular Qt Test class using @c QBENCHMARK. Classes
+ * register themselves with @ref QUDEV_BENCHMARK and are run one after the
+ * other by the shared @c main().
+ */
+
+/// Factory creating one benchmark class instance.
+using QudevBenchmarkFactory = std::unique_ptr<QObject> (*)();
+
+/// All benchmark classes linked into the executable, in registration order.
+std::vector<QudevBenchmarkFactory>& qudevBenchmarks();
+
+/// Static registrar used by @ref QUDEV_BENCHMARK.
+struct QudevBenchmarkRegistrar
+{
+    explicit QudevBenchmarkRegistrar(QudevBenchmarkFactory factory)
+    {
+        qudevBenchmarks().push_back(factory);
+    }
+};
+
+/// Heap allocations (malloc, calloc, realloc) made by the process so far.
+quint64 qudevAllocations() noexcept;
+
+/// Register benchmark class @p Class with the qudev_benchmarks runner.
+#define QUDEV_BENCHMARK(Class) \
+    static const QudevBenchmarkRegistrar qudevBenchmarkRegistrar##Class( \
+        []() -> std::unique_ptr<QObject> { return std::make_unique<Class>(); })
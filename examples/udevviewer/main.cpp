@@ -30,7 +30,9 @@ int main(int argc, char** argv)
     // Initially load filters if any
     service.setFilters(filtersModel.toQudevFilters());
 
-    QObject::connect(&service, &QudevService::scanFinished, &deviceModel, &QudevDeviceModel::setDevices);
+    QObject::connect(&service, &QudevService::scanStarted,  &deviceModel, &QudevDeviceModel::beginPopulation);
+    QObject::connect(&service, &QudevService::scanChunk,    &deviceModel, &QudevDeviceModel::appendDevices);
+    QObject::connect(&service, &QudevService::scanFinished, &deviceModel, &QudevDeviceModel::endPopulation);
     QObject::connect(&service, &QudevService::deviceFound, &deviceModel, &QudevDeviceModel::deviceAdded);
     QObject::connect(&filtersModel, &QudevFiltersModel::changed, &service, [&](){
         service.setFilters(filtersModel.toQudevFilters());
@@ -8,11 +8,21 @@
 
 #include "qudev_device_model.h"
 
+#include <QSet>
+#include <QDebug>
+
+#include <qudev_trace.h>
+
 
 QudevDeviceModel::QudevDeviceModel(QObject* parent)
     : QAbstractItemModel(parent)
 {
     root_ = makeRoot();
+
+    // Zero-interval timer: one insertion slice per event-loop pass, so
+    // input and rendering get a turn between slices.
+    insertTimer_.setInterval(0);
+    connect(&insertTimer_, &QTimer::timeout, this, &QudevDeviceModel::drainPending);
 }
 
 QudevDeviceModel::~QudevDeviceModel()
@@ -30,9 +40,12 @@ QudevDeviceModel::Node* QudevDeviceModel::makeRoot()
 
 void QudevDeviceModel::clear()
 {
+    resetPending();
+
     beginResetModel();
     delete root_;
     root_ = makeRoot();
+    subsystems_.clear();
     endResetModel();
 
     emit countChanged();
@@ -107,9 +120,9 @@ static QString iconFor(const QudevDeviceModel::Node* n)
     case QudevDeviceModel::SubsystemNode:
         return QStringLiteral("devices_other");
     case QudevDeviceModel::DeviceNode:
-        if (n->device.subsystem == QLatin1String("usb"))   return QStringLiteral("usb");
-        if (n->device.subsystem == QLatin1String("block")) return QStringLiteral("storage");
-        if (n->device.subsystem == QLatin1String("net"))   return QStringLiteral("router");
+        if (n->device->subsystem == QLatin1String("usb"))   return QStringLiteral("usb");
+        if (n->device->subsystem == QLatin1String("block")) return QStringLiteral("storage");
+        if (n->device->subsystem == QLatin1String("net"))   return QStringLiteral("router");
         return QStringLiteral("memory");
     case QudevDeviceModel::SectionNode:
         return QStringLiteral("info");
@@ -336,30 +349,44 @@ void QudevDeviceModel::addSections(Node* device, const QudevDevice& d)
     addListSection(device, QStringLiteral("Tags"),     d.tags);
 }
 
-QudevDeviceModel::Node* QudevDeviceModel::addSubsystem(const QString& name)
+QudevDeviceModel::Node* QudevDeviceModel::makeSubsystem(const QString& name)
 {
-    for (auto* s : root_->children) {
-        if (s->type == SubsystemNode && s->display == name)
-            return s;
-    }
-
     auto* n = new Node;
     n->type = SubsystemNode;
     n->display = name;
     n->parent = root_;
+    subsystems_.insert(name, n);
+
+    return n;
+}
+
+QudevDeviceModel::Node* QudevDeviceModel::addSubsystem(const QString& name)
+{
+    if (Node* s = subsystems_.value(name)) {
+        return s;
+    }
+
+    Node* n = makeSubsystem(name);
     root_->children.push_back(n);
 
     return n;
 }
 
-QudevDeviceModel::Node* QudevDeviceModel::addDevice(Node* subsystem, const QudevDevice& d)
+QudevDeviceModel::Node* QudevDeviceModel::makeDevice(Node* subsystem, const QudevSharedDevice& d)
 {
-    auto label = d.devnode.isEmpty() ? d.syspath : d.devnode;
+    auto label = d->devnode.isEmpty() ? d->syspath : d->devnode;
     auto* n = new Node;
     n->type = DeviceNode;
     n->display = label;
     n->device = d;
     n->parent = subsystem;
+
+    return n;
+}
+
+QudevDeviceModel::Node* QudevDeviceModel::addDevice(Node* subsystem, const QudevSharedDevice& d)
+{
+    Node* n = makeDevice(subsystem, d);
     subsystem->children.push_back(n);
 
     return n;
@@ -367,25 +394,32 @@ QudevDeviceModel::Node* QudevDeviceModel::addDevice(Node* subsystem, const Qudev
 
 void QudevDeviceModel::rebuild(const QList<QudevDevice>& list)
 {
+    QUDEV_TRACE_SCOPE_NAMED(span, "viewer", "model.rebuild");
+    QUDEV_TRACE_ARG(span, "devices", qint64(list.size()));
+
     delete root_;
     root_ = makeRoot();
+    subsystems_.clear();
 
-    QHash<QString, QList<QudevDevice>> buckets;
+    // Bucket by pointer; each device is copied once, into its shared node.
+    QHash<QString, QList<const QudevDevice*>> buckets;
     for (const auto& d : list) {
-        buckets[d.subsystem].push_back(d);
+        buckets[d.subsystem].push_back(&d);
     }
 
     for (auto it = buckets.cbegin(); it != buckets.cend(); ++it) {
         Node* sub = addSubsystem(it.key());
-        for (const auto& d : it.value()) {
-            Node* dev = addDevice(sub, d);
-            addSections(dev, d);
+        for (const QudevDevice* d : it.value()) {
+            Node* dev = addDevice(sub, QudevSharedDevice(*d));
+            addSections(dev, *dev->device);
         }
     }
 }
 
 void QudevDeviceModel::setDevices(const QList<QudevDevice>& list)
 {
+    resetPending();
+
     beginResetModel();
     rebuild(list);
     endResetModel();
@@ -393,22 +427,150 @@ void QudevDeviceModel::setDevices(const QList<QudevDevice>& list)
     emit countChanged();
 }
 
-void QudevDeviceModel::deviceAdded(const QudevDevice& d)
+void QudevDeviceModel::deviceAdded(const QudevSharedDevice& d)
 {
-    beginResetModel();
+    pending_.enqueue(d);
+    if (!insertTimer_.isActive()) {
+        insertTimer_.start();
+    }
+}
 
-    QList<QudevDevice> flat;
-    for (auto* s : root_->children) {
-        for (auto* dv : s->children) {
-            if (dv->type == DeviceNode) {
-                flat.push_back(dv->device);
-            }
+void QudevDeviceModel::beginPopulation()
+{
+    clear();
+
+    populationClock_.start();
+    populationEnded_ = false;
+    firstRowNs_ = -1;
+    maxStallNs_ = 0;
+
+    emit populationStatsChanged();
+}
+
+void QudevDeviceModel::appendDevices(const QList<QudevSharedDevice>& list)
+{
+    if (list.isEmpty()) {
+        return;
+    }
+
+    pending_.append(list);
+    if (!insertTimer_.isActive()) {
+        insertTimer_.start();
+    }
+}
+
+void QudevDeviceModel::endPopulation()
+{
+    populationEnded_ = true;
+    if (pending_.isEmpty()) {
+        reportPopulation();
+    }
+}
+
+void QudevDeviceModel::resetPending()
+{
+    insertTimer_.stop();
+    pending_.clear();
+}
+
+void QudevDeviceModel::drainPending()
+{
+    QUDEV_TRACE_SCOPE_NAMED(span, "viewer", "model.drainPending");
+    QUDEV_TRACE_ARG(span, "pending", qint64(pending_.size()));
+
+    QElapsedTimer slice;
+    slice.start();
+    const qint64 budgetNs = qint64(frameBudgetMs_) * 1000 * 1000;
+
+    // Build detached device nodes first, then attach them with one
+    // insertRows notification per touched parent.
+    QVector<Node*> newSubsystems;
+    QSet<Node*> isNew;
+    QHash<Node*, QVector<Node*>> appended;
+
+    while (!pending_.isEmpty())
+    {
+        const QudevSharedDevice d = pending_.dequeue();
+
+        Node* sub = subsystems_.value(d->subsystem);
+        if (!sub) {
+            sub = makeSubsystem(d->subsystem);
+            newSubsystems.push_back(sub);
+            isNew.insert(sub);
+        }
+
+        Node* dev = makeDevice(sub, d);
+        addSections(dev, d);
+
+        if (isNew.contains(sub)) {
+            sub->children.push_back(dev);
+        } else {
+            appended[sub].push_back(dev);
+        }
+
+        if (slice.nsecsElapsed() >= budgetNs) {
+            break;
         }
     }
-    flat.push_back(d);
 
-    rebuild(flat);
-    endResetModel();
+    for (auto it = appended.cbegin(); it != appended.cend(); ++it)
+    {
+        Node* sub = it.key();
+        const int first = sub->children.size();
+        beginInsertRows(indexFromNode(sub), first, first + it.value().size() - 1);
+        sub->children += it.value();
+        endInsertRows();
+    }
 
-    emit countChanged();
+    if (!newSubsystems.isEmpty())
+    {
+        const int first = root_->children.size();
+        beginInsertRows({}, first, first + newSubsystems.size() - 1);
+        root_->children += newSubsystems;
+        endInsertRows();
+
+        emit countChanged();
+    }
+
+    if (populationClock_.isValid())
+    {
+        if (firstRowNs_ < 0 && !root_->children.isEmpty()) {
+            firstRowNs_ = populationClock_.nsecsElapsed();
+        }
+        maxStallNs_ = qMax(maxStallNs_, slice.nsecsElapsed());
+    }
+
+    if (pending_.isEmpty())
+    {
+        insertTimer_.stop();
+        if (populationEnded_) {
+            reportPopulation();
+        }
+    }
+}
+
+void QudevDeviceModel::reportPopulation()
+{
+    if (!populationClock_.isValid()) {
+        return;
+    }
+
+    qInfo() << "[QudevDeviceModel] Population finished in" << populationClock_.elapsed() << "ms,"
+            << "time to first row:" << timeToFirstRowMs() << "ms,"
+            << "max GUI stall:" << maxStallMs() << "ms";
+
+    populationClock_.invalidate();
+    populationEnded_ = false;
+
+    emit populationStatsChanged();
+}
+
+double QudevDeviceModel::timeToFirstRowMs() const
+{
+    return firstRowNs_ < 0 ? -1.0 : firstRowNs_ / 1e6;
+}
+
+double QudevDeviceModel::maxStallMs() const
+{
+    return maxStallNs_ / 1e6;
 }
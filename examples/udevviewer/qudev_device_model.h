@@ -15,6 +15,9 @@
 #include <QByteArray>
 #include <QString>
 #include <QList>
+#include <QQueue>
+#include <QTimer>
+#include <QElapsedTimer>
 
 #include "qudev_device.h"
 #include "qudev_filters.h"
@@ -46,6 +49,11 @@ class QudevDeviceModel : public QAbstractItemModel
     /// Number of top-level device rows (for convenience in QML).
     Q_PROPERTY(int count READ rowCount NOTIFY countChanged)
 
+    /// Milliseconds from @ref beginPopulation() until the first row was inserted (-1 if none yet).
+    Q_PROPERTY(double timeToFirstRowMs READ timeToFirstRowMs NOTIFY populationStatsChanged)
+    /// Longest single GUI-thread slice spent inserting rows during the last population.
+    Q_PROPERTY(double maxStallMs READ maxStallMs NOTIFY populationStatsChanged)
+
 public:
     /**
      * @brief Node type enumeration used to distinguish items in the tree.
@@ -78,9 +86,49 @@ public:
     /**
      * @brief Triggered by the QudevService when a new device is found.
      *
+     * The device is queued and inserted incrementally, see
+     * @ref appendDevices().
+     *
      * @param d The @ref QudevDevice found
      */
-    Q_INVOKABLE void deviceAdded(const QudevDevice& d);
+    Q_INVOKABLE void deviceAdded(const QudevSharedDevice& d);
+
+    /**
+     * @brief Start a progressive population (e.g. a streamed scan).
+     *
+     * Clears the model and any pending insertions, and resets the
+     * population statistics.
+     */
+    Q_INVOKABLE void beginPopulation();
+
+    /**
+     * @brief Queue @p list for incremental insertion.
+     *
+     * Rows are inserted from the event loop in slices bounded by
+     * @ref frameBudget(), so a large scan never blocks the GUI thread
+     * for longer than roughly one slice.
+     *
+     * Only the handles are queued; the devices themselves are shared, not
+     * copied.
+     *
+     * @param list Devices to append.
+     */
+    Q_INVOKABLE void appendDevices(const QList<QudevSharedDevice>& list);
+
+    /**
+     * @brief Mark the end of a progressive population.
+     *
+     * Statistics are reported once the remaining queue has been drained.
+     */
+    Q_INVOKABLE void endPopulation();
+
+    /// Time budget of a single insertion slice, in milliseconds.
+    int frameBudget() const { return frameBudgetMs_; }
+    /// Set the time budget of a single insertion slice, in milliseconds.
+    void setFrameBudget(int msecs) { frameBudgetMs_ = qMax(1, msecs); }
+
+    double timeToFirstRowMs() const;
+    double maxStallMs() const;
 
     /**
      * @brief Clear all devices from the model.
@@ -100,6 +148,7 @@ public:
 signals:
     void selectionChanged();
     void countChanged();
+    void populationStatsChanged();
 
 public:
     /**
@@ -113,7 +162,7 @@ public:
         QString  display;
         QString  key;
         QString  value;
-        QudevDevice device;
+        QudevSharedDevice device;
         Node* parent = nullptr;
         QVector<Node*> children;
         ~Node() { qDeleteAll(children); }
@@ -126,7 +175,9 @@ public:
     Node* makeRoot();
     void  rebuild(const QList<QudevDevice>& list);
     Node* addSubsystem(const QString& name);
-    Node* addDevice(Node* subsystem, const QudevDevice& d);
+    Node* makeSubsystem(const QString& name);
+    Node* addDevice(Node* subsystem, const QudevSharedDevice& d);
+    Node* makeDevice(Node* subsystem, const QudevSharedDevice& d);
     void  addSections(Node* device, const QudevDevice& d);
     Node* addOverview(Node* device, const QudevDevice& d);
     void  addKVSection(Node* device, const QString& title, const QMap<QString,QString>& map);
@@ -135,5 +186,23 @@ public:
     Node* nodeFromIndex(const QModelIndex& idx) const;
     QModelIndex indexFromNode(Node* n, int column=0) const;
 
+    /// Insert as many queued devices as fit into one frame budget.
+    void drainPending();
+    void resetPending();
+    void reportPopulation();
+
     mutable QModelIndex currentSelection_;
+
+    /// Subsystem name → subsystem node, for O(1) lookups while inserting.
+    QHash<QString, Node*> subsystems_;
+
+    /// Devices waiting to be inserted by @ref drainPending().
+    QQueue<QudevSharedDevice> pending_;
+    QTimer insertTimer_;
+    int frameBudgetMs_ = 4;
+
+    QElapsedTimer populationClock_;
+    bool populationEnded_ = false;
+    qint64 firstRowNs_ = -1;
+    qint64 maxStallNs_ = 0;
 };
@@ -29,14 +29,14 @@ void QudevDeviceSearchModel::setFilterText(const QString& text)
         return;
 
     filterText_ = text;
-    filterTextLower_ = filterText_.toLower();
+    matcher_.setPattern(filterText_);
     emit filterTextChanged();
     invalidateFilter();
 }
 
 bool QudevDeviceSearchModel::filterAcceptsRow(int sourceRow, const QModelIndex& sourceParent) const
 {
-    if (filterTextLower_.isEmpty()) {
+    if (matcher_.isEmpty()) {
         return true;
     }
 
@@ -130,5 +130,5 @@ bool QudevDeviceSearchModel::indexMatches(const QModelIndex& index) const
         return false;
     }
 
-    return s.toLower().contains(filterTextLower_);
+    return matcher_.matches(s);
 }
@@ -11,6 +11,8 @@
 #include <QSortFilterProxyModel>
 #include <QString>
 
+#include <qudev_text_match.h>
+
 
 /**
  * @file qudev_device_search_model.h
@@ -104,5 +106,5 @@ private:
     bool indexMatches(const QModelIndex& index) const;
 
     QString filterText_;
-    QString filterTextLower_;
+    QudevTextMatcher matcher_;
 };
@@ -14,13 +14,30 @@
 #include <QJsonObject>
 
 
+namespace {
+// Long enough to swallow a burst of edits, short enough that a crash
+// right after editing rarely loses anything.
+constexpr int SaveDebounceMs = 500;
+}
+
 QudevFiltersModel::QudevFiltersModel(QObject* parent)
     : QObject(parent),
     settings_()
 {
+    writer_.setMaxThreadCount(1);
+
+    saveTimer_.setSingleShot(true);
+    saveTimer_.setInterval(SaveDebounceMs);
+    connect(&saveTimer_, &QTimer::timeout, this, &QudevFiltersModel::saveSettings);
+
     loadSettings();
 }
 
+QudevFiltersModel::~QudevFiltersModel()
+{
+    flush();
+}
+
 QVariantMap QudevFiltersModel::value() const
 {
     return map_;
@@ -32,8 +49,7 @@ void QudevFiltersModel::setValue(const QVariantMap& map)
         return;
     }
 
-    map_ = map;
-    saveSettings();
+    updateMap(map);
 
     emit changed();
 
@@ -45,13 +61,24 @@ void QudevFiltersModel::clearValue()
         return;
     }
 
-    map_.clear();
-    saveSettings();
+    updateMap({});
 
     emit changed();
 }
 
-QudevFilters QudevFiltersModel::toQudevFilters() const
+void QudevFiltersModel::updateMap(const QVariantMap& map)
+{
+    map_ = map;
+    filters_ = fromMap(map_);
+    saveTimer_.start();
+}
+
+const QudevFilters& QudevFiltersModel::toQudevFilters() const
+{
+    return filters_;
+}
+
+QudevFilters QudevFiltersModel::fromMap(const QVariantMap& map)
 {
     auto toHash = [](const QVariant& value)
     {
@@ -68,16 +95,16 @@ QudevFilters QudevFiltersModel::toQudevFilters() const
 
     QudevFilters f;
 
-    f.subsystem     = map_.value("subsystem").toString();
-    f.devtype       = map_.value("devtype").toString();
-    f.sysname       = map_.value("sysname").toString();
-    f.devnode       = map_.value("devnode").toString();
-    f.syspathPrefix = map_.value("syspathPrefix").toString();
-    f.actions       = map_.value("actions").toStringList();
-    f.tags          = map_.value("tags").toStringList();
-    f.properties      = toHash(map_.value("properties"));
-    f.sysattrs        = toHash(map_.value("sysattrs"));
-    f.nomatchSysattrs = toHash(map_.value("nomatchSysattrs"));
+    f.subsystem     = map.value("subsystem").toString();
+    f.devtype       = map.value("devtype").toString();
+    f.sysname       = map.value("sysname").toString();
+    f.devnode       = map.value("devnode").toString();
+    f.syspathPrefix = map.value("syspathPrefix").toString();
+    f.actions       = map.value("actions").toStringList();
+    f.tags          = map.value("tags").toStringList();
+    f.properties      = toHash(map.value("properties"));
+    f.sysattrs        = toHash(map.value("sysattrs"));
+    f.nomatchSysattrs = toHash(map.value("nomatchSysattrs"));
 
     return f;
 }
@@ -85,26 +112,52 @@ QudevFilters QudevFiltersModel::toQudevFilters() const
 void QudevFiltersModel::loadSettings()
 {
     const QString json = settings_.value(settingsKey_).toString();
+    lastSaved_ = json.toUtf8();
+
     if (json.isEmpty()) {
         map_.clear();
+        filters_ = {};
         emit changed();
         return;
     }
 
-    const QJsonDocument doc = QJsonDocument::fromJson(json.toUtf8());
+    const QJsonDocument doc = QJsonDocument::fromJson(lastSaved_);
     if (!doc.isObject()) {
         map_.clear();
+        filters_ = {};
         emit changed();
         return;
     }
 
     map_ = doc.object().toVariantMap();
+    filters_ = fromMap(map_);
     emit changed();
 }
 
-void QudevFiltersModel::saveSettings() const
+void QudevFiltersModel::saveSettings()
+{
+    saveTimer_.stop();
+
+    const QByteArray json = QJsonDocument::fromVariant(map_).toJson(QJsonDocument::Compact);
+    if (json == lastSaved_) {
+        return;
+    }
+    lastSaved_ = json;
+
+    // QSettings is reentrant; the writer uses its own instance, and the
+    // single-thread pool keeps writes in order.
+    writer_.start([key = settingsKey_, json]() {
+        QSettings settings;
+        settings.setValue(key, QString::fromUtf8(json));
+        settings.sync();
+    });
+}
+
+void QudevFiltersModel::flush()
 {
-    const QJsonDocument doc = QJsonDocument::fromVariant(map_);
-    settings_.setValue(settingsKey_, QString::fromUtf8(doc.toJson(QJsonDocument::Compact)));
-    settings_.sync();
+    if (saveTimer_.isActive()) {
+        saveSettings();
+    }
+
+    writer_.waitForDone();
 }
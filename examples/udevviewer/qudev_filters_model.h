@@ -11,6 +11,9 @@
 #include <QObject>
 #include <QVariant>
 #include <QSettings>
+#include <QTimer>
+#include <QThreadPool>
+#include <QByteArray>
 
 #include "qudev_filters.h"
 
@@ -27,6 +30,11 @@
  * can be bound to from QML (e.g. the FiltersDrawer). It also provides
  * load/save helpers backed by QSettings so that filter configuration can
  * persist across application runs.
+ *
+ * Edits are persisted lazily: every change restarts a short debounce
+ * timer, and when it fires the serialized configuration is written by a
+ * single background writer thread, unless it is byte-identical to what
+ * was last written. Pending writes are flushed on destruction.
  */
 class QudevFiltersModel : public QObject
 {
@@ -41,6 +49,9 @@ public:
      */
      explicit QudevFiltersModel(QObject* parent = nullptr);
 
+    /// Flushes any pending write and waits for the writer thread.
+    ~QudevFiltersModel() override;
+
     /**
      * @brief Return the current filter configuration as a map.
      *
@@ -53,8 +64,8 @@ public:
     /**
      * @brief Replace the current filter configuration map.
      *
-     * This does not automatically persist the configuration; call
-     * @ref saveSettings() to write it to QSettings.
+     * The configuration is persisted after a short debounce delay; call
+     * @ref flush() to force the write immediately.
      *
      * @param map New configuration.
      */
@@ -76,15 +87,24 @@ public:
 
     /**
      * @brief Save filter settings to QSettings.
+     *
+     * The write itself happens asynchronously on the writer thread and is
+     * skipped if the serialized configuration did not change.
+     */
+    Q_INVOKABLE void saveSettings();
+
+    /**
+     * @brief Write a pending debounced save now and wait until it is on disk.
      */
-    Q_INVOKABLE void saveSettings() const;
+    Q_INVOKABLE void flush();
 
     /**
-     * @brief Convert the current QVariantMap to a QudevFilters instance.
+     * @brief Return the current configuration as a QudevFilters instance.
      *
      * This is used by the service layer to apply filters to the library.
+     * The conversion is cached and only redone when the map changes.
      */
-    QudevFilters toQudevFilters() const;
+    const QudevFilters& toQudevFilters() const;
 
 signals:
     /**
@@ -93,7 +113,19 @@ signals:
     void changed();
 
 private:
+    /// Apply a new map: refresh the cached filters and schedule a save.
+    void updateMap(const QVariantMap& map);
+    static QudevFilters fromMap(const QVariantMap& map);
+
     QVariantMap map_;
-    mutable QSettings settings_;
+    QudevFilters filters_;
+    QSettings settings_;
     QString settingsKey_ = QStringLiteral("qudev/filters");
+
+    /// Debounces saves triggered by rapid edits.
+    QTimer saveTimer_;
+    /// Single-threaded pool serializing QSettings writes off the GUI thread.
+    QThreadPool writer_;
+    /// Last serialized configuration handed to (or read from) QSettings.
+    QByteArray lastSaved_;
 };
@@ -10,17 +10,25 @@
 #include <QVariant>
 #include <QHash>
 #include <QThread>
+#include <QDebug>
+#include <atomic>
 
 
 // Private worker that lives entirely in a dedicated QThread
 // and owns the single Qudev instance.
+//
+// Scans are tagged with a generation number. The service bumps the shared
+// generation whenever a newer scan supersedes the current one, which makes
+// queued stale requests no-ops and aborts a running enumeration at the
+// next chunk boundary.
 class QudevWorker : public QObject
 {
     Q_OBJECT
 
 public:
-    explicit QudevWorker(QObject* parent = nullptr)
-        : QObject(parent)
+    explicit QudevWorker(const std::atomic<quint64>& generation, QObject* parent = nullptr)
+        : QObject(parent),
+        generation_(generation)
     {
         qudev_.setParent(this);
         connect(&qudev_, &Qudev::deviceFound, this, &QudevWorker::deviceFound);
@@ -32,10 +40,30 @@ public slots:
         qudev_.setFilters(filters);
     }
 
-    void scan()
+    void scan(quint64 generation)
     {
-        const QList<QudevDevice> devices = qudev_.enumerate();
-        emit scanFinished(devices);
+        if (generation != generation_.load(std::memory_order_acquire)) {
+            return;
+        }
+
+        qsizetype built = 0;
+        const bool completed = qudev_.enumerate(ScanChunkSize, [&](QList<QudevDevice> chunk) {
+            built += chunk.size();
+            if (generation != generation_.load(std::memory_order_acquire)) {
+                return false;
+            }
+            // The chunk is ours: move each device into its shared handle so
+            // neither the queued emission nor the model copies it again.
+            QList<QudevSharedDevice> shared;
+            shared.reserve(chunk.size());
+            for (QudevDevice& d : chunk) {
+                shared.append(QudevSharedDevice(std::move(d)));
+            }
+            emit scanChunk(generation, shared);
+            return true;
+        });
+
+        emit scanFinished(generation, completed, built);
     }
 
     void startMonitoring()
@@ -51,11 +79,17 @@ public slots:
     }
 
 signals:
-    void scanFinished(const QList<QudevDevice>& devices);
-    void deviceFound(const QudevDevice& device);
+    void scanChunk(quint64 generation, const QList<QudevSharedDevice>& devices);
+    void scanFinished(quint64 generation, bool completed, qsizetype devices);
+    void deviceFound(const QudevSharedDevice& device);
     void monitoringStateChanged(bool active);
 
 private:
+    // Small enough for the first rows to show up quickly, large enough to
+    // keep the number of queued cross-thread emissions low.
+    static constexpr qsizetype ScanChunkSize = 64;
+
+    const std::atomic<quint64>& generation_;
     Qudev qudev_;
 };
 
@@ -64,7 +98,7 @@ QudevService::QudevService(QObject* parent)
     : QObject(parent)
 {
     workerThread_ = new QThread(this);
-    worker_       = new QudevWorker;
+    worker_       = new QudevWorker(scanGeneration_);
     worker_->moveToThread(workerThread_);
 
 
@@ -76,6 +110,7 @@ QudevService::QudevService(QObject* parent)
     connect(this, &QudevService::requestStopMonitoring,  worker_, &QudevWorker::stopMonitoring);
     connect(this, &QudevService::filtersChanged,         worker_, &QudevWorker::setFilters);
 
+    connect(worker_, &QudevWorker::scanChunk,              this, &QudevService::onScanChunk);
     connect(worker_, &QudevWorker::scanFinished,           this, &QudevService::onScanFinished);
     connect(worker_, &QudevWorker::deviceFound,            this, &QudevService::deviceFound);
     connect(worker_, &QudevWorker::monitoringStateChanged, this, &QudevService::onMonitoringStateChanged);
@@ -84,31 +119,69 @@ QudevService::QudevService(QObject* parent)
 QudevService::~QudevService()
 {
     if (workerThread_) {
+        // Abort a running scan so that shutdown does not wait for it.
+        scanGeneration_.fetch_add(1, std::memory_order_release);
         workerThread_->quit();
         workerThread_->wait();
     }
 }
 
-// Async scan
+// Async scan, latest request wins
 bool QudevService::scan()
 {
-    if (!worker_ || scanning_)
+    if (!worker_)
         return false;
 
-    scanning_ = true;
-    emit scanningChanged();
+    ++scanStats_.requested;
+
+    // Supersedes any running or still queued scan.
+    const quint64 generation = scanGeneration_.fetch_add(1, std::memory_order_release) + 1;
+
+    if (!scanning_) {
+        scanning_ = true;
+        emit scanningChanged();
+    }
+    emit scanStarted();
 
-    emit requestScan();
+    emit requestScan(generation);
 
     return true;
 }
 
-void QudevService::onScanFinished(const QList<QudevDevice>& devices)
+void QudevService::onScanChunk(quint64 generation, const QList<QudevSharedDevice>& devices)
+{
+    if (generation != scanGeneration_.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    emit scanChunk(devices);
+}
+
+void QudevService::onScanFinished(quint64 generation, bool completed, qsizetype devices)
 {
+    ++scanStats_.run;
+
+    // Superseded while running; a newer scan is already queued.
+    if (generation != scanGeneration_.load(std::memory_order_acquire)) {
+        ++scanStats_.cancelled;
+        scanStats_.devicesWasted += devices;
+        return;
+    }
+
+    if (!completed) {
+        qWarning() << "[QudevService] Scan failed";
+    }
+
+    scanStats_.devicesDelivered += devices;
     scanning_ = false;
 
     emit scanningChanged();
-    emit scanFinished(devices);
+    emit scanFinished();
+}
+
+QudevService::ScanStats QudevService::scanStats() const
+{
+    return scanStats_;
 }
 
 bool QudevService::scanning() const
@@ -157,8 +230,16 @@ QudevFilters QudevService::filters() const
 
 void QudevService::setFilters(const QudevFilters &filters)
 {
+    if (filters == filters_)
+        return;
+
     filters_ = filters;
     emit filtersChanged(filters_);
+
+    // Results of an in-flight scan are stale now; restart it with the new
+    // filters. The worker applies them to an active monitor in place.
+    if (scanning_)
+        scan();
 }
 
 #include "qudev_service.moc"
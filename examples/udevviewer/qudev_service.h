@@ -10,6 +10,7 @@
 
 #include <QObject>
 #include <QList>
+#include <atomic>
 
 #include <qudev.h>
 #include <qudev_device.h>
@@ -31,6 +32,10 @@ class QudevWorker;
  *  - Exposes a QML-friendly API (@ref scan(), @ref startMonitoring,
  *    @ref stopMonitoring()).
  *  - Manages @ref QudevFilters based on data provided by the UI.
+ *
+ * Scan requests follow latest-wins semantics: calling @ref scan() or
+ * changing filters while a scan is running cancels it, and requests that
+ * pile up while the worker is busy collapse into a single scan.
  */
 class QudevService : public QObject
 {
@@ -40,6 +45,26 @@ class QudevService : public QObject
     Q_PROPERTY(bool monitoring READ monitoring NOTIFY monitoringChanged)
 
 public:
+    /**
+     * @brief Counters describing how much scan work was requested and wasted.
+     */
+    struct ScanStats
+    {
+        /// Number of @ref scan() requests (including filter-triggered restarts).
+        quint64 requested = 0;
+        /// Number of scans the worker actually started.
+        quint64 run = 0;
+        /// Started scans that were cancelled or superseded before delivery.
+        quint64 cancelled = 0;
+        /// Devices built by scans whose results reached the UI.
+        quint64 devicesDelivered = 0;
+        /// Devices built by cancelled or superseded scans.
+        quint64 devicesWasted = 0;
+
+        /// Requests that never ran because a newer one replaced them.
+        quint64 coalesced() const { return requested - run; }
+    };
+
     explicit QudevService(QObject* parent = nullptr);
     ~QudevService() override;
 
@@ -54,20 +79,29 @@ public:
     QudevFilters filters() const;
     void setFilters(const QudevFilters& filters);
 
+    /// Snapshot of the scan bookkeeping since construction.
+    ScanStats scanStats() const;
+
 signals:
-    void scanFinished(QList<QudevDevice> devices);
-    void deviceFound(const QudevDevice& device);
+    /// Emitted right before a scan is handed to the worker thread.
+    void scanStarted();
+    /// Emitted for every chunk of devices streamed by a running scan.
+    void scanChunk(const QList<QudevSharedDevice>& devices);
+    /// Emitted after the last chunk of a scan has been delivered.
+    void scanFinished();
+    void deviceFound(const QudevSharedDevice& device);
 
     void scanningChanged();
     void monitoringChanged();
     
-    void requestScan();
+    void requestScan(quint64 generation);
     void requestStartMonitoring();
     void requestStopMonitoring();
     void filtersChanged(const QudevFilters& filters);
 
 private slots:
-    void onScanFinished(const QList<QudevDevice> &devices);
+    void onScanChunk(quint64 generation, const QList<QudevSharedDevice>& devices);
+    void onScanFinished(quint64 generation, bool completed, qsizetype devices);
     void onMonitoringStateChanged(bool active);
 
 private:
@@ -76,5 +110,9 @@ private:
     QudevFilters  filters_;
     bool          scanning_     = false;
     bool          monitoring_   = false;
+    ScanStats     scanStats_;
+
+    /// Generation of the most recent scan request, shared with the worker.
+    std::atomic<quint64> scanGeneration_{0};
 
 };
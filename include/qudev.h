@@ -8,12 +8,23 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
+#include <optional>
 #include <QObject>
+#include <QList>
 
 #include "qudev_filters.h"
+#include "qudev_stats.h"
+#include "qudev_sysattr_policy.h"
 
 class QudevDevice;
+class QudevSharedDevice;
+class QudevQuery;
+class QudevMonitorHub;
+struct QudevPriorityLanes;
+class QudevBackend;
+class QudevStatsCollector;
 
 /**
  * @file qudev.h
@@ -23,7 +34,7 @@ class QudevDevice;
  *
  *  - Synchronous device enumeration via @ref Qudev::enumerate().
  *  - Event-based monitoring of device changes via @ref Qudev::startMonitoring()
- *    and the @ref Qudev::deviceFound(const QudevDevice& device) signal.
+ *    and the @ref Qudev::deviceFound(const QudevSharedDevice& device) signal.
  *
  * The class itself is synchronous and not thread-safe. It must be used
  * from a single thread (typically the GUI thread or a dedicated worker
@@ -43,6 +54,22 @@ class Qudev : public QObject
 {
     Q_OBJECT
 public:
+    /**
+     * @brief Callback receiving one chunk of an incremental enumeration.
+     *
+     * Returning @c false stops the enumeration early.
+     */
+    using ChunkHandler = std::function<bool(QList<QudevDevice> chunk)>;
+
+    /// Where an instance without an explicit backend gets devices from.
+    enum class Source {
+        /// Enumerate and monitor through libudev in this process.
+        Libudev,
+        /// Ask the local broker (@c qudevd, see @ref QudevBrokerBackend);
+        /// falls back to libudev if no broker is reachable.
+        Broker
+    };
+
     /**
      * @brief Construct a new Qudev instance.
      *
@@ -50,7 +77,30 @@ public:
      */
     explicit Qudev(QObject* parent = nullptr);
 
-    /// Destructor. Ensures the underlying libudev context is released.
+    /**
+     * @brief Construct a Qudev instance getting devices from @p source.
+     *
+     * With @ref Source::Broker, many processes share one broker's scan
+     * and monitor instead of each reading sysfs and netlink themselves.
+     *
+     * @param source Device source.
+     * @param parent Optional QObject parent.
+     */
+    explicit Qudev(Source source, QObject* parent = nullptr);
+
+    /**
+     * @brief Construct a Qudev instance on top of a specific backend.
+     *
+     * Use this to run against something other than libudev, e.g. a
+     * @ref QudevMemoryBackend with synthetic devices for tests and load
+     * generation.
+     *
+     * @param backend Backend to use; must not be @c nullptr.
+     * @param parent  Optional QObject parent.
+     */
+    explicit Qudev(std::unique_ptr<QudevBackend> backend, QObject* parent = nullptr);
+
+    /// Destructor. Ensures the underlying backend (libudev context) is released.
     ~Qudev() override;
 
     /**
@@ -64,6 +114,45 @@ public:
      */
     QList<QudevDevice> enumerate();
 
+    /**
+     * @brief Enumerate devices matching the current filters in chunks.
+     *
+     * Devices are handed to @p onChunk in groups of at most @p chunkSize
+     * as soon as they are built, so callers can start presenting results
+     * before the whole snapshot is available. The call still blocks until
+     * the enumeration completes; @p onChunk runs on the calling thread.
+     *
+     * @param chunkSize Maximum number of devices per chunk (at least 1).
+     * @param onChunk   Callback receiving each chunk.
+     * @return @c true if the enumeration ran to completion; @c false if it
+     *         failed or @p onChunk requested to stop.
+     */
+    bool enumerate(qsizetype chunkSize, const ChunkHandler& onChunk);
+
+    /**
+     * @brief Enumerate devices for several filter sets in one pass.
+     *
+     * Equivalent to setting each of @p filterSets and calling
+     * @ref enumerate() in turn, at roughly the cost of one scan: the
+     * backend enumerates once with the criteria all sets share, builds each
+     * device once and hands it to every set it matches. The current
+     * filters are neither used nor changed.
+     *
+     * @param filterSets Filter sets to enumerate.
+     * @return One list per filter set, in the same order. A device matched
+     *         by several sets is shared between their lists.
+     */
+    QList<QList<QudevSharedDevice>> enumerate(const QList<QudevFilters>& filterSets);
+
+    /**
+     * @brief Enumerate devices for several queries in one pass.
+     *
+     * As @ref enumerate(const QList<QudevFilters>&), with the pushed-down
+     * filters of each @ref QudevQuery and its residual checked per device.
+     * An invalid query gets an empty list.
+     */
+    QList<QList<QudevSharedDevice>> enumerate(const QList<QudevQuery>& queries);
+
     /**
      * @brief Start monitoring for udev events.
      *
@@ -75,6 +164,21 @@ public:
      */
     bool startMonitoring();
 
+    /**
+     * @brief Start monitoring, first catching up on the events after @p seqnum.
+     *
+     * Pass the @ref QudevDevice::seqnum of the last event seen before
+     * monitoring stopped or the process restarted. Events after it that
+     * match the current filters are emitted through @ref deviceFound()
+     * before live ones, if the source still has them: a broker keeps a
+     * @ref QudevJournal of recent events. Otherwise @ref rescanRequired()
+     * is emitted before this function returns, and monitoring continues
+     * with live events.
+     *
+     * @return @c true on success, @c false if monitoring could not be started.
+     */
+    bool resumeMonitoring(quint64 seqnum);
+
     /**
      * @brief Stop monitoring for udev events.
      *
@@ -89,7 +193,8 @@ public:
      *
      * Existing filters are replaced by @p filters. Subsequent calls to
      * @ref enumerate() and @ref startMonitoring() will use the new
-     * configuration.
+     * configuration. If monitoring is active, the running monitor is
+     * switched to the new filters in place without reopening its socket.
      *
      * @param filters New filter set to apply.
      */
@@ -110,18 +215,174 @@ public:
      */
     void clearFilters();
 
+    /**
+     * @brief Set a textual query to apply when enumerating and monitoring.
+     *
+     * The query may combine criteria with OR and NOT and use glob patterns;
+     * see @ref QudevQuery for the syntax. Its conjunctive part replaces the
+     * filters and is matched by libudev; the rest is evaluated on built
+     * devices before they are returned or emitted. A later
+     * @ref setFilters() discards the query.
+     *
+     * @param query Query text; an empty query matches all devices.
+     * @return @c false, leaving the configuration unchanged, if @p query
+     *         does not parse.
+     */
+    bool setQuery(const QString& query);
+
+    /// The text of the query set by @ref setQuery(), or an empty string.
+    QString query() const;
+
+    /**
+     * @brief Record monitor traffic to the event log at @p path.
+     *
+     * Every event received while monitoring is appended to the log, before
+     * filtering, so the log can later be replayed with a
+     * @ref QudevReplayBackend under any filter set. Recording applies to the
+     * current and any later monitor until @ref stopRecording().
+     *
+     * @return @c true if the log could be created.
+     */
+    bool startRecording(const QString& path);
+
+    /// Stop recording and close the event log.
+    void stopRecording();
+
+    /// Whether monitor traffic is being recorded.
+    bool isRecording() const;
+
+    /**
+     * @brief Snapshot of the counters and timings collected so far.
+     *
+     * Collection is always on; counters are relaxed atomics, so taking a
+     * snapshot is cheap and safe from any thread.
+     */
+    QudevStats stats() const;
+
+    /**
+     * @brief Emit @ref statsUpdated() every @p msec milliseconds.
+     *
+     * @param msec Interval in milliseconds; 0 (the default) disables the
+     *             periodic signal.
+     */
+    void setStatsInterval(int msec);
+
+    /// Interval of @ref statsUpdated() in milliseconds, or 0 if disabled.
+    int statsInterval() const;
+
+    /**
+     * @brief Pipeline timestamps of the event being delivered.
+     *
+     * Valid inside slots directly connected to @ref deviceFound(); the same
+     * values feed the end-to-end latency histograms of @ref stats().
+     */
+    const QudevEventTiming& eventTiming() const;
+
+    /**
+     * @brief Also measure kernel → udevd latency.
+     *
+     * Opens an additional kernel-channel monitor whose uevents are matched
+     * to udev events by seqnum. Off by default; applies to the running and
+     * any later monitor.
+     */
+    void setKernelLatencyTracking(bool enabled);
+
+    /// Whether kernel → udevd latency is measured.
+    bool kernelLatencyTracking() const;
+
+    /**
+     * @brief Monitor through @p hub instead of a monitor of our own.
+     *
+     * Many instances in one process then share a single event stream,
+     * built once per event; see @ref QudevMonitorHub. Filters and queries
+     * apply as before. Recording, kernel latency tracking, priority lanes
+     * and @ref eventTiming() need a monitor of the instance's own, and
+     * @ref resumeMonitoring() always emits @ref rescanRequired(). Takes
+     * effect immediately if monitoring; pass @c nullptr to go back.
+     *
+     * @param hub Hub to subscribe to; not owned, and may be destroyed first.
+     */
+    void setMonitorHub(QudevMonitorHub* hub);
+
+    /// The hub set with @ref setMonitorHub(), or @c nullptr.
+    QudevMonitorHub* monitorHub() const;
+
+    /**
+     * @brief Deliver urgent events first.
+     *
+     * With @p lanes enabled the monitor reads all pending events off its
+     * socket before each emission and emits the most urgent one; see
+     * @ref QudevPriorityLanes, and @ref QudevPriorityLanes::defaults() for
+     * a starting point. Events of one device keep their order. Applies to
+     * the running and any later monitor of the instance's own, not to a
+     * @ref setMonitorHub() subscription. Disabled by default.
+     */
+    void setPriorityLanes(const QudevPriorityLanes& lanes);
+
+    /// The lanes set with @ref setPriorityLanes().
+    const QudevPriorityLanes& priorityLanes() const;
+
+    /**
+     * @brief Configure the sysfs attribute value cache.
+     *
+     * Static attributes (see @ref QudevSysattrPolicy::defaults(), the
+     * initial policy) are read once per device lifetime instead of on
+     * every scan and change event. Replacing the policy drops all cached
+     * values.
+     */
+    void setSysattrPolicy(const QudevSysattrPolicy& policy);
+
+    /// The sysfs attribute cache policy in effect.
+    const QudevSysattrPolicy& sysattrPolicy() const;
+
+    /**
+     * @brief Choose how sysfs attribute values missing from the cache are read.
+     *
+     * @ref QudevSysattrReadMode::Libudev (the default) reads them one
+     * blocking libudev call at a time; the batched modes read all values of
+     * a device, or of a group of enumerated devices, in one submission.
+     */
+    void setSysattrReadMode(QudevSysattrReadMode mode);
+
+    /// The sysfs attribute read mode in effect.
+    QudevSysattrReadMode sysattrReadMode() const;
+
 signals:
     /**
      * @brief Emitted when a matching device event is observed.
      *
+     * The device is shared, so queued connections and receivers that keep
+     * it do not copy it. Slots taking <tt>const QudevDevice&</tt> can be
+     * connected as well.
+     *
      * @param device Device representation for the observed event.
      */
-    void deviceFound(const QudevDevice& device);
+    void deviceFound(const QudevSharedDevice& device);
+
+    /**
+     * @brief Periodic statistics snapshot; see @ref setStatsInterval().
+     *
+     * @param stats Same as returned by @ref stats() at emission time.
+     */
+    void statsUpdated(const QudevStats& stats);
+
+    /**
+     * @brief Events were lost since the seqnum passed to @ref resumeMonitoring().
+     *
+     * Enumerate again to get back in sync.
+     */
+    void rescanRequired();
 
 private:
+    // Attached dispatchers count coalesced events into stats().
+    friend class QudevDispatcher;
+    QudevStatsCollector* statsCollector() const noexcept;
+
     struct Private;
     std::unique_ptr<Private> d_;
 
     QudevFilters filters_;
-    bool ensureContext();
+    bool ensureBackend();
+    bool openMonitor(std::optional<quint64> resumeAfter, bool* complete);
+    bool subscribeHub(std::optional<quint64> resumeAfter, bool* complete);
 };
@@ -0,0 +1,197 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <optional>
+
+#include "qudev_device.h"
+#include "qudev_filters.h"
+#include "qudev_sysattr_policy.h"
+
+class QudevStatsCollector;
+
+/**
+ * @file qudev_backend.h
+ * @brief Device source abstraction used by enumeration and monitoring.
+ *
+ * A backend provides the two primitives the library is built on: a
+ * snapshot of devices, and a pollable stream of device events. The
+ * default backend talks to libudev; alternative backends (for example
+ * @ref QudevMemoryBackend) make it possible to run the library against
+ * synthetic devices.
+ */
+
+/**
+ * @brief Abstract source of devices and device events.
+ *
+ * Backends are used from a single thread, like @ref Qudev itself.
+ */
+class QudevBackend
+{
+public:
+    /**
+     * @brief Callback receiving each device produced by @ref enumerate().
+     *
+     * Returning @c false stops the enumeration early.
+     */
+    using Visitor = std::function<bool(QudevDevice&& device)>;
+
+    /**
+     * @brief Event channel to subscribe to.
+     *
+     * See libudev documentation for details.
+     */
+    enum class MonitorChannel {
+        Kernel,
+        Udev
+    };
+
+    /**
+     * @brief A pollable stream of device events.
+     *
+     * The owner watches @ref fd() for readability and then drains events
+     * with @ref receive() until it returns an empty optional.
+     */
+    class MonitorSource
+    {
+    public:
+        virtual ~MonitorSource() = default;
+
+        /// File descriptor that becomes readable when events are pending.
+        virtual int fd() const noexcept = 0;
+
+        /**
+         * @brief Receive the next pending event, without blocking.
+         *
+         * @return The event's device, or an empty optional if nothing is
+         *         pending.
+         */
+        virtual std::optional<QudevDevice> receive() noexcept = 0;
+
+        /**
+         * @brief Receive the next pending event, keeping only its seqnum.
+         *
+         * Used to correlate a second channel with the first: sources that
+         * can should skip building the device (no sysattr reads) and
+         * record no receive/build statistics. The default uses
+         * @ref receive().
+         *
+         * @return The event's seqnum, or an empty optional if nothing is
+         *         pending.
+         */
+        virtual std::optional<quint64> receiveSeqnum() noexcept
+        {
+            if (std::optional<QudevDevice> device = receive()) {
+                return device->seqnum;
+            }
+            return std::nullopt;
+        }
+
+        /**
+         * @brief Replace the source-side (pre-)filters without reopening it.
+         *
+         * @return @c false if the filters could not be applied.
+         */
+        virtual bool setFilters(const QudevFilters& filters) noexcept = 0;
+
+        /**
+         * @brief Socket arrival time of the event last returned by
+         *        @ref receive().
+         *
+         * @return @c CLOCK_MONOTONIC nanoseconds, or 0 if the source cannot
+         *         tell (the default).
+         */
+        virtual quint64 lastReceiveTimestampNs() const noexcept { return 0; }
+    };
+
+    virtual ~QudevBackend() = default;
+
+    /**
+     * @brief Enumerate devices, applying as much of @p filters as possible.
+     *
+     * Backends must honour every criterion they cannot leave to the
+     * caller: the generic post-filters (@ref QudevFilters::devnode,
+     * @ref QudevFilters::syspathPrefix) are re-applied by the enumerator,
+     * everything else is the backend's responsibility.
+     *
+     * @param filters Filter set to apply.
+     * @param visit   Callback invoked for every device.
+     * @return @c true if the enumeration ran to completion; @c false if it
+     *         failed or @p visit requested to stop.
+     */
+    virtual bool enumerate(const QudevFilters& filters, const Visitor& visit) noexcept = 0;
+
+    /**
+     * @brief Open an event stream with receiving already enabled.
+     *
+     * @p filters are applied at the source as far as the backend supports
+     * it; the monitor re-checks every event with its full post-filter.
+     *
+     * @return The new source, or @c nullptr on failure.
+     */
+    virtual std::unique_ptr<MonitorSource> createMonitor(MonitorChannel channel,
+                                                         const QudevFilters& filters) noexcept = 0;
+
+    /**
+     * @brief Open an event stream that first delivers the events after @p seqnum.
+     *
+     * Backends that keep a journal of recent events (see @ref QudevJournal)
+     * replay the matching ones before live events. @p complete tells whether
+     * nothing after @p seqnum was lost; if it is @c false, the caller must
+     * rescan. The default opens a live stream and reports it incomplete.
+     *
+     * @return The new source, or @c nullptr on failure.
+     */
+    virtual std::unique_ptr<MonitorSource> resumeMonitor(MonitorChannel channel,
+                                                         const QudevFilters& filters,
+                                                         quint64 seqnum, bool* complete) noexcept
+    {
+        Q_UNUSED(seqnum);
+        *complete = false;
+        return createMonitor(channel, filters);
+    }
+
+    /**
+     * @brief Create the default backend backed by libudev.
+     *
+     * @return The backend, or @c nullptr if no libudev context could be
+     *         created.
+     */
+    static std::unique_ptr<QudevBackend> createLibudev() noexcept;
+
+    /**
+     * @brief Attach the statistics collector of the owning @ref Qudev.
+     *
+     * Backends report what only they can observe (receive and build
+     * timings, sysattr reads) to it. @c nullptr detaches.
+     */
+    virtual void setStats(QudevStatsCollector* stats) noexcept { stats_ = stats; }
+
+    /// The attached statistics collector, or @c nullptr.
+    QudevStatsCollector* stats() const noexcept { return stats_; }
+
+    /**
+     * @brief Configure caching of sysfs attribute values.
+     *
+     * Only meaningful for backends that read sysfs; the default ignores it.
+     */
+    virtual void setSysattrPolicy(const QudevSysattrPolicy& policy) { Q_UNUSED(policy); }
+
+    /**
+     * @brief Choose how uncached sysfs attribute values are read.
+     *
+     * Only meaningful for backends that read sysfs; the default ignores it.
+     */
+    virtual void setSysattrReadMode(QudevSysattrReadMode mode) { Q_UNUSED(mode); }
+
+protected:
+    QudevStatsCollector* stats_ = nullptr;
+};
@@ -0,0 +1,158 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#pragma once
+
+#include <QObject>
+#include <QString>
+
+#include <memory>
+
+class Qudev;
+class QudevBackend;
+class QudevJournal;
+
+/**
+ * @file qudev_broker.h
+ * @brief Local broker sharing one device snapshot and monitor with many clients.
+ */
+
+/**
+ * @brief Serves devices and events to @ref QudevBrokerBackend clients.
+ *
+ * The broker enumerates once and monitors once, keeping a live device
+ * list up to date from the event stream. Clients connect over a Unix
+ * domain socket and either request a snapshot of the devices matching
+ * their filters or subscribe to matching events; each event is encoded
+ * once however many clients receive it. This is the engine of the
+ * @c qudevd daemon.
+ *
+ * Clients whose unsent data exceeds @ref maxPendingBytes() are
+ * disconnected rather than buffering without bound.
+ *
+ * Every event is kept in a @ref QudevJournal, so clients that were away
+ * can resume from the last seqnum they saw (@ref Qudev::resumeMonitoring())
+ * instead of rescanning.
+ *
+ * With @ref setSharedSnapshotEnabled(), the live device list is also
+ * published in shared memory for @ref QudevSharedSnapshotReader.
+ *
+ * Access is controlled by the socket file and checked again on accept.
+ * The socket gets @ref socketMode() (default @c 0660) and, if set,
+ * @ref socketGroup(). Each connecting peer is then checked with
+ * @c SO_PEERCRED against the same rules: root and the broker's own user
+ * are always accepted, members of the socket's group (primary or
+ * supplementary) when the mode grants group access, and everyone else
+ * only when it grants access to others. Rejected peers are disconnected
+ * before they can send a request.
+ *
+ * Like @ref Qudev, the broker is used from a single thread.
+ */
+class QudevBroker : public QObject
+{
+    Q_OBJECT
+public:
+    /// Construct a broker on top of libudev.
+    explicit QudevBroker(QObject* parent = nullptr);
+
+    /// Construct a broker on top of @p backend.
+    explicit QudevBroker(std::unique_ptr<QudevBackend> backend, QObject* parent = nullptr);
+
+    /// Disconnects all clients and removes the socket.
+    ~QudevBroker() override;
+
+    /**
+     * @brief Take the initial snapshot, start monitoring and listen on @p path.
+     *
+     * A stale socket file left by a previous broker is replaced; a live
+     * one is not.
+     *
+     * @return @c false with @ref errorString() set on failure.
+     */
+    bool listen(const QString& path);
+
+    /// Disconnect all clients, stop monitoring and remove the socket.
+    void close();
+
+    /// Permission bits of the socket file; default @c 0660.
+    uint socketMode() const noexcept;
+
+    /// Set the permission bits applied by the next @ref listen().
+    void setSocketMode(uint mode) noexcept;
+
+    /// Group owning the socket file; empty keeps the broker's group.
+    QString socketGroup() const;
+
+    /**
+     * @brief Set the group, by name or number, applied by the next @ref listen().
+     *
+     * @ref listen() fails if the group does not exist or cannot be set.
+     */
+    void setSocketGroup(const QString& group);
+
+    /// Whether the broker is listening.
+    bool isListening() const noexcept;
+
+    /// Path passed to @ref listen().
+    QString socketPath() const;
+
+    /// Why @ref listen() failed.
+    QString errorString() const;
+
+    /// The underlying @ref Qudev, e.g. for statistics or sysattr settings.
+    Qudev& qudev() noexcept;
+
+    /// Connected clients.
+    qsizetype clientCount() const noexcept;
+
+    /// Devices in the live snapshot.
+    qsizetype deviceCount() const noexcept;
+
+    /// Events written to clients so far, counting each client separately.
+    quint64 eventsForwarded() const noexcept;
+
+    /// Per-client limit of unsent bytes; default 64 MiB.
+    qsizetype maxPendingBytes() const noexcept;
+
+    /// Set the per-client limit of unsent bytes.
+    void setMaxPendingBytes(qsizetype bytes) noexcept;
+
+    /**
+     * @brief Publish the live device list in shared memory.
+     *
+     * Clients map it with @ref QudevSharedSnapshotReader::fromBroker() and
+     * then read devices without talking to the broker again. Changes are
+     * coalesced and published at most every 10 ms. Off by default.
+     *
+     * @return @c false with @ref errorString() set if the shared memory
+     *         region cannot be created.
+     */
+    bool setSharedSnapshotEnabled(bool enabled);
+
+    /// Whether the live device list is published in shared memory.
+    bool sharedSnapshotEnabled() const noexcept;
+
+    /**
+     * @brief Journal of recent events served to resuming subscribers.
+     *
+     * In memory by default; use @ref QudevJournal::openFile() to keep it
+     * across broker restarts.
+     */
+    QudevJournal& journal() noexcept;
+
+    /// Replace the journal by an empty in-memory one of @p bytes.
+    void setJournalCapacity(qsizetype bytes);
+
+signals:
+    /// Emitted when a client connects or disconnects.
+    void clientCountChanged(qsizetype count);
+
+private:
+    struct Private;
+    std::unique_ptr<Private> d_;
+};
@@ -0,0 +1,76 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#pragma once
+
+#include <QString>
+
+#include "qudev_backend.h"
+
+/**
+ * @file qudev_broker_backend.h
+ * @brief @ref QudevBackend served by a @ref QudevBroker (qudevd).
+ */
+
+/**
+ * @brief Backend that asks a local broker instead of libudev.
+ *
+ * Enumeration requests a snapshot of the broker's live device list, so
+ * no sysfs attribute is read in this process; each monitor is one
+ * subscription on its own connection. Filters are evaluated by the
+ * broker and again by the regular post-filters. A monitor that loses its
+ * broker keeps retrying with backoff (100 ms doubling up to 5 s) and
+ * resumes after the last event it delivered once the broker is back.
+ *
+ * Only the udev channel is served: kernel-channel monitors (used for
+ * kernel latency tracking) fail. Sysattr caching and read mode are the
+ * broker's, so the corresponding setters have no effect.
+ *
+ * Usually selected with <tt>Qudev(Qudev::Source::Broker)</tt>.
+ */
+class QudevBrokerBackend final : public QudevBackend
+{
+public:
+    /**
+     * @brief Construct a backend talking to the broker at @p socketPath.
+     *
+     * No connection is made until the first request.
+     */
+    explicit QudevBrokerBackend(const QString& socketPath = defaultSocketPath());
+
+    ~QudevBrokerBackend() override;
+
+    /// @c $QUDEV_BROKER_SOCKET if set, else @c /run/qudev/qudevd.sock.
+    static QString defaultSocketPath();
+
+    /// Path of the broker socket.
+    QString socketPath() const;
+
+    /// Whether a broker accepts connections at @ref socketPath().
+    bool isReachable() const noexcept;
+
+    /// Time to wait for an enumeration snapshot or resume verdict, in milliseconds.
+    void setTimeout(int msec) noexcept;
+
+    bool enumerate(const QudevFilters& filters, const Visitor& visit) noexcept override;
+
+    std::unique_ptr<MonitorSource> createMonitor(MonitorChannel channel,
+                                                 const QudevFilters& filters) noexcept override;
+
+    /// Replays the broker's journal after @p seqnum; see @ref QudevBroker::journal().
+    std::unique_ptr<MonitorSource> resumeMonitor(MonitorChannel channel, const QudevFilters& filters,
+                                                 quint64 seqnum, bool* complete) noexcept override;
+
+private:
+    bool request(const QudevFilters& filters, QByteArray* snapshot) noexcept;
+    void disconnect() noexcept;
+
+    QString socketPath_;
+    int controlFd_ = -1;
+    int timeoutMs_ = 10000;
+};
@@ -15,6 +15,8 @@
 #include <QVariantMap>
 #include <QMetaType>
 
+#include <memory>
+
 struct udev_device;
 class QudevContext;
 
@@ -32,7 +34,8 @@ class QudevContext;
  *
  * All fields are public for convenience. The struct is intentionally
  * lightweight and trivially copyable. It is safe to store in containers,
- * emit through signals, or expose to QML.
+ * emit through signals, or expose to QML. Copies touch every field; use
+ * @ref QudevSharedDevice where devices are passed around a lot.
  */
 struct QudevDevice
 {
@@ -83,6 +86,55 @@ public:
 };
 Q_DECLARE_METATYPE(QudevDevice)
 
+/**
+ * @brief Immutable, implicitly shared @ref QudevDevice.
+ *
+ * Copying is a reference count bump, so devices can be queued across
+ * threads, stored in models and emitted to many receivers without copying
+ * their strings and maps. Sharing a moved-from device is implicit, sharing
+ * a copy must be spelled out. Converts implicitly to <tt>const QudevDevice&</tt>:
+ * slots and functions taking a @ref QudevDevice keep working, and fields
+ * are read through @c -> or after conversion. A @c QVariant holding one
+ * also converts to @ref QudevDevice (see @ref registerMetaType()).
+ *
+ * A default-constructed instance refers to an empty device.
+ */
+class QudevSharedDevice
+{
+public:
+    QudevSharedDevice() noexcept = default;
+
+    /// Share @p device, moving its contents.
+    QudevSharedDevice(QudevDevice&& device)
+        : d_(std::make_shared<const QudevDevice>(std::move(device)))
+    {}
+
+    /// Share a copy of @p device; explicit, as it copies every string and map.
+    explicit QudevSharedDevice(const QudevDevice& device)
+        : d_(std::make_shared<const QudevDevice>(device))
+    {}
+
+    /// The shared device.
+    const QudevDevice& get() const noexcept { return d_ ? *d_ : empty(); }
+
+    /// The shared device, without a copy; binding it to a @ref QudevDevice by value copies.
+    operator const QudevDevice&() const noexcept { return get(); }
+    const QudevDevice& operator*() const noexcept { return get(); }
+    const QudevDevice* operator->() const noexcept { return &get(); }
+
+    /// Whether this refers to the empty device.
+    bool isNull() const noexcept { return !d_; }
+
+    /// Register the metatype and its conversion to @ref QudevDevice.
+    static void registerMetaType();
+
+private:
+    static const QudevDevice& empty() noexcept;
+
+    std::shared_ptr<const QudevDevice> d_;
+};
+Q_DECLARE_METATYPE(QudevSharedDevice)
+
 /**
  * @brief Build a QudevDevice from a raw libudev handle.
  *
@@ -95,3 +147,17 @@ Q_DECLARE_METATYPE(QudevDevice)
  */
 QudevDevice buildDevice(const QudevContext& ctx, udev_device* d);
 
+/**
+ * @brief Build several devices, reading their sysattrs in one batch.
+ *
+ * Equivalent to calling @ref buildDevice() for each handle, but when the
+ * context has a bulk sysattr reader all values missing from the cache are
+ * read with a single submission.
+ *
+ * @param ctx     Associated libudev context.
+ * @param devices Raw @c udev_device pointers (not owning).
+ * @param count   Number of entries in @p devices.
+ * @return One QudevDevice per handle, in order.
+ */
+QList<QudevDevice> buildDevices(const QudevContext& ctx, udev_device* const* devices, qsizetype count);
+
@@ -0,0 +1,160 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#pragma once
+
+#include <QObject>
+#include <QString>
+
+#include <functional>
+#include <memory>
+
+class Qudev;
+class QudevSharedDevice;
+
+/**
+ * @file qudev_dispatcher.h
+ * @brief Parallel event delivery, sharded by device subtree.
+ */
+
+/**
+ * @brief Delivers events to a handler on a pool of workers, in order per device.
+ *
+ * @ref Qudev emits @ref Qudev::deviceFound() serially on its thread, so a
+ * handler that mounts or probes delays every later event. A dispatcher
+ * queues events instead and runs the handler on worker threads.
+ *
+ * Each worker owns one queue. Events go to the queue chosen by a hash of
+ * their syspath cut after @ref Options::subtreeDepth components below
+ * @c /sys/devices, so all events of a device, and of the devices under
+ * the same ancestor at that depth, run on one worker in the order they
+ * were posted. Independent subtrees proceed in parallel. Ordering between
+ * a device and its descendants holds for devices at least that deep; a
+ * @c move keeps it when only the last path component changes.
+ *
+ * Queues are bounded by @ref Options::queueCapacity. When one is full,
+ * @ref Options::overflow decides: wait for room (@ref Overflow::Block,
+ * pushing back on the poster and eventually on the kernel socket), drop
+ * the oldest queued event (@ref Overflow::DropOldest), or replace the
+ * device's queued @c change with the new one and otherwise wait
+ * (@ref Overflow::Coalesce).
+ *
+ * The handler runs concurrently on several threads and must be
+ * thread-safe; the immutable @ref QudevSharedDevice may be kept or passed
+ * on freely. Destroying the dispatcher delivers what is queued and joins
+ * the workers.
+ */
+class QudevDispatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    /// Receives each event, on a worker thread.
+    using Handler = std::function<void(const QudevSharedDevice& device)>;
+
+    /**
+     * @brief What @ref post() does when the target queue is full.
+     *
+     * @ref Overflow::Block and @ref Overflow::Coalesce make the poster
+     * wait, with two hazards:
+     * - Through @ref attach(), the poster is the thread running the
+     *   @ref Qudev's event loop, as the connection is direct. A full queue
+     *   stalls that loop (its timers, other slots and the monitor socket)
+     *   until the worker makes room.
+     * - A handler posting to its own worker waits for room only it can
+     *   make, and deadlocks once that queue is full. Post follow-up events
+     *   from another thread, or use @ref Overflow::DropOldest.
+     */
+    enum class Overflow {
+        Block,        ///< Wait until the worker makes room.
+        DropOldest,   ///< Drop the oldest queued event of that queue.
+        Coalesce      ///< Replace the device's last queued @c change; otherwise block.
+    };
+    Q_ENUM(Overflow)
+
+    struct Options
+    {
+        /// Worker threads, one queue each.
+        int workers = 4;
+        /// Maximum queued events per worker.
+        qsizetype queueCapacity = 1024;
+        /// Policy when a queue is full.
+        Overflow overflow = Overflow::Block;
+        /// Path components below @c /sys/devices that pick the queue; 0 for the full syspath.
+        int subtreeDepth = 2;
+    };
+
+    /// Counters since construction.
+    struct Counters
+    {
+        quint64 posted = 0;       ///< Calls to @ref post().
+        quint64 delivered = 0;    ///< Handler calls completed.
+        quint64 dropped = 0;      ///< Events dropped by @ref Overflow::DropOldest.
+        quint64 coalesced = 0;    ///< Events merged by @ref Overflow::Coalesce.
+        quint64 blocked = 0;      ///< Posts that had to wait for room.
+        qsizetype maxDepth = 0;   ///< Deepest any queue has been.
+    };
+
+    /**
+     * @brief Start @ref Options::workers threads running @p handler.
+     *
+     * @param handler Called for every event; must not be empty.
+     * @param options Pool size, queue bounds and sharding.
+     * @param parent  Optional QObject parent.
+     */
+    QudevDispatcher(Handler handler, const Options& options, QObject* parent = nullptr);
+
+    /// Start a dispatcher with default @ref Options.
+    explicit QudevDispatcher(Handler handler, QObject* parent = nullptr);
+
+    /// Delivers queued events, then stops the workers.
+    ~QudevDispatcher() override;
+
+    /**
+     * @brief Queue @p event for its worker.
+     *
+     * Thread-safe. May block under @ref Overflow::Block and
+     * @ref Overflow::Coalesce; see @ref Overflow for the hazards.
+     *
+     * @return @c false if the dispatcher is shutting down and @p event was
+     *         not queued.
+     */
+    bool post(const QudevSharedDevice& event);
+
+    /**
+     * @brief Post every event @p qudev emits.
+     *
+     * Connected directly, so events are queued on the thread that emits
+     * them, which a full queue stalls unless the policy is
+     * @ref Overflow::DropOldest; disconnected when either object is
+     * destroyed. Events merged under @ref Overflow::Coalesce are counted
+     * in the @ref QudevStats::eventsCoalesced of @p qudev.
+     */
+    QMetaObject::Connection attach(Qudev* qudev);
+
+    /**
+     * @brief Wait until every queue is empty and no handler is running.
+     *
+     * @param timeoutMs Maximum wait in milliseconds; negative waits forever.
+     * @return @c false on timeout.
+     */
+    bool waitForIdle(int timeoutMs = -1);
+
+    /// Worker, and queue, that events for @p syspath go to.
+    int workerOf(const QString& syspath) const;
+
+    /// Number of worker threads.
+    int workerCount() const noexcept;
+
+    /// Snapshot of the counters.
+    Counters counters() const;
+
+private:
+    struct Private;
+    std::unique_ptr<Private> d_;
+};
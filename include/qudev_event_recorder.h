@@ -0,0 +1,88 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#pragma once
+
+#include <QString>
+#include <memory>
+
+struct QudevDevice;
+
+/**
+ * @file qudev_event_recorder.h
+ * @brief Recording of monitor traffic into a binary event log.
+ *
+ * An event log starts with a 24-byte header and is followed by one record
+ * per event. All integers are little-endian.
+ *
+ * @code
+ * header: char magic[8] = "QUDEVLOG"; u16 version; u16 reserved;
+ *         u32 reserved; i64 startedMsecsSinceEpoch
+ * record: u32 payloadSize; u64 seqnum; u64 timestampNs; payload
+ * @endcode
+ *
+ * @c timestampNs is the monotonic time since recording started. The
+ * payload holds the complete device, including its action, as
+ * NUL-separated "key=value" records. Logs are replayed with
+ * @ref QudevReplayBackend.
+ */
+
+/**
+ * @brief Writes received device events to an event log.
+ *
+ * Attach a recorder with @ref Qudev::startRecording(); the monitor then
+ * records every event it receives, before user-space filtering, so a
+ * replay can exercise any filter set.
+ */
+class QudevEventRecorder
+{
+public:
+    /// Current event log format version.
+    static constexpr quint16 FormatVersion = 1;
+
+    QudevEventRecorder();
+
+    /// Closes the log, flushing pending records.
+    ~QudevEventRecorder();
+
+    QudevEventRecorder(const QudevEventRecorder&) = delete;
+    QudevEventRecorder& operator=(const QudevEventRecorder&) = delete;
+
+    /**
+     * @brief Create (or truncate) the log at @p path and write its header.
+     *
+     * Any previously open log is closed first. Timestamps of recorded
+     * events are relative to this call.
+     *
+     * @return @c true on success; see @ref errorString() otherwise.
+     */
+    bool open(const QString& path);
+
+    /// Flush and close the log. Safe to call if no log is open.
+    void close();
+
+    /// Whether a log is open for writing.
+    bool isOpen() const noexcept;
+
+    /**
+     * @brief Append @p event to the log.
+     *
+     * @return @c false if no log is open or the write failed.
+     */
+    bool record(const QudevDevice& event);
+
+    /// Number of events recorded since @ref open().
+    quint64 eventsRecorded() const noexcept;
+
+    /// Description of the last error.
+    QString errorString() const;
+
+private:
+    struct Private;
+    std::unique_ptr<Private> d_;
+};
@@ -12,6 +12,7 @@
 #include <QStringList>
 #include <QHash>
 #include <QSet>
+#include <QMetaType>
 
 /**
  * @file qudev_filters.h
@@ -78,6 +79,7 @@ struct QudevFilters
                nomatchSysattrs.isEmpty();
     }
 };
+Q_DECLARE_METATYPE(QudevFilters)
 
 /**
  * @brief Compare two QStringLists as sets (order-insensitive).
@@ -0,0 +1,154 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#pragma once
+
+#include "qudev_device.h"
+
+#include <QList>
+#include <QString>
+
+#include <memory>
+
+struct QudevFilters;
+
+/**
+ * @file qudev_index.h
+ * @brief Hashed secondary indexes over a device set.
+ */
+
+/**
+ * @brief Device set with hashed lookups by identity fields, properties and tags.
+ *
+ * Lookups such as "the device behind /dev/sda", "8:1", a given
+ * @c ID_SERIAL or everything tagged @c uaccess are hash lookups instead of
+ * scans, for the fields declared with @ref addIndex(). The indexes are
+ * kept current by @ref insert(), @ref remove() and @ref apply(); a changed
+ * device only touches the indexes whose values changed.
+ *
+ * @ref select() evaluates @ref QudevFilters starting from the smallest
+ * matching index bucket among the criteria that have an index, and checks
+ * the rest per candidate. Values containing glob characters never pick a
+ * bucket, so the candidates are also complete for enumeration semantics,
+ * where such values are fnmatch() patterns; see @ref candidates().
+ *
+ * Each index maps a value to the slots of the devices carrying it.
+ * Removing a device from a value shared by @c k devices costs O(k) integer
+ * compares, which matters only for broad indexes such as subsystem or tag.
+ *
+ * Not thread-safe.
+ */
+class QudevIndex
+{
+public:
+    /// Indexable device fields.
+    enum class Field {
+        Devnode,     ///< @ref QudevDevice::devnode
+        DevNumber,   ///< "major:minor", for devices with a device number
+        Subsystem,   ///< @ref QudevDevice::subsystem
+        Devtype,     ///< @ref QudevDevice::devtype and the @c DEVTYPE property
+        Sysname,     ///< @ref QudevDevice::sysname
+        Driver,      ///< @ref QudevDevice::driver
+        Tag,         ///< each of @ref QudevDevice::tags
+        Property     ///< the value of one property
+    };
+
+    /// Construct an empty set without indexes.
+    QudevIndex();
+
+    ~QudevIndex();
+
+    QudevIndex(const QudevIndex&) = delete;
+    QudevIndex& operator=(const QudevIndex&) = delete;
+
+    /**
+     * @brief Index @p field, or the property @p property for @ref Field::Property.
+     *
+     * Devices already held are indexed right away. Empty values are not
+     * indexed; filters never look them up.
+     */
+    void addIndex(Field field, const QString& property = {});
+
+    /// Index devnode, device number, subsystem, driver, tags, @c ID_SERIAL and @c ID_PATH.
+    void addDefaultIndexes();
+
+    /// Whether @p field (or @p property) is indexed.
+    bool hasIndex(Field field, const QString& property = {}) const;
+
+    /// Remove every device, keeping the declared indexes.
+    void clear();
+
+    /**
+     * @brief Add @p device, or replace the device with the same syspath.
+     *
+     * @return @c false if the device has no syspath.
+     */
+    bool insert(const QudevSharedDevice& device);
+
+    /**
+     * @brief Remove the device at @p syspath.
+     *
+     * @return @c false if there is no such device.
+     */
+    bool remove(const QString& syspath);
+
+    /// Apply a monitor event, as @ref QudevTopology::apply() does.
+    void apply(const QudevSharedDevice& event);
+
+    /// Devices held.
+    qsizetype size() const noexcept;
+
+    /// Device at @p syspath, or a null device.
+    QudevSharedDevice device(const QString& syspath) const;
+
+    /// Every device, in no particular order.
+    QList<QudevSharedDevice> devices() const;
+
+    /**
+     * @brief Devices whose @p field equals @p value.
+     *
+     * Scans every device if @p field is not indexed.
+     */
+    QList<QudevSharedDevice> find(Field field, const QString& value) const;
+
+    /// Devices whose property @p name equals @p value; see @ref find().
+    QList<QudevSharedDevice> findProperty(const QString& name, const QString& value) const;
+
+    /// Device with @p devnode, or a null device.
+    QudevSharedDevice findDevnode(const QString& devnode) const;
+
+    /// Devices with the device number @p major:@p minor (a char and a block device may share one).
+    QList<QudevSharedDevice> findDevNumber(quint32 major, quint32 minor) const;
+
+    /**
+     * @brief Devices matching @p filters, with the semantics of @ref QudevMonitor post-filters.
+     *
+     * Actions are matched as given, so clear them for enumeration semantics.
+     */
+    QList<QudevSharedDevice> select(const QudevFilters& filters) const;
+
+    /**
+     * @brief Devices @ref select() would examine for @p filters.
+     *
+     * Every device matching @p filters is among them, whether the filters
+     * are evaluated as monitor post-filters or as an enumeration. Every
+     * device if no literal criterion has an index.
+     */
+    QList<QudevSharedDevice> candidates(const QudevFilters& filters) const;
+
+    /**
+     * @brief Number of @ref candidates() for @p filters.
+     *
+     * Equals @ref size() if no criterion has an index.
+     */
+    qsizetype candidateCount(const QudevFilters& filters) const;
+
+private:
+    struct Private;
+    std::unique_ptr<Private> d_;
+};
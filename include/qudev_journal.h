@@ -0,0 +1,139 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#pragma once
+
+#include <QString>
+
+#include <functional>
+#include <memory>
+
+struct QudevDevice;
+
+/**
+ * @file qudev_journal.h
+ * @brief Bounded ring of recent device events, indexed by seqnum.
+ *
+ * The journal keeps the most recent events in a fixed number of bytes,
+ * either in memory or in a memory-mapped file that survives restarts of
+ * the owning process. Layout (host byte order; the file stays on the host):
+ *
+ * @code
+ * header: char magic[8] = "QUDEVJNL"; u32 version; u32 flags (1: gap pending);
+ *         u64 capacity; u64 head; u64 tail; u64 floor; u64 lastSeqnum;
+ *         u64 reserved                                          (64 bytes)
+ * data:   capacity bytes, used as a ring
+ * record: u32 payloadSize; u32 reserved; u64 seqnum; payload; padding to 8
+ * @endcode
+ *
+ * @c head and @c tail are ever-growing byte positions; a record at position
+ * @c p starts at data offset <tt>p % capacity</tt> and may wrap. Payloads
+ * hold the complete event, as in @ref QudevEventRecorder logs.
+ */
+
+/**
+ * @brief Lets subscribers that were away catch up from a seqnum.
+ *
+ * Events are appended in seqnum order (see @ref QudevDevice::seqnum, as
+ * filled in by the backends). A subscriber that last saw seqnum @c X asks
+ * for everything after it with @ref replay(); if events after @c X may
+ * have been lost, because they were evicted from the ring or arrived
+ * while nobody was appending, the journal says so and the subscriber
+ * rescans instead.
+ *
+ * Not thread-safe.
+ */
+class QudevJournal
+{
+public:
+    /// Default capacity: 4 MiB, some thousands of events.
+    static constexpr qsizetype DefaultCapacity = 4 * 1024 * 1024;
+
+    /// Current file format version.
+    static constexpr quint32 FormatVersion = 1;
+
+    /// Callback receiving each replayed event; returning @c false stops.
+    using Visitor = std::function<bool(QudevDevice&& event)>;
+
+    /// Construct an empty in-memory journal of @p capacity bytes.
+    explicit QudevJournal(qsizetype capacity = DefaultCapacity);
+
+    ~QudevJournal();
+
+    QudevJournal(const QudevJournal&) = delete;
+    QudevJournal& operator=(const QudevJournal&) = delete;
+
+    /**
+     * @brief Move the journal into the file at @p path.
+     *
+     * A compatible journal of the same capacity left in the file is
+     * reopened, so its events can still be replayed; as events may have
+     * been missed while nobody appended, continuity is only assumed again
+     * if the next event directly follows the last one kept. Otherwise the
+     * file is reinitialized with the current contents.
+     *
+     * @return @c false with @ref errorString() set on failure; the journal
+     *         then stays in memory.
+     */
+    bool openFile(const QString& path);
+
+    /// Whether the journal lives in a file.
+    bool isFileBacked() const noexcept;
+
+    /// Why @ref openFile() failed.
+    QString errorString() const;
+
+    /**
+     * @brief Append @p event, evicting the oldest events as needed.
+     *
+     * @return @c false if the event has no seqnum, is not newer than the
+     *         last one, or is larger than the whole journal.
+     */
+    bool append(const QudevDevice& event);
+
+    /**
+     * @brief Record that events may have been missed from now on.
+     *
+     * Call when the event source restarts. Continuity is re-established by
+     * the next event if it directly follows @ref lastSeqnum().
+     */
+    void markDiscontinuity() noexcept;
+
+    /// Whether every event after @p seqnum is still in the journal.
+    bool covers(quint64 seqnum) const noexcept;
+
+    /**
+     * @brief Pass every event after @p seqnum to @p visit, oldest first.
+     *
+     * Finding the first event is a binary search over the index.
+     *
+     * @return @c false without calling @p visit if @ref covers() is
+     *         @c false for @p seqnum, i.e. the caller must rescan; also
+     *         @c false if @p visit stopped the replay.
+     */
+    bool replay(quint64 seqnum, const Visitor& visit) const;
+
+    /// Events held.
+    qsizetype size() const noexcept;
+
+    /// Capacity in bytes.
+    qsizetype capacity() const noexcept;
+
+    /// Seqnum of the oldest event held, or 0 if empty.
+    quint64 firstSeqnum() const noexcept;
+
+    /// Seqnum of the newest event appended, or 0 if none.
+    quint64 lastSeqnum() const noexcept;
+
+    /// Events evicted so far to make room.
+    quint64 evicted() const noexcept;
+
+private:
+    struct Private;
+    std::unique_ptr<Private> d_;
+};
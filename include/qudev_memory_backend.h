@@ -0,0 +1,145 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#pragma once
+
+#include <QList>
+
+#include "qudev_backend.h"
+
+/**
+ * @file qudev_memory_backend.h
+ * @brief In-memory @ref QudevBackend with synthetic devices and events.
+ */
+
+/**
+ * @brief Backend serving synthetic devices and injected events.
+ *
+ * Devices live in memory, so enumeration never touches sysfs. Monitors
+ * receive events through a @c socketpair(), which keeps the real
+ * receive path (socket notifier, non-blocking drain, decoding) in play
+ * while making the event rate fully controllable. Events can be injected
+ * one by one with @ref inject() or generated at a fixed rate on a
+ * background thread with @ref startEvents().
+ *
+ * Like libudev netlink sockets, monitors apply subsystem/devtype and tag
+ * filters before an event is queued to them.
+ *
+ * Monitors created by this backend may outlive it; they then receive
+ * nothing more.
+ */
+class QudevMemoryBackend final : public QudevBackend
+{
+public:
+    /**
+     * @brief Construction parameters.
+     */
+    struct Options
+    {
+        /// Number of synthetic devices to generate.
+        int devices = 1000;
+        /// Seed for device and event generation.
+        quint32 seed = 42;
+        /// Requested socket buffer per monitor, in bytes.
+        int socketBufferBytes = 4 * 1024 * 1024;
+        /// Drop events for monitors whose socket is full (netlink-like),
+        /// instead of waiting for the reader to catch up.
+        bool dropWhenFull = false;
+    };
+
+    /// Construct with default @ref Options.
+    QudevMemoryBackend();
+
+    /**
+     * @brief Construct with @p options.devices generated devices.
+     *
+     * @param options Construction parameters.
+     */
+    explicit QudevMemoryBackend(const Options& options);
+
+    /**
+     * @brief Construct serving exactly @p devices, with default @ref Options.
+     *
+     * @param devices Devices to serve.
+     */
+    explicit QudevMemoryBackend(QList<QudevDevice> devices);
+
+    /**
+     * @brief Construct serving exactly @p devices.
+     *
+     * @param devices Devices to serve.
+     * @param options Construction parameters; @c devices is ignored.
+     */
+    QudevMemoryBackend(QList<QudevDevice> devices, const Options& options);
+
+    /// Stops event generation.
+    ~QudevMemoryBackend() override;
+
+    /**
+     * @brief Generate @p count reproducible devices.
+     *
+     * The mix of subsystems and the number of properties (~20) and sysattrs
+     * (~15) per device loosely follow a typical desktop/server host. The same
+     * @p seed always yields the same list.
+     *
+     * @param count Number of devices to generate.
+     * @param seed  Random seed.
+     */
+    static QList<QudevDevice> generateDevices(int count, quint32 seed = 42);
+
+    /// Devices served by @ref enumerate().
+    const QList<QudevDevice>& devices() const noexcept;
+
+    /**
+     * @brief Deliver @p event to every monitor whose source filter matches.
+     *
+     * A zero @ref QudevDevice::seqnum is replaced by the next sequence
+     * number. Thread-safe.
+     *
+     * @return @c false if the event was dropped for at least one monitor.
+     */
+    bool inject(const QudevDevice& event) noexcept;
+
+    /**
+     * @brief Generate events on a background thread.
+     *
+     * Events are derived from random served devices, mostly @c change
+     * with some @c add / @c remove. Any previous generator is stopped.
+     *
+     * @param eventsPerSecond Target rate; zero or negative means as fast
+     *                        as possible.
+     * @param count           Number of events to send, or 0 for no limit.
+     */
+    void startEvents(double eventsPerSecond, quint64 count = 0);
+
+    /// Stop the background generator, if running.
+    void stopEvents();
+
+    /// Whether the background generator is still sending.
+    bool eventsRunning() const noexcept;
+
+    /// Events handed to at least one monitor socket so far.
+    quint64 eventsSent() const noexcept;
+
+    /// Per-monitor deliveries dropped because a socket was full, or too
+    /// large for a monitor's receive buffer.
+    quint64 eventsDropped() const noexcept;
+
+    bool enumerate(const QudevFilters& filters, const Visitor& visit) noexcept override;
+
+    std::unique_ptr<MonitorSource> createMonitor(MonitorChannel channel,
+                                                 const QudevFilters& filters) noexcept override;
+
+    void setStats(QudevStatsCollector* stats) noexcept override;
+
+    struct Private;
+
+private:
+    // Shared with every monitor source, which may outlive the backend.
+    std::shared_ptr<Private> d_;
+};
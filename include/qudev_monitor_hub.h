@@ -0,0 +1,123 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#pragma once
+
+#include "qudev_filters.h"
+
+#include <QObject>
+
+#include <functional>
+#include <memory>
+
+class QudevBackend;
+class QudevSharedDevice;
+
+/**
+ * @file qudev_monitor_hub.h
+ * @brief One monitor shared by any number of subscribers in a process.
+ */
+
+/**
+ * @brief Monitor multiplexer: many filtered subscribers on one event stream.
+ *
+ * Every @ref Qudev that monitors on its own opens a netlink socket and
+ * receives and builds every event its kernel-side filter lets through. A
+ * hub opens one monitor for all of its subscribers, builds each event
+ * once and hands the same @ref QudevSharedDevice to every subscriber whose
+ * @ref QudevFilters match.
+ *
+ * Subscribers are filed under their subsystem, else their first tag, else
+ * their actions; only subscribers filed under the event's subsystem, one
+ * of its tags or its action, plus those with none of these criteria, are
+ * checked against it. Dispatch cost therefore follows the number of
+ * subscribers that could match rather than the total.
+ *
+ * The monitor is opened with the first subscriber and closed with the
+ * last. Its socket filter is the set of criteria all subscribers share,
+ * updated in place as subscribers come and go.
+ *
+ * Use @ref Qudev::setMonitorHub() to let @ref Qudev instances monitor
+ * through a hub. Not thread-safe; handlers run on the hub's thread.
+ */
+class QudevMonitorHub : public QObject
+{
+    Q_OBJECT
+
+public:
+    /// Receives each matching event.
+    using Handler = std::function<void(const QudevSharedDevice& device)>;
+
+    /**
+     * @brief Construct a hub monitoring through libudev.
+     *
+     * @param parent Optional QObject parent.
+     */
+    explicit QudevMonitorHub(QObject* parent = nullptr);
+
+    /**
+     * @brief Construct a hub monitoring through @p backend.
+     *
+     * @param backend Backend to use; must not be @c nullptr.
+     * @param parent  Optional QObject parent.
+     */
+    explicit QudevMonitorHub(std::unique_ptr<QudevBackend> backend, QObject* parent = nullptr);
+
+    ~QudevMonitorHub() override;
+
+    /**
+     * @brief Register @p handler for events matching @p filters.
+     *
+     * Opens the monitor if this is the first subscriber.
+     *
+     * @return Subscription id, or 0 if the monitor could not be opened.
+     */
+    quint64 subscribe(const QudevFilters& filters, Handler handler);
+
+    /**
+     * @brief As @ref subscribe(), dropped automatically when @p context is destroyed.
+     */
+    quint64 subscribe(const QudevFilters& filters, QObject* context, Handler handler);
+
+    /**
+     * @brief Replace the filters of subscription @p id.
+     *
+     * @return @c false if @p id is unknown or the monitor could not be
+     *         reconfigured.
+     */
+    bool setFilters(quint64 id, const QudevFilters& filters);
+
+    /**
+     * @brief Drop subscription @p id; its handler is not called again.
+     *
+     * Safe to call from a handler. Closes the monitor if this was the last
+     * subscriber.
+     *
+     * @return @c false if @p id is unknown.
+     */
+    bool unsubscribe(quint64 id);
+
+    /// Number of subscriptions.
+    qsizetype subscriberCount() const noexcept;
+
+    /// Whether the shared monitor is open.
+    bool isMonitoring() const noexcept;
+
+    /// Criteria applied by the shared monitor: what all subscribers share.
+    QudevFilters monitorFilters() const;
+
+    /// Events received by the shared monitor and handed to subscribers.
+    quint64 eventsDispatched() const noexcept;
+
+    /// Handler calls made, summed over subscribers.
+    quint64 deliveries() const noexcept;
+
+private:
+    struct Private;
+    std::unique_ptr<Private> d_;
+};
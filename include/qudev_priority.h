@@ -0,0 +1,83 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#pragma once
+
+#include <QList>
+
+#include "qudev_filters.h"
+#include "qudev_stats.h"
+
+struct QudevDevice;
+
+/**
+ * @file qudev_priority.h
+ * @brief Priority lanes for monitor event delivery.
+ */
+
+/// Sends events matching @ref filters to @ref lane.
+struct QudevPriorityRule
+{
+    /// Matched like the monitor's own filters; empty matches every event.
+    QudevFilters filters;
+    /// Target lane; 0 is delivered first.
+    int lane = 0;
+};
+
+/**
+ * @brief Which events a monitor delivers first.
+ *
+ * With lanes enabled, the monitor reads its socket empty before every
+ * delivery and queues matching events in @ref LaneCount FIFO lanes, so a
+ * burst of @c change events from @c power_supply or @c net cannot delay
+ * a disk being added behind it. Each event goes to the lane of the first
+ * rule it matches, or to @ref defaultLane, and delivery always takes the
+ * oldest event of the highest non-empty lane.
+ *
+ * Two exceptions keep this safe to use:
+ * - Events of one device are never reordered: while a device has events
+ *   queued, a new one joins them, and an urgent one pulls them into its
+ *   own lane ahead of itself.
+ * - An event that waited longer than @ref starvationMs is delivered before
+ *   higher lanes, so a steady stream of urgent events cannot hold back the
+ *   rest forever.
+ *
+ * Per-lane counts and queueing latency are in @ref QudevStats::lanes.
+ */
+struct QudevPriorityLanes
+{
+    /// Number of lanes.
+    static constexpr int LaneCount = QudevStats::PriorityLaneCount;
+
+    /// Checked in order; the first match picks the lane. No rules disables lanes.
+    QList<QudevPriorityRule> rules;
+
+    /// Lane of events that match no rule.
+    int defaultLane = 1;
+
+    /// Queue time after which an event overtakes higher lanes; 0 disables.
+    int starvationMs = 100;
+
+    /// Events queued at most, at least 1; beyond that, the socket is left to buffer them.
+    qsizetype maxQueued = 65536;
+
+    /// Whether lanes are in use.
+    bool isEnabled() const noexcept { return !rules.isEmpty(); }
+
+    /// Lane for @p device, within 0..LaneCount-1.
+    int laneOf(const QudevDevice& device) const noexcept;
+
+    /**
+     * @brief Lanes for hotplug-driven applications.
+     *
+     * Lane 0: @c add and @c remove of @c block and @c usb devices.
+     * Lane 2: @c change of @c power_supply, @c thermal and @c net devices.
+     * Everything else: lane 1.
+     */
+    static QudevPriorityLanes defaults();
+};
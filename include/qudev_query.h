@@ -0,0 +1,108 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#pragma once
+
+#include "qudev_filters.h"
+
+#include <QString>
+
+#include <memory>
+
+struct QudevDevice;
+
+/**
+ * @file qudev_query.h
+ * @brief Textual device queries with AND, OR, NOT and globs.
+ */
+
+/**
+ * @brief Device query compiled from text into an expression tree.
+ *
+ * Extends the single conjunction of @ref QudevFilters with disjunction,
+ * negation and glob patterns:
+ *
+ * @code
+ * subsystem==block && (ID_BUS==usb || ID_BUS==ata) && !tag:systemd
+ * syspath==/sys/devices/pci0000:00/0000:00:14.0* && attr:removable!=0
+ * sysname==tty[0-9]* || driver
+ * @endcode
+ *
+ * Grammar, lowest precedence first: <tt>a || b</tt>, <tt>a && b</tt>,
+ * <tt>!a</tt>, <tt>( ... )</tt> and terms. A term compares a field with
+ * @c == or @c !=, tests a tag with <tt>tag:name</tt>, or on its own tests
+ * that a field is not empty. Fields are @c subsystem, @c devtype,
+ * @c sysname, @c devnode, @c syspath, @c driver, @c action, @c tag,
+ * <tt>attr:name</tt> for sysfs attributes and anything else for udev
+ * properties. Values are bare words, or double-quoted strings with
+ * backslash escapes. Bare values containing @c *, @c ? or <tt>[...]</tt>
+ * are globs; quoted values are always literal.
+ *
+ * Matching follows the post-filter semantics of @ref QudevFilters:
+ * @c devtype also matches the @c DEVTYPE property, and sysfs attributes
+ * are those the device carries.
+ *
+ * @ref filters() holds the parts that @ref QudevFilters can express:
+ * literal comparisons joined to the whole query by AND, a trailing-@c *
+ * syspath glob as @ref QudevFilters::syspathPrefix, and alternatives of
+ * actions. Literals containing @c *, @c ? or @c [ are left out, as libudev
+ * would glob them, and so is every property or @c devtype comparison
+ * after the first, as libudev ORs property matches. The backends push
+ * these into libudev enumerate and monitor matches; @ref matchesResidual()
+ * evaluates the rest on built devices.
+ *
+ * Copies share the compiled tree.
+ */
+class QudevQuery
+{
+public:
+    /// Construct an empty query; it matches every device.
+    QudevQuery();
+
+    /// Parse @p text; see @ref isValid().
+    explicit QudevQuery(const QString& text);
+
+    ~QudevQuery();
+
+    QudevQuery(const QudevQuery& other);
+    QudevQuery& operator=(const QudevQuery& other);
+
+    /// Whether the text parsed; an invalid query matches nothing.
+    bool isValid() const noexcept;
+
+    /// Why parsing failed.
+    QString errorString() const;
+
+    /// Offset into @ref text() where parsing failed, or -1.
+    qsizetype errorPosition() const noexcept;
+
+    /// The text parsed.
+    QString text() const;
+
+    /// Whether the query has no terms.
+    bool isEmpty() const noexcept;
+
+    /// The query, fully parenthesized; for diagnostics.
+    QString toString() const;
+
+    /// Criteria every matching device meets, for enumerate and monitor matches.
+    const QudevFilters& filters() const noexcept;
+
+    /// Whether @p device matches the whole query.
+    bool matches(const QudevDevice& device) const noexcept;
+
+    /// Whether @p device, known to match @ref filters(), matches the rest.
+    bool matchesResidual(const QudevDevice& device) const noexcept;
+
+    /// Whether @ref matchesResidual() checks anything.
+    bool hasResidual() const noexcept;
+
+private:
+    struct Private;
+    std::shared_ptr<const Private> d_;
+};
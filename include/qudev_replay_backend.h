@@ -0,0 +1,81 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#pragma once
+
+#include <QString>
+
+#include "qudev_backend.h"
+
+/**
+ * @file qudev_replay_backend.h
+ * @brief @ref QudevBackend replaying a recorded event log.
+ */
+
+/**
+ * @brief Backend whose monitors replay an event log.
+ *
+ * The log written by @ref QudevEventRecorder is loaded into memory once.
+ * Every monitor created afterwards replays it from the start, in recorded
+ * order and with the recorded seqnums and payloads, through the regular
+ * monitor pipeline (socket notifier, decoding, post-filtering, signal
+ * emission). Runs are therefore deterministic apart from wall-clock
+ * timing.
+ *
+ * Pacing follows the recorded timestamps scaled by @ref speed(): @c 1.0
+ * replays in real time, @c 10.0 ten times faster, and @c 0 as fast as the
+ * consumer drains events (in bursts, so the event loop stays responsive).
+ * Events are never skipped; a consumer that falls behind receives due
+ * events back to back.
+ *
+ * Enumeration yields no devices, as the log only contains events.
+ */
+class QudevReplayBackend final : public QudevBackend
+{
+public:
+    /**
+     * @brief Load the event log at @p path.
+     *
+     * @param path  Event log to replay.
+     * @param speed Replay speed factor; zero or negative means maximum.
+     */
+    explicit QudevReplayBackend(const QString& path, double speed = 1.0);
+
+    ~QudevReplayBackend() override;
+
+    /// Whether the log was loaded successfully.
+    bool isValid() const noexcept;
+
+    /// Description of the load error, if any.
+    QString errorString() const;
+
+    /// Number of events in the log.
+    qsizetype eventCount() const noexcept;
+
+    /// Recorded time between the first and the last event, in nanoseconds.
+    quint64 durationNs() const noexcept;
+
+    /// Replay speed factor used by monitors created from now on.
+    double speed() const noexcept;
+
+    /// Set the replay speed factor; zero or negative means maximum.
+    void setSpeed(double speed) noexcept;
+
+    /// Events handed to monitors so far, over all monitors.
+    quint64 eventsReplayed() const noexcept;
+
+    bool enumerate(const QudevFilters& filters, const Visitor& visit) noexcept override;
+
+    std::unique_ptr<MonitorSource> createMonitor(MonitorChannel channel,
+                                                 const QudevFilters& filters) noexcept override;
+
+    struct Private;
+
+private:
+    std::unique_ptr<Private> d_;
+};
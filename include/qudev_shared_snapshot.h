@@ -0,0 +1,196 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+
+#include <memory>
+#include <optional>
+
+#include "qudev_snapshot.h"
+
+/**
+ * @file qudev_shared_snapshot.h
+ * @brief Device snapshot published in shared memory for lock-free readers.
+ *
+ * A writer publishes encoded snapshots (@ref qudevEncodeSnapshot()) into
+ * a sealed memfd. Readers in other processes map it read-only once and
+ * then read devices in place: no system call, no copy, no lock.
+ *
+ * The region uses offsets only, so it reads the same at any mapping
+ * address (integers in host byte order; the region never leaves the host):
+ *
+ *     header  "QUDEVSHM", u32 layoutVersion, u32 slotCount (2),
+ *             u64 slotCapacity, u64 slotOffset[2];
+ *             on its own cache line: atomic u64 generation
+ *     slot    on its own cache line: atomic u64 sequence,
+ *             atomic u64 size, atomic u64 generation;
+ *             then slotCapacity bytes of snapshot from offset 64
+ *
+ * Publication @e g goes to slot <tt>g % 2</tt>, so a reader of the current
+ * snapshot is overwritten only if two more are published while it reads.
+ * Each slot is a seqlock: its sequence is odd while the writer fills it
+ * and advances by two per fill. A reader notes the sequence, reads the
+ * slot, and retries if the sequence changed meanwhile.
+ */
+
+/**
+ * @brief Publishes snapshots into a memfd for @ref QudevSharedSnapshotReader.
+ *
+ * The memfd is sized once for two slots of @p slotCapacity bytes and sealed
+ * against resizing, so readers can never fault on a truncated mapping, and
+ * against writes other than through the writer's own mapping.
+ * Pages are allocated as snapshots touch them. Hand @ref fd() to readers,
+ * e.g. through @ref QudevBroker (see @ref QudevSharedSnapshotReader::fromBroker()).
+ *
+ * There must be a single writer; it is not thread-safe.
+ */
+class QudevSharedSnapshotWriter
+{
+public:
+    /// Default slot capacity: 64 MiB, several times a large host's inventory.
+    static constexpr qsizetype DefaultSlotCapacity = 64 * 1024 * 1024;
+
+    /// Create the memfd and map it; check @ref isValid().
+    explicit QudevSharedSnapshotWriter(qsizetype slotCapacity = DefaultSlotCapacity);
+    ~QudevSharedSnapshotWriter();
+
+    QudevSharedSnapshotWriter(const QudevSharedSnapshotWriter&) = delete;
+    QudevSharedSnapshotWriter& operator=(const QudevSharedSnapshotWriter&) = delete;
+
+    /// Whether the shared memory region was set up.
+    bool isValid() const noexcept;
+
+    /// Why the region could not be set up or the last publication failed.
+    QString errorString() const;
+
+    /**
+     * @brief Descriptor to hand to readers; owned by the writer.
+     *
+     * Read-only for whoever receives it: writable mappings, @c write() and
+     * resizing all fail. Readers get their own copy, e.g. over a socket.
+     */
+    int fd() const noexcept;
+
+    /// Largest snapshot a slot holds.
+    qsizetype slotCapacity() const noexcept;
+
+    /**
+     * @brief Publish an encoded snapshot.
+     *
+     * @return @c false with @ref errorString() set if @p snapshot does not
+     *         fit a slot; readers keep seeing the previous publication.
+     */
+    bool publish(const QByteArray& snapshot);
+
+    /// Number of publications so far; 0 before the first.
+    quint64 generation() const noexcept;
+
+private:
+    struct Private;
+    std::unique_ptr<Private> d_;
+};
+
+/**
+ * @brief Reads snapshots published by a @ref QudevSharedSnapshotWriter.
+ *
+ * After construction every call is plain memory access. The reader keeps
+ * the validated @ref QudevSnapshotReader of the current publication and
+ * revalidates only when a new one appears, so polling an unchanged
+ * snapshot costs a few atomic loads.
+ *
+ * @code
+ * QudevSharedSnapshotReader shared(fd);
+ * qsizetype disks = 0;
+ * shared.read([&](const QudevSnapshotReader& snapshot) {
+ *     disks = 0;   // may run again if the writer overtook us
+ *     for (qsizetype i = 0; i < snapshot.deviceCount(); ++i)
+ *         disks += snapshot.device(i).devtype() == QUtf8StringView("disk");
+ * });
+ * @endcode
+ *
+ * Not thread-safe; use one reader per thread.
+ */
+class QudevSharedSnapshotReader
+{
+public:
+    /// Map the region behind @p fd read-only; @p fd may be closed afterwards.
+    explicit QudevSharedSnapshotReader(int fd);
+    ~QudevSharedSnapshotReader();
+
+    QudevSharedSnapshotReader(const QudevSharedSnapshotReader&) = delete;
+    QudevSharedSnapshotReader& operator=(const QudevSharedSnapshotReader&) = delete;
+
+    /**
+     * @brief Ask the broker at @p socketPath for its shared snapshot.
+     *
+     * The broker must have @ref QudevBroker::setSharedSnapshotEnabled() on.
+     *
+     * @return The reader, or @c nullptr with a warning on failure.
+     */
+    static std::unique_ptr<QudevSharedSnapshotReader> fromBroker(const QString& socketPath);
+
+    /// Whether the region was mapped and has the expected layout.
+    bool isValid() const noexcept;
+
+    /// Why the region was rejected.
+    QString errorString() const;
+
+    /// Latest publication; 0 until the writer published anything.
+    quint64 generation() const noexcept;
+
+    /**
+     * @brief Run @p fn on a consistent view of the latest publication.
+     *
+     * The snapshot may be rewritten while @p fn runs. Views then return
+     * wrong values but stay within the region; the call detects it and runs
+     * @p fn again on the new publication. @p fn must therefore only
+     * compute results, resetting them on entry, and not keep views past
+     * its return.
+     *
+     * @return The generation @p fn last saw consistently, or 0 if nothing
+     *         was published yet or the reader is invalid (@p fn not run).
+     */
+    template <typename Fn>
+    quint64 read(Fn&& fn)
+    {
+        for (;;) {
+            const QudevSnapshotReader* snapshot = nullptr;
+            const std::optional<quint64> token = begin(&snapshot);
+            if (!token) {
+                return 0;
+            }
+            fn(*snapshot);
+            if (validate(*token)) {
+                return current_.generation;
+            }
+        }
+    }
+
+    /// Retries caused by the writer overtaking @ref read() so far.
+    quint64 retries() const noexcept { return retries_; }
+
+private:
+    std::optional<quint64> begin(const QudevSnapshotReader** snapshot);
+    bool validate(quint64 sequence) noexcept;
+
+    struct Cached
+    {
+        quint64 generation = 0;
+        quint64 sequence = 0;
+        int slot = -1;
+        std::optional<QudevSnapshotReader> snapshot;
+    };
+
+    struct Private;
+    std::unique_ptr<Private> d_;
+    Cached current_;
+    quint64 retries_ = 0;
+};
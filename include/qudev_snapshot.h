@@ -0,0 +1,165 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#pragma once
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QUtf8StringView>
+
+#include "qudev_device.h"
+
+/**
+ * @file qudev_snapshot.h
+ * @brief Compact, versioned binary format for device inventories.
+ *
+ * A snapshot holds a list of devices. Layout (integers little-endian;
+ * "varint" is unsigned LEB128; strings are a varint byte length followed
+ * by UTF-8 without terminator):
+ *
+ *     header      "QUDEVSNP", u16 version, u16 compatVersion, u32 deviceCount,
+ *                 u32 keyCount, u32 keyTableOffset, u32 deviceTableOffset,
+ *                 u32 totalSize                                  (32 bytes)
+ *     keys        keyCount strings
+ *     key table   keyCount u32 offsets of the keys
+ *     devices     one record per device
+ *     dev. table  deviceCount u32 offsets of the records
+ *
+ * Property and sysattr keys, tags, and the low-cardinality fields
+ * (subsystem, devtype, driver, action, parent subsystem) are stored once
+ * in the key dictionary and referenced by varint index. A device record is
+ *
+ *     u8 flags (1: isBlock, 2: isChar), varint major, minor, seqnum,
+ *     string syspath, devnode, sysname, parentSyspath,
+ *     key subsystem, devtype, driver, action, parentSubsystem,
+ *     varint n, n × (key, string) properties,
+ *     varint n, n × (key, string) sysattrs,
+ *     varint n, n × string devlinks,
+ *     varint n, n × key tags
+ *
+ * Readers ignore bytes after the fields they know, so later versions may
+ * append fields to records; @c compatVersion is the oldest reader version
+ * able to read the data.
+ */
+
+/**
+ * @brief Encode @p devices as a snapshot.
+ */
+QByteArray qudevEncodeSnapshot(const QList<QudevDevice>& devices);
+
+/// @overload
+QByteArray qudevEncodeSnapshot(const QList<QudevSharedDevice>& devices);
+
+/**
+ * @brief Zero-copy reader of snapshots produced by @ref qudevEncodeSnapshot().
+ *
+ * The constructor validates the whole snapshot once; afterwards
+ * @ref DeviceView accessors return views into the encoded data without
+ * copying or allocating. The data must outlive the reader and every view
+ * obtained from it.
+ *
+ * Accessors never read outside the data, even if it changes after
+ * validation (as a @ref QudevSharedSnapshotReader slot may); they then
+ * return wrong values, which the caller's consistency check discards.
+ */
+class QudevSnapshotReader
+{
+public:
+    /// Version written by @ref qudevEncodeSnapshot().
+    static constexpr quint16 FormatVersion = 1;
+
+    /// Read-only view of one encoded device.
+    class DeviceView
+    {
+    public:
+        QUtf8StringView syspath() const noexcept { return syspath_; }
+        QUtf8StringView devnode() const noexcept { return devnode_; }
+        QUtf8StringView sysname() const noexcept { return sysname_; }
+        QUtf8StringView parentSyspath() const noexcept { return parentSyspath_; }
+        QUtf8StringView subsystem() const noexcept;
+        QUtf8StringView devtype() const noexcept;
+        QUtf8StringView driver() const noexcept;
+        QUtf8StringView action() const noexcept;
+        QUtf8StringView parentSubsystem() const noexcept;
+
+        quint32 major() const noexcept { return major_; }
+        quint32 minor() const noexcept { return minor_; }
+        quint64 seqnum() const noexcept { return seqnum_; }
+        bool isBlock() const noexcept { return flags_ & 1; }
+        bool isChar() const noexcept { return flags_ & 2; }
+
+        /// Value of property @p key, or a null view if absent.
+        QUtf8StringView property(QUtf8StringView key) const noexcept;
+        /// Value of sysattr @p key, or a null view if absent.
+        QUtf8StringView sysattr(QUtf8StringView key) const noexcept;
+        /// Whether the device carries @p tag.
+        bool hasTag(QUtf8StringView tag) const noexcept;
+
+        /// Materialize the device; keys are shared with the reader's dictionary.
+        QudevDevice toDevice() const;
+
+    private:
+        friend class QudevSnapshotReader;
+
+        const QudevSnapshotReader* reader_ = nullptr;
+        const char* sections_ = nullptr;   // property count onwards
+        const char* end_ = nullptr;
+        QUtf8StringView syspath_, devnode_, sysname_, parentSyspath_;
+        quint32 subsystem_ = 0, devtype_ = 0, driver_ = 0, action_ = 0, parentSubsystem_ = 0;
+        quint32 major_ = 0, minor_ = 0;
+        quint64 seqnum_ = 0;
+        quint8 flags_ = 0;
+    };
+
+    /// Read @p data; the byte array is kept (shared, not copied).
+    explicit QudevSnapshotReader(const QByteArray& data);
+
+    /// Read @p size bytes at @p data, e.g. a mapped file; not copied.
+    QudevSnapshotReader(const char* data, qsizetype size);
+
+    /// Whether the data is a well-formed snapshot this reader understands.
+    bool isValid() const noexcept { return error_.isEmpty(); }
+
+    /// Why the data was rejected.
+    QString errorString() const { return error_; }
+
+    /// Format version of the data.
+    quint16 version() const noexcept { return version_; }
+
+    /// Number of devices; 0 if invalid.
+    qsizetype deviceCount() const noexcept { return isValid() ? deviceCount_ : 0; }
+
+    /// View of device @p index, 0 <= @p index < @ref deviceCount().
+    DeviceView device(qsizetype index) const noexcept;
+
+    /// Decode every device.
+    QList<QudevDevice> devices() const;
+
+private:
+    void open();
+    QUtf8StringView key(quint32 index) const noexcept;
+    QString keyString(quint32 index) const;
+
+    QByteArray data_;
+    QString error_;
+    quint16 version_ = 0;
+    qsizetype deviceCount_ = 0;
+    const uchar* deviceTable_ = nullptr;
+    QList<QUtf8StringView> keyViews_;
+    QStringList keys_;   // decoded once, shared by materialized devices
+};
+
+/// @name QDataStream serialization of a single device
+/// Versioned field-by-field encoding for use in existing QDataStream formats.
+///@{
+QDataStream& operator<<(QDataStream& out, const QudevDevice& device);
+QDataStream& operator>>(QDataStream& in, QudevDevice& device);
+///@}
@@ -0,0 +1,186 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#pragma once
+
+#include <QMetaType>
+#include <QStringList>
+#include <array>
+
+/**
+ * @file qudev_stats.h
+ * @brief Runtime statistics of a @ref Qudev instance.
+ */
+
+/**
+ * @brief Snapshot of a latency distribution.
+ *
+ * Values are kept in log-linear buckets: every power of two is split into
+ * @ref SubBuckets equal parts, so a reported percentile is at most ~25%
+ * above the true value. Durations are in nanoseconds.
+ */
+struct QudevLatencyHistogram
+{
+    /// Linear sub-divisions per power of two.
+    static constexpr int SubBuckets = 4;
+    /// Bucket count; the last bucket also holds everything above ~1 hour.
+    static constexpr int BucketCount = 42 * SubBuckets;
+
+    /// Index of the bucket holding @p ns.
+    static int bucketIndex(quint64 ns) noexcept;
+
+    /// Largest value falling into bucket @p index.
+    static quint64 bucketUpperBound(int index) noexcept;
+
+    /**
+     * @brief Estimate the @p percentile (0..100) of the recorded values.
+     *
+     * @return The upper bound of the bucket containing the percentile, or 0
+     *         if nothing was recorded.
+     */
+    quint64 percentileNs(double percentile) const noexcept;
+
+    /// Mean of the recorded values, or 0 if nothing was recorded.
+    double meanNs() const noexcept;
+
+    /// Number of recorded values.
+    quint64 count = 0;
+    /// Sum of the recorded values.
+    quint64 sumNs = 0;
+    /// Largest recorded value.
+    quint64 maxNs = 0;
+    /// Per-bucket counts.
+    std::array<quint64, BucketCount> buckets{};
+};
+
+/**
+ * @brief Timestamps of one delivered event along the hotplug pipeline.
+ *
+ * All times are @c CLOCK_MONOTONIC nanoseconds, the clock udevd uses for
+ * @c USEC_INITIALIZED; 0 means unknown. Obtained with
+ * @ref Qudev::eventTiming() from a slot connected to
+ * @ref Qudev::deviceFound().
+ */
+struct QudevEventTiming
+{
+    /// Sequence number of the event.
+    quint64 seqnum = 0;
+
+    /// Kernel uevent seen on the kernel channel; only with
+    /// @ref Qudev::setKernelLatencyTracking() enabled.
+    quint64 kernelNs = 0;
+
+    /// Device initialized by udevd (@c USEC_INITIALIZED). udevd sets this
+    /// once per device, so it is only the event's processing time for
+    /// @c add events.
+    quint64 initializedNs = 0;
+
+    /// Event arrived on the monitor socket. Socket timestamps are used
+    /// where the backend provides them (@ref receivedIsSocketTimestamp);
+    /// otherwise this is when the monitor started reading the event.
+    quint64 receivedNs = 0;
+
+    /// Event about to be emitted, after filtering.
+    quint64 deliveredNs = 0;
+
+    /// Whether @ref receivedNs is a kernel socket timestamp.
+    bool receivedIsSocketTimestamp = false;
+};
+
+/**
+ * @brief Delivery through one priority lane; see @ref QudevPriorityLanes.
+ */
+struct QudevLaneStats
+{
+    /// Events delivered from this lane.
+    quint64 delivered = 0;
+    /// Of those, events delivered ahead of higher lanes because they
+    /// waited longer than @ref QudevPriorityLanes::starvationMs.
+    quint64 starved = 0;
+    /// Most events queued in this lane at once.
+    quint64 maxDepth = 0;
+    /// Time from leaving the socket to delivery.
+    QudevLatencyHistogram queueLatency;
+};
+
+/**
+ * @brief Counters and timings accumulated by a @ref Qudev instance.
+ *
+ * Obtained with @ref Qudev::stats() or delivered periodically by
+ * @ref Qudev::statsUpdated(). All values are cumulative since the
+ * instance was created.
+ */
+struct QudevStats
+{
+    /// Number of priority lanes; see @ref QudevPriorityLanes.
+    static constexpr int PriorityLaneCount = 4;
+
+    /// Completed or aborted enumerations.
+    quint64 scans = 0;
+    /// Total time spent enumerating, in nanoseconds.
+    quint64 scanNs = 0;
+    /// Duration of the most recent enumeration, in nanoseconds.
+    quint64 lastScanNs = 0;
+
+    /// Devices produced by the backend, for scans and events.
+    quint64 devicesBuilt = 0;
+
+    /// Sysfs attribute values read while building devices.
+    quint64 sysattrReads = 0;
+    /// Bytes of sysfs attribute values read.
+    quint64 sysattrBytes = 0;
+    /// Sysfs attribute values served from the cache instead of sysfs.
+    quint64 sysattrCacheHits = 0;
+
+    /// Attribute reads skipped because the policy denies them.
+    quint64 sysattrsDenied = 0;
+    /// Attribute reads skipped because the file exceeds
+    /// @ref QudevSysattrPolicy::maxValueSize.
+    quint64 sysattrsOversized = 0;
+    /// Attribute reads skipped because the attribute was learned to be slow.
+    quint64 sysattrsSlow = 0;
+    /// Attributes learned to be slow, as "subsystem/attribute".
+    QStringList slowSysattrs;
+
+    /// Events received from the backend.
+    quint64 eventsReceived = 0;
+    /// Received events rejected by the user-space filter.
+    quint64 eventsFiltered = 0;
+    /// Events merged into an already queued one by a @ref QudevDispatcher
+    /// attached to the instance, under @ref QudevDispatcher::Overflow::Coalesce.
+    quint64 eventsCoalesced = 0;
+    /// Events emitted through @ref Qudev::deviceFound().
+    quint64 eventsDelivered = 0;
+
+    /// Time to receive a raw event from the backend.
+    QudevLatencyHistogram receiveLatency;
+    /// Time to turn a raw event into a @ref QudevDevice.
+    QudevLatencyHistogram buildLatency;
+    /// Time spent in the user-space filter.
+    QudevLatencyHistogram filterLatency;
+    /// Time spent emitting, i.e. in directly connected slots.
+    QudevLatencyHistogram emitLatency;
+
+    /// Kernel uevent to udevd initialization, for @c add events, when
+    /// kernel latency tracking is enabled.
+    QudevLatencyHistogram kernelToUdevdLatency;
+    /// udevd initialization to socket arrival, for @c add events.
+    QudevLatencyHistogram udevdToReceiveLatency;
+    /// Socket arrival to delivery, for every delivered event.
+    QudevLatencyHistogram receiveToDeliveryLatency;
+
+    /// Per priority lane, lane 0 first; only filled while
+    /// @ref Qudev::setPriorityLanes() is in effect.
+    std::array<QudevLaneStats, PriorityLaneCount> lanes;
+
+    /// Memory currently held by library caches, in bytes.
+    quint64 cacheBytes = 0;
+};
+
+Q_DECLARE_METATYPE(QudevEventTiming)
+Q_DECLARE_METATYPE(QudevStats)
@@ -0,0 +1,127 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#pragma once
+
+#include <QHash>
+#include <QSet>
+#include <QString>
+
+/**
+ * @file qudev_sysattr_policy.h
+ * @brief Staleness policy and read mode of sysfs attribute values.
+ */
+
+/**
+ * @brief How sysfs attribute values missing from the cache are read.
+ *
+ * The batched modes read every attribute of a device, or of a group of
+ * enumerated devices, with one submission instead of one blocking
+ * @c udev_device_get_sysattr_value() call per attribute. Values are
+ * post-processed like libudev does (trailing newlines stripped, symlinks
+ * other than @c driver, @c subsystem and @c module yield empty values).
+ */
+enum class QudevSysattrReadMode
+{
+    Libudev,    ///< One libudev call per attribute (default).
+    Batched,    ///< io_uring if the kernel supports it, thread pool otherwise.
+    IoUring,    ///< io_uring only; behaves like @ref Libudev if unavailable.
+    ThreadPool, ///< Blocking reads spread over a small thread pool.
+};
+
+/**
+ * @brief Decides how long a sysfs attribute value may be served from cache.
+ *
+ * Every attribute is given a time-to-live in milliseconds:
+ *  - @ref Static values are read once per device lifetime and only
+ *    re-read after the device was removed or re-added;
+ *  - @ref Uncached values are read from sysfs every time;
+ *  - any positive value is the maximum age of a cached value.
+ *
+ * Lookup order: the device's subsystem entry in @ref subsystems, then
+ * @ref attributes, then @ref defaultTtlMs.
+ *
+ * The policy also guards against attributes that are expensive to read:
+ * denied attributes are never read, oversized binary attributes are
+ * skipped, and attributes whose reads repeatedly exceed a latency budget
+ * are learned per subsystem and skipped from then on. Skipped attributes
+ * are left out of @ref QudevDevice::sysattrs and counted in
+ * @ref QudevStats.
+ */
+struct QudevSysattrPolicy
+{
+    /// TTL marking a value as constant for the device lifetime.
+    static constexpr qint64 Static = -1;
+    /// TTL marking a value as always re-read.
+    static constexpr qint64 Uncached = 0;
+
+    /// Whether the cache is used at all.
+    bool enabled = true;
+
+    /// Devices with cached values at most; the least recently built are dropped beyond.
+    qsizetype maxDevices = 16384;
+
+    /// TTL of attributes not listed anywhere.
+    qint64 defaultTtlMs = Uncached;
+
+    /// TTL per attribute name, for every subsystem.
+    QHash<QString, qint64> attributes;
+
+    /// TTL per subsystem and attribute name; overrides @ref attributes.
+    QHash<QString, QHash<QString, qint64>> subsystems;
+
+    /// Attributes never read, for every subsystem.
+    QSet<QString> deniedAttributes;
+
+    /// Attributes never read on devices of a subsystem.
+    QHash<QString, QSet<QString>> deniedSubsystemAttributes;
+
+    /**
+     * @brief Attribute files larger than this many bytes are skipped; 0 reads
+     *        everything.
+     *
+     * Checked against the file size sysfs reports. Text attributes always
+     * report one page and are never skipped, so this only affects binary
+     * attributes (ROMs, VPD, EEPROMs, ...). The bulk readers of
+     * @ref QudevSysattrReadMode never read more than 4096 bytes.
+     */
+    qint64 maxValueSize = 4096;
+
+    /// Read latency budget in microseconds; 0 disables learning.
+    qint64 slowReadBudgetUs = 10000;
+
+    /// Over-budget reads after which an attribute is skipped for its subsystem.
+    int slowReadStrikes = 2;
+
+    /// Whether @p attribute of @p subsystem devices is denied.
+    bool isDenied(const QString& subsystem, const QString& attribute) const;
+
+    /**
+     * @brief TTL of @p attribute on devices of @p subsystem.
+     *
+     * @return @ref Static, @ref Uncached or a TTL in milliseconds.
+     */
+    qint64 ttlMs(const QString& subsystem, const QString& attribute) const;
+
+    /**
+     * @brief Policy with well-known identity attributes marked static.
+     *
+     * Covers USB and PCI identifiers and descriptors on @c usb and @c pci
+     * devices, @c type, @c dev_id and @c dev_port on @c net devices, input
+     * device names, and @c dev, @c modalias, @c removable and @c size
+     * everywhere. Block devices keep @c size and @c ro uncached, as both
+     * change on resize or media change.
+     *
+     * Denies attributes known to block on hardware: PCI @c config, @c rom
+     * and @c vpd, and TPM @c pcrs.
+     */
+    static QudevSysattrPolicy defaults();
+
+    /// Policy that disables the cache but keeps the default protections.
+    static QudevSysattrPolicy disabled();
+};
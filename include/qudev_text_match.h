@@ -0,0 +1,126 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#pragma once
+
+#include <QString>
+#include <QStringView>
+
+/**
+ * @file qudev_text_match.h
+ * @brief Non-allocating case-insensitive substring and glob matching.
+ *
+ * Device properties, sysfs attributes and paths are almost always plain
+ * ASCII. The helpers in this header exploit that: ASCII haystacks are
+ * searched with a vectorized (SSE2/AVX2, scalar fallback) case-folding
+ * scan that never allocates, while anything containing non-ASCII code
+ * units falls back to Qt's UTF-16 case-insensitive search.
+ */
+
+/**
+ * @brief Case-insensitive substring search with a pre-processed needle.
+ *
+ * The needle is folded once in @ref setPattern(); subsequent calls to
+ * @ref matches() only scan the haystack. This is the intended building
+ * block for free-text search over many short strings (e.g. tree model
+ * rows), where lowering every haystack would dominate the cost.
+ */
+class QudevTextMatcher
+{
+public:
+    /// Construct an empty matcher; it matches every haystack.
+    QudevTextMatcher() = default;
+
+    /**
+     * @brief Construct a matcher for @p pattern.
+     *
+     * @param pattern Substring to look for, compared case-insensitively.
+     */
+    explicit QudevTextMatcher(const QString& pattern);
+
+    /**
+     * @brief Replace the pattern searched for.
+     *
+     * @param pattern New substring to look for.
+     */
+    void setPattern(const QString& pattern);
+
+    /// Currently configured pattern, as passed to @ref setPattern().
+    const QString& pattern() const noexcept { return pattern_; }
+
+    /// Whether the pattern is empty (an empty pattern matches everything).
+    bool isEmpty() const noexcept { return pattern_.isEmpty(); }
+
+    /**
+     * @brief Check whether @p haystack contains the pattern.
+     *
+     * ASCII letters are compared case-insensitively. If either the
+     * pattern or the haystack contains non-ASCII code units, the
+     * comparison is delegated to @c QStringView::contains() with
+     * @c Qt::CaseInsensitive.
+     *
+     * @param haystack Text to search in.
+     * @return @c true if the pattern occurs in @p haystack.
+     */
+    bool matches(QStringView haystack) const noexcept;
+
+private:
+    QString pattern_;           //!< Pattern as given by the caller.
+    QString folded_;            //!< ASCII-lowered copy of @ref pattern_.
+    bool    asciiPattern_ = true;
+};
+
+/**
+ * @brief One-shot case-insensitive substring test.
+ *
+ * Convenience wrapper for callers that do not reuse the needle. Prefer
+ * @ref QudevTextMatcher when the same needle is tested repeatedly.
+ *
+ * @param haystack Text to search in.
+ * @param needle   Substring to look for.
+ * @return @c true if @p needle occurs in @p haystack ignoring case.
+ */
+bool qudevContainsCaseInsensitive(QStringView haystack, QStringView needle) noexcept;
+
+/**
+ * @brief fnmatch()-style glob test, as libudev matches filter values.
+ *
+ * Supports @c *, @c ? and bracket expressions (with @c ! or @c ^ negation
+ * and ranges); an unterminated @c [ is literal. A backslash makes the
+ * next character literal, inside bracket expressions too, and a trailing
+ * backslash matches nothing, as with fnmatch() without @c FNM_NOESCAPE.
+ * Does not allocate.
+ *
+ * @param pattern Glob to match.
+ * @param text    Whole text to match it against.
+ * @return @c true if @p pattern matches all of @p text.
+ */
+bool qudevGlobMatch(QStringView pattern, QStringView text) noexcept;
+
+/// Search implementations behind @ref QudevTextMatcher.
+enum class QudevTextMatchPath {
+    Auto,     ///< Best one this CPU supports; the default.
+    Scalar,   ///< Portable loop.
+    Sse2,     ///< 8 code units per step (x86-64 builds).
+    Avx2      ///< 16 code units per step, on CPUs with AVX2.
+};
+
+/**
+ * @brief Force one search implementation, for tests and benchmarks.
+ *
+ * May be called while other threads match; their next search uses the
+ * new implementation. Results never depend on the implementation, only
+ * speed does.
+ *
+ * @return @c false, leaving the selection unchanged, if @p path is not
+ *         available in this build or on this CPU.
+ */
+bool qudevSetTextMatchPath(QudevTextMatchPath path) noexcept;
+
+/// The implementation in use; never @ref QudevTextMatchPath::Auto.
+QudevTextMatchPath qudevTextMatchPath() noexcept;
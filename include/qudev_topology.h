@@ -0,0 +1,144 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#pragma once
+
+#include "qudev_device.h"
+
+#include <QList>
+#include <QString>
+
+#include <functional>
+#include <memory>
+
+struct QudevFilters;
+
+/**
+ * @file qudev_topology.h
+ * @brief Device tree with ancestor, descendant and syspath prefix queries.
+ */
+
+/**
+ * @brief Parent/child index over a set of devices.
+ *
+ * Built from a snapshot with @ref insert() and kept current with
+ * @ref apply() for each monitor event, it answers questions such as "all
+ * block devices under this USB hub" (@ref subtree()) or "which PCI device
+ * backs eth0" (@ref ancestors()) without scanning the whole set.
+ *
+ * The hierarchy is that of the sysfs paths, which is also what libudev
+ * follows for @ref QudevDevice::parent_syspath. Ancestor directories that
+ * are not devices themselves, or whose devices are not in the set (e.g.
+ * filtered out), are kept as path-only nodes, so every device hangs below
+ * the nodes of its path prefixes. That makes a syspath prefix a handful of
+ * subtrees: @ref visitPrefix() compares names among the children of one
+ * node only.
+ *
+ * Nodes live in flat arrays linked by index (parent, first/last child,
+ * siblings), with freed slots reused; all queries cost O(result) plus any
+ * path-only nodes on the way. Children are kept in insertion order.
+ *
+ * Not thread-safe.
+ */
+class QudevTopology
+{
+public:
+    /// Callback receiving each device; returning @c false stops the walk.
+    using Visitor = std::function<bool(const QudevSharedDevice& device)>;
+
+    /// Construct an empty topology.
+    QudevTopology();
+
+    ~QudevTopology();
+
+    QudevTopology(const QudevTopology&) = delete;
+    QudevTopology& operator=(const QudevTopology&) = delete;
+
+    /// Remove every device.
+    void clear();
+
+    /**
+     * @brief Add @p device, or replace the device with the same syspath.
+     *
+     * @return @c false if the device has no syspath.
+     */
+    bool insert(const QudevSharedDevice& device);
+
+    /**
+     * @brief Remove the device at @p syspath; devices below it stay.
+     *
+     * @return @c false if there is no such device.
+     */
+    bool remove(const QString& syspath);
+
+    /**
+     * @brief Apply a monitor event.
+     *
+     * @c remove events remove the device, @c move events remove it from
+     * the path in its @c DEVPATH_OLD property; any other event inserts the
+     * device as received.
+     */
+    void apply(const QudevSharedDevice& event);
+
+    /// Devices held.
+    qsizetype size() const noexcept;
+
+    /// Whether a device has @p syspath.
+    bool contains(const QString& syspath) const;
+
+    /// Device at @p syspath, or a null device.
+    QudevSharedDevice device(const QString& syspath) const;
+
+    /// Nearest device above @p syspath, or a null device.
+    QudevSharedDevice parent(const QString& syspath) const;
+
+    /// Devices above @p syspath, nearest first.
+    QList<QudevSharedDevice> ancestors(const QString& syspath) const;
+
+    /// Devices whose @ref parent() is @p syspath.
+    QList<QudevSharedDevice> children(const QString& syspath) const;
+
+    /// Devices below @p syspath, depth-first, excluding @p syspath itself.
+    QList<QudevSharedDevice> descendants(const QString& syspath) const;
+
+    /**
+     * @brief The device at @p syspath and the ones below it matching @p filters.
+     *
+     * Filters are evaluated as on the enumeration path: subsystem,
+     * sysname, devtype, property and attribute values are fnmatch() globs
+     * and actions are ignored. @ref select() applies monitor post-filters
+     * instead.
+     */
+    QList<QudevSharedDevice> subtree(const QString& syspath, const QudevFilters& filters) const;
+
+    /// Every device, depth-first.
+    QList<QudevSharedDevice> devices() const;
+
+    /**
+     * @brief Pass every device whose syspath starts with @p prefix to @p visit.
+     *
+     * Depth-first; an empty prefix visits every device.
+     *
+     * @return @c false if @p visit stopped the walk.
+     */
+    bool visitPrefix(const QString& prefix, const Visitor& visit) const;
+
+    /**
+     * @brief Devices matching @p filters.
+     *
+     * @ref QudevFilters::syspathPrefix narrows the walk through
+     * @ref visitPrefix(); the remaining fields are checked per device.
+     * Actions are matched as given, so clear them for enumeration
+     * semantics.
+     */
+    QList<QudevSharedDevice> select(const QudevFilters& filters) const;
+
+private:
+    struct Private;
+    std::unique_ptr<Private> d_;
+};
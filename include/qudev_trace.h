@@ -0,0 +1,154 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <atomic>
+
+/**
+ * @file qudev_trace.h
+ * @brief Opt-in Chrome trace (Perfetto-compatible) export of qudev internals.
+ *
+ * Tracing records spans for scans, device builds, sysattr reads, monitor
+ * receive batches, filter evaluation and (in the viewer) model rebuilds.
+ * Spans are buffered per thread and written as a Chrome trace JSON file
+ * by @ref QudevTrace::stop(); the file loads directly in
+ * https://ui.perfetto.dev or @c chrome://tracing.
+ *
+ * Tracing is off at runtime until @ref QudevTrace::start() is called or
+ * the @c QUDEV_TRACE environment variable names an output file. While
+ * off, a span costs one relaxed atomic load. Configuring with
+ * @c -DQUDEV_ENABLE_TRACING=OFF defines @c QUDEV_NO_TRACING and removes
+ * the spans entirely.
+ */
+
+/**
+ * @brief Process-wide trace recorder.
+ */
+class QudevTrace
+{
+public:
+    /**
+     * @brief Start recording; spans are written to @p path on @ref stop().
+     *
+     * Any spans recorded by a previous, unstopped session are discarded.
+     *
+     * @return @c false if tracing is compiled out.
+     */
+    static bool start(const QString& path);
+
+    /**
+     * @brief Stop recording and write the trace file.
+     *
+     * @return @c false if no session was active or writing failed.
+     */
+    static bool stop();
+
+    /// Whether spans are being recorded.
+    static bool isEnabled() noexcept
+    {
+        return enabled_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Start tracing if @c QUDEV_TRACE is set; write at process exit.
+     *
+     * Called by @ref Qudev on construction; only the first call has an
+     * effect.
+     */
+    static void startFromEnvironment();
+
+    /// Monotonic clock in nanoseconds, as used for span timestamps.
+    static quint64 nowNs() noexcept;
+
+    /// Append a complete span; @p name and @p category must be literals.
+    static void record(const char* category, const char* name, quint64 beginNs, quint64 endNs,
+                       const char* argKey, QByteArray&& argValue);
+
+private:
+    static std::atomic<bool> enabled_;
+};
+
+/**
+ * @brief RAII span; records from construction to destruction.
+ *
+ * Use through the @c QUDEV_TRACE_* macros so builds without tracing
+ * compile the span away.
+ */
+class QudevTraceSpan
+{
+public:
+    QudevTraceSpan(const char* category, const char* name) noexcept
+        : category_(category),
+        name_(name),
+        beginNs_(QudevTrace::isEnabled() ? QudevTrace::nowNs() : 0)
+    {}
+
+    ~QudevTraceSpan()
+    {
+        if (beginNs_) {
+            QudevTrace::record(category_, name_, beginNs_, QudevTrace::nowNs(), argKey_, std::move(argValue_));
+        }
+    }
+
+    QudevTraceSpan(const QudevTraceSpan&) = delete;
+    QudevTraceSpan& operator=(const QudevTraceSpan&) = delete;
+
+    /// Whether this span is being recorded.
+    bool active() const noexcept { return beginNs_ != 0; }
+
+    /// Attach one argument, shown in the trace viewer's details pane.
+    void setArg(const char* key, const char* value)
+    {
+        if (active()) {
+            argKey_ = key;
+            argValue_ = value;
+        }
+    }
+
+    /// @overload
+    void setArg(const char* key, qint64 value)
+    {
+        if (active()) {
+            argKey_ = key;
+            argValue_ = QByteArray::number(value);
+        }
+    }
+
+private:
+    const char* category_;
+    const char* name_;
+    quint64 beginNs_;
+    const char* argKey_ = nullptr;
+    QByteArray argValue_;
+};
+
+#define QUDEV_TRACE_CONCAT_(a, b) a##b
+#define QUDEV_TRACE_CONCAT(a, b) QUDEV_TRACE_CONCAT_(a, b)
+
+#ifndef QUDEV_NO_TRACING
+/// Trace the enclosing scope as span @p name in @p category.
+#  define QUDEV_TRACE_SCOPE(category, name) \
+       QudevTraceSpan QUDEV_TRACE_CONCAT(qudevTraceSpan_, __LINE__)(category, name)
+/// Like @c QUDEV_TRACE_SCOPE, with a span object named @p var.
+#  define QUDEV_TRACE_SCOPE_NAMED(var, category, name) QudevTraceSpan var(category, name)
+/// Attach an argument to the span @p var.
+#  define QUDEV_TRACE_ARG(var, key, value) var.setArg(key, value)
+/// Declare a counter @p var for a span argument, compiled out with the spans.
+#  define QUDEV_TRACE_COUNTER(var) qint64 var = 0
+/// Increment the counter @p var.
+#  define QUDEV_TRACE_COUNT(var) ++var
+#else
+#  define QUDEV_TRACE_SCOPE(category, name) do {} while (0)
+#  define QUDEV_TRACE_SCOPE_NAMED(var, category, name) do {} while (0)
+#  define QUDEV_TRACE_ARG(var, key, value) do {} while (0)
+#  define QUDEV_TRACE_COUNTER(var) do {} while (0)
+#  define QUDEV_TRACE_COUNT(var) do {} while (0)
+#endif
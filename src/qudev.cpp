@@ -12,33 +12,86 @@
 #include <QDebug>
 #include <QJsonDocument>
 #include <QJsonObject>
-#include "qudev_context.h"
+#include "qudev_backend.h"
+#include "qudev_broker_backend.h"
+#include "qudev_event_recorder.h"
 #include "qudev_enumerator.h"
 #include "qudev_monitor.h"
+#include "qudev_monitor_hub.h"
 #include "qudev_device.h"
 #include "qudev_filters.h"
+#include "qudev_priority.h"
+#include "qudev_query.h"
+#include "qudev_stats_collector.h"
+#include "qudev_trace.h"
+
+#include <QPointer>
+#include <QTimer>
 
 
 struct Qudev::Private {
-    std::unique_ptr<QudevContext> ctx;
+    std::unique_ptr<QudevBackend> backend;
     std::unique_ptr<QudevMonitor> mon;
+    QPointer<QudevMonitorHub> hub;
+    quint64 subscription = 0;
+    std::unique_ptr<QudevEventRecorder> recorder;
+    QudevStatsCollector stats;
+    QTimer* statsTimer = nullptr;
+    bool kernelLatencyTracking = false;
+    QudevQuery query;
+    QudevPriorityLanes priorityLanes;
+    QudevSysattrPolicy sysattrPolicy = QudevSysattrPolicy::defaults();
+    QudevSysattrReadMode sysattrReadMode = QudevSysattrReadMode::Libudev;
+    Source source = Source::Libudev;
 };
 
 Qudev::Qudev(QObject* parent) : QObject(parent),
     d_{std::make_unique<Private>()}
 {
+    QudevTrace::startFromEnvironment();
+    QudevSharedDevice::registerMetaType();
+}
 
+Qudev::Qudev(Source source, QObject* parent) : Qudev(parent)
+{
+    d_->source = source;
 }
 
-Qudev::~Qudev() { stopMonitoring(); }
+Qudev::Qudev(std::unique_ptr<QudevBackend> backend, QObject* parent) : Qudev(parent)
+{
+    d_->backend = std::move(backend);
+    if (d_->backend) {
+        d_->backend->setStats(&d_->stats);
+        d_->backend->setSysattrPolicy(d_->sysattrPolicy);
+        d_->backend->setSysattrReadMode(d_->sysattrReadMode);
+    }
+}
 
-bool Qudev::ensureContext() {
-    if (d_->ctx) return true;
-    if (auto ctx = QudevContext::create()) {
-        d_->ctx = std::make_unique<QudevContext>(std::move(*ctx));
+Qudev::~Qudev()
+{
+    stopMonitoring();
+    if (d_->backend) {
+        d_->backend->setStats(nullptr);
+    }
+}
+
+bool Qudev::ensureBackend() {
+    if (d_->backend) return true;
+    if (d_->source == Source::Broker) {
+        auto broker = std::make_unique<QudevBrokerBackend>();
+        if (broker->isReachable()) {
+            d_->backend = std::move(broker);
+        } else {
+            qWarning() << "[Qudev] No broker at" << broker->socketPath() << ", using libudev";
+        }
+    }
+    if (d_->backend || (d_->backend = QudevBackend::createLibudev())) {
+        d_->backend->setStats(&d_->stats);
+        d_->backend->setSysattrPolicy(d_->sysattrPolicy);
+        d_->backend->setSysattrReadMode(d_->sysattrReadMode);
         return true;
     }
-    qWarning() << "[Qudev] Failed to create QUdevContext";
+    qWarning() << "[Qudev] Failed to create libudev backend";
     return false;
 }
 
@@ -46,36 +99,216 @@ QList<QudevDevice> Qudev::enumerate()
 {
     QList<QudevDevice> list;
 
-    if (!ensureContext()) {
+    if (!ensureBackend()) {
         return list;
     }
 
-    QudevEnumerator enumerator(*d_->ctx);
-    return enumerator.scan(filters_);
+    const quint64 start = QudevStatsCollector::nowNs();
+    QudevEnumerator enumerator(*d_->backend);
+    list = enumerator.scan(filters_);
+    if (d_->query.hasResidual()) {
+        list.removeIf([this](const QudevDevice& device) { return !d_->query.matchesResidual(device); });
+    }
+    d_->stats.recordScan(QudevStatsCollector::nowNs() - start);
+
+    return list;
+}
+
+bool Qudev::enumerate(qsizetype chunkSize, const ChunkHandler& onChunk)
+{
+    if (!ensureBackend() || !onChunk) {
+        return false;
+    }
+
+    chunkSize = qMax<qsizetype>(chunkSize, 1);
+
+    QList<QudevDevice> chunk;
+    chunk.reserve(chunkSize);
+
+    const quint64 start = QudevStatsCollector::nowNs();
+    QudevEnumerator enumerator(*d_->backend);
+    const bool completed = enumerator.scan(filters_, [&](QudevDevice&& device) {
+        if (!d_->query.matchesResidual(device)) {
+            return true;
+        }
+        chunk.push_back(std::move(device));
+        if (chunk.size() < chunkSize) {
+            return true;
+        }
+
+        QList<QudevDevice> full;
+        full.reserve(chunkSize);
+        full.swap(chunk);
+        return onChunk(std::move(full));
+    });
+
+    bool result = completed;
+    if (completed && !chunk.isEmpty()) {
+        result = onChunk(std::move(chunk));
+    }
+
+    // Includes time spent in onChunk, as seen by the caller.
+    d_->stats.recordScan(QudevStatsCollector::nowNs() - start);
+    return result;
+}
+
+QList<QList<QudevSharedDevice>> Qudev::enumerate(const QList<QudevFilters>& filterSets)
+{
+    if (!ensureBackend()) {
+        return QList<QList<QudevSharedDevice>>(filterSets.size());
+    }
+
+    const quint64 start = QudevStatsCollector::nowNs();
+    QList<QList<QudevSharedDevice>> results = QudevEnumerator(*d_->backend).scan(filterSets);
+    d_->stats.recordScan(QudevStatsCollector::nowNs() - start);
+    return results;
+}
+
+QList<QList<QudevSharedDevice>> Qudev::enumerate(const QList<QudevQuery>& queries)
+{
+    if (!ensureBackend()) {
+        return QList<QList<QudevSharedDevice>>(queries.size());
+    }
+
+    // Invalid queries match nothing; left out, they cannot widen the scan.
+    QList<qsizetype> valid;
+    QList<QudevFilters> filterSets;
+    valid.reserve(queries.size());
+    filterSets.reserve(queries.size());
+    for (qsizetype i = 0; i < queries.size(); ++i) {
+        if (queries.at(i).isValid()) {
+            valid << i;
+            filterSets << queries.at(i).filters();
+        }
+    }
+
+    QList<QList<QudevSharedDevice>> results(queries.size());
+    if (valid.isEmpty()) {
+        return results;
+    }
+
+    const quint64 start = QudevStatsCollector::nowNs();
+    QList<QList<QudevSharedDevice>> found = QudevEnumerator(*d_->backend).scan(
+        filterSets, [&queries, &valid](qsizetype set, const QudevDevice& device) {
+            return queries.at(valid.at(set)).matchesResidual(device);
+        });
+    d_->stats.recordScan(QudevStatsCollector::nowNs() - start);
+
+    for (qsizetype set = 0; set < valid.size(); ++set) {
+        results[valid.at(set)] = std::move(found[set]);
+    }
+    return results;
 }
 
 bool Qudev::startMonitoring()
 {
-    if (!ensureContext()) {
+    return openMonitor(std::nullopt, nullptr);
+}
+
+bool Qudev::resumeMonitoring(quint64 seqnum)
+{
+    bool complete = false;
+    if (!openMonitor(seqnum, &complete)) {
+        return false;
+    }
+
+    if (!complete) {
+        emit rescanRequired();
+    }
+    return true;
+}
+
+bool Qudev::openMonitor(std::optional<quint64> resumeAfter, bool* complete)
+{
+    if (d_->hub) {
+        return subscribeHub(resumeAfter, complete);
+    }
+
+    if (!ensureBackend()) {
         return false;
     }
 
     stopMonitoring();
-    d_->mon = std::make_unique<QudevMonitor>(QudevMonitor::Channel::Udev, this);
+    d_->mon = std::make_unique<QudevMonitor>(*d_->backend, QudevMonitor::Channel::Udev, this);
 
-    if (!d_->mon->start(filters_)) {
+    const bool started = resumeAfter ? d_->mon->resume(filters_, *resumeAfter, complete)
+                                     : d_->mon->start(filters_);
+    if (!started) {
         qWarning() << "[Qudev] Failed to start monitor";
         d_->mon.reset();
         return false;
     }
 
-    connect(d_->mon.get(), &QudevMonitor::deviceFound, this, &Qudev::deviceFound);
+    d_->mon->setRecorder(d_->recorder.get());
+    d_->mon->setKernelLatencyTracking(d_->kernelLatencyTracking);
+    d_->mon->setPriorityLanes(d_->priorityLanes);
+    // The monitor matches filters_; the rest of a query is checked here.
+    connect(d_->mon.get(), &QudevMonitor::deviceFound, this, [this](const QudevSharedDevice& device) {
+        if (d_->query.matchesResidual(device)) {
+            emit deviceFound(device);
+        }
+    });
 
     return true;
 }
 
+bool Qudev::subscribeHub(std::optional<quint64> resumeAfter, bool* complete)
+{
+    stopMonitoring();
+
+    // The hub keeps no history to resume from.
+    if (resumeAfter && complete) {
+        *complete = false;
+    }
+
+    d_->subscription = d_->hub->subscribe(filters_, this, [this](const QudevSharedDevice& device) {
+        if (d_->query.matchesResidual(device)) {
+            emit deviceFound(device);
+        }
+    });
+    if (!d_->subscription) {
+        qWarning() << "[Qudev] Failed to subscribe to monitor hub";
+        return false;
+    }
+    return true;
+}
+
 void Qudev::stopMonitoring() {
     if (d_->mon) { d_->mon->stop(); d_->mon.reset(); }
+    if (d_->subscription) {
+        if (d_->hub) {
+            d_->hub->unsubscribe(d_->subscription);
+        }
+        d_->subscription = 0;
+    }
+}
+
+void Qudev::setMonitorHub(QudevMonitorHub* hub)
+{
+    const bool monitoring = d_->mon || d_->subscription;
+    stopMonitoring();
+    d_->hub = hub;
+    if (monitoring) {
+        startMonitoring();
+    }
+}
+
+QudevMonitorHub* Qudev::monitorHub() const
+{
+    return d_->hub;
+}
+
+void Qudev::setPriorityLanes(const QudevPriorityLanes& lanes)
+{
+    d_->priorityLanes = lanes;
+    if (d_->mon) {
+        d_->mon->setPriorityLanes(lanes);
+    }
+}
+
+const QudevPriorityLanes& Qudev::priorityLanes() const
+{
+    return d_->priorityLanes;
 }
 
 const QudevFilters& Qudev::filters() const
@@ -86,6 +319,15 @@ const QudevFilters& Qudev::filters() const
 void Qudev::setFilters(const QudevFilters &filters)
 {
     filters_ = filters;
+    d_->query = QudevQuery();
+
+    if (d_->mon && !d_->mon->setFilters(filters_)) {
+        qWarning() << "[Qudev] Failed to update monitor filters in place, restarting monitor";
+        startMonitoring();
+    }
+    if (d_->subscription && d_->hub && !d_->hub->setFilters(d_->subscription, filters_)) {
+        qWarning() << "[Qudev] Failed to update monitor hub filters";
+    }
 }
 
 void Qudev::clearFilters()
@@ -93,4 +335,128 @@ void Qudev::clearFilters()
     setFilters({});
 }
 
+bool Qudev::setQuery(const QString& query)
+{
+    QudevQuery parsed(query);
+    if (!parsed.isValid()) {
+        qWarning() << "[Qudev] Invalid query at" << parsed.errorPosition() << ":" << parsed.errorString();
+        return false;
+    }
+
+    setFilters(parsed.filters());
+    d_->query = parsed;
+    return true;
+}
+
+QString Qudev::query() const
+{
+    return d_->query.text();
+}
+
+
+
+bool Qudev::startRecording(const QString& path)
+{
+    auto recorder = std::make_unique<QudevEventRecorder>();
+    if (!recorder->open(path)) {
+        qWarning() << "[Qudev] Failed to open event log" << path << ":" << recorder->errorString();
+        return false;
+    }
+
+    d_->recorder = std::move(recorder);
+    if (d_->mon) {
+        d_->mon->setRecorder(d_->recorder.get());
+    }
+
+    return true;
+}
+
+void Qudev::stopRecording()
+{
+    if (d_->mon) {
+        d_->mon->setRecorder(nullptr);
+    }
+    d_->recorder.reset();
+}
+
+bool Qudev::isRecording() const
+{
+    return d_->recorder != nullptr;
+}
+
+QudevStats Qudev::stats() const
+{
+    return d_->stats.snapshot();
+}
+
+QudevStatsCollector* Qudev::statsCollector() const noexcept
+{
+    return &d_->stats;
+}
 
+void Qudev::setStatsInterval(int msec)
+{
+    if (msec <= 0) {
+        delete d_->statsTimer;
+        d_->statsTimer = nullptr;
+        return;
+    }
+
+    if (!d_->statsTimer) {
+        d_->statsTimer = new QTimer(this);
+        connect(d_->statsTimer, &QTimer::timeout, this, [this]() {
+            emit statsUpdated(stats());
+        });
+    }
+    d_->statsTimer->start(msec);
+}
+
+int Qudev::statsInterval() const
+{
+    return d_->statsTimer ? d_->statsTimer->interval() : 0;
+}
+
+const QudevEventTiming& Qudev::eventTiming() const
+{
+    static const QudevEventTiming none;
+    return d_->mon ? d_->mon->timing() : none;
+}
+
+void Qudev::setKernelLatencyTracking(bool enabled)
+{
+    d_->kernelLatencyTracking = enabled;
+    if (d_->mon) {
+        d_->mon->setKernelLatencyTracking(enabled);
+    }
+}
+
+bool Qudev::kernelLatencyTracking() const
+{
+    return d_->kernelLatencyTracking;
+}
+
+void Qudev::setSysattrPolicy(const QudevSysattrPolicy& policy)
+{
+    d_->sysattrPolicy = policy;
+    if (d_->backend) {
+        d_->backend->setSysattrPolicy(policy);
+    }
+}
+
+const QudevSysattrPolicy& Qudev::sysattrPolicy() const
+{
+    return d_->sysattrPolicy;
+}
+
+void Qudev::setSysattrReadMode(QudevSysattrReadMode mode)
+{
+    d_->sysattrReadMode = mode;
+    if (d_->backend) {
+        d_->backend->setSysattrReadMode(mode);
+    }
+}
+
+QudevSysattrReadMode Qudev::sysattrReadMode() const
+{
+    return d_->sysattrReadMode;
+}
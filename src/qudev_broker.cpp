@@ -0,0 +1,753 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include "qudev_broker.h"
+#include "qudev_broker_protocol.h"
+#include "qudev_backend.h"
+#include "qudev_enumerator.h"
+#include "qudev_event_codec.h"
+#include "qudev_index.h"
+#include "qudev_journal.h"
+#include "qudev_monitor.h"
+#include "qudev_shared_snapshot.h"
+#include "qudev_snapshot.h"
+#include "qudev_topology.h"
+#include "qudev_trace.h"
+
+#include <qudev.h>
+
+#include <QDebug>
+#include <QFile>
+#include <QSocketNotifier>
+#include <QTimer>
+
+#include <vector>
+
+#include <cerrno>
+#include <cstring>
+#include <grp.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+
+namespace Proto = QudevBrokerProtocol;
+
+namespace {
+
+constexpr qsizetype ReadChunk = 4 * 1024;
+constexpr int SharedPublishDelayMs = 10;
+
+struct Client
+{
+    int fd = -1;
+    QSocketNotifier* reader = nullptr;
+    QSocketNotifier* writer = nullptr;
+    QByteArray in;
+    QByteArray out;           // unsent bytes from outPos on
+    qsizetype outPos = 0;
+    QudevFilters filters;
+    bool subscribed = false;
+};
+
+/// Resolve a group given by name or number.
+bool resolveGroup(const QString& name, gid_t* gid)
+{
+    bool numeric = false;
+    const uint id = name.toUInt(&numeric);
+    if (numeric) {
+        *gid = gid_t(id);
+        return true;
+    }
+
+    const QByteArray native = name.toLocal8Bit();
+    std::vector<char> buffer(1024);
+    struct group entry{};
+    struct group* found = nullptr;
+    int rc;
+    while ((rc = ::getgrnam_r(native.constData(), &entry, buffer.data(), buffer.size(), &found)) == ERANGE) {
+        buffer.resize(buffer.size() * 2);
+    }
+    if (rc != 0 || !found) {
+        return false;
+    }
+    *gid = found->gr_gid;
+    return true;
+}
+
+/// Whether process @p pid has @p gid among its supplementary groups.
+bool hasSupplementaryGroup(pid_t pid, gid_t gid)
+{
+    QFile status(QStringLiteral("/proc/%1/status").arg(pid));
+    if (!status.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    for (QByteArray line = status.readLine(); !line.isEmpty(); line = status.readLine()) {
+        if (line.startsWith("Groups:")) {
+            for (const QByteArray& group : line.mid(7).simplified().split(' ')) {
+                bool ok = false;
+                if (group.toUInt(&ok) == gid && ok) {
+                    return true;
+                }
+            }
+            return false;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+struct QudevBroker::Private
+{
+    QudevBroker* q;
+    std::unique_ptr<Qudev> qudev;
+
+    /// Live snapshot: enumerated devices updated by events, without action/seqnum.
+    QudevTopology devices;
+
+    /// The same devices, hashed by identity fields, properties and tags.
+    QudevIndex index;
+
+    /// Recent events, for subscribers resuming after a seqnum.
+    std::unique_ptr<QudevJournal> journal = std::make_unique<QudevJournal>();
+
+    std::vector<std::unique_ptr<Client>> clients;
+    int listenFd = -1;
+    QSocketNotifier* listener = nullptr;
+    QString path;
+    QString error;
+    qsizetype maxPendingBytes = 64 * 1024 * 1024;
+    quint64 forwarded = 0;
+
+    // Socket access; socketGid is the group the socket file ended up with.
+    uint socketMode = 0660;
+    QString socketGroup;
+    gid_t socketGid = gid_t(-1);
+
+    // Last snapshot frame, valid while no event changed the device list.
+    QudevFilters cachedFilters;
+    QByteArray cachedSnapshot;
+
+    // Shared memory publication, coalesced by publishTimer.
+    std::unique_ptr<QudevSharedSnapshotWriter> shared;
+    QTimer* publishTimer = nullptr;
+
+    Private() { index.addDefaultIndexes(); }
+
+    void accept();
+    bool allowed(const ucred& peer) const;
+    void read(Client* c);
+    void write(Client* c);
+    bool handle(Client* c, const Proto::Frame& frame);
+    bool send(Client* c, const QByteArray& frame);
+    void remove(Client* c, const char* reason);
+    void onEvent(const QudevSharedDevice& device);
+    const QByteArray& snapshotFrame(const QudevFilters& filters);
+    bool shareSnapshot(Client* c);
+    bool resume(Client* c, quint64 seqnum);
+    void publishShared();
+};
+
+void QudevBroker::Private::accept()
+{
+    const size_t before = clients.size();
+    for (;;)
+    {
+        const int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                qWarning() << "[QudevBroker] accept() failed:" << strerror(errno);
+            }
+            break;
+        }
+
+        // The socket file already gates connect(); this also covers a
+        // mode loosened behind the broker's back.
+        ucred peer{};
+        socklen_t length = sizeof(peer);
+        if (::getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &peer, &length) < 0 || !allowed(peer)) {
+            qWarning() << "[QudevBroker] Rejected client: pid" << peer.pid << "uid" << peer.uid;
+            ::close(fd);
+            continue;
+        }
+
+        auto client = std::make_unique<Client>();
+        Client* c = client.get();
+        c->fd = fd;
+        c->reader = new QSocketNotifier(fd, QSocketNotifier::Read, q);
+        c->writer = new QSocketNotifier(fd, QSocketNotifier::Write, q);
+        c->writer->setEnabled(false);
+        QObject::connect(c->reader, &QSocketNotifier::activated, q, [this, c] { read(c); });
+        QObject::connect(c->writer, &QSocketNotifier::activated, q, [this, c] { write(c); });
+        clients.push_back(std::move(client));
+    }
+
+    if (clients.size() != before) {
+        emit q->clientCountChanged(qsizetype(clients.size()));
+    }
+}
+
+bool QudevBroker::Private::allowed(const ucred& peer) const
+{
+    if (peer.uid == 0 || peer.uid == ::geteuid()) {
+        return true;
+    }
+    // connect() needs write permission on the socket.
+    if (socketMode & S_IWOTH) {
+        return true;
+    }
+    if (!(socketMode & S_IWGRP)) {
+        return false;
+    }
+    return peer.gid == socketGid || hasSupplementaryGroup(peer.pid, socketGid);
+}
+
+void QudevBroker::Private::read(Client* c)
+{
+    // Frames are handled as each chunk arrives, so a client holds at most
+    // one partial request of MaxRequestSize plus one chunk.
+    char chunk[ReadChunk];
+    for (;;)
+    {
+        const ssize_t n = ::recv(c->fd, chunk, sizeof(chunk), 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return;
+        }
+        if (n <= 0) {
+            remove(c, nullptr);   // closed by the client
+            return;
+        }
+        c->in.append(chunk, qsizetype(n));
+
+        qsizetype pos = 0;
+        for (;;)
+        {
+            bool error = false;
+            const auto frame = Proto::nextFrame(c->in.constData() + pos, c->in.size() - pos, &error,
+                                                Proto::MaxRequestSize);
+            if (error) {
+                remove(c, "request too large");
+                return;
+            }
+            if (!frame) {
+                break;
+            }
+            pos += frame->frameSize;
+            if (!handle(c, *frame)) {
+                return;
+            }
+        }
+        c->in.remove(0, pos);
+    }
+}
+
+bool QudevBroker::Private::handle(Client* c, const Proto::Frame& frame)
+{
+    QByteArray reply;
+
+    if (frame.type == Proto::FrameType::MapShared) {
+        return shareSnapshot(c);
+    }
+    if (frame.type != Proto::FrameType::Enumerate && frame.type != Proto::FrameType::Subscribe) {
+        Proto::appendFrame(reply, Proto::FrameType::Error, QByteArrayLiteral("Unexpected frame"));
+        return send(c, reply);
+    }
+
+    QudevFilters filters;
+    quint8 flags = 0;
+    quint64 resumeAfter = 0;
+    QString message;
+    if (!Proto::decodeRequest(frame.payload, frame.size, &filters, &flags, &resumeAfter, &message)) {
+        Proto::appendFrame(reply, Proto::FrameType::Error, message.toUtf8());
+        return send(c, reply);
+    }
+
+    if (frame.type == Proto::FrameType::Subscribe) {
+        c->filters = filters;
+        c->subscribed = true;
+        if (flags & Proto::ResumeAfter) {
+            return resume(c, resumeAfter);
+        }
+        if (!(flags & Proto::WithSnapshot)) {
+            return true;
+        }
+    }
+
+    return send(c, snapshotFrame(filters));
+}
+
+const QByteArray& QudevBroker::Private::snapshotFrame(const QudevFilters& filters)
+{
+    // Agents starting together usually ask the same question.
+    if (!cachedSnapshot.isEmpty() && filters == cachedFilters) {
+        return cachedSnapshot;
+    }
+
+    QUDEV_TRACE_SCOPE("qudev", "broker.snapshot");
+
+    // Matched as a libudev scan would: globs, DEVTYPE, no actions.
+    QList<QudevSharedDevice> selected;
+    const auto keep = [&](const QudevSharedDevice& d) {
+        if (QudevEnumerator::matches(d, filters)) {
+            selected << d;
+        }
+        return true;
+    };
+
+    // The most selective index, else only the subtrees below a syspath prefix.
+    if (index.candidateCount(filters) < index.size()) {
+        for (const QudevSharedDevice& d : index.candidates(filters)) {
+            keep(d);
+        }
+    } else {
+        devices.visitPrefix(filters.syspathPrefix, keep);
+    }
+
+    cachedFilters = filters;
+    cachedSnapshot.clear();
+    Proto::appendFrame(cachedSnapshot, Proto::FrameType::Snapshot, qudevEncodeSnapshot(selected));
+    return cachedSnapshot;
+}
+
+bool QudevBroker::Private::resume(Client* c, quint64 seqnum)
+{
+    QUDEV_TRACE_SCOPE("qudev", "broker.resume");
+
+    QByteArray reply;
+    const char complete = journal->covers(seqnum) ? 1 : 0;
+    Proto::appendFrame(reply, Proto::FrameType::Resumed, &complete, 1);
+
+    // Queued ahead of any live event, as everything runs on this thread.
+    journal->replay(seqnum, [&](QudevDevice&& event) {
+        if (QudevMonitor::applyPostFilters(event, c->filters)) {
+            Proto::appendFrame(reply, Proto::FrameType::Event, qudevEncodeEvent(event));
+        }
+        return true;
+    });
+    return send(c, reply);
+}
+
+bool QudevBroker::Private::shareSnapshot(Client* c)
+{
+    QByteArray reply;
+    if (!shared) {
+        Proto::appendFrame(reply, Proto::FrameType::Error, QByteArrayLiteral("Shared snapshot not enabled"));
+        return send(c, reply);
+    }
+
+    // The descriptor rides on the frame's first byte, so nothing may be queued before it.
+    if (c->out.size() != c->outPos) {
+        Proto::appendFrame(reply, Proto::FrameType::Error, QByteArrayLiteral("Output pending, retry"));
+        return send(c, reply);
+    }
+
+    Proto::appendFrame(reply, Proto::FrameType::Shared, nullptr, 0);
+    if (!Proto::sendWithFd(c->fd, reply, shared->fd())) {
+        remove(c, "cannot pass shared snapshot");
+        return false;
+    }
+    return true;
+}
+
+void QudevBroker::Private::publishShared()
+{
+    if (!shared) {
+        return;
+    }
+
+    QUDEV_TRACE_SCOPE("qudev", "broker.publishShared");
+    if (!shared->publish(qudevEncodeSnapshot(devices.devices()))) {
+        qWarning() << "[QudevBroker]" << shared->errorString();
+    }
+}
+
+bool QudevBroker::Private::send(Client* c, const QByteArray& frame)
+{
+    qsizetype sent = 0;
+    if (c->out.size() == c->outPos) {
+        c->out.clear();
+        c->outPos = 0;
+        while (sent < frame.size()) {
+            const ssize_t n = ::send(c->fd, frame.constData() + sent, size_t(frame.size() - sent),
+                                     MSG_DONTWAIT | MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            }
+            if (n < 0) {
+                remove(c, nullptr);
+                return false;
+            }
+            sent += n;
+        }
+    }
+
+    if (sent == frame.size()) {
+        return true;
+    }
+
+    if (c->out.size() - c->outPos + frame.size() - sent > maxPendingBytes) {
+        remove(c, "too slow, pending output limit exceeded");
+        return false;
+    }
+
+    c->out.append(frame.constData() + sent, frame.size() - sent);
+    c->writer->setEnabled(true);
+    return true;
+}
+
+void QudevBroker::Private::write(Client* c)
+{
+    while (c->outPos < c->out.size()) {
+        const ssize_t n = ::send(c->fd, c->out.constData() + c->outPos, size_t(c->out.size() - c->outPos),
+                                 MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return;
+        }
+        if (n < 0) {
+            remove(c, nullptr);
+            return;
+        }
+        c->outPos += n;
+    }
+
+    c->out.clear();
+    c->outPos = 0;
+    c->writer->setEnabled(false);
+}
+
+void QudevBroker::Private::remove(Client* c, const char* reason)
+{
+    if (reason) {
+        qWarning() << "[QudevBroker] Disconnecting client:" << reason;
+    }
+
+    // May run from the client's own notifier.
+    c->reader->setEnabled(false);
+    c->writer->setEnabled(false);
+    c->reader->deleteLater();
+    c->writer->deleteLater();
+    ::close(c->fd);
+
+    for (auto it = clients.begin(); it != clients.end(); ++it) {
+        if (it->get() == c) {
+            clients.erase(it);
+            break;
+        }
+    }
+
+    emit q->clientCountChanged(qsizetype(clients.size()));
+}
+
+void QudevBroker::Private::onEvent(const QudevSharedDevice& device)
+{
+    QUDEV_TRACE_SCOPE("qudev", "broker.event");
+
+    const QudevDevice& d = device.get();
+    journal->append(d);
+
+    if (d.action == QLatin1String("remove")) {
+        devices.remove(d.syspath);
+        index.remove(d.syspath);
+    } else {
+        if (d.action == QLatin1String("move")) {
+            const QString old = QStringLiteral("/sys") + d.properties.value(QStringLiteral("DEVPATH_OLD"));
+            devices.remove(old);
+            index.remove(old);
+        }
+        QudevDevice atRest = d;
+        atRest.action.clear();
+        atRest.seqnum = 0;
+        const QudevSharedDevice stored(std::move(atRest));
+        devices.insert(stored);
+        index.insert(stored);
+    }
+    cachedSnapshot.clear();
+    if (shared && !publishTimer->isActive()) {
+        publishTimer->start();
+    }
+
+    // Encoded at most once, for however many subscribers match.
+    QByteArray frame;
+    std::vector<Client*> matching;
+    for (const auto& c : clients) {
+        if (c->subscribed && QudevMonitor::applyPostFilters(d, c->filters)) {
+            matching.push_back(c.get());
+        }
+    }
+    if (matching.empty()) {
+        return;
+    }
+
+    Proto::appendFrame(frame, Proto::FrameType::Event, qudevEncodeEvent(d));
+    for (Client* c : matching) {
+        if (send(c, frame)) {
+            ++forwarded;
+        }
+    }
+}
+
+QudevBroker::QudevBroker(QObject* parent)
+    : QObject(parent),
+    d_{std::make_unique<Private>()}
+{
+    d_->q = this;
+    d_->qudev = std::make_unique<Qudev>();
+    connect(d_->qudev.get(), &Qudev::deviceFound, this,
+            [this](const QudevSharedDevice& device) { d_->onEvent(device); });
+    d_->publishTimer = new QTimer(this);
+    d_->publishTimer->setSingleShot(true);
+    d_->publishTimer->setInterval(SharedPublishDelayMs);
+    connect(d_->publishTimer, &QTimer::timeout, this, [this] { d_->publishShared(); });
+}
+
+QudevBroker::QudevBroker(std::unique_ptr<QudevBackend> backend, QObject* parent)
+    : QObject(parent),
+    d_{std::make_unique<Private>()}
+{
+    d_->q = this;
+    d_->qudev = std::make_unique<Qudev>(std::move(backend));
+    connect(d_->qudev.get(), &Qudev::deviceFound, this,
+            [this](const QudevSharedDevice& device) { d_->onEvent(device); });
+    d_->publishTimer = new QTimer(this);
+    d_->publishTimer->setSingleShot(true);
+    d_->publishTimer->setInterval(SharedPublishDelayMs);
+    connect(d_->publishTimer, &QTimer::timeout, this, [this] { d_->publishShared(); });
+}
+
+QudevBroker::~QudevBroker()
+{
+    close();
+}
+
+bool QudevBroker::listen(const QString& path)
+{
+    if (isListening()) {
+        d_->error = QStringLiteral("Already listening on %1").arg(d_->path);
+        return false;
+    }
+    d_->error.clear();
+
+    gid_t group = gid_t(-1);
+    if (!d_->socketGroup.isEmpty() && !resolveGroup(d_->socketGroup, &group)) {
+        d_->error = QStringLiteral("Unknown group: %1").arg(d_->socketGroup);
+        return false;
+    }
+
+    // Monitor first: events racing the scan queue up and are applied after it.
+    d_->journal->markDiscontinuity();
+    if (!d_->qudev->startMonitoring()) {
+        d_->error = QStringLiteral("Failed to start monitoring");
+        return false;
+    }
+
+    d_->devices.clear();
+    d_->index.clear();
+    for (QudevDevice& device : d_->qudev->enumerate()) {
+        const QudevSharedDevice stored(std::move(device));
+        d_->devices.insert(stored);
+        d_->index.insert(stored);
+    }
+    d_->publishShared();
+
+    const QByteArray native = QFile::encodeName(path);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (native.size() >= qsizetype(sizeof(addr.sun_path))) {
+        d_->error = QStringLiteral("Socket path too long: %1").arg(path);
+        d_->qudev->stopMonitoring();
+        return false;
+    }
+    std::memcpy(addr.sun_path, native.constData(), size_t(native.size()));
+
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    int rc = fd < 0 ? -1 : ::bind(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr));
+    if (rc < 0 && errno == EADDRINUSE) {
+        const int probe = Proto::connectTo(path);
+        if (probe >= 0) {
+            ::close(probe);
+            errno = EADDRINUSE;
+        } else {
+            // Left behind by a broker that did not shut down cleanly.
+            ::unlink(native.constData());
+            rc = ::bind(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr));
+        }
+    }
+    const bool bound = rc == 0;
+
+    // Before listen(), so that nobody connects through looser permissions.
+    struct stat st{};
+    if (rc == 0) {
+        rc = ::chmod(native.constData(), mode_t(d_->socketMode));
+    }
+    if (rc == 0 && group != gid_t(-1)) {
+        rc = ::chown(native.constData(), uid_t(-1), group);
+    }
+    if (rc == 0) {
+        rc = ::stat(native.constData(), &st);
+    }
+    if (rc == 0) {
+        rc = ::listen(fd, SOMAXCONN);
+    }
+    if (rc < 0) {
+        d_->error = QStringLiteral("Cannot listen on %1: %2").arg(path, QString::fromLocal8Bit(strerror(errno)));
+        if (bound) {
+            ::unlink(native.constData());
+        }
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        d_->qudev->stopMonitoring();
+        return false;
+    }
+
+    d_->listenFd = fd;
+    d_->path = path;
+    d_->socketGid = st.st_gid;
+    d_->listener = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+    connect(d_->listener, &QSocketNotifier::activated, this, [this] { d_->accept(); });
+
+    return true;
+}
+
+void QudevBroker::close()
+{
+    while (!d_->clients.empty()) {
+        d_->remove(d_->clients.back().get(), nullptr);
+    }
+
+    if (d_->listenFd >= 0) {
+        delete d_->listener;
+        d_->listener = nullptr;
+        ::close(d_->listenFd);
+        d_->listenFd = -1;
+        ::unlink(QFile::encodeName(d_->path).constData());
+    }
+
+    d_->qudev->stopMonitoring();
+    d_->devices.clear();
+    d_->index.clear();
+    d_->cachedSnapshot.clear();
+    d_->publishTimer->stop();
+}
+
+uint QudevBroker::socketMode() const noexcept
+{
+    return d_->socketMode;
+}
+
+void QudevBroker::setSocketMode(uint mode) noexcept
+{
+    d_->socketMode = mode;
+}
+
+QString QudevBroker::socketGroup() const
+{
+    return d_->socketGroup;
+}
+
+void QudevBroker::setSocketGroup(const QString& group)
+{
+    d_->socketGroup = group;
+}
+
+bool QudevBroker::isListening() const noexcept
+{
+    return d_->listenFd >= 0;
+}
+
+QString QudevBroker::socketPath() const
+{
+    return d_->path;
+}
+
+QString QudevBroker::errorString() const
+{
+    return d_->error;
+}
+
+Qudev& QudevBroker::qudev() noexcept
+{
+    return *d_->qudev;
+}
+
+qsizetype QudevBroker::clientCount() const noexcept
+{
+    return qsizetype(d_->clients.size());
+}
+
+qsizetype QudevBroker::deviceCount() const noexcept
+{
+    return d_->devices.size();
+}
+
+quint64 QudevBroker::eventsForwarded() const noexcept
+{
+    return d_->forwarded;
+}
+
+qsizetype QudevBroker::maxPendingBytes() const noexcept
+{
+    return d_->maxPendingBytes;
+}
+
+void QudevBroker::setMaxPendingBytes(qsizetype bytes) noexcept
+{
+    d_->maxPendingBytes = bytes;
+}
+
+bool QudevBroker::setSharedSnapshotEnabled(bool enabled)
+{
+    if (!enabled) {
+        d_->publishTimer->stop();
+        d_->shared.reset();
+        return true;
+    }
+    if (d_->shared) {
+        return true;
+    }
+
+    auto shared = std::make_unique<QudevSharedSnapshotWriter>();
+    if (!shared->isValid()) {
+        d_->error = shared->errorString();
+        return false;
+    }
+    d_->shared = std::move(shared);
+    if (isListening()) {
+        d_->publishShared();
+    }
+    return true;
+}
+
+bool QudevBroker::sharedSnapshotEnabled() const noexcept
+{
+    return d_->shared != nullptr;
+}
+
+QudevJournal& QudevBroker::journal() noexcept
+{
+    return *d_->journal;
+}
+
+void QudevBroker::setJournalCapacity(qsizetype bytes)
+{
+    d_->journal = std::make_unique<QudevJournal>(bytes);
+}
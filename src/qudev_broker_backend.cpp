@@ -0,0 +1,445 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include "qudev_broker_backend.h"
+#include "qudev_broker_protocol.h"
+#include "qudev_event_codec.h"
+#include "qudev_snapshot.h"
+#include "qudev_stats_collector.h"
+#include "qudev_trace.h"
+
+#include <QDeadlineTimer>
+#include <QDebug>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+
+namespace Proto = QudevBrokerProtocol;
+
+namespace {
+
+constexpr qsizetype ReadChunk = 64 * 1024;
+
+/// Delay before the first reconnection attempt; doubled per failure.
+constexpr int ReconnectInitialMs = 100;
+/// Longest delay between reconnection attempts.
+constexpr int ReconnectMaxMs = 5000;
+
+/// Append what @p fd has to @p buffer; returns the recv() result.
+ssize_t readInto(int fd, QByteArray& buffer, int flags) noexcept
+{
+    const qsizetype old = buffer.size();
+    buffer.resize(old + ReadChunk);
+    ssize_t n;
+    do {
+        n = ::recv(fd, buffer.data() + old, size_t(ReadChunk), flags);
+    } while (n < 0 && errno == EINTR);
+    buffer.resize(old + (n > 0 ? qsizetype(n) : 0));
+    return n;
+}
+
+bool sendRequest(int fd, Proto::FrameType type, const QudevFilters& filters, quint8 flags = 0,
+                 quint64 resumeAfter = 0) noexcept
+{
+    const QByteArray request = Proto::encodeRequest(filters, flags, resumeAfter);
+    if (request.size() > qsizetype(Proto::MaxRequestSize)) {
+        qWarning() << "[QudevBrokerBackend] Filters too large for the broker:" << request.size() << "bytes";
+        errno = EMSGSIZE;
+        return false;
+    }
+
+    QByteArray frame;
+    Proto::appendFrame(frame, type, request);
+    return Proto::writeAll(fd, frame.constData(), frame.size());
+}
+
+/// One subscription; events arrive as frames on its own connection.
+class BrokerMonitorSource final : public QudevBackend::MonitorSource
+{
+public:
+    BrokerMonitorSource(const QudevBackend& owner, QString socketPath, int fd,
+                        const QudevFilters& filters, QByteArray pending = {}, quint64 lastSeqnum = 0) noexcept
+        : owner_(owner),
+        socketPath_(std::move(socketPath)),
+        fd_(fd),
+        filters_(filters),
+        buffer_(std::move(pending)),
+        lastSeqnum_(lastSeqnum)
+    {}
+
+    ~BrokerMonitorSource() override
+    {
+        ::close(fd_);
+    }
+
+    int fd() const noexcept override
+    {
+        return fd_;
+    }
+
+    std::optional<QudevDevice> receive() noexcept override
+    {
+        for (;;)
+        {
+            if (parked_ && !retry()) {
+                return std::nullopt;
+            }
+
+            bool error = false;
+            const auto frame = Proto::nextFrame(buffer_.constData() + pos_, buffer_.size() - pos_, &error);
+            if (error) {
+                qWarning() << "[QudevBrokerBackend] Protocol error from broker";
+                reconnect();
+                continue;
+            }
+
+            if (frame) {
+                pos_ += frame->frameSize;
+                if (frame->type == Proto::FrameType::Event) {
+                    QudevStatsCollector* stats = owner_.stats();
+                    const quint64 t0 = stats ? QudevStatsCollector::nowNs() : 0;
+                    QudevDevice device = qudevDecodeEvent(frame->payload, frame->size);
+                    if (stats) {
+                        stats->build.record(QudevStatsCollector::nowNs() - t0);
+                    }
+                    lastSeqnum_ = std::max(lastSeqnum_, device.seqnum);
+                    return device;
+                }
+                if (frame->type == Proto::FrameType::Resumed && !(frame->size > 0 && frame->payload[0])) {
+                    qWarning() << "[QudevBrokerBackend] Events after seqnum" << lastSeqnum_
+                               << "were lost while reconnecting";
+                }
+                if (frame->type == Proto::FrameType::Error) {
+                    qWarning() << "[QudevBrokerBackend] Broker error:"
+                               << QString::fromUtf8(frame->payload, frame->size);
+                }
+                continue;
+            }
+
+            // Need more bytes: drop consumed frames, then read.
+            buffer_.remove(0, pos_);
+            pos_ = 0;
+
+            const ssize_t n = readInto(fd_, buffer_, MSG_DONTWAIT);
+            if (n > 0) {
+                continue;
+            }
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                return std::nullopt;
+            }
+
+            qWarning() << "[QudevBrokerBackend] Lost connection to broker:"
+                       << (n == 0 ? QStringLiteral("closed") : QString::fromLocal8Bit(strerror(errno)));
+            reconnect();
+        }
+    }
+
+    bool setFilters(const QudevFilters& filters) noexcept override
+    {
+        filters_ = filters;
+        return parked_ || sendRequest(fd_, Proto::FrameType::Subscribe, filters_);
+    }
+
+private:
+    /**
+     * Resubscribe on a new connection, keeping the descriptor number the
+     * owner watches. The broker replays what its journal holds after the
+     * last event delivered. If the broker is gone, park on a timerfd in
+     * its place that wakes the owner for the next attempt, backing off
+     * from @ref ReconnectInitialMs to @ref ReconnectMaxMs.
+     */
+    void reconnect() noexcept
+    {
+        buffer_.clear();
+        pos_ = 0;
+
+        if (subscribe()) {
+            return;
+        }
+
+        qWarning() << "[QudevBrokerBackend] Broker unavailable, retrying";
+        const int timer = ::timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+        if (timer >= 0) {
+            ::dup2(timer, fd_);
+            ::close(timer);
+        }
+        parked_ = true;
+        backoffMs_ = ReconnectInitialMs;
+        arm();
+    }
+
+    /// Called while parked; true once connected again.
+    bool retry() noexcept
+    {
+        quint64 expirations = 0;
+        if (::read(fd_, &expirations, sizeof(expirations)) != ssize_t(sizeof(expirations))) {
+            return false;   // not due yet
+        }
+
+        if (subscribe()) {
+            qInfo() << "[QudevBrokerBackend] Reconnected to broker";
+            parked_ = false;
+            return true;
+        }
+
+        backoffMs_ = std::min(backoffMs_ * 2, ReconnectMaxMs);
+        arm();
+        return false;
+    }
+
+    /// Subscribe on a new connection and put it in place of @ref fd_.
+    bool subscribe() noexcept
+    {
+        const quint8 flags = lastSeqnum_ ? Proto::ResumeAfter : 0;
+        const int fd = Proto::connectTo(socketPath_);
+        if (fd < 0) {
+            return false;
+        }
+        if (!sendRequest(fd, Proto::FrameType::Subscribe, filters_, flags, lastSeqnum_)) {
+            ::close(fd);
+            return false;
+        }
+
+        ::dup2(fd, fd_);
+        ::close(fd);
+        return true;
+    }
+
+    /// Make the parked timerfd readable after the current backoff.
+    void arm() noexcept
+    {
+        itimerspec spec{};
+        spec.it_value.tv_sec = backoffMs_ / 1000;
+        spec.it_value.tv_nsec = long(backoffMs_ % 1000) * 1000000L;
+        ::timerfd_settime(fd_, 0, &spec, nullptr);
+    }
+
+    const QudevBackend& owner_;
+    QString socketPath_;
+    int fd_;
+    QudevFilters filters_;
+    QByteArray buffer_;
+    qsizetype pos_ = 0;
+    quint64 lastSeqnum_ = 0;
+    bool parked_ = false;
+    int backoffMs_ = ReconnectInitialMs;
+};
+
+} // namespace
+
+QudevBrokerBackend::QudevBrokerBackend(const QString& socketPath)
+    : socketPath_(socketPath)
+{}
+
+QudevBrokerBackend::~QudevBrokerBackend()
+{
+    disconnect();
+}
+
+QString QudevBrokerBackend::defaultSocketPath()
+{
+    return Proto::defaultSocketPath();
+}
+
+QString QudevBrokerBackend::socketPath() const
+{
+    return socketPath_;
+}
+
+bool QudevBrokerBackend::isReachable() const noexcept
+{
+    const int fd = Proto::connectTo(socketPath_);
+    if (fd < 0) {
+        return false;
+    }
+    ::close(fd);
+    return true;
+}
+
+void QudevBrokerBackend::setTimeout(int msec) noexcept
+{
+    timeoutMs_ = msec;
+}
+
+void QudevBrokerBackend::disconnect() noexcept
+{
+    if (controlFd_ >= 0) {
+        ::close(controlFd_);
+        controlFd_ = -1;
+    }
+}
+
+bool QudevBrokerBackend::request(const QudevFilters& filters, QByteArray* snapshot) noexcept
+{
+    // The control connection is kept open; one retry covers a broker restart.
+    for (int attempt = 0; attempt < 2; ++attempt)
+    {
+        if (controlFd_ < 0 && (controlFd_ = Proto::connectTo(socketPath_)) < 0) {
+            qWarning() << "[QudevBrokerBackend] Cannot connect to" << socketPath_ << ":" << strerror(errno);
+            return false;
+        }
+
+        if (!sendRequest(controlFd_, Proto::FrameType::Enumerate, filters)) {
+            disconnect();
+            continue;
+        }
+
+        QByteArray buffer;
+        const QDeadlineTimer deadline(timeoutMs_);
+        for (;;)
+        {
+            bool error = false;
+            const auto frame = Proto::nextFrame(buffer.constData(), buffer.size(), &error);
+            if (error) {
+                qWarning() << "[QudevBrokerBackend] Protocol error from broker";
+                disconnect();
+                return false;
+            }
+            if (frame && frame->type == Proto::FrameType::Snapshot) {
+                *snapshot = buffer.sliced(Proto::FrameHeaderSize, frame->size);
+                return true;
+            }
+            if (frame && frame->type == Proto::FrameType::Error) {
+                qWarning() << "[QudevBrokerBackend] Broker error:" << QString::fromUtf8(frame->payload, frame->size);
+                return false;
+            }
+            if (frame) {
+                buffer.remove(0, frame->frameSize);
+                continue;
+            }
+
+            pollfd pfd{ controlFd_, POLLIN, 0 };
+            const int ready = ::poll(&pfd, 1, int(deadline.remainingTime()));
+            if (ready == 0) {
+                qWarning() << "[QudevBrokerBackend] Timed out waiting for a snapshot";
+                disconnect();
+                return false;
+            }
+            if (ready < 0 && errno == EINTR) {
+                continue;
+            }
+            if (ready < 0 || readInto(controlFd_, buffer, 0) <= 0) {
+                break;
+            }
+        }
+
+        // Connection lost; a partial reply is useless.
+        disconnect();
+    }
+
+    qWarning() << "[QudevBrokerBackend] Lost connection to" << socketPath_;
+    return false;
+}
+
+bool QudevBrokerBackend::enumerate(const QudevFilters& filters, const Visitor& visit) noexcept
+{
+    QByteArray data;
+    {
+        QUDEV_TRACE_SCOPE("qudev", "broker.request");
+        if (!request(filters, &data)) {
+            return false;
+        }
+    }
+
+    const QudevSnapshotReader reader(data);
+    if (!reader.isValid()) {
+        qWarning() << "[QudevBrokerBackend] Invalid snapshot:" << reader.errorString();
+        return false;
+    }
+
+    for (qsizetype i = 0; i < reader.deviceCount(); ++i) {
+        if (!visit(reader.device(i).toDevice())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::unique_ptr<QudevBackend::MonitorSource>
+QudevBrokerBackend::createMonitor(MonitorChannel channel, const QudevFilters& filters) noexcept
+{
+    if (channel != MonitorChannel::Udev) {
+        qWarning() << "[QudevBrokerBackend] Only the udev channel is served by the broker";
+        return nullptr;
+    }
+
+    const int fd = Proto::connectTo(socketPath_);
+    if (fd < 0) {
+        qWarning() << "[QudevBrokerBackend] Cannot connect to" << socketPath_ << ":" << strerror(errno);
+        return nullptr;
+    }
+
+    if (!sendRequest(fd, Proto::FrameType::Subscribe, filters)) {
+        qWarning() << "[QudevBrokerBackend] Failed to subscribe:" << strerror(errno);
+        ::close(fd);
+        return nullptr;
+    }
+
+    return std::make_unique<BrokerMonitorSource>(*this, socketPath_, fd, filters);
+}
+
+std::unique_ptr<QudevBackend::MonitorSource>
+QudevBrokerBackend::resumeMonitor(MonitorChannel channel, const QudevFilters& filters,
+                                  quint64 seqnum, bool* complete) noexcept
+{
+    *complete = false;
+    if (channel != MonitorChannel::Udev) {
+        qWarning() << "[QudevBrokerBackend] Only the udev channel is served by the broker";
+        return nullptr;
+    }
+
+    const int fd = Proto::connectTo(socketPath_);
+    if (fd < 0) {
+        qWarning() << "[QudevBrokerBackend] Cannot connect to" << socketPath_ << ":" << strerror(errno);
+        return nullptr;
+    }
+
+    if (!sendRequest(fd, Proto::FrameType::Subscribe, filters, Proto::ResumeAfter, seqnum)) {
+        qWarning() << "[QudevBrokerBackend] Failed to subscribe:" << strerror(errno);
+        ::close(fd);
+        return nullptr;
+    }
+
+    // Wait for the verdict; replayed events behind it stay buffered for the source.
+    QByteArray buffer;
+    const QDeadlineTimer deadline(timeoutMs_);
+    for (;;)
+    {
+        bool error = false;
+        const auto frame = Proto::nextFrame(buffer.constData(), buffer.size(), &error);
+        if (frame && frame->type == Proto::FrameType::Resumed) {
+            *complete = frame->size > 0 && frame->payload[0];
+            buffer.remove(0, frame->frameSize);
+            return std::make_unique<BrokerMonitorSource>(*this, socketPath_, fd, filters, std::move(buffer),
+                                                         seqnum);
+        }
+        if (error || frame) {
+            qWarning() << "[QudevBrokerBackend] Unexpected reply to resume request";
+            break;
+        }
+
+        pollfd pfd{ fd, POLLIN, 0 };
+        const int ready = ::poll(&pfd, 1, int(deadline.remainingTime()));
+        if (ready < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ready <= 0 || readInto(fd, buffer, 0) <= 0) {
+            qWarning() << "[QudevBrokerBackend] No reply to resume request";
+            break;
+        }
+    }
+
+    ::close(fd);
+    return nullptr;
+}
@@ -0,0 +1,210 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include "qudev_broker_protocol.h"
+#include "qudev_filters.h"
+
+#include <QDataStream>
+#include <QFile>
+#include <QtEndian>
+
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+
+namespace QudevBrokerProtocol {
+
+void appendFrame(QByteArray& out, FrameType type, const char* payload, qsizetype size)
+{
+    char header[FrameHeaderSize];
+    qToLittleEndian(quint32(size), header);
+    header[4] = char(type);
+    out.append(header, FrameHeaderSize);
+    out.append(payload, size);
+}
+
+std::optional<Frame> nextFrame(const char* data, qsizetype size, bool* error, quint32 maxSize)
+{
+    *error = false;
+    if (size < FrameHeaderSize) {
+        return std::nullopt;
+    }
+
+    const quint32 payloadSize = qFromLittleEndian<quint32>(data);
+    if (payloadSize > maxSize) {
+        *error = true;
+        return std::nullopt;
+    }
+    if (size - FrameHeaderSize < qsizetype(payloadSize)) {
+        return std::nullopt;
+    }
+
+    return Frame{ FrameType(quint8(data[4])), data + FrameHeaderSize, qsizetype(payloadSize),
+                  FrameHeaderSize + qsizetype(payloadSize) };
+}
+
+QByteArray encodeRequest(const QudevFilters& f, quint8 flags, quint64 resumeAfter)
+{
+    QByteArray out;
+    QDataStream s(&out, QIODevice::WriteOnly);
+    s.setVersion(QDataStream::Qt_6_0);
+    s << Version << flags
+      << f.subsystem << f.devtype << f.sysname << f.devnode << f.syspathPrefix
+      << f.tags << f.actions
+      << f.properties << f.sysattrs << f.nomatchSysattrs;
+    if (flags & ResumeAfter) {
+        s << resumeAfter;
+    }
+    return out;
+}
+
+bool decodeRequest(const char* data, qsizetype size, QudevFilters* f, quint8* flags,
+                   quint64* resumeAfter, QString* error)
+{
+    const QByteArray raw = QByteArray::fromRawData(data, size);
+    QDataStream s(raw);
+    s.setVersion(QDataStream::Qt_6_0);
+
+    quint16 version = 0;
+    s >> version;
+    if (version != Version) {
+        *error = QStringLiteral("Unsupported protocol version %1 (broker speaks %2)").arg(version).arg(Version);
+        return false;
+    }
+
+    s >> *flags
+      >> f->subsystem >> f->devtype >> f->sysname >> f->devnode >> f->syspathPrefix
+      >> f->tags >> f->actions
+      >> f->properties >> f->sysattrs >> f->nomatchSysattrs;
+    *resumeAfter = 0;
+    if (*flags & ResumeAfter) {
+        s >> *resumeAfter;
+    }
+    if (s.status() != QDataStream::Ok) {
+        *error = QStringLiteral("Malformed request");
+        return false;
+    }
+
+    return true;
+}
+
+QString defaultSocketPath()
+{
+    const QString path = qEnvironmentVariable("QUDEV_BROKER_SOCKET");
+    return path.isEmpty() ? QStringLiteral("/run/qudev/qudevd.sock") : path;
+}
+
+int connectTo(const QString& path) noexcept
+{
+    const QByteArray native = QFile::encodeName(path);
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (native.size() >= qsizetype(sizeof(addr.sun_path))) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    std::memcpy(addr.sun_path, native.constData(), size_t(native.size()));
+
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    if (::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) < 0) {
+        const int saved = errno;
+        ::close(fd);
+        errno = saved;
+        return -1;
+    }
+
+    return fd;
+}
+
+bool writeAll(int fd, const char* data, qsizetype size) noexcept
+{
+    while (size > 0) {
+        const ssize_t n = ::send(fd, data, size_t(size), MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+
+bool sendWithFd(int fd, const QByteArray& frame, int passFd) noexcept
+{
+    iovec iov{ const_cast<char*>(frame.constData()), size_t(frame.size()) };
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    std::memcpy(CMSG_DATA(cmsg), &passFd, sizeof(int));
+
+    ssize_t n;
+    do {
+        n = ::sendmsg(fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+    } while (n < 0 && errno == EINTR);
+    return n == frame.size();
+}
+
+qsizetype receiveWithFd(int fd, char* data, qsizetype size, int* passFd) noexcept
+{
+    iovec iov{ data, size_t(size) };
+    alignas(cmsghdr) char control[CMSG_SPACE(4 * sizeof(int))];
+
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    ssize_t n;
+    do {
+        n = ::recvmsg(fd, &msg, MSG_CMSG_CLOEXEC);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0) {
+        return -1;
+    }
+
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+            continue;
+        }
+        const size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        for (size_t i = 0; i < count; ++i) {
+            int received;
+            std::memcpy(&received, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(int));
+            if (*passFd < 0) {
+                *passFd = received;
+            } else {
+                ::close(received);
+            }
+        }
+    }
+
+    return qsizetype(n);
+}
+
+} // namespace QudevBrokerProtocol
@@ -0,0 +1,130 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+
+#include <optional>
+
+struct QudevFilters;
+
+/**
+ * @file qudev_broker_protocol.h
+ * @brief Internal wire protocol between @ref QudevBroker and its clients.
+ *
+ * A stream socket carries frames of <tt>u32 payloadSize, u8 type,
+ * payload</tt> (little-endian). Clients send @c Enumerate or
+ * @c Subscribe; both start with the u16 protocol version followed by the
+ * filters. The broker answers @c Enumerate with one @c Snapshot
+ * (@ref qudevEncodeSnapshot() of the matching devices) and streams an
+ * @c Event (@ref qudevEncodeEvent()) for every matching event after a
+ * @c Subscribe. A later @c Subscribe on the same connection replaces the
+ * filters. Anything the broker cannot serve is answered with @c Error
+ * (UTF-8 text).
+ *
+ * A @c Subscribe with @c ResumeAfter is answered with @c Resumed (u8: 1 if
+ * the broker's journal still holds every event after the seqnum, else 0),
+ * followed by the journaled events matching the filters.
+ *
+ * @c MapShared (payload: the u16 protocol version) asks for the memfd of
+ * the broker's @ref QudevSharedSnapshotWriter; the empty @c Shared reply
+ * carries it as @c SCM_RIGHTS ancillary data on its first byte.
+ */
+namespace QudevBrokerProtocol {
+
+constexpr quint16 Version = 1;
+constexpr int FrameHeaderSize = 5;
+/// Larger frames are a protocol error.
+constexpr quint32 MaxFrameSize = 256 * 1024 * 1024;
+/// Larger client requests are a protocol error; the broker drops the client.
+constexpr quint32 MaxRequestSize = 8 * 1024;
+
+enum class FrameType : quint8 {
+    Enumerate = 1,
+    Subscribe = 2,
+    Snapshot = 3,
+    Event = 4,
+    Error = 5,
+    MapShared = 6,
+    Shared = 7,
+    Resumed = 8,
+};
+
+/// Subscribe flag: send a @c Snapshot of matching devices before the first event.
+constexpr quint8 WithSnapshot = 1;
+/// Subscribe flag: a u64 seqnum follows the filters; see @c Resumed.
+constexpr quint8 ResumeAfter = 2;
+
+/// Append a frame of @p type carrying @p payload to @p out.
+void appendFrame(QByteArray& out, FrameType type, const char* payload, qsizetype size);
+
+inline void appendFrame(QByteArray& out, FrameType type, const QByteArray& payload)
+{
+    appendFrame(out, type, payload.constData(), payload.size());
+}
+
+/// A frame inside a receive buffer; @c payload points into the buffer.
+struct Frame
+{
+    FrameType type;
+    const char* payload;
+    qsizetype size;
+    /// Bytes the frame occupies in the buffer, header included.
+    qsizetype frameSize;
+};
+
+/**
+ * @brief Locate the first complete frame in @p data.
+ *
+ * @return The frame, or an empty optional if more bytes are needed. Sets
+ *         @p error if the data can never form a valid frame, i.e. its
+ *         header announces more than @p maxSize payload bytes.
+ */
+std::optional<Frame> nextFrame(const char* data, qsizetype size, bool* error,
+                               quint32 maxSize = MaxFrameSize);
+
+/// Payload of an @c Enumerate or @c Subscribe request.
+QByteArray encodeRequest(const QudevFilters& filters, quint8 flags = 0, quint64 resumeAfter = 0);
+
+/**
+ * @brief Decode a request payload.
+ *
+ * @return @c false with @p error set on version mismatch or bad data.
+ */
+bool decodeRequest(const char* data, qsizetype size, QudevFilters* filters, quint8* flags,
+                   quint64* resumeAfter, QString* error);
+
+/// Default broker socket: @c $QUDEV_BROKER_SOCKET, else @c /run/qudev/qudevd.sock.
+QString defaultSocketPath();
+
+/// Connect a blocking stream socket to @p path; -1 with @c errno set on failure.
+int connectTo(const QString& path) noexcept;
+
+/// Write all of @p data to blocking @p fd; @c false on error.
+bool writeAll(int fd, const char* data, qsizetype size) noexcept;
+
+/**
+ * @brief Send @p frame on non-blocking @p fd with @p passFd attached.
+ *
+ * @return @c false unless the whole frame was sent at once.
+ */
+bool sendWithFd(int fd, const QByteArray& frame, int passFd) noexcept;
+
+/**
+ * @brief Receive up to @p size bytes from @p fd, accepting one passed descriptor.
+ *
+ * A descriptor arriving with the data is stored in @p passFd (close-on-exec);
+ * any further ones are closed.
+ *
+ * @return Bytes received, 0 on EOF, -1 with @c errno set on error.
+ */
+qsizetype receiveWithFd(int fd, char* data, qsizetype size, int* passFd) noexcept;
+
+} // namespace QudevBrokerProtocol
@@ -24,15 +24,26 @@ void QudevContext::reset() noexcept {
     }
 }
 
-QudevContext::QudevContext(QudevContext&& other) noexcept : ctx_(other.ctx_) {
+QudevContext::QudevContext(QudevContext&& other) noexcept
+    : ctx_(other.ctx_), stats_(other.stats_), sysattrCache_(other.sysattrCache_),
+    sysattrReader_(other.sysattrReader_) {
     other.ctx_ = nullptr;
+    other.stats_ = nullptr;
+    other.sysattrCache_ = nullptr;
+    other.sysattrReader_ = nullptr;
 }
 
 QudevContext& QudevContext::operator=(QudevContext&& other) noexcept {
     if (this != &other) {
         reset();
         ctx_ = other.ctx_;
+        stats_ = other.stats_;
+        sysattrCache_ = other.sysattrCache_;
+        sysattrReader_ = other.sysattrReader_;
         other.ctx_ = nullptr;
+        other.stats_ = nullptr;
+        other.sysattrCache_ = nullptr;
+        other.sysattrReader_ = nullptr;
     }
     return *this;
 }
@@ -11,6 +11,9 @@
 #include <optional>
 
 struct udev;
+class QudevStatsCollector;
+class QudevSysattrCache;
+class QudevSysattrReader;
 
 /**
  * @file qudev_context.h
@@ -58,6 +61,31 @@ public:
      */
     bool valid() const noexcept { return ctx_ != nullptr; }
 
+    /**
+     * @brief Statistics collector fed by helpers using this context.
+     */
+    QudevStatsCollector* stats() const noexcept { return stats_; }
+
+    /// Attach a statistics collector, or detach with @c nullptr.
+    void setStats(QudevStatsCollector* stats) noexcept { stats_ = stats; }
+
+    /**
+     * @brief Sysattr value cache consulted by @ref buildDevice().
+     */
+    QudevSysattrCache* sysattrCache() const noexcept { return sysattrCache_; }
+
+    /// Attach a sysattr cache, or detach with @c nullptr.
+    void setSysattrCache(QudevSysattrCache* cache) noexcept { sysattrCache_ = cache; }
+
+    /**
+     * @brief Bulk reader used by @ref buildDevice() for sysattr values;
+     *        @c nullptr reads them one libudev call at a time.
+     */
+    QudevSysattrReader* sysattrReader() const noexcept { return sysattrReader_; }
+
+    /// Attach a bulk sysattr reader, or detach with @c nullptr.
+    void setSysattrReader(QudevSysattrReader* reader) noexcept { sysattrReader_ = reader; }
+
 private:
     /// Construct from an already-created udev* (takes ownership).
     explicit QudevContext(udev* p) noexcept : ctx_(p) {}
@@ -66,4 +94,7 @@ private:
     void reset() noexcept;
 
     udev* ctx_ = nullptr; //!< Owned libudev context handle.
+    QudevStatsCollector* stats_ = nullptr; //!< Not owned.
+    QudevSysattrCache* sysattrCache_ = nullptr; //!< Not owned.
+    QudevSysattrReader* sysattrReader_ = nullptr; //!< Not owned.
 };
@@ -8,20 +8,93 @@
 
 #include "qudev_device.h"
 #include "qudev_context.h"
+#include "qudev_stats_collector.h"
+#include "qudev_sysattr_cache.h"
+#include "qudev_sysattr_reader.h"
+#include "qudev_trace.h"
 
+#include <fcntl.h>
 #include <libudev.h>
 #include <sys/stat.h>
 #include <sys/sysmacros.h>
+#include <unistd.h>
 #include <QVariantMap>
 
+#include <cerrno>
+#include <cstring>
+#include <vector>
 
-QudevDevice buildDevice(const QudevContext&, udev_device* d)
+
+namespace {
+
+/// Sysattr values collected from one or more devices for one bulk read.
+struct SysattrBatch
 {
-    const auto toQString = [](const char* s) {
-        return QString::fromLocal8Bit(s ? s : "");
+    struct Target
+    {
+        QudevDevice* device;
+        QString key;
+        bool cacheable;
     };
 
-    QudevDevice device;
+    std::vector<QudevSysattrReader::Request> requests;
+    std::vector<Target> targets;
+};
+
+/// Symlinked attributes that libudev resolves to their target's basename.
+bool isResolvedLink(const char* name)
+{
+    return !strcmp(name, "driver") || !strcmp(name, "subsystem") || !strcmp(name, "module");
+}
+
+QString toQString(const char* s)
+{
+    return QString::fromLocal8Bit(s ? s : "");
+}
+
+/**
+ * Whether attribute @p name of the device directory @p syspath is a file
+ * larger than @p limit. sysfs reports exactly one page for text
+ * attributes, so that size never counts as oversized. The directory is
+ * opened on first use into @p dirFd (-1: not yet, -2: failed); the caller
+ * closes it.
+ */
+bool isOversized(int& dirFd, const char* syspath, const char* name, qint64 limit)
+{
+    if (dirFd == -1) {
+        dirFd = ::open(syspath, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (dirFd < 0) {
+            dirFd = -2;
+        }
+    }
+
+    static const off_t pageSize = off_t(::sysconf(_SC_PAGESIZE));
+
+    struct stat st;
+    return dirFd >= 0
+        && ::fstatat(dirFd, name, &st, AT_SYMLINK_NOFOLLOW) == 0
+        && S_ISREG(st.st_mode)
+        && st.st_size > limit
+        && st.st_size != pageSize;
+}
+
+/// Count a read skipped by the policy or by learned slowness.
+void countSkipped(QudevStatsCollector* stats, const QudevSysattrCache& cache,
+                  const QString& subsystem, const QString& attribute)
+{
+    if (stats) {
+        QudevStatsCollector::add(cache.policy().isDenied(subsystem, attribute)
+                                     ? stats->sysattrsDenied : stats->sysattrsSlow);
+    }
+}
+
+/**
+ * Fill @p device from @p d. Sysattrs not served from the cache are read
+ * right away, or queued in @p batch if one is given.
+ */
+void fillDevice(const QudevContext& ctx, udev_device* d, QudevDevice& device, SysattrBatch* batch)
+{
+    QUDEV_TRACE_SCOPE("qudev", "buildDevice");
 
     device.syspath   = toQString(udev_device_get_syspath(d));
     device.devnode   = toQString(udev_device_get_devnode(d));
@@ -51,10 +124,77 @@ QudevDevice buildDevice(const QudevContext&, udev_device* d)
     for (udev_list_entry* e = udev_device_get_properties_list_entry(d); e; e = udev_list_entry_get_next(e))
         device.properties.insert(toQString(udev_list_entry_get_name(e)), toQString(udev_list_entry_get_value(e)));
 
-    // sysattrs
+    // sysattrs, served from the cache where the policy allows
+    QudevStatsCollector* stats = ctx.stats();
+    QudevSysattrCache* cache = ctx.sysattrCache();
+    QudevSysattrCache::Device* cached = cache
+        ? cache->device(device.syspath, device.subsystem,
+                        device.properties.value(QStringLiteral("USEC_INITIALIZED")), device.action)
+        : nullptr;
+    const qint64 now = cached ? qint64(QudevStatsCollector::nowNs()) : 0;
+    const qint64 maxValueSize = cache ? cache->policy().maxValueSize : 0;
+    const bool timeReads = cache && cache->policy().slowReadBudgetUs > 0;
+    int dirFd = -1;
+
     for (udev_list_entry* e = udev_device_get_sysattr_list_entry(d); e; e = udev_list_entry_get_next(e)) {
         const char* k = udev_list_entry_get_name(e);
-        device.sysattrs.insert(toQString(k), toQString(udev_device_get_sysattr_value(d, k)));
+        const QString key = toQString(k);
+
+        if (cached) {
+            if (const QString* value = cache->lookup(*cached, key, now)) {
+                device.sysattrs.insert(key, *value);
+                if (stats) {
+                    QudevStatsCollector::add(stats->sysattrCacheHits);
+                }
+                continue;
+            }
+        }
+
+        if (cache && cache->isSkipped(device.subsystem, key)) {
+            countSkipped(stats, *cache, device.subsystem, key);
+            continue;
+        }
+
+        if (batch && !isResolvedLink(k)) {
+            QudevSysattrReader::Request request;
+            request.path = udev_device_get_syspath(d);
+            request.path += '/';
+            request.path += k;
+            batch->requests.push_back(std::move(request));
+            batch->targets.push_back({ &device, key, cached != nullptr });
+            continue;
+        }
+
+        if (maxValueSize > 0 && isOversized(dirFd, udev_device_get_syspath(d), k, maxValueSize)) {
+            if (stats) {
+                QudevStatsCollector::add(stats->sysattrsOversized);
+            }
+            continue;
+        }
+
+        const char* v = nullptr;
+        const quint64 t0 = timeReads ? QudevStatsCollector::nowNs() : 0;
+        {
+            QUDEV_TRACE_SCOPE_NAMED(span, "qudev", "sysattr");
+            QUDEV_TRACE_ARG(span, "name", k);
+            v = udev_device_get_sysattr_value(d, k);
+        }
+        if (timeReads) {
+            cache->recordReadTime(device.subsystem, key, QudevStatsCollector::nowNs() - t0);
+        }
+        if (stats) {
+            stats->recordSysattr(v ? strlen(v) : 0);
+        }
+
+        const QString value = toQString(v);
+        if (cached) {
+            cache->store(*cached, key, value, now);
+        }
+        device.sysattrs.insert(key, value);
+    }
+
+    if (dirFd >= 0) {
+        ::close(dirFd);
     }
 
     // devlinks
@@ -70,6 +210,108 @@ QudevDevice buildDevice(const QudevContext&, udev_device* d)
         device.parent_syspath = toQString(udev_device_get_syspath(p));
         device.parent_subsystem = toQString(udev_device_get_subsystem(p));
     }
+}
+
+/// Read every queued sysattr with one reader call and store the values.
+void readBatch(const QudevContext& ctx, QudevSysattrReader& reader, SysattrBatch& batch)
+{
+    if (batch.requests.empty()) {
+        return;
+    }
+
+    {
+        QUDEV_TRACE_SCOPE_NAMED(span, "qudev", "sysattrBatch");
+        QUDEV_TRACE_ARG(span, "count", qint64(batch.requests.size()));
+        reader.read(batch.requests.data(), qsizetype(batch.requests.size()));
+    }
+
+    QudevStatsCollector* stats = ctx.stats();
+    QudevSysattrCache* cache = ctx.sysattrCache();
+    const qint64 now = cache ? qint64(QudevStatsCollector::nowNs()) : 0;
+    const qint64 maxValueSize = cache ? cache->policy().maxValueSize : 0;
+
+    // Cache entries are looked up again: building later devices of the
+    // batch may have rehashed the cache.
+    const QudevDevice* current = nullptr;
+    QudevSysattrCache::Device* cached = nullptr;
+
+    for (std::size_t i = 0; i < batch.requests.size(); ++i)
+    {
+        const QudevSysattrReader::Request& request = batch.requests[i];
+        const SysattrBatch::Target& target = batch.targets[i];
+
+        if (cache && request.elapsedNs) {
+            cache->recordReadTime(target.device->subsystem, target.key, request.elapsedNs);
+        }
+
+        if (request.error == EFBIG || (maxValueSize > 0 && request.value.size() > maxValueSize)) {
+            if (stats) {
+                QudevStatsCollector::add(stats->sysattrsOversized);
+            }
+            continue;
+        }
+
+        if (stats) {
+            stats->recordSysattr(quint64(request.value.size()));
+        }
+
+        const QString value = QString::fromLocal8Bit(request.value);
+        if (target.cacheable && cache) {
+            if (target.device != current) {
+                current = target.device;
+                cached = cache->device(current->syspath, current->subsystem,
+                                       current->properties.value(QStringLiteral("USEC_INITIALIZED")), QString());
+            }
+            if (cached) {
+                cache->store(*cached, target.key, value, now);
+            }
+        }
+        target.device->sysattrs.insert(target.key, value);
+    }
+}
+
+} // namespace
+
+const QudevDevice& QudevSharedDevice::empty() noexcept
+{
+    static const QudevDevice device;
+    return device;
+}
+
+void QudevSharedDevice::registerMetaType()
+{
+    static const bool registered = QMetaType::registerConverter<QudevSharedDevice, QudevDevice>(
+        [](const QudevSharedDevice& shared) { return shared.get(); });
+    Q_UNUSED(registered);
+}
+
+QudevDevice buildDevice(const QudevContext& ctx, udev_device* d)
+{
+    QudevDevice device;
+
+    if (QudevSysattrReader* reader = ctx.sysattrReader()) {
+        SysattrBatch batch;
+        fillDevice(ctx, d, device, &batch);
+        readBatch(ctx, *reader, batch);
+    } else {
+        fillDevice(ctx, d, device, nullptr);
+    }
 
     return device;
 }
+
+QList<QudevDevice> buildDevices(const QudevContext& ctx, udev_device* const* devices, qsizetype count)
+{
+    QList<QudevDevice> result(count);
+    QudevSysattrReader* reader = ctx.sysattrReader();
+    SysattrBatch batch;
+
+    for (qsizetype i = 0; i < count; ++i) {
+        fillDevice(ctx, devices[i], result[i], reader ? &batch : nullptr);
+    }
+    if (reader) {
+        readBatch(ctx, *reader, batch);
+    }
+
+    return result;
+}
@@ -0,0 +1,284 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include "qudev_dispatcher.h"
+#include "qudev_stats_collector.h"
+#include "qudev_trace.h"
+
+#include <qudev.h>
+#include <qudev_device.h>
+
+#include <QDebug>
+#include <QHash>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace {
+
+// The syspath up to @p depth components below /sys/devices (or /sys for
+// virtual class paths); shorter paths are their own key.
+QStringView shardKey(QStringView syspath, int depth)
+{
+    if (depth <= 0) {
+        return syspath;
+    }
+
+    static const QLatin1String devices("/sys/devices/");
+    static const QLatin1String sys("/sys/");
+    qsizetype pos = syspath.startsWith(devices) ? devices.size() : syspath.startsWith(sys) ? sys.size() : 0;
+    for (int i = 0; i < depth; ++i) {
+        const qsizetype slash = syspath.indexOf(QLatin1Char('/'), pos);
+        if (slash < 0) {
+            return syspath;
+        }
+        pos = slash + 1;
+    }
+    return syspath.left(pos - 1);
+}
+
+struct Shard
+{
+    std::mutex mutex;
+    std::condition_variable ready;   // worker: queue not empty or stopping
+    std::condition_variable space;   // posters: room in the queue
+    std::condition_variable idle;    // waitForIdle(): empty and not busy
+    std::deque<QudevSharedDevice> queue;
+    bool busy = false;
+    bool stopping = false;
+    std::thread thread;
+};
+
+} // namespace
+
+struct QudevDispatcher::Private
+{
+    Handler handler;
+    Options options;
+    std::vector<std::unique_ptr<Shard>> shards;
+
+    std::atomic<quint64> posted{0};
+    std::atomic<quint64> delivered{0};
+    std::atomic<quint64> dropped{0};
+    std::atomic<quint64> coalesced{0};
+    std::atomic<quint64> blocked{0};
+    std::atomic<qsizetype> maxDepth{0};
+
+    int shardOf(QStringView syspath) const
+    {
+        return int(qHash(shardKey(syspath, options.subtreeDepth)) % shards.size());
+    }
+
+    static bool coalesce(std::deque<QudevSharedDevice>& queue, const QudevSharedDevice& event);
+    bool post(const QudevSharedDevice& event, bool* merged);
+    void run(Shard& shard);
+};
+
+bool QudevDispatcher::Private::coalesce(std::deque<QudevSharedDevice>& queue, const QudevSharedDevice& event)
+{
+    static const QLatin1String change("change");
+    if (event->action != change) {
+        return false;
+    }
+
+    // Only the device's last queued event may be replaced, or the new
+    // state would overtake an add or remove queued after it.
+    const auto it = std::find_if(queue.rbegin(), queue.rend(),
+                                 [&event](const QudevSharedDevice& e) { return e->syspath == event->syspath; });
+    if (it == queue.rend() || (*it)->action != change) {
+        return false;
+    }
+    *it = event;
+    return true;
+}
+
+void QudevDispatcher::Private::run(Shard& shard)
+{
+    std::unique_lock<std::mutex> lock(shard.mutex);
+    for (;;) {
+        shard.ready.wait(lock, [&shard] { return !shard.queue.empty() || shard.stopping; });
+        if (shard.queue.empty()) {
+            return;   // stopping, and everything queued was delivered
+        }
+
+        const QudevSharedDevice event = std::move(shard.queue.front());
+        shard.queue.pop_front();
+        shard.busy = true;
+        lock.unlock();
+        shard.space.notify_one();
+
+        {
+            QUDEV_TRACE_SCOPE("qudev", "dispatcher.deliver");
+            handler(event);
+        }
+        delivered.fetch_add(1, std::memory_order_relaxed);
+
+        lock.lock();
+        shard.busy = false;
+        if (shard.queue.empty()) {
+            shard.idle.notify_all();
+        }
+    }
+}
+
+QudevDispatcher::QudevDispatcher(Handler handler, const Options& options, QObject* parent)
+    : QObject(parent),
+    d_{std::make_unique<Private>()}
+{
+    QudevSharedDevice::registerMetaType();
+
+    d_->handler = std::move(handler);
+    if (!d_->handler) {
+        qWarning() << "[QudevDispatcher] No handler given, events will be discarded";
+        d_->handler = [](const QudevSharedDevice&) {};
+    }
+    d_->options = options;
+    d_->options.workers = std::max(1, options.workers);
+    d_->options.queueCapacity = std::max<qsizetype>(1, options.queueCapacity);
+
+    d_->shards.reserve(size_t(d_->options.workers));
+    for (int i = 0; i < d_->options.workers; ++i) {
+        d_->shards.push_back(std::make_unique<Shard>());
+    }
+    for (const auto& shard : d_->shards) {
+        shard->thread = std::thread([d = d_.get(), s = shard.get()] { d->run(*s); });
+    }
+}
+
+QudevDispatcher::QudevDispatcher(Handler handler, QObject* parent)
+    : QudevDispatcher(std::move(handler), Options(), parent)
+{}
+
+QudevDispatcher::~QudevDispatcher()
+{
+    for (const auto& shard : d_->shards) {
+        {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            shard->stopping = true;
+        }
+        shard->ready.notify_all();
+        shard->space.notify_all();
+    }
+    for (const auto& shard : d_->shards) {
+        shard->thread.join();
+    }
+}
+
+bool QudevDispatcher::post(const QudevSharedDevice& event)
+{
+    bool merged = false;
+    return d_->post(event, &merged);
+}
+
+bool QudevDispatcher::Private::post(const QudevSharedDevice& event, bool* merged)
+{
+    if (event.isNull()) {
+        return false;
+    }
+    posted.fetch_add(1, std::memory_order_relaxed);
+
+    Shard& shard = *shards[size_t(shardOf(event->syspath))];
+    const qsizetype capacity = options.queueCapacity;
+
+    std::unique_lock<std::mutex> lock(shard.mutex);
+    if (shard.stopping) {
+        return false;
+    }
+    if (qsizetype(shard.queue.size()) >= capacity) {
+        switch (options.overflow) {
+        case Overflow::DropOldest:
+            shard.queue.pop_front();
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            break;
+        case Overflow::Coalesce:
+            if (coalesce(shard.queue, event)) {
+                coalesced.fetch_add(1, std::memory_order_relaxed);
+                *merged = true;
+                return true;
+            }
+            [[fallthrough]];
+        case Overflow::Block:
+            blocked.fetch_add(1, std::memory_order_relaxed);
+            shard.space.wait(lock, [&] { return qsizetype(shard.queue.size()) < capacity || shard.stopping; });
+            if (shard.stopping) {
+                return false;
+            }
+            break;
+        }
+    }
+
+    shard.queue.push_back(event);
+    const qsizetype depth = qsizetype(shard.queue.size());
+    lock.unlock();
+    shard.ready.notify_one();
+
+    qsizetype max = maxDepth.load(std::memory_order_relaxed);
+    while (depth > max && !maxDepth.compare_exchange_weak(max, depth, std::memory_order_relaxed)) {
+    }
+    return true;
+}
+
+QMetaObject::Connection QudevDispatcher::attach(Qudev* qudev)
+{
+    if (!qudev) {
+        return {};
+    }
+    // Runs while qudev emits, so its collector is alive.
+    QudevStatsCollector* stats = qudev->statsCollector();
+    return connect(qudev, &Qudev::deviceFound, this, [this, stats](const QudevSharedDevice& device) {
+        bool merged = false;
+        d_->post(device, &merged);
+        if (merged) {
+            QudevStatsCollector::add(stats->eventsCoalesced);
+        }
+    }, Qt::DirectConnection);
+}
+
+bool QudevDispatcher::waitForIdle(int timeoutMs)
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max(0, timeoutMs));
+    for (const auto& shard : d_->shards) {
+        std::unique_lock<std::mutex> lock(shard->mutex);
+        const auto idle = [&shard] { return shard->queue.empty() && !shard->busy; };
+        if (timeoutMs < 0) {
+            shard->idle.wait(lock, idle);
+        } else if (!shard->idle.wait_until(lock, deadline, idle)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int QudevDispatcher::workerOf(const QString& syspath) const
+{
+    return d_->shardOf(syspath);
+}
+
+int QudevDispatcher::workerCount() const noexcept
+{
+    return int(d_->shards.size());
+}
+
+QudevDispatcher::Counters QudevDispatcher::counters() const
+{
+    Counters c;
+    c.posted = d_->posted.load(std::memory_order_relaxed);
+    c.delivered = d_->delivered.load(std::memory_order_relaxed);
+    c.dropped = d_->dropped.load(std::memory_order_relaxed);
+    c.coalesced = d_->coalesced.load(std::memory_order_relaxed);
+    c.blocked = d_->blocked.load(std::memory_order_relaxed);
+    c.maxDepth = d_->maxDepth.load(std::memory_order_relaxed);
+    return c;
+}
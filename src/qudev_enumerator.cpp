@@ -7,182 +7,193 @@
 // See the LICENSE file in the project root for full license text.
 
 #include "qudev_enumerator.h"
-#include "qudev_context.h"
+#include "qudev_backend.h"
 #include "qudev_device.h"
 #include "qudev_filters.h"
+#include "qudev_stats_collector.h"
+#include "qudev_text_match.h"
+#include "qudev_trace.h"
 
-#include <libudev.h>
+#include <iterator>
 
 /**
- * @brief Set libudev prefilters for enumeration.
- * @return false if a libudev call failed; true otherwise.
+ * @brief Post-filter parts that backends cannot prefilter for enumeration.
+ * @return true if @p device matches remaining criteria; false otherwise.
  */
-static bool applyPreFilters(udev_enumerate* en, const QudevFilters& filters)
+static bool applyPostFilters(const QudevDevice& device, const QudevFilters& filters)
 {
-    // subsystem
-    if (!filters.subsystem.isEmpty())
-    {
-        const QByteArray subsystem = filters.subsystem.toUtf8();
-        const int rc = udev_enumerate_add_match_subsystem(en, subsystem.constData());
-        if (rc < 0) {
-            return false;
-        }
+    if (!filters.devnode.isEmpty() &&
+        filters.devnode != device.devnode) {
+        return false;
     }
 
-    // sysname
-    if (!filters.sysname.isEmpty())
-    {
-        const QByteArray sysname = filters.sysname.toUtf8();
-        const int rc = udev_enumerate_add_match_sysname(en, sysname.constData());
-        if (rc < 0) {
-            return false;
-        }
+    if (!filters.syspathPrefix.isEmpty() &&
+        !device.syspath.startsWith(filters.syspathPrefix)) {
+        return false;
     }
 
-    // properties (key=value)
-    for (auto it = filters.properties.cbegin(); it != filters.properties.cend(); ++it)
-    {
-        if (it.key().isEmpty() || it.value().isEmpty()) {
-            continue;
-        }
+    return true;
+}
 
-        const QByteArray key = it.key().toUtf8();
-        const QByteArray value = it.value().toUtf8();
-        const int rc = udev_enumerate_add_match_property(en, key.constData(), value.constData());
-        if (rc < 0) {
-            return false;
-        }
+bool QudevEnumerator::matches(const QudevDevice& device, const QudevFilters& filters) noexcept
+{
+    if (!filters.subsystem.isEmpty() && !qudevGlobMatch(filters.subsystem, device.subsystem)) {
+        return false;
     }
-
-    // tags (AND semantics across multiple calls)
-    for (const auto& tag : filters.tags)
-    {
-        if (tag.isEmpty()) {
-            continue;
-        }
-
-        const QByteArray tagBuf = tag.toUtf8();
-        const int rc = udev_enumerate_add_match_tag(en, tagBuf.constData());
-        if (rc < 0) {
+    if (!filters.devtype.isEmpty() && !qudevGlobMatch(filters.devtype, device.devtype) &&
+        !qudevGlobMatch(filters.devtype, device.properties.value(QStringLiteral("DEVTYPE")))) {
+        return false;
+    }
+    if (!filters.sysname.isEmpty() && !qudevGlobMatch(filters.sysname, device.sysname)) {
+        return false;
+    }
+    for (const auto& tag : filters.tags) {
+        if (!device.tags.contains(tag)) {
             return false;
         }
     }
-
-    // sysattrs (key=value)
-    for (auto it = filters.sysattrs.cbegin(); it != filters.sysattrs.cend(); ++it)
-    {
-        if (it.key().isEmpty() || it.value().isEmpty()) {
-            continue;
-        }
-
-        const QByteArray key = it.key().toUtf8();
-        const QByteArray value = it.value().toUtf8();
-        const int rc = udev_enumerate_add_match_sysattr(en, key.constData(), value.constData());
-        if (rc < 0) {
+    for (auto it = filters.properties.cbegin(); it != filters.properties.cend(); ++it) {
+        const auto v = device.properties.constFind(it.key());
+        if (v == device.properties.cend() || !qudevGlobMatch(it.value(), *v)) {
             return false;
         }
     }
-
-    // negative sysattrs (key!=value)
-    for (auto it = filters.nomatchSysattrs.cbegin(); it != filters.nomatchSysattrs.cend(); ++it)
-    {
-        if (it.key().isEmpty() || it.value().isEmpty()) {
-            continue;
-        }
-
-        const QByteArray key = it.key().toUtf8();
-        const QByteArray value = it.value().toUtf8();
-        const int rc = udev_enumerate_add_nomatch_sysattr(en, key.constData(), value.constData());
-        if (rc < 0) {
+    for (auto it = filters.sysattrs.cbegin(); it != filters.sysattrs.cend(); ++it) {
+        const auto v = device.sysattrs.constFind(it.key());
+        if (v == device.sysattrs.cend() || !qudevGlobMatch(it.value(), *v)) {
             return false;
         }
     }
-
-    // devtype: enumerator doesn’t have a dedicated API; DEVTYPE is exposed as a property
-    if (!filters.devtype.isEmpty())
-    {
-        static const char* DEVTYPE = "DEVTYPE";
-        const QByteArray value = filters.devtype.toUtf8();
-        const int rc = udev_enumerate_add_match_property(en, DEVTYPE, value.constData());
-        if (rc < 0) {
+    for (auto it = filters.nomatchSysattrs.cbegin(); it != filters.nomatchSysattrs.cend(); ++it) {
+        const auto v = device.sysattrs.constFind(it.key());
+        if (v != device.sysattrs.cend() && qudevGlobMatch(it.value(), *v)) {
             return false;
         }
     }
 
-    return true;
+    return applyPostFilters(device, filters);
 }
 
-/**
- * @brief Post-filter parts that libudev cannot prefilter for enumeration.
- * @return true if @p device matches remaining criteria; false otherwise.
- */
-static bool applyPostFilters(const QudevDevice& device, const QudevFilters& filters)
+QudevEnumerator::QudevEnumerator(QudevBackend& backend) noexcept
+    : backend(backend)
+{}
+
+QList<QudevDevice> QudevEnumerator::scan(const QudevFilters& filters) const noexcept
 {
-    if (!filters.devnode.isEmpty() &&
-        filters.devnode != device.devnode) {
-        return false;
-    }
+    QList<QudevDevice> devices;
 
-    if (!filters.syspathPrefix.isEmpty() &&
-        !device.syspath.startsWith(filters.syspathPrefix)) {
-        return false;
-    }
+    scan(filters, [&devices](QudevDevice&& device) {
+        devices.push_back(std::move(device));
+        return true;
+    });
 
-    return true;
+    return devices;
 }
 
-QudevEnumerator::QudevEnumerator(const QudevContext& ctx) noexcept
-    : context(ctx)
-{}
-
-QList<QudevDevice> QudevEnumerator::scan(const QudevFilters& filters) const noexcept
+bool QudevEnumerator::scan(const QudevFilters& filters, const Visitor& visit) const noexcept
 {
-    QList<QudevDevice> devices;
+    QUDEV_TRACE_SCOPE_NAMED(span, "qudev", "scan");
+    QudevStatsCollector* stats = backend.stats();
+    QUDEV_TRACE_COUNTER(visited);
 
-    // Create enumerate handle
-    udev_enumerate* en = udev_enumerate_new(context.get());
-    if (!en) {
-        return devices;
-    }
+    const bool completed = backend.enumerate(filters, [&](QudevDevice&& device) {
+        if (stats) {
+            QudevStatsCollector::add(stats->devicesBuilt);
+        }
+        if (!applyPostFilters(device, filters)) {
+            return true;
+        }
+        QUDEV_TRACE_COUNT(visited);
+        return visit(std::move(device));
+    });
 
-    if (!applyPreFilters(en, filters))
-    {
-        udev_enumerate_unref(en);
-        return devices;
-    }
+    QUDEV_TRACE_ARG(span, "devices", visited);
+    return completed;
+}
 
-    if (udev_enumerate_scan_devices(en) < 0)
-    {
-        udev_enumerate_unref(en);
-        return devices;
+QList<QList<QudevSharedDevice>> QudevEnumerator::scan(const QList<QudevFilters>& sets,
+                                                      const Residual& residual) const noexcept
+{
+    QUDEV_TRACE_SCOPE_NAMED(span, "qudev", "scan.shared");
+    QList<QList<QudevSharedDevice>> results(sets.size());
+    if (sets.isEmpty()) {
+        return results;
     }
 
-    // Iterate results
-    for (udev_list_entry* it = udev_enumerate_get_list_entry(en);
-         it; it = udev_list_entry_get_next(it))
-    {
+    // Actions do not apply to a snapshot.
+    QList<QudevFilters> routes = sets;
+    for (QudevFilters& f : routes) {
+        f.actions.clear();
+    }
 
-        const char* syspath = udev_list_entry_get_name(it);
-        if (!syspath) {
-            continue;
+    const bool completed = scan(commonFilters(routes), [&](QudevDevice&& device) {
+        // Shared on the first match, so each device is stored once.
+        QudevSharedDevice shared;
+        for (qsizetype i = 0; i < routes.size(); ++i) {
+            const QudevDevice& d = shared.isNull() ? device : shared.get();
+            if (!matches(d, routes.at(i)) || (residual && !residual(i, d))) {
+                continue;
+            }
+            if (shared.isNull()) {
+                shared = QudevSharedDevice(std::move(device));
+            }
+            results[i].push_back(shared);
         }
+        return true;
+    });
 
-        udev_device* d = udev_device_new_from_syspath(context.get(), syspath);
-        if (!d) {
-            continue;
-        }
+    QUDEV_TRACE_ARG(span, "sets", sets.size());
+    return completed ? results : QList<QList<QudevSharedDevice>>(sets.size());
+}
 
-        QudevDevice device = buildDevice(context, d);
-        udev_device_unref(d);
+QudevFilters QudevEnumerator::commonFilters(const QList<QudevFilters>& sets)
+{
+    if (sets.isEmpty()) {
+        return {};
+    }
 
-        if (!applyPostFilters(device, filters)) {
-            continue;
+    const auto keepEqual = [](QString& field, const QString& other) {
+        if (field != other) {
+            field.clear();
         }
+    };
+    const auto keepShared = [](QHash<QString, QString>& map, const QHash<QString, QString>& other) {
+        for (auto it = map.begin(); it != map.end();) {
+            const auto o = other.constFind(it.key());
+            it = (o == other.cend() || *o != *it) ? map.erase(it) : std::next(it);
+        }
+    };
 
-        devices.push_back(std::move(device));
+    QudevFilters common = sets.first();
+    for (qsizetype i = 1; i < sets.size(); ++i)
+    {
+        const QudevFilters& f = sets.at(i);
+        keepEqual(common.subsystem, f.subsystem);
+        keepEqual(common.devtype, f.devtype);
+        keepEqual(common.sysname, f.sysname);
+        keepEqual(common.devnode, f.devnode);
+
+        qsizetype n = 0;
+        const qsizetype max = qMin(common.syspathPrefix.size(), f.syspathPrefix.size());
+        while (n < max && common.syspathPrefix.at(n) == f.syspathPrefix.at(n)) {
+            ++n;
+        }
+        common.syspathPrefix.truncate(n);
+
+        common.tags.removeIf([&f](const QString& tag) { return !f.tags.contains(tag); });
+        keepShared(common.properties, f.properties);
+        keepShared(common.sysattrs, f.sysattrs);
+        keepShared(common.nomatchSysattrs, f.nomatchSysattrs);
+
+        if (f.actions.isEmpty()) {
+            common.actions.clear();
+        } else if (!common.actions.isEmpty()) {
+            for (const QString& action : f.actions) {
+                if (!common.actions.contains(action)) {
+                    common.actions << action;
+                }
+            }
+        }
     }
-
-    udev_enumerate_unref(en);
-
-    return devices;
+    return common;
 }
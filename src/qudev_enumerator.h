@@ -8,11 +8,13 @@
 
 #pragma once
 
+#include <functional>
 #include <QList>
 #include "qudev_filters.h"
 
-class QudevContext;
+class QudevBackend;
 struct QudevDevice;
+class QudevSharedDevice;
 
 /**
  * @file qudev_enumerator.h
@@ -20,29 +22,37 @@ struct QudevDevice;
  */
 
 /**
- * @brief Snapshot enumerator for libudev devices.
+ * @brief Snapshot enumerator for devices.
  *
- * This class performs a one-shot enumeration of devices using libudev.
- * It is an internal helper and not part of the public API surface.
+ * This class performs a one-shot enumeration of devices using a
+ * @ref QudevBackend (libudev by default). It is an internal helper and
+ * not part of the public API surface.
  */
 class QudevEnumerator
 {
 public:
     /**
-     * @brief Construct an enumerator using an existing libudev context.
+     * @brief Callback receiving each matching device during a scan.
      *
-     * The enumerator never takes ownership of the context; the caller
-     * is responsible for ensuring that @p ctx outlives this object.
+     * Returning @c false stops the enumeration early.
+     */
+    using Visitor = std::function<bool(QudevDevice&& device)>;
+
+    /**
+     * @brief Construct an enumerator using an existing backend.
+     *
+     * The enumerator never takes ownership of the backend; the caller
+     * is responsible for ensuring that @p backend outlives this object.
      *
-     * @param ctx Reference to an existing @ref QudevContext.
+     * @param backend Reference to an existing @ref QudevBackend.
      */
-    explicit QudevEnumerator(const QudevContext& ctx) noexcept;
+    explicit QudevEnumerator(QudevBackend& backend) noexcept;
 
     /**
      * @brief Enumerate devices matching @p filters.
      *
-     * This method runs libudev's enumeration with the given filter set,
-     * and then applies any additional post-filters defined in
+     * This method runs the backend's enumeration with the given filter
+     * set, and then applies any additional post-filters defined in
      * @ref QudevFilters.
      *
      * @param filters Filter set to apply (see @ref QudevFilters).
@@ -50,6 +60,62 @@ public:
      */
     QList<QudevDevice> scan(const QudevFilters& filters) const noexcept;
 
+    /**
+     * @brief Enumerate devices matching @p filters, one device at a time.
+     *
+     * Same semantics as @ref scan(const QudevFilters&) const, but each
+     * matching device is handed to @p visit as soon as it is built instead
+     * of being collected into a list.
+     *
+     * @param filters Filter set to apply (see @ref QudevFilters).
+     * @param visit   Callback invoked for every matching device.
+     * @return @c true if the enumeration ran to completion; @c false if it
+     *         failed or @p visit requested to stop.
+     */
+    bool scan(const QudevFilters& filters, const Visitor& visit) const noexcept;
+
+    /**
+     * @brief Extra per-set check for @ref scan(const QList<QudevFilters>&, const Residual&) const.
+     *
+     * Called with the index of a filter set the device already matches.
+     */
+    using Residual = std::function<bool(qsizetype set, const QudevDevice& device)>;
+
+    /**
+     * @brief Enumerate once for several filter sets.
+     *
+     * The backend enumerates with @ref commonFilters() of @p sets, so the
+     * union of their matches is walked and built once. Each device is then
+     * checked against every set with @ref matches() (and @p residual, if
+     * given) and appended to the result list of each set it matches;
+     * devices matched by several sets are shared between their lists.
+     *
+     * @param sets     Filter sets; actions are ignored, as for any scan.
+     * @param residual Optional further check per matching set.
+     * @return One list per entry of @p sets, in the same order; empty lists
+     *         on failure.
+     */
+    QList<QList<QudevSharedDevice>> scan(const QList<QudevFilters>& sets,
+                                         const Residual& residual = {}) const noexcept;
+
+    /**
+     * @brief Criteria shared by all of @p sets.
+     *
+     * Every device matching any of @p sets matches the result: fields
+     * equal in all sets, common tags, properties and attributes, and the
+     * longest common syspath prefix.
+     */
+    static QudevFilters commonFilters(const QList<QudevFilters>& sets);
+
+    /**
+     * @brief Whether a scan with @p filters returns @p device.
+     *
+     * Matches as libudev enumeration does: subsystem, sysname, devtype,
+     * property and attribute values are fnmatch() globs; tags, devnode and
+     * the syspath prefix are exact. Actions are ignored.
+     */
+    static bool matches(const QudevDevice& device, const QudevFilters& filters) noexcept;
+
 private:
-    const QudevContext& context;
+    QudevBackend& backend;
 };
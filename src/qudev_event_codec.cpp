@@ -0,0 +1,168 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include "qudev_event_codec.h"
+#include "qudev_device.h"
+#include "qudev_trace.h"
+
+#include <cstring>
+
+
+namespace {
+
+void appendField(QByteArray& out, const char* key, const QString& value)
+{
+    if (value.isEmpty()) {
+        return;
+    }
+    out.append(key);
+    out.append('=');
+    out.append(value.toUtf8());
+    out.append('\0');
+}
+
+void appendField(QByteArray& out, const char* key, quint64 value)
+{
+    out.append(key);
+    out.append('=');
+    out.append(QByteArray::number(value));
+    out.append('\0');
+}
+
+} // namespace
+
+QByteArray qudevEncodeEvent(const QudevDevice& d)
+{
+    QByteArray out;
+    out.reserve(2048);
+
+    appendField(out, ".action",    d.action);
+    appendField(out, ".seqnum",    d.seqnum);
+    appendField(out, ".syspath",   d.syspath);
+    appendField(out, ".devnode",   d.devnode);
+    appendField(out, ".subsystem", d.subsystem);
+    appendField(out, ".devtype",   d.devtype);
+    appendField(out, ".sysname",   d.sysname);
+    appendField(out, ".driver",    d.driver);
+    appendField(out, ".major",     d.major);
+    appendField(out, ".minor",     d.minor);
+    appendField(out, ".parent",    d.parent_syspath);
+    appendField(out, ".parentSubsystem", d.parent_subsystem);
+    appendField(out, ".flags",     quint64((d.isBlock ? 1 : 0) | (d.isChar ? 2 : 0)));
+
+    for (auto it = d.properties.cbegin(); it != d.properties.cend(); ++it) {
+        out.append("E:").append(it.key().toUtf8()).append('=').append(it.value().toUtf8()).append('\0');
+    }
+    for (auto it = d.sysattrs.cbegin(); it != d.sysattrs.cend(); ++it) {
+        out.append("A:").append(it.key().toUtf8()).append('=').append(it.value().toUtf8()).append('\0');
+    }
+    for (const auto& link : d.devlinks) {
+        out.append("L:").append(link.toUtf8()).append('\0');
+    }
+    for (const auto& tag : d.tags) {
+        out.append("G:").append(tag.toUtf8()).append('\0');
+    }
+
+    return out;
+}
+
+QudevDevice qudevDecodeEvent(const char* data, qsizetype size)
+{
+    QUDEV_TRACE_SCOPE("qudev", "decodeEvent");
+
+    QudevDevice d;
+
+    const char* end = data + size;
+    for (const char* rec = data; rec < end; )
+    {
+        const char* recEnd = static_cast<const char*>(memchr(rec, '\0', end - rec));
+        if (!recEnd) {
+            recEnd = end;
+        }
+
+        // No copy: the key is only compared, values are decoded directly.
+        const QByteArray record = QByteArray::fromRawData(rec, recEnd - rec);
+        rec = recEnd + 1;
+
+        if (record.size() < 2) {
+            continue;
+        }
+
+        if (record.startsWith("L:")) {
+            d.devlinks << QString::fromUtf8(record.constData() + 2, record.size() - 2);
+            continue;
+        }
+        if (record.startsWith("G:")) {
+            d.tags << QString::fromUtf8(record.constData() + 2, record.size() - 2);
+            continue;
+        }
+
+        const qsizetype eq = record.indexOf('=');
+        if (eq < 0) {
+            continue;
+        }
+        const QByteArray key = QByteArray::fromRawData(record.constData(), eq);
+        const QString value = QString::fromUtf8(record.constData() + eq + 1, record.size() - eq - 1);
+
+        if (key.startsWith("E:")) {
+            d.properties.insert(QString::fromUtf8(key.constData() + 2, key.size() - 2), value);
+        } else if (key.startsWith("A:")) {
+            d.sysattrs.insert(QString::fromUtf8(key.constData() + 2, key.size() - 2), value);
+        } else if (key == ".action") {
+            d.action = value;
+        } else if (key == ".seqnum") {
+            d.seqnum = value.toULongLong();
+        } else if (key == ".syspath") {
+            d.syspath = value;
+        } else if (key == ".devnode") {
+            d.devnode = value;
+        } else if (key == ".subsystem") {
+            d.subsystem = value;
+        } else if (key == ".devtype") {
+            d.devtype = value;
+        } else if (key == ".sysname") {
+            d.sysname = value;
+        } else if (key == ".driver") {
+            d.driver = value;
+        } else if (key == ".major") {
+            d.major = value.toUInt();
+        } else if (key == ".minor") {
+            d.minor = value.toUInt();
+        } else if (key == ".parent") {
+            d.parent_syspath = value;
+        } else if (key == ".parentSubsystem") {
+            d.parent_subsystem = value;
+        } else if (key == ".flags") {
+            const uint flags = value.toUInt();
+            d.isBlock = flags & 1;
+            d.isChar  = flags & 2;
+        }
+    }
+
+    return d;
+}
+
+quint64 qudevDecodeEventSeqnum(const char* data, qsizetype size)
+{
+    static constexpr char key[] = ".seqnum=";
+    constexpr qsizetype keySize = sizeof(key) - 1;
+
+    const char* end = data + size;
+    for (const char* rec = data; rec < end; )
+    {
+        const char* recEnd = static_cast<const char*>(memchr(rec, '\0', end - rec));
+        if (!recEnd) {
+            recEnd = end;
+        }
+        if (recEnd - rec > keySize && memcmp(rec, key, keySize) == 0) {
+            return QByteArray::fromRawData(rec + keySize, recEnd - rec - keySize).toULongLong();
+        }
+        rec = recEnd + 1;
+    }
+    return 0;
+}
@@ -0,0 +1,56 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#pragma once
+
+#include <QByteArray>
+
+struct QudevDevice;
+
+/**
+ * @file qudev_event_codec.h
+ * @brief Internal wire encoding of device events.
+ *
+ * Events travel as NUL-separated "key=value" records, in the spirit of
+ * the kernel's uevent payload: "." prefixes device fields, while "E:",
+ * "A:", "L:" and "G:" (as in the udev database) carry properties,
+ * sysattrs, devlinks and tags. The encoding is used on the in-memory
+ * backend's sockets and as the payload of recorded event logs.
+ */
+
+/**
+ * @brief Encode every field of @p device, including action and seqnum.
+ */
+QByteArray qudevEncodeEvent(const QudevDevice& device);
+
+/**
+ * @brief Decode a payload produced by @ref qudevEncodeEvent().
+ *
+ * Unknown records are ignored, so older readers accept newer payloads.
+ *
+ * @param data Start of the payload; need not be NUL-terminated.
+ * @param size Payload size in bytes.
+ */
+QudevDevice qudevDecodeEvent(const char* data, qsizetype size);
+
+/**
+ * @brief Only the seqnum of a payload produced by @ref qudevEncodeEvent().
+ *
+ * @return The seqnum, or 0 if the payload has none.
+ */
+quint64 qudevDecodeEventSeqnum(const char* data, qsizetype size);
+
+/// Layout constants of the event log written by @ref QudevEventRecorder.
+namespace QudevEventLog {
+
+constexpr char Magic[8] = { 'Q', 'U', 'D', 'E', 'V', 'L', 'O', 'G' };
+constexpr int HeaderSize = 24;
+/// u32 payloadSize, u64 seqnum, u64 timestampNs.
+constexpr int RecordHeaderSize = 20;
+
+} // namespace QudevEventLog
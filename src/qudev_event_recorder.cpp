@@ -0,0 +1,111 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include "qudev_event_recorder.h"
+#include "qudev_event_codec.h"
+#include "qudev_device.h"
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QtEndian>
+
+#include <cstring>
+
+
+struct QudevEventRecorder::Private
+{
+    QFile file;
+    QElapsedTimer clock;
+    quint64 recorded = 0;
+    QString error;
+};
+
+QudevEventRecorder::QudevEventRecorder()
+    : d_{std::make_unique<Private>()}
+{
+
+}
+
+QudevEventRecorder::~QudevEventRecorder()
+{
+    close();
+}
+
+bool QudevEventRecorder::open(const QString& path)
+{
+    close();
+
+    d_->file.setFileName(path);
+    if (!d_->file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        d_->error = d_->file.errorString();
+        return false;
+    }
+
+    char header[QudevEventLog::HeaderSize] = {};
+    memcpy(header, QudevEventLog::Magic, sizeof(QudevEventLog::Magic));
+    qToLittleEndian<quint16>(FormatVersion, header + 8);
+    qToLittleEndian<qint64>(QDateTime::currentMSecsSinceEpoch(), header + 16);
+
+    if (d_->file.write(header, sizeof(header)) != qint64(sizeof(header))) {
+        d_->error = d_->file.errorString();
+        d_->file.close();
+        return false;
+    }
+
+    d_->recorded = 0;
+    d_->error.clear();
+    d_->clock.start();
+    return true;
+}
+
+void QudevEventRecorder::close()
+{
+    if (d_->file.isOpen()) {
+        d_->file.close();
+    }
+}
+
+bool QudevEventRecorder::isOpen() const noexcept
+{
+    return d_->file.isOpen();
+}
+
+bool QudevEventRecorder::record(const QudevDevice& event)
+{
+    if (!d_->file.isOpen()) {
+        return false;
+    }
+
+    const QByteArray payload = qudevEncodeEvent(event);
+
+    char header[QudevEventLog::RecordHeaderSize];
+    qToLittleEndian<quint32>(quint32(payload.size()), header);
+    qToLittleEndian<quint64>(event.seqnum, header + 4);
+    qToLittleEndian<quint64>(quint64(d_->clock.nsecsElapsed()), header + 12);
+
+    // QFile buffers, so two small writes do not cost two syscalls.
+    if (d_->file.write(header, sizeof(header)) != qint64(sizeof(header)) ||
+        d_->file.write(payload) != payload.size()) {
+        d_->error = d_->file.errorString();
+        return false;
+    }
+
+    ++d_->recorded;
+    return true;
+}
+
+quint64 QudevEventRecorder::eventsRecorded() const noexcept
+{
+    return d_->recorded;
+}
+
+QString QudevEventRecorder::errorString() const
+{
+    return d_->error;
+}
@@ -0,0 +1,424 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include "qudev_index.h"
+#include "qudev_monitor.h"
+#include "qudev_trace.h"
+
+#include <qudev_filters.h>
+
+#include <QHash>
+#include <QStringList>
+
+#include <algorithm>
+#include <vector>
+
+
+namespace {
+
+using Field = QudevIndex::Field;
+using Bucket = std::vector<qint32>;
+
+struct Index
+{
+    Field field;
+    QString property;
+    QHash<QString, Bucket> buckets;
+};
+
+/// Whether @p value can only match itself, as an fnmatch() pattern too.
+bool isLiteral(const QString& value)
+{
+    return !value.contains(QLatin1Char('*')) && !value.contains(QLatin1Char('?'))
+           && !value.contains(QLatin1Char('[')) && !value.contains(QLatin1Char('\\'));
+}
+
+QString devNumber(quint32 major, quint32 minor)
+{
+    return QString::number(major) + QLatin1Char(':') + QString::number(minor);
+}
+
+/// Values @p device is filed under in an index of @p field.
+QStringList keys(const QudevDevice& device, Field field, const QString& property)
+{
+    QStringList out;
+    const auto add = [&out](const QString& value) {
+        if (!value.isEmpty() && !out.contains(value)) {
+            out << value;
+        }
+    };
+
+    switch (field) {
+    case Field::Devnode:   add(device.devnode); break;
+    case Field::Subsystem: add(device.subsystem); break;
+    case Field::Sysname:   add(device.sysname); break;
+    case Field::Driver:    add(device.driver); break;
+    case Field::Property:  add(device.properties.value(property)); break;
+    case Field::DevNumber:
+        if (device.major || device.minor) {
+            add(devNumber(device.major, device.minor));
+        }
+        break;
+    case Field::Devtype:
+        // As matched by the devtype filter.
+        add(device.devtype);
+        add(device.properties.value(QStringLiteral("DEVTYPE")));
+        break;
+    case Field::Tag:
+        for (const QString& tag : device.tags) {
+            add(tag);
+        }
+        break;
+    }
+    return out;
+}
+
+void removeSlot(Bucket& bucket, qint32 slot)
+{
+    const auto it = std::find(bucket.begin(), bucket.end(), slot);
+    if (it != bucket.end()) {
+        *it = bucket.back();
+        bucket.pop_back();
+    }
+}
+
+} // namespace
+
+struct QudevIndex::Private
+{
+    std::vector<QudevSharedDevice> slots;   // null when free
+    std::vector<qint32> freeSlots;
+    QHash<QString, qint32> bySyspath;
+    std::vector<Index> indexes;
+
+    const Index* index(Field field, const QString& property) const;
+    void file(Index& index, qint32 slot, const QStringList& values);
+    void unfile(Index& index, qint32 slot, const QStringList& values);
+
+    /// Smallest bucket among the indexed criteria of @p filters, if any.
+    const Bucket* candidates(const QudevFilters& filters, bool* indexed) const;
+
+    template<typename Fn>
+    void scan(Fn&& fn) const
+    {
+        for (const QudevSharedDevice& d : slots) {
+            if (!d.isNull()) {
+                fn(d);
+            }
+        }
+    }
+};
+
+const Index* QudevIndex::Private::index(Field field, const QString& property) const
+{
+    for (const Index& i : indexes) {
+        if (i.field == field && (field != Field::Property || i.property == property)) {
+            return &i;
+        }
+    }
+    return nullptr;
+}
+
+void QudevIndex::Private::file(Index& index, qint32 slot, const QStringList& values)
+{
+    for (const QString& value : values) {
+        index.buckets[value].push_back(slot);
+    }
+}
+
+void QudevIndex::Private::unfile(Index& index, qint32 slot, const QStringList& values)
+{
+    for (const QString& value : values) {
+        const auto it = index.buckets.find(value);
+        if (it == index.buckets.end()) {
+            continue;
+        }
+        removeSlot(*it, slot);
+        if (it->empty()) {
+            index.buckets.erase(it);
+        }
+    }
+}
+
+const Bucket* QudevIndex::Private::candidates(const QudevFilters& filters, bool* indexed) const
+{
+    static const Bucket empty;
+    const Bucket* best = nullptr;
+    *indexed = false;
+
+    const auto consider = [&](Field field, const QString& property, const QString& value) {
+        // A glob may match devices filed under other values.
+        if (value.isEmpty() || !isLiteral(value) || (best && best->empty())) {
+            return;
+        }
+        const Index* i = index(field, property);
+        if (!i) {
+            return;
+        }
+        const auto it = i->buckets.constFind(value);
+        const Bucket* bucket = it != i->buckets.cend() ? &*it : &empty;
+        if (!best || bucket->size() < best->size()) {
+            best = bucket;
+        }
+        *indexed = true;
+    };
+
+    consider(Field::Devnode, {}, filters.devnode);
+    consider(Field::Sysname, {}, filters.sysname);
+    consider(Field::Subsystem, {}, filters.subsystem);
+    consider(Field::Devtype, {}, filters.devtype);
+    for (const QString& tag : filters.tags) {
+        consider(Field::Tag, {}, tag);
+    }
+    for (auto it = filters.properties.cbegin(); it != filters.properties.cend(); ++it) {
+        consider(Field::Property, it.key(), it.value());
+    }
+    return best;
+}
+
+QudevIndex::QudevIndex()
+    : d_{std::make_unique<Private>()}
+{
+}
+
+QudevIndex::~QudevIndex() = default;
+
+void QudevIndex::addIndex(Field field, const QString& property)
+{
+    if (hasIndex(field, property) || (field == Field::Property && property.isEmpty())) {
+        return;
+    }
+
+    Index index{ field, field == Field::Property ? property : QString(), {} };
+    for (size_t s = 0; s < d_->slots.size(); ++s) {
+        if (!d_->slots[s].isNull()) {
+            d_->file(index, qint32(s), keys(d_->slots[s], field, index.property));
+        }
+    }
+    d_->indexes.push_back(std::move(index));
+}
+
+void QudevIndex::addDefaultIndexes()
+{
+    addIndex(Field::Devnode);
+    addIndex(Field::DevNumber);
+    addIndex(Field::Subsystem);
+    addIndex(Field::Driver);
+    addIndex(Field::Tag);
+    addIndex(Field::Property, QStringLiteral("ID_SERIAL"));
+    addIndex(Field::Property, QStringLiteral("ID_PATH"));
+}
+
+bool QudevIndex::hasIndex(Field field, const QString& property) const
+{
+    return d_->index(field, property) != nullptr;
+}
+
+void QudevIndex::clear()
+{
+    d_->slots.clear();
+    d_->freeSlots.clear();
+    d_->bySyspath.clear();
+    for (Index& index : d_->indexes) {
+        index.buckets.clear();
+    }
+}
+
+bool QudevIndex::insert(const QudevSharedDevice& device)
+{
+    if (device->syspath.isEmpty()) {
+        return false;
+    }
+
+    if (const qint32 slot = d_->bySyspath.value(device->syspath, -1); slot >= 0) {
+        // A change: only indexes whose values differ are touched.
+        const QudevSharedDevice old = d_->slots[size_t(slot)];
+        for (Index& index : d_->indexes) {
+            const QStringList before = keys(old, index.field, index.property);
+            const QStringList after = keys(device, index.field, index.property);
+            if (before != after) {
+                d_->unfile(index, slot, before);
+                d_->file(index, slot, after);
+            }
+        }
+        d_->slots[size_t(slot)] = device;
+        return true;
+    }
+
+    qint32 slot;
+    if (!d_->freeSlots.empty()) {
+        slot = d_->freeSlots.back();
+        d_->freeSlots.pop_back();
+        d_->slots[size_t(slot)] = device;
+    } else {
+        slot = qint32(d_->slots.size());
+        d_->slots.push_back(device);
+    }
+    d_->bySyspath.insert(device->syspath, slot);
+    for (Index& index : d_->indexes) {
+        d_->file(index, slot, keys(device, index.field, index.property));
+    }
+    return true;
+}
+
+bool QudevIndex::remove(const QString& syspath)
+{
+    const auto it = d_->bySyspath.constFind(syspath);
+    if (it == d_->bySyspath.cend()) {
+        return false;
+    }
+
+    const qint32 slot = *it;
+    const QudevDevice& device = d_->slots[size_t(slot)];
+    for (Index& index : d_->indexes) {
+        d_->unfile(index, slot, keys(device, index.field, index.property));
+    }
+    d_->bySyspath.erase(it);
+    d_->slots[size_t(slot)] = QudevSharedDevice();
+    d_->freeSlots.push_back(slot);
+    return true;
+}
+
+void QudevIndex::apply(const QudevSharedDevice& event)
+{
+    if (event->action == QLatin1String("remove")) {
+        remove(event->syspath);
+        return;
+    }
+    if (event->action == QLatin1String("move")) {
+        remove(QStringLiteral("/sys") + event->properties.value(QStringLiteral("DEVPATH_OLD")));
+    }
+    insert(event);
+}
+
+qsizetype QudevIndex::size() const noexcept
+{
+    return d_->bySyspath.size();
+}
+
+QudevSharedDevice QudevIndex::device(const QString& syspath) const
+{
+    const qint32 slot = d_->bySyspath.value(syspath, -1);
+    return slot >= 0 ? d_->slots[size_t(slot)] : QudevSharedDevice();
+}
+
+QList<QudevSharedDevice> QudevIndex::devices() const
+{
+    QList<QudevSharedDevice> out;
+    out.reserve(size());
+    d_->scan([&](const QudevSharedDevice& d) { out << d; });
+    return out;
+}
+
+QList<QudevSharedDevice> QudevIndex::find(Field field, const QString& value) const
+{
+    QList<QudevSharedDevice> out;
+    if (field == Field::Property || value.isEmpty()) {
+        return out;
+    }
+
+    if (const Index* index = d_->index(field, {})) {
+        if (const auto it = index->buckets.constFind(value); it != index->buckets.cend()) {
+            for (const qint32 slot : *it) {
+                out << d_->slots[size_t(slot)];
+            }
+        }
+        return out;
+    }
+
+    d_->scan([&](const QudevSharedDevice& d) {
+        if (keys(d, field, {}).contains(value)) {
+            out << d;
+        }
+    });
+    return out;
+}
+
+QList<QudevSharedDevice> QudevIndex::findProperty(const QString& name, const QString& value) const
+{
+    QList<QudevSharedDevice> out;
+    if (value.isEmpty()) {
+        return out;
+    }
+
+    if (const Index* index = d_->index(Field::Property, name)) {
+        if (const auto it = index->buckets.constFind(value); it != index->buckets.cend()) {
+            for (const qint32 slot : *it) {
+                out << d_->slots[size_t(slot)];
+            }
+        }
+        return out;
+    }
+
+    d_->scan([&](const QudevSharedDevice& d) {
+        if (d->properties.value(name) == value) {
+            out << d;
+        }
+    });
+    return out;
+}
+
+QudevSharedDevice QudevIndex::findDevnode(const QString& devnode) const
+{
+    const QList<QudevSharedDevice> found = find(Field::Devnode, devnode);
+    return found.isEmpty() ? QudevSharedDevice() : found.first();
+}
+
+QList<QudevSharedDevice> QudevIndex::findDevNumber(quint32 major, quint32 minor) const
+{
+    return find(Field::DevNumber, devNumber(major, minor));
+}
+
+QList<QudevSharedDevice> QudevIndex::select(const QudevFilters& filters) const
+{
+    QUDEV_TRACE_SCOPE("qudev", "index.select");
+
+    QList<QudevSharedDevice> out;
+    bool indexed = false;
+    const Bucket* bucket = d_->candidates(filters, &indexed);
+    if (indexed) {
+        for (const qint32 slot : *bucket) {
+            const QudevSharedDevice& d = d_->slots[size_t(slot)];
+            if (QudevMonitor::applyPostFilters(d, filters)) {
+                out << d;
+            }
+        }
+        return out;
+    }
+
+    d_->scan([&](const QudevSharedDevice& d) {
+        if (QudevMonitor::applyPostFilters(d, filters)) {
+            out << d;
+        }
+    });
+    return out;
+}
+
+QList<QudevSharedDevice> QudevIndex::candidates(const QudevFilters& filters) const
+{
+    QList<QudevSharedDevice> out;
+    bool indexed = false;
+    const Bucket* bucket = d_->candidates(filters, &indexed);
+    if (indexed) {
+        out.reserve(qsizetype(bucket->size()));
+        for (const qint32 slot : *bucket) {
+            out << d_->slots[size_t(slot)];
+        }
+        return out;
+    }
+
+    d_->scan([&](const QudevSharedDevice& d) { out << d; });
+    return out;
+}
+
+qsizetype QudevIndex::candidateCount(const QudevFilters& filters) const
+{
+    bool indexed = false;
+    const Bucket* bucket = d_->candidates(filters, &indexed);
+    return indexed ? qsizetype(bucket->size()) : size();
+}
@@ -0,0 +1,344 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include "qudev_journal.h"
+#include "qudev_event_codec.h"
+#include "qudev_trace.h"
+
+#include <qudev_device.h>
+
+#include <QDebug>
+#include <QFile>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace {
+
+constexpr char Magic[8] = { 'Q', 'U', 'D', 'E', 'V', 'J', 'N', 'L' };
+constexpr quint32 GapPending = 1;
+constexpr qsizetype RecordHeaderSize = 16;
+
+struct Header
+{
+    char magic[8];
+    quint32 version;
+    quint32 flags;
+    quint64 capacity;
+    quint64 head;
+    quint64 tail;
+    quint64 floor;        // events up to this seqnum may be missing
+    quint64 lastSeqnum;
+    quint64 reserved;
+};
+static_assert(sizeof(Header) == 64);
+
+quint64 recordSize(qsizetype payloadSize)
+{
+    return (quint64(RecordHeaderSize + payloadSize) + 7) & ~quint64(7);
+}
+
+struct Entry
+{
+    quint64 seqnum;
+    quint64 pos;
+};
+
+} // namespace
+
+struct QudevJournal::Private
+{
+    QByteArray memory;          // storage while not file-backed
+    char* base = nullptr;       // header, then the ring
+    qsizetype mappedSize = 0;   // non-zero while file-backed
+    quint64 capacity = 0;
+    std::deque<Entry> index;
+    quint64 evicted = 0;
+    QString error;
+
+    Header* header() const { return reinterpret_cast<Header*>(base); }
+    char* ring() const { return base + sizeof(Header); }
+
+    void write(quint64 pos, const char* src, quint64 n) const;
+    void read(quint64 pos, char* dst, quint64 n) const;
+    void initialize(char* storage) const;
+    bool rebuildIndex();
+    void clear();
+};
+
+void QudevJournal::Private::write(quint64 pos, const char* src, quint64 n) const
+{
+    const quint64 at = pos % capacity;
+    const quint64 first = std::min(n, capacity - at);
+    std::memcpy(ring() + at, src, size_t(first));
+    std::memcpy(ring(), src + first, size_t(n - first));
+}
+
+void QudevJournal::Private::read(quint64 pos, char* dst, quint64 n) const
+{
+    const quint64 at = pos % capacity;
+    const quint64 first = std::min(n, capacity - at);
+    std::memcpy(dst, ring() + at, size_t(first));
+    std::memcpy(dst + first, ring(), size_t(n - first));
+}
+
+void QudevJournal::Private::initialize(char* storage) const
+{
+    Header* h = reinterpret_cast<Header*>(storage);
+    *h = Header{};
+    std::memcpy(h->magic, Magic, sizeof(Magic));
+    h->version = FormatVersion;
+    h->flags = GapPending;
+    h->capacity = capacity;
+}
+
+bool QudevJournal::Private::rebuildIndex()
+{
+    const Header* h = header();
+    index.clear();
+    if (h->head > h->tail || h->tail - h->head > capacity || h->head % 8 || h->tail % 8) {
+        return false;
+    }
+
+    quint64 previous = 0;
+    for (quint64 pos = h->head; pos < h->tail;)
+    {
+        char rec[RecordHeaderSize];
+        read(pos, rec, RecordHeaderSize);
+        quint32 payloadSize;
+        quint64 seqnum;
+        std::memcpy(&payloadSize, rec, sizeof(payloadSize));
+        std::memcpy(&seqnum, rec + 8, sizeof(seqnum));
+
+        const quint64 size = recordSize(payloadSize);
+        if (size > h->tail - pos || seqnum <= previous || seqnum > h->lastSeqnum) {
+            index.clear();
+            return false;
+        }
+        index.push_back({ seqnum, pos });
+        previous = seqnum;
+        pos += size;
+    }
+    return true;
+}
+
+void QudevJournal::Private::clear()
+{
+    Header* h = header();
+    index.clear();
+    h->head = h->tail;
+    h->floor = 0;
+    h->lastSeqnum = 0;
+}
+
+QudevJournal::QudevJournal(qsizetype capacity)
+    : d_{std::make_unique<Private>()}
+{
+    d_->capacity = quint64(std::max<qsizetype>(capacity, 64) + 7) & ~quint64(7);
+    d_->memory.resize(qsizetype(sizeof(Header) + d_->capacity), '\0');
+    d_->base = d_->memory.data();
+    d_->initialize(d_->base);
+}
+
+QudevJournal::~QudevJournal()
+{
+    if (d_->mappedSize) {
+        ::munmap(d_->base, size_t(d_->mappedSize));
+    }
+}
+
+bool QudevJournal::openFile(const QString& path)
+{
+    if (d_->mappedSize) {
+        d_->error = QStringLiteral("Journal is already file-backed");
+        return false;
+    }
+
+    const int fd = ::open(QFile::encodeName(path).constData(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        d_->error = QStringLiteral("Cannot open %1: %2").arg(path, QString::fromLocal8Bit(strerror(errno)));
+        return false;
+    }
+
+    const qsizetype size = qsizetype(sizeof(Header) + d_->capacity);
+    struct stat st{};
+    const bool reusable = ::fstat(fd, &st) == 0 && st.st_size == off_t(size);
+    if (!reusable && ::ftruncate(fd, off_t(size)) < 0) {
+        d_->error = QStringLiteral("Cannot size %1: %2").arg(path, QString::fromLocal8Bit(strerror(errno)));
+        ::close(fd);
+        return false;
+    }
+
+    void* map = ::mmap(nullptr, size_t(size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        d_->error = QStringLiteral("Cannot map %1: %2").arg(path, QString::fromLocal8Bit(strerror(errno)));
+        return false;
+    }
+
+    char* const memory = d_->base;
+    const std::deque<Entry> memoryIndex = d_->index;
+    d_->base = static_cast<char*>(map);
+    d_->mappedSize = size;
+
+    const Header* h = d_->header();
+    const bool compatible = reusable && std::memcmp(h->magic, Magic, sizeof(Magic)) == 0
+                            && h->version == FormatVersion && h->capacity == d_->capacity;
+    if (!compatible || !d_->rebuildIndex()) {
+        if (compatible) {
+            qWarning() << "[QudevJournal] Discarding corrupt journal" << path;
+        }
+        std::memcpy(d_->base, memory, size_t(size));
+        d_->index = memoryIndex;
+    }
+
+    d_->memory = QByteArray();
+    d_->error.clear();
+    markDiscontinuity();
+    return true;
+}
+
+bool QudevJournal::isFileBacked() const noexcept
+{
+    return d_->mappedSize != 0;
+}
+
+QString QudevJournal::errorString() const
+{
+    return d_->error;
+}
+
+bool QudevJournal::append(const QudevDevice& event)
+{
+    Header* h = d_->header();
+    const quint64 seqnum = event.seqnum;
+    const bool gap = h->flags & GapPending;
+
+    if (seqnum == 0) {
+        return false;
+    }
+    if (seqnum <= h->lastSeqnum) {
+        if (!gap) {
+            return false;
+        }
+        // After a discontinuity, e.g. a reboot: a new seqnum sequence.
+        d_->clear();
+    }
+
+    const QByteArray payload = qudevEncodeEvent(event);
+    const quint64 size = recordSize(payload.size());
+    if (size > d_->capacity) {
+        return false;
+    }
+
+    while (h->tail + size - h->head > d_->capacity) {
+        const Entry oldest = d_->index.front();
+        d_->index.pop_front();
+        h->head = d_->index.empty() ? h->tail : d_->index.front().pos;
+        h->floor = std::max(h->floor, oldest.seqnum);
+        ++d_->evicted;
+    }
+
+    char rec[RecordHeaderSize] = {};
+    const quint32 payloadSize = quint32(payload.size());
+    std::memcpy(rec, &payloadSize, sizeof(payloadSize));
+    std::memcpy(rec + 8, &seqnum, sizeof(seqnum));
+    d_->write(h->tail, rec, RecordHeaderSize);
+    d_->write(h->tail + RecordHeaderSize, payload.constData(), quint64(payload.size()));
+
+    // Events between the last one kept and this one went unseen.
+    if (gap && seqnum != h->lastSeqnum + 1) {
+        h->floor = seqnum - 1;
+    }
+
+    // Header last: a crash leaves at most an unreferenced record.
+    d_->index.push_back({ seqnum, h->tail });
+    h->tail += size;
+    h->lastSeqnum = seqnum;
+    h->flags &= ~GapPending;
+    return true;
+}
+
+void QudevJournal::markDiscontinuity() noexcept
+{
+    d_->header()->flags |= GapPending;
+}
+
+bool QudevJournal::covers(quint64 seqnum) const noexcept
+{
+    const Header* h = d_->header();
+    return !(h->flags & GapPending) && seqnum >= h->floor && seqnum <= h->lastSeqnum;
+}
+
+bool QudevJournal::replay(quint64 seqnum, const Visitor& visit) const
+{
+    QUDEV_TRACE_SCOPE("qudev", "journal.replay");
+
+    if (!covers(seqnum)) {
+        return false;
+    }
+
+    auto it = std::upper_bound(d_->index.cbegin(), d_->index.cend(), seqnum,
+                               [](quint64 s, const Entry& e) { return s < e.seqnum; });
+
+    QByteArray wrapped;
+    for (; it != d_->index.cend(); ++it)
+    {
+        quint32 payloadSize;
+        char rec[RecordHeaderSize];
+        d_->read(it->pos, rec, RecordHeaderSize);
+        std::memcpy(&payloadSize, rec, sizeof(payloadSize));
+
+        // Decode in place unless the record wraps around the ring's end.
+        const quint64 at = (it->pos + RecordHeaderSize) % d_->capacity;
+        const char* payload = d_->ring() + at;
+        if (at + payloadSize > d_->capacity) {
+            wrapped.resize(qsizetype(payloadSize));
+            d_->read(it->pos + RecordHeaderSize, wrapped.data(), payloadSize);
+            payload = wrapped.constData();
+        }
+
+        if (!visit(qudevDecodeEvent(payload, qsizetype(payloadSize)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+qsizetype QudevJournal::size() const noexcept
+{
+    return qsizetype(d_->index.size());
+}
+
+qsizetype QudevJournal::capacity() const noexcept
+{
+    return qsizetype(d_->capacity);
+}
+
+quint64 QudevJournal::firstSeqnum() const noexcept
+{
+    return d_->index.empty() ? 0 : d_->index.front().seqnum;
+}
+
+quint64 QudevJournal::lastSeqnum() const noexcept
+{
+    return d_->header()->lastSeqnum;
+}
+
+quint64 QudevJournal::evicted() const noexcept
+{
+    return d_->evicted;
+}
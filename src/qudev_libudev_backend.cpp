@@ -0,0 +1,383 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include "qudev_libudev_backend.h"
+#include "qudev_device.h"
+#include "qudev_filters.h"
+#include "qudev_stats_collector.h"
+
+#include <QDebug>
+#include <QFile>
+
+#include <libudev.h>
+
+/**
+ * @brief Set libudev prefilters for enumeration.
+ * @return false if a libudev call failed; true otherwise.
+ */
+static bool applyEnumerateFilters(udev_enumerate* en, const QudevFilters& filters)
+{
+    // subsystem
+    if (!filters.subsystem.isEmpty())
+    {
+        const QByteArray subsystem = filters.subsystem.toUtf8();
+        const int rc = udev_enumerate_add_match_subsystem(en, subsystem.constData());
+        if (rc < 0) {
+            return false;
+        }
+    }
+
+    // sysname
+    if (!filters.sysname.isEmpty())
+    {
+        const QByteArray sysname = filters.sysname.toUtf8();
+        const int rc = udev_enumerate_add_match_sysname(en, sysname.constData());
+        if (rc < 0) {
+            return false;
+        }
+    }
+
+    // properties (key=value)
+    for (auto it = filters.properties.cbegin(); it != filters.properties.cend(); ++it)
+    {
+        if (it.key().isEmpty() || it.value().isEmpty()) {
+            continue;
+        }
+
+        const QByteArray key = it.key().toUtf8();
+        const QByteArray value = it.value().toUtf8();
+        const int rc = udev_enumerate_add_match_property(en, key.constData(), value.constData());
+        if (rc < 0) {
+            return false;
+        }
+    }
+
+    // tags (AND semantics across multiple calls)
+    for (const auto& tag : filters.tags)
+    {
+        if (tag.isEmpty()) {
+            continue;
+        }
+
+        const QByteArray tagBuf = tag.toUtf8();
+        const int rc = udev_enumerate_add_match_tag(en, tagBuf.constData());
+        if (rc < 0) {
+            return false;
+        }
+    }
+
+    // sysattrs (key=value)
+    for (auto it = filters.sysattrs.cbegin(); it != filters.sysattrs.cend(); ++it)
+    {
+        if (it.key().isEmpty() || it.value().isEmpty()) {
+            continue;
+        }
+
+        const QByteArray key = it.key().toUtf8();
+        const QByteArray value = it.value().toUtf8();
+        const int rc = udev_enumerate_add_match_sysattr(en, key.constData(), value.constData());
+        if (rc < 0) {
+            return false;
+        }
+    }
+
+    // negative sysattrs (key!=value)
+    for (auto it = filters.nomatchSysattrs.cbegin(); it != filters.nomatchSysattrs.cend(); ++it)
+    {
+        if (it.key().isEmpty() || it.value().isEmpty()) {
+            continue;
+        }
+
+        const QByteArray key = it.key().toUtf8();
+        const QByteArray value = it.value().toUtf8();
+        const int rc = udev_enumerate_add_nomatch_sysattr(en, key.constData(), value.constData());
+        if (rc < 0) {
+            return false;
+        }
+    }
+
+    // devtype: enumerator doesn’t have a dedicated API; DEVTYPE is exposed as a property
+    if (!filters.devtype.isEmpty())
+    {
+        static const char* DEVTYPE = "DEVTYPE";
+        const QByteArray value = filters.devtype.toUtf8();
+        const int rc = udev_enumerate_add_match_property(en, DEVTYPE, value.constData());
+        if (rc < 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Set libudev socket filters on a monitor.
+ * @return false if a libudev call failed; true otherwise.
+ */
+static bool applyMonitorFilters(udev_monitor* monitor, const QudevFilters& filters)
+{
+    const QByteArray subsystemBuf = filters.subsystem.toUtf8();
+    const char* subsystemP = subsystemBuf.isEmpty() ? nullptr : subsystemBuf.constData();
+
+    const QByteArray devtypeBuf = filters.devtype.toUtf8();
+    const char* devtypeP = devtypeBuf.isEmpty() ? nullptr : devtypeBuf.constData();
+
+    if (subsystemP)
+    {
+        const int rc = udev_monitor_filter_add_match_subsystem_devtype(monitor, subsystemP, devtypeP);
+        if (rc < 0) {
+            return false;
+        }
+    }
+
+    for (const auto& tag : filters.tags)
+    {
+        if (tag.isEmpty()) {
+            continue;
+        }
+
+        const QByteArray tagBuf = tag.toUtf8();
+        const int rc = udev_monitor_filter_add_match_tag(monitor, tagBuf.constData());
+        if (rc < 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+namespace {
+
+/// Netlink event stream of a libudev monitor.
+class LibudevMonitorSource final : public QudevBackend::MonitorSource
+{
+public:
+    LibudevMonitorSource(const QudevContext& ctx, udev_monitor* monitor) noexcept
+        : context_(ctx),
+        monitor_(monitor)
+    {}
+
+    ~LibudevMonitorSource() override
+    {
+        udev_monitor_unref(monitor_);
+    }
+
+    int fd() const noexcept override
+    {
+        return udev_monitor_get_fd(monitor_);
+    }
+
+    std::optional<QudevDevice> receive() noexcept override
+    {
+        QudevStatsCollector* stats = context_.stats();
+        const quint64 t0 = stats ? QudevStatsCollector::nowNs() : 0;
+
+        udev_device* rawData = udev_monitor_receive_device(monitor_);
+        if (!rawData) {
+            return std::nullopt;
+        }
+
+        const quint64 t1 = stats ? QudevStatsCollector::nowNs() : 0;
+        QudevDevice device = buildDevice(context_, rawData);
+        udev_device_unref(rawData);
+
+        if (stats) {
+            stats->receive.record(t1 - t0);
+            stats->build.record(QudevStatsCollector::nowNs() - t1);
+        }
+        return device;
+    }
+
+    std::optional<quint64> receiveSeqnum() noexcept override
+    {
+        udev_device* rawData = udev_monitor_receive_device(monitor_);
+        if (!rawData) {
+            return std::nullopt;
+        }
+
+        const quint64 seqnum = udev_device_get_seqnum(rawData);
+        udev_device_unref(rawData);
+        return seqnum;
+    }
+
+    bool setFilters(const QudevFilters& filters) noexcept override
+    {
+        if (udev_monitor_filter_remove(monitor_) < 0) {
+            return false;
+        }
+
+        if (!applyMonitorFilters(monitor_, filters)) {
+            return false;
+        }
+
+        return udev_monitor_filter_update(monitor_) >= 0;
+    }
+
+private:
+    const QudevContext& context_;
+    udev_monitor* monitor_;
+};
+
+} // namespace
+
+std::unique_ptr<QudevBackend> QudevBackend::createLibudev() noexcept
+{
+    if (auto ctx = QudevContext::create()) {
+        return std::make_unique<QudevLibudevBackend>(std::move(*ctx));
+    }
+    return nullptr;
+}
+
+QudevLibudevBackend::QudevLibudevBackend(QudevContext&& ctx) noexcept
+    : context_(std::move(ctx))
+{
+    context_.setSysattrCache(&sysattrCache_);
+}
+
+void QudevLibudevBackend::setStats(QudevStatsCollector* stats) noexcept
+{
+    QudevBackend::setStats(stats);
+    context_.setStats(stats);
+    sysattrCache_.setStats(stats);
+}
+
+void QudevLibudevBackend::setSysattrPolicy(const QudevSysattrPolicy& policy)
+{
+    sysattrCache_.setPolicy(policy);
+}
+
+void QudevLibudevBackend::setSysattrReadMode(QudevSysattrReadMode mode)
+{
+    sysattrReader_ = QudevSysattrReader::create(mode);
+    if (!sysattrReader_ && mode != QudevSysattrReadMode::Libudev) {
+        qWarning() << "[QudevLibudevBackend] io_uring unavailable; reading sysattrs through libudev";
+    }
+    context_.setSysattrReader(sysattrReader_.get());
+}
+
+bool QudevLibudevBackend::enumerate(const QudevFilters& filters, const Visitor& visit) noexcept
+{
+    // Create enumerate handle
+    udev_enumerate* en = udev_enumerate_new(context_.get());
+    if (!en) {
+        return false;
+    }
+
+    if (!applyEnumerateFilters(en, filters))
+    {
+        udev_enumerate_unref(en);
+        return false;
+    }
+
+    if (udev_enumerate_scan_devices(en) < 0)
+    {
+        udev_enumerate_unref(en);
+        return false;
+    }
+
+    // An unfiltered scan sees every device, so whatever the sysattr cache
+    // holds beyond that is gone.
+    const bool sweep = filters.empty();
+    if (sweep) {
+        sysattrCache_.beginScan();
+    }
+
+    bool completed = true;
+
+    // With a bulk sysattr reader, devices are built in groups so that one
+    // submission covers the attributes of the whole group.
+    const qsizetype groupSize = sysattrReader_ ? BuildGroupSize : 1;
+    std::vector<udev_device*> group;
+    group.reserve(size_t(groupSize));
+
+    const auto flush = [&]() {
+        QList<QudevDevice> devices = buildDevices(context_, group.data(), qsizetype(group.size()));
+        for (udev_device* d : group) {
+            udev_device_unref(d);
+        }
+        group.clear();
+
+        for (QudevDevice& device : devices) {
+            if (!visit(std::move(device))) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    // Iterate results
+    for (udev_list_entry* it = udev_enumerate_get_list_entry(en);
+         it; it = udev_list_entry_get_next(it))
+    {
+
+        const char* syspath = udev_list_entry_get_name(it);
+        if (!syspath) {
+            continue;
+        }
+
+        udev_device* d = udev_device_new_from_syspath(context_.get(), syspath);
+        if (!d) {
+            continue;
+        }
+
+        group.push_back(d);
+        if (qsizetype(group.size()) == groupSize && !flush()) {
+            completed = false;
+            break;
+        }
+    }
+
+    if (completed && !group.empty()) {
+        completed = flush();
+    }
+
+    udev_enumerate_unref(en);
+
+    if (sweep) {
+        sysattrCache_.endScan(completed);
+    }
+
+    return completed;
+}
+
+std::unique_ptr<QudevBackend::MonitorSource>
+QudevLibudevBackend::createMonitor(MonitorChannel channel, const QudevFilters& filters) noexcept
+{
+    const char* grp = (channel == MonitorChannel::Kernel) ? "kernel" : "udev";
+    udev_monitor* monitor = udev_monitor_new_from_netlink(context_.get(), grp);
+    if (!monitor) {
+        return nullptr;
+    }
+
+    // The source owns the monitor from here on and unrefs it on failure.
+    auto source = std::make_unique<LibudevMonitorSource>(context_, monitor);
+
+    if (!applyMonitorFilters(monitor, filters)) {
+        return nullptr;
+    }
+
+    if (udev_monitor_enable_receiving(monitor) < 0) {
+        return nullptr;
+    }
+
+    return source;
+}
+
+std::unique_ptr<QudevBackend::MonitorSource>
+QudevLibudevBackend::resumeMonitor(MonitorChannel channel, const QudevFilters& filters,
+                                   quint64 seqnum, bool* complete) noexcept
+{
+    auto source = createMonitor(channel, filters);
+
+    // Read after the socket is bound: anything later reaches the source.
+    QFile file(QStringLiteral("/sys/kernel/uevent_seqnum"));
+    bool ok = false;
+    const quint64 current = file.open(QIODevice::ReadOnly) ? file.readAll().trimmed().toULongLong(&ok) : 0;
+    *complete = source && ok && current == seqnum;
+    return source;
+}
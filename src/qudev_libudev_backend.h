@@ -0,0 +1,65 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#pragma once
+
+#include "qudev_backend.h"
+#include "qudev_context.h"
+#include "qudev_sysattr_cache.h"
+#include "qudev_sysattr_reader.h"
+
+/**
+ * @file qudev_libudev_backend.h
+ * @brief Default @ref QudevBackend implementation on top of libudev.
+ */
+
+/**
+ * @brief Backend enumerating and monitoring real devices through libudev.
+ *
+ * Enumeration pushes every criterion libudev supports into
+ * @c udev_enumerate matches; monitors use netlink sockets with
+ * subsystem/devtype and tag socket filters.
+ */
+class QudevLibudevBackend final : public QudevBackend
+{
+public:
+    /**
+     * @brief Construct a backend that owns @p ctx.
+     *
+     * @param ctx A valid libudev context.
+     */
+    explicit QudevLibudevBackend(QudevContext&& ctx) noexcept;
+
+    bool enumerate(const QudevFilters& filters, const Visitor& visit) noexcept override;
+
+    std::unique_ptr<MonitorSource> createMonitor(MonitorChannel channel,
+                                                 const QudevFilters& filters) noexcept override;
+
+    /// Complete only if no uevent happened since @p seqnum; libudev keeps no history.
+    std::unique_ptr<MonitorSource> resumeMonitor(MonitorChannel channel, const QudevFilters& filters,
+                                                 quint64 seqnum, bool* complete) noexcept override;
+
+    void setStats(QudevStatsCollector* stats) noexcept override;
+
+    void setSysattrPolicy(const QudevSysattrPolicy& policy) override;
+
+    void setSysattrReadMode(QudevSysattrReadMode mode) override;
+
+    /// The libudev context shared by enumeration and monitors.
+    ///
+    /// Must not be moved out: it points at this backend's sysattr cache.
+    const QudevContext& context() const noexcept { return context_; }
+
+private:
+    /// Devices built per bulk sysattr submission during enumeration.
+    static constexpr qsizetype BuildGroupSize = 64;
+
+    QudevContext context_;
+    QudevSysattrCache sysattrCache_;
+    std::unique_ptr<QudevSysattrReader> sysattrReader_;
+};
@@ -0,0 +1,578 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include "qudev_memory_backend.h"
+#include "qudev_enumerator.h"
+#include "qudev_monitor.h"
+#include "qudev_event_codec.h"
+#include "qudev_stats_collector.h"
+
+#include <QRandomGenerator>
+#include <QDebug>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+
+namespace {
+
+struct Kind
+{
+    const char* subsystem;
+    const char* devtype;
+    const char* sysnamePrefix;
+    const char* devnodePrefix;  // nullptr for devices without a node
+    int weight;
+};
+
+// Rough subsystem mix of a busy host.
+constexpr Kind Kinds[] = {
+    { "pci",          nullptr,        "0000:00:",  nullptr,        14 },
+    { "usb",          "usb_device",   "1-",        "/dev/bus/usb", 10 },
+    { "usb",          "usb_interface","1-1:1.",    nullptr,        10 },
+    { "block",        "disk",         "sd",        "/dev/sd",       6 },
+    { "block",        "partition",    "sda",       "/dev/sda",      8 },
+    { "net",          nullptr,        "eth",       nullptr,         4 },
+    { "input",        nullptr,        "event",     "/dev/input/event", 8 },
+    { "tty",          nullptr,        "tty",       "/dev/tty",     20 },
+    { "power_supply", nullptr,        "BAT",       nullptr,         2 },
+    { "thermal",      nullptr,        "thermal_zone", nullptr,      6 },
+    { "hwmon",        nullptr,        "hwmon",     nullptr,         4 },
+    { "platform",     nullptr,        "serial8250.", nullptr,       8 },
+};
+
+const Kind& pickKind(QRandomGenerator& rng)
+{
+    int total = 0;
+    for (const auto& k : Kinds) {
+        total += k.weight;
+    }
+
+    int r = rng.bounded(total);
+    for (const auto& k : Kinds) {
+        if (r < k.weight) {
+            return k;
+        }
+        r -= k.weight;
+    }
+    return Kinds[0];
+}
+
+QString hex(QRandomGenerator& rng, int digits)
+{
+    const quint64 mask = (quint64(1) << (4 * digits)) - 1;
+    return QString::number(rng.generate64() & mask, 16).rightJustified(digits, QLatin1Char('0'));
+}
+
+/// Convert a @c CLOCK_REALTIME socket timestamp to @c CLOCK_MONOTONIC.
+quint64 realtimeToMonotonicNs(const timespec& stamp) noexcept
+{
+    timespec real;
+    clock_gettime(CLOCK_REALTIME, &real);
+    const qint64 ageNs = (qint64(real.tv_sec) - stamp.tv_sec) * 1000000000ll + (real.tv_nsec - stamp.tv_nsec);
+    const quint64 now = QudevStatsCollector::nowNs();
+    return ageNs > 0 && quint64(ageNs) < now ? now - quint64(ageNs) : now;
+}
+
+/// The part of @p filters a netlink socket filter would apply.
+bool matchesSourceFilter(const QudevDevice& d, const QudevFilters& filters)
+{
+    if (!filters.subsystem.isEmpty()) {
+        if (d.subsystem != filters.subsystem) {
+            return false;
+        }
+        if (!filters.devtype.isEmpty() && d.devtype != filters.devtype) {
+            return false;
+        }
+    }
+
+    for (const auto& tag : filters.tags) {
+        if (!tag.isEmpty() && !d.tags.contains(tag)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+class MemoryMonitorSource;
+
+} // namespace
+
+struct QudevMemoryBackend::Private
+{
+    Options options;
+    QList<QudevDevice> devices;
+
+    /// The backend's stats, for sources; cleared when the backend goes.
+    std::atomic<QudevStatsCollector*> stats{nullptr};
+
+    /// Guards @ref sources and every source's filters.
+    std::mutex mutex;
+    std::vector<MemoryMonitorSource*> sources;
+
+    std::atomic<quint64> seqnum{0};
+    std::atomic<quint64> sent{0};
+    std::atomic<quint64> dropped{0};
+
+    std::thread generator;
+    std::atomic<bool> stopGenerator{false};
+    std::atomic<bool> generating{false};
+
+    bool send(const QudevDevice& event) noexcept;
+    void generate(double eventsPerSecond, quint64 count) noexcept;
+};
+
+namespace {
+
+/// Receiving end of a socketpair fed by QudevMemoryBackend::Private::send().
+class MemoryMonitorSource final : public QudevBackend::MonitorSource
+{
+public:
+    MemoryMonitorSource(std::shared_ptr<QudevMemoryBackend::Private> backend,
+                        int readFd, int writeFd, const QudevFilters& filters) noexcept
+        : backend_(std::move(backend)),
+        readFd_(readFd),
+        writeFd(writeFd),
+        filters(filters)
+    {
+        buffer_.resize(64 * 1024);
+
+        std::lock_guard<std::mutex> lock(backend_->mutex);
+        backend_->sources.push_back(this);
+    }
+
+    ~MemoryMonitorSource() override
+    {
+        {
+            std::lock_guard<std::mutex> lock(backend_->mutex);
+            auto& sources = backend_->sources;
+            sources.erase(std::remove(sources.begin(), sources.end(), this), sources.end());
+        }
+
+        ::close(readFd_);
+        ::close(writeFd);
+    }
+
+    int fd() const noexcept override
+    {
+        return readFd_;
+    }
+
+    std::optional<QudevDevice> receive() noexcept override
+    {
+        QudevStatsCollector* stats = backend_->stats.load(std::memory_order_relaxed);
+        const quint64 t0 = stats ? QudevStatsCollector::nowNs() : 0;
+
+        const qsizetype n = read();
+        if (n <= 0) {
+            return std::nullopt;
+        }
+
+        const quint64 t1 = stats ? QudevStatsCollector::nowNs() : 0;
+        QudevDevice device = qudevDecodeEvent(buffer_.constData(), n);
+
+        if (stats) {
+            stats->receive.record(t1 - t0);
+            stats->build.record(QudevStatsCollector::nowNs() - t1);
+        }
+        return device;
+    }
+
+    std::optional<quint64> receiveSeqnum() noexcept override
+    {
+        const qsizetype n = read();
+        if (n <= 0) {
+            return std::nullopt;
+        }
+        return qudevDecodeEventSeqnum(buffer_.constData(), n);
+    }
+
+    quint64 lastReceiveTimestampNs() const noexcept override
+    {
+        return lastTimestampNs_;
+    }
+
+    bool setFilters(const QudevFilters& newFilters) noexcept override
+    {
+        std::lock_guard<std::mutex> lock(backend_->mutex);
+        filters = newFilters;
+        return true;
+    }
+
+private:
+    /// Read one whole datagram into buffer_ and note its arrival time.
+    qsizetype read() noexcept
+    {
+        iovec iov{ buffer_.data(), size_t(buffer_.size()) };
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(timespec))];
+        msghdr msg{};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        ssize_t n;
+        for (;;)
+        {
+            n = ::recvmsg(readFd_, &msg, MSG_DONTWAIT);
+            if (n <= 0) {
+                return n;
+            }
+            if (!(msg.msg_flags & MSG_TRUNC)) {
+                break;
+            }
+            // A cut-off event would decode into a wrong device: skip it.
+            qWarning() << "[QudevMemoryBackend] Dropped an event larger than" << buffer_.size() << "bytes";
+            ++backend_->dropped;
+            msg.msg_controllen = sizeof(control);
+            msg.msg_flags = 0;
+        }
+
+        lastTimestampNs_ = 0;
+        for (cmsghdr* c = CMSG_FIRSTHDR(&msg); c; c = CMSG_NXTHDR(&msg, c)) {
+            if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_TIMESTAMPNS) {
+                timespec ts;
+                memcpy(&ts, CMSG_DATA(c), sizeof(ts));
+                lastTimestampNs_ = realtimeToMonotonicNs(ts);
+            }
+        }
+        return n;
+    }
+
+    std::shared_ptr<QudevMemoryBackend::Private> backend_;
+    int readFd_;
+    QByteArray buffer_;
+    quint64 lastTimestampNs_ = 0;
+
+public:
+    // Used by the sender under backend_->mutex.
+    int writeFd;
+    QudevFilters filters;
+};
+
+} // namespace
+
+bool QudevMemoryBackend::Private::send(const QudevDevice& event) noexcept
+{
+    bool delivered = false;
+    bool lossless = true;
+    QByteArray payload;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (MemoryMonitorSource* source : sources)
+    {
+        if (!matchesSourceFilter(event, source->filters)) {
+            continue;
+        }
+
+        if (payload.isEmpty()) {
+            payload = qudevEncodeEvent(event);
+        }
+
+        for (;;)
+        {
+            const ssize_t rc = ::send(source->writeFd, payload.constData(), payload.size(),
+                                      MSG_DONTWAIT | MSG_NOSIGNAL);
+            if (rc >= 0) {
+                delivered = true;
+                break;
+            }
+
+            if (errno == EINTR) {
+                continue;
+            }
+
+            if ((errno == EAGAIN || errno == EWOULDBLOCK) && !options.dropWhenFull) {
+                // Wait for the reader, but never forever: a monitor that is
+                // not being drained must not wedge the generator.
+                pollfd pfd{source->writeFd, POLLOUT, 0};
+                if (::poll(&pfd, 1, 100) > 0) {
+                    continue;
+                }
+            }
+
+            ++dropped;
+            lossless = false;
+            break;
+        }
+    }
+
+    if (delivered) {
+        ++sent;
+    }
+
+    return lossless;
+}
+
+void QudevMemoryBackend::Private::generate(double eventsPerSecond, quint64 count) noexcept
+{
+    using Clock = std::chrono::steady_clock;
+
+    QRandomGenerator rng(options.seed ^ 0x9e3779b9u);
+    const Clock::time_point start = Clock::now();
+    quint64 n = 0;
+
+    while (!stopGenerator.load(std::memory_order_relaxed) && (count == 0 || n < count))
+    {
+        quint64 due = n + 1024;
+        if (eventsPerSecond > 0) {
+            const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+            due = quint64(elapsed * eventsPerSecond) + 1;
+        }
+        if (count != 0) {
+            due = qMin(due, count);
+        }
+
+        if (n >= due) {
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+            continue;
+        }
+
+        for (; n < due && !stopGenerator.load(std::memory_order_relaxed); ++n)
+        {
+            QudevDevice event = devices.at(rng.bounded(int(devices.size())));
+
+            const int roll = rng.bounded(10);
+            event.action = roll == 0 ? QStringLiteral("remove")
+                         : roll == 1 ? QStringLiteral("add")
+                                     : QStringLiteral("change");
+            event.seqnum = ++seqnum;
+            event.properties.insert(QStringLiteral("ACTION"), event.action);
+            event.properties.insert(QStringLiteral("SEQNUM"), QString::number(event.seqnum));
+            // Stands in for udevd finishing the event right now.
+            event.properties.insert(QStringLiteral("USEC_INITIALIZED"),
+                                    QString::number(QudevStatsCollector::nowNs() / 1000));
+
+            send(event);
+        }
+    }
+
+    generating = false;
+}
+
+QudevMemoryBackend::QudevMemoryBackend()
+    : QudevMemoryBackend(Options{})
+{}
+
+QudevMemoryBackend::QudevMemoryBackend(const Options& options)
+    : QudevMemoryBackend(generateDevices(options.devices, options.seed), options)
+{}
+
+QudevMemoryBackend::QudevMemoryBackend(QList<QudevDevice> devices)
+    : QudevMemoryBackend(std::move(devices), Options{})
+{}
+
+QudevMemoryBackend::QudevMemoryBackend(QList<QudevDevice> devices, const Options& options)
+    : d_{std::make_shared<Private>()}
+{
+    d_->options = options;
+    d_->devices = std::move(devices);
+}
+
+QudevMemoryBackend::~QudevMemoryBackend()
+{
+    stopEvents();
+
+    // Open sources keep d_ alive; the stats they report to may not be.
+    d_->stats = nullptr;
+}
+
+void QudevMemoryBackend::setStats(QudevStatsCollector* stats) noexcept
+{
+    QudevBackend::setStats(stats);
+    d_->stats = stats;
+}
+
+const QList<QudevDevice>& QudevMemoryBackend::devices() const noexcept
+{
+    return d_->devices;
+}
+
+bool QudevMemoryBackend::inject(const QudevDevice& event) noexcept
+{
+    if (event.seqnum != 0) {
+        return d_->send(event);
+    }
+
+    QudevDevice numbered = event;
+    numbered.seqnum = ++d_->seqnum;
+    return d_->send(numbered);
+}
+
+void QudevMemoryBackend::startEvents(double eventsPerSecond, quint64 count)
+{
+    stopEvents();
+
+    if (d_->devices.isEmpty()) {
+        return;
+    }
+
+    d_->stopGenerator = false;
+    d_->generating = true;
+    d_->generator = std::thread([this, eventsPerSecond, count]() {
+        d_->generate(eventsPerSecond, count);
+    });
+}
+
+void QudevMemoryBackend::stopEvents()
+{
+    d_->stopGenerator = true;
+    if (d_->generator.joinable()) {
+        d_->generator.join();
+    }
+    d_->generating = false;
+}
+
+bool QudevMemoryBackend::eventsRunning() const noexcept
+{
+    return d_->generating.load();
+}
+
+quint64 QudevMemoryBackend::eventsSent() const noexcept
+{
+    return d_->sent.load();
+}
+
+quint64 QudevMemoryBackend::eventsDropped() const noexcept
+{
+    return d_->dropped.load();
+}
+
+bool QudevMemoryBackend::enumerate(const QudevFilters& filters, const Visitor& visit) noexcept
+{
+    // Everything libudev would match in the kernel/database is matched
+    // here, with its glob semantics; actions do not apply to a snapshot.
+    for (const QudevDevice& d : std::as_const(d_->devices))
+    {
+        if (!QudevEnumerator::matches(d, filters)) {
+            continue;
+        }
+
+        QudevDevice copy = d;
+        if (!visit(std::move(copy))) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+std::unique_ptr<QudevBackend::MonitorSource>
+QudevMemoryBackend::createMonitor(MonitorChannel, const QudevFilters& filters) noexcept
+{
+    int fds[2];
+    if (::socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds) < 0) {
+        qWarning() << "[QudevMemoryBackend] socketpair() failed:" << strerror(errno);
+        return nullptr;
+    }
+
+    // Ask for a large buffer; fall back to what unprivileged users may set.
+    const int bytes = d_->options.socketBufferBytes;
+    if (::setsockopt(fds[1], SOL_SOCKET, SO_SNDBUFFORCE, &bytes, sizeof(bytes)) < 0) {
+        ::setsockopt(fds[1], SOL_SOCKET, SO_SNDBUF, &bytes, sizeof(bytes));
+    }
+
+    // Arrival timestamps, where AF_UNIX supports them; receive() copes
+    // with their absence.
+    const int on = 1;
+    ::setsockopt(fds[0], SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on));
+
+    return std::make_unique<MemoryMonitorSource>(d_, fds[0], fds[1], filters);
+}
+
+QList<QudevDevice> QudevMemoryBackend::generateDevices(int count, quint32 seed)
+{
+    QRandomGenerator rng(seed);
+    QList<QudevDevice> devices;
+    devices.reserve(count);
+
+    for (int i = 0; i < count; ++i)
+    {
+        const Kind& k = pickKind(rng);
+        QudevDevice d;
+
+        d.subsystem = QString::fromLatin1(k.subsystem);
+        d.devtype   = k.devtype ? QString::fromLatin1(k.devtype) : QString();
+        d.sysname   = QString::fromLatin1(k.sysnamePrefix) + QString::number(i);
+        d.syspath   = QStringLiteral("/sys/devices/pci0000:00/0000:00:%1.0/%2/%3")
+                        .arg(rng.bounded(32), 2, 16, QLatin1Char('0'))
+                        .arg(d.subsystem, d.sysname);
+        d.devnode   = k.devnodePrefix ? QString::fromLatin1(k.devnodePrefix) + QString::number(i) : QString();
+        d.driver    = (i % 3) ? QStringLiteral("drv_%1").arg(d.subsystem) : QString();
+        d.action    = QStringLiteral("add");
+        d.seqnum    = quint64(i) + 1;
+
+        d.isBlock = d.subsystem == QLatin1String("block");
+        d.isChar  = !d.devnode.isEmpty() && !d.isBlock;
+        if (!d.devnode.isEmpty()) {
+            d.major   = 8 + rng.bounded(240);
+            d.minor   = rng.bounded(256);
+        }
+
+        d.parent_syspath   = d.syspath.section(QLatin1Char('/'), 0, -2);
+        d.parent_subsystem = QStringLiteral("pci");
+
+        d.properties.insert(QStringLiteral("ACTION"),    d.action);
+        d.properties.insert(QStringLiteral("DEVPATH"),   d.syspath.mid(4));
+        d.properties.insert(QStringLiteral("SUBSYSTEM"), d.subsystem);
+        d.properties.insert(QStringLiteral("SEQNUM"),    QString::number(d.seqnum));
+        d.properties.insert(QStringLiteral("USEC_INITIALIZED"), QString::number(1000000 + 17 * i));
+        if (!d.devtype.isEmpty()) {
+            d.properties.insert(QStringLiteral("DEVTYPE"), d.devtype);
+        }
+        if (!d.devnode.isEmpty()) {
+            d.properties.insert(QStringLiteral("DEVNAME"), d.devnode);
+            d.properties.insert(QStringLiteral("MAJOR"), QString::number(d.major));
+            d.properties.insert(QStringLiteral("MINOR"), QString::number(d.minor));
+        }
+        d.properties.insert(QStringLiteral("ID_BUS"), (i % 2) ? QStringLiteral("usb") : QStringLiteral("ata"));
+        d.properties.insert(QStringLiteral("ID_VENDOR_ID"), hex(rng, 4));
+        d.properties.insert(QStringLiteral("ID_MODEL_ID"),  hex(rng, 4));
+        d.properties.insert(QStringLiteral("ID_SERIAL"),    QStringLiteral("Vendor_Model_%1").arg(hex(rng, 8)));
+        d.properties.insert(QStringLiteral("ID_PATH"),      QStringLiteral("pci-0000:00:%1.0").arg(i % 32));
+        const int extraProps = 8 + rng.bounded(8);
+        for (int p = 0; p < extraProps; ++p) {
+            d.properties.insert(QStringLiteral("ID_EXTRA_%1").arg(p), hex(rng, 6));
+        }
+
+        const int attrs = 8 + rng.bounded(14);
+        for (int a = 0; a < attrs; ++a) {
+            d.sysattrs.insert(QStringLiteral("attr_%1").arg(a), hex(rng, 4));
+        }
+        d.sysattrs.insert(QStringLiteral("uevent"), QStringLiteral("DEVTYPE=%1").arg(d.devtype));
+        d.sysattrs.insert(QStringLiteral("removable"), QString::number(i % 2));
+
+        if (!d.devnode.isEmpty()) {
+            d.devlinks << QStringLiteral("/dev/disk/by-id/%1-%2").arg(d.subsystem).arg(i)
+                       << QStringLiteral("/dev/disk/by-path/pci-%1").arg(i);
+        }
+
+        d.tags << QStringLiteral("systemd");
+        if (i % 4 == 0) {
+            d.tags << QStringLiteral("uaccess");
+        }
+
+        devices.push_back(std::move(d));
+    }
+
+    return devices;
+}
@@ -7,15 +7,21 @@
 // See the LICENSE file in the project root for full license text.
 
 #include "qudev_monitor.h"
-#include "qudev_context.h"
 #include "qudev_device.h"
+#include "qudev_event_recorder.h"
+#include "qudev_stats_collector.h"
+#include "qudev_trace.h"
 
-#include <libudev.h>
+#include <QDebug>
 #include <QSocketNotifier>
 
+#include <algorithm>
+#include <iterator>
 
-QudevMonitor::QudevMonitor(Channel channel, QObject* parent) noexcept
+
+QudevMonitor::QudevMonitor(QudevBackend& backend, Channel channel, QObject* parent) noexcept
     : QObject(parent),
+    backend_(backend),
     channel_(channel)
 {
 
@@ -31,90 +37,183 @@ bool QudevMonitor::start(const QudevFilters& filters) noexcept
     // Clean any previous state.
     stop();
 
-    // Create and hold a udev context.
-    context_.reset();
-    if (auto ctx = QudevContext::create()) {
-        context_.emplace(std::move(*ctx));
-    } else {
-        return false;
-    }
-
     filters_ = filters;
+    return attach(backend_.createMonitor(channel_, filters_));
+}
 
-    const char* grp = (channel_ == Channel::Kernel) ? "kernel" : "udev";
-    monitor_ = udev_monitor_new_from_netlink(context_->get(), grp);
-    if (!monitor_) {
-        stop();
-        return false;
-    }
+bool QudevMonitor::resume(const QudevFilters& filters, quint64 seqnum, bool* complete) noexcept
+{
+    stop();
 
-    if (!applyPreFilters(filters_)) {
-        stop();
+    filters_ = filters;
+    if (!attach(backend_.resumeMonitor(channel_, filters_, seqnum, complete))) {
         return false;
     }
 
-    const int rc = udev_monitor_enable_receiving(monitor_);
-    if (rc < 0){
-        stop();
+    // Replayed events may already sit in the source's buffer.
+    QMetaObject::invokeMethod(this, &QudevMonitor::onReadyRead, Qt::QueuedConnection);
+    return true;
+}
+
+bool QudevMonitor::attach(std::unique_ptr<QudevBackend::MonitorSource> source) noexcept
+{
+    source_ = std::move(source);
+    if (!source_) {
         return false;
     }
 
-    const int fd = udev_monitor_get_fd(monitor_);
-    socket_ = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+    socket_ = new QSocketNotifier(source_->fd(), QSocketNotifier::Read, this);
     connect(socket_, &QSocketNotifier::activated, this, &QudevMonitor::onReadyRead);
 
+    if (kernelTracking_ && channel_ != Channel::Kernel && !startKernelSource()) {
+        qWarning() << "[QudevMonitor] Kernel latency tracking unavailable";
+    }
+
     return true;
 }
 
 void QudevMonitor::stop() noexcept
 {
+    stopKernelSource();
+
     if (socket_) {
         socket_->disconnect(this);
         socket_->deleteLater();
         socket_ = nullptr;
     }
 
-    if (monitor_) {
-        udev_monitor_unref(monitor_);
-        monitor_ = nullptr;
+    source_.reset();
+
+    for (auto& lane : lanes_) {
+        lane.clear();
     }
+    pending_.clear();
+    queued_ = 0;
+}
 
-    context_.reset();
+bool QudevMonitor::setFilters(const QudevFilters& filters) noexcept
+{
+    filters_ = filters;
+
+    if (!source_) {
+        return true;
+    }
+
+    if (kernelSource_ && !kernelSource_->setFilters(filters_)) {
+        stopKernelSource();
+    }
+
+    return source_->setFilters(filters_);
 }
 
-bool QudevMonitor::applyPreFilters(const QudevFilters &filters) const noexcept
+void QudevMonitor::setPriorityLanes(const QudevPriorityLanes& lanes) noexcept
 {
-    const QByteArray subsystemBuf = filters.subsystem.toUtf8();
-    const char* subsystemP = subsystemBuf.isEmpty() ? nullptr : subsystemBuf.constData();
+    priority_ = lanes;
+    // Zero would leave no room to read into, and the socket readable.
+    priority_.maxQueued = std::max<qsizetype>(1, lanes.maxQueued);
+}
 
-    const QByteArray devtypeBuf = filters.devtype.toUtf8();
-    const char* devtypeP = devtypeBuf.isEmpty() ? nullptr : devtypeBuf.constData();
+void QudevMonitor::setKernelLatencyTracking(bool enabled) noexcept
+{
+    kernelTracking_ = enabled;
 
-    if (subsystemP)
-    {
-        const int rc = udev_monitor_filter_add_match_subsystem_devtype(monitor_, subsystemP, devtypeP);
-        if (rc < 0) {
-            return false;
-        }
+    if (!enabled) {
+        stopKernelSource();
+    } else if (source_ && !kernelSource_ && channel_ != Channel::Kernel) {
+        startKernelSource();
     }
+}
 
-    for (const auto& tag : filters.tags)
+bool QudevMonitor::startKernelSource() noexcept
+{
+    kernelSource_ = backend_.createMonitor(Channel::Kernel, filters_);
+    if (!kernelSource_) {
+        return false;
+    }
+
+    kernelSocket_ = new QSocketNotifier(kernelSource_->fd(), QSocketNotifier::Read, this);
+    connect(kernelSocket_, &QSocketNotifier::activated, this, &QudevMonitor::onKernelReadyRead);
+    return true;
+}
+
+void QudevMonitor::stopKernelSource() noexcept
+{
+    if (kernelSocket_) {
+        kernelSocket_->disconnect(this);
+        kernelSocket_->deleteLater();
+        kernelSocket_ = nullptr;
+    }
+
+    kernelSource_.reset();
+    kernelSeen_.fill({});
+}
+
+void QudevMonitor::onKernelReadyRead()
+{
+    while (kernelSource_)
     {
-        if (tag.isEmpty()) {
-            continue;
+        // Only the seqnum is needed: no device is built for this channel.
+        const quint64 now = QudevStatsCollector::nowNs();
+        const std::optional<quint64> seqnum = kernelSource_->receiveSeqnum();
+        if (!seqnum) {
+            break;
         }
 
-        const QByteArray tagBuf = tag.toUtf8();
-        const int rc = udev_monitor_filter_add_match_tag(monitor_, tagBuf.constData());
-        if (rc < 0) {
-            return false;
+        const quint64 stamp = kernelSource_->lastReceiveTimestampNs();
+        kernelSeen_[*seqnum % kernelSeen_.size()] = { *seqnum, stamp ? stamp : now };
+    }
+}
+
+void QudevMonitor::stampTiming(const QudevDevice& device, quint64 receivedNs, bool socketTimestamp,
+                               quint64 deliveredNs, QudevStatsCollector& stats) noexcept
+{
+    timing_ = {};
+    timing_.seqnum = device.seqnum;
+    timing_.deliveredNs = deliveredNs;
+    timing_.receivedIsSocketTimestamp = socketTimestamp;
+    timing_.receivedNs = receivedNs;
+
+    const auto usec = device.properties.constFind(QStringLiteral("USEC_INITIALIZED"));
+    if (usec != device.properties.cend()) {
+        timing_.initializedNs = usec->toULongLong() * 1000;
+    }
+
+    if (kernelSource_) {
+        // The kernel uevent may still sit unread in its socket.
+        KernelSeen* seen = &kernelSeen_[device.seqnum % kernelSeen_.size()];
+        if (seen->seqnum != device.seqnum) {
+            onKernelReadyRead();
+            seen = &kernelSeen_[device.seqnum % kernelSeen_.size()];
+        }
+        if (seen->seqnum == device.seqnum) {
+            timing_.kernelNs = seen->ns;
         }
     }
 
-    return true;
+    if (timing_.receivedNs && deliveredNs >= timing_.receivedNs) {
+        stats.receiveToDelivery.record(deliveredNs - timing_.receivedNs);
+    }
+
+    // USEC_INITIALIZED is kept from the first add, so only add events
+    // measure udevd's work on this event.
+    if (device.action != QLatin1String("add") || !timing_.initializedNs) {
+        return;
+    }
+
+    if (timing_.receivedNs >= timing_.initializedNs) {
+        stats.udevdToReceive.record(timing_.receivedNs - timing_.initializedNs);
+    }
+    if (timing_.kernelNs && timing_.initializedNs >= timing_.kernelNs) {
+        stats.kernelToUdevd.record(timing_.initializedNs - timing_.kernelNs);
+    }
 }
 
-bool QudevMonitor::applyPostFilters(const QudevDevice& device, const QudevFilters &filters) const noexcept
+void QudevMonitor::setRecorder(QudevEventRecorder* recorder) noexcept
+{
+    recorder_ = recorder;
+}
+
+bool QudevMonitor::applyPostFilters(const QudevDevice& device, const QudevFilters &filters) noexcept
 {
     // subsystem
     if (!filters.subsystem.isEmpty() &&
@@ -186,19 +285,214 @@ bool QudevMonitor::applyPostFilters(const QudevDevice& device, const QudevFilter
 
 void QudevMonitor::onReadyRead()
 {
-    if (!monitor_ || !context_) {
+    if (priority_.isEnabled() || queued_ > 0) {
+        deliverFromLanes();
         return;
     }
 
-    while (udev_device* rawData = udev_monitor_receive_device(monitor_))
+    QUDEV_TRACE_SCOPE_NAMED(span, "qudev", "monitor.receive");
+    QudevStatsCollector* stats = backend_.stats();
+    QUDEV_TRACE_COUNTER(received);
+
+    // A slot connected to deviceFound() may stop the monitor.
+    while (source_)
     {
-        QudevDevice device = buildDevice(*context_, rawData);
-        udev_device_unref(rawData);
+        std::optional<Received> r = receiveOne(stats);
+        if (!r) {
+            break;
+        }
+
+        QUDEV_TRACE_COUNT(received);
+
+        if (!r->accepted) {
+            continue;
+        }
+        if (!stats) {
+            emit deviceFound(QudevSharedDevice(std::move(r->device)));
+            continue;
+        }
+
+        stampTiming(r->device, r->receivedNs, r->socketTimestamp, r->filteredNs, *stats);
+        emit deviceFound(QudevSharedDevice(std::move(r->device)));
+        stats->emit_.record(QudevStatsCollector::nowNs() - r->filteredNs);
+        QudevStatsCollector::add(stats->eventsDelivered);
+    }
+
+    QUDEV_TRACE_ARG(span, "events", received);
+}
+
+std::optional<QudevMonitor::Received> QudevMonitor::receiveOne(QudevStatsCollector* stats)
+{
+    const quint64 dequeued = stats ? QudevStatsCollector::nowNs() : 0;
+    std::optional<QudevDevice> device = source_->receive();
+    if (!device) {
+        return std::nullopt;
+    }
+
+    if (recorder_) {
+        recorder_->record(*device);
+    }
+
+    Received r;
+    r.device = std::move(*device);
+
+    if (!stats) {
+        r.accepted = applyPostFilters(r.device, filters_);
+        return r;
+    }
+
+    QudevStatsCollector::add(stats->eventsReceived);
+    QudevStatsCollector::add(stats->devicesBuilt);
+
+    const quint64 t0 = QudevStatsCollector::nowNs();
+    {
+        QUDEV_TRACE_SCOPE("qudev", "filter");
+        r.accepted = applyPostFilters(r.device, filters_);
+    }
+    r.filteredNs = QudevStatsCollector::nowNs();
+    stats->filter.record(r.filteredNs - t0);
+
+    if (!r.accepted) {
+        QudevStatsCollector::add(stats->eventsFiltered);
+        return r;
+    }
+
+    const quint64 stamp = source_->lastReceiveTimestampNs();
+    r.receivedNs = stamp ? stamp : dequeued;
+    r.socketTimestamp = stamp != 0;
+    return r;
+}
+
+void QudevMonitor::drainIntoLanes()
+{
+    QUDEV_TRACE_SCOPE_NAMED(span, "qudev", "monitor.drain");
+    QudevStatsCollector* stats = backend_.stats();
+    QUDEV_TRACE_COUNTER(received);
+
+    while (source_ && queued_ < priority_.maxQueued)
+    {
+        std::optional<Received> r = receiveOne(stats);
+        if (!r) {
+            break;
+        }
+
+        QUDEV_TRACE_COUNT(received);
 
-        if (applyPostFilters(device, filters_)) {
-            emit deviceFound(device);
+        if (r->accepted) {
+            enqueue(std::move(r->device), r->receivedNs, r->socketTimestamp);
         }
     }
 
+    QUDEV_TRACE_ARG(span, "events", received);
 }
 
+void QudevMonitor::enqueue(QudevDevice&& device, quint64 receivedNs, bool socketTimestamp)
+{
+    int lane = priority_.laneOf(device);
+
+    // A device's queued events stay in one lane, the most urgent one
+    // they were sent to, so they are delivered in arrival order.
+    auto it = pending_.find(device.syspath);
+    if (it == pending_.end()) {
+        it = pending_.insert(device.syspath, Pending{ lane, 0 });
+    } else if (it->lane > lane) {
+        std::deque<Queued>& from = lanes_[size_t(it->lane)];
+        std::deque<Queued>& to = lanes_[size_t(lane)];
+        const auto moved = std::stable_partition(from.begin(), from.end(), [&device](const Queued& q) {
+            return q.device.syspath != device.syspath;
+        });
+        std::move(moved, from.end(), std::back_inserter(to));
+        from.erase(moved, from.end());
+        it->lane = lane;
+    } else {
+        lane = it->lane;
+    }
+    ++it->count;
+
+    std::deque<Queued>& queue = lanes_[size_t(lane)];
+    queue.push_back({ std::move(device), QudevStatsCollector::nowNs(), receivedNs, socketTimestamp });
+    ++queued_;
+
+    if (QudevStatsCollector* stats = backend_.stats()) {
+        stats->lanes[lane].recordDepth(quint64(queue.size()));
+    }
+}
+
+int QudevMonitor::nextLane(bool* starved) const noexcept
+{
+    *starved = false;
+
+    const auto first = std::find_if(lanes_.cbegin(), lanes_.cend(),
+                                    [](const std::deque<Queued>& lane) { return !lane.empty(); });
+    if (first == lanes_.cend()) {
+        return -1;
+    }
+    const int highest = int(first - lanes_.cbegin());
+    if (priority_.starvationMs <= 0) {
+        return highest;
+    }
+
+    // The longest-waiting head of a lower lane, if it waited too long.
+    const quint64 now = QudevStatsCollector::nowNs();
+    const quint64 limit = quint64(priority_.starvationMs) * 1000000ull;
+    int oldest = highest;
+    for (int i = highest + 1; i < QudevPriorityLanes::LaneCount; ++i) {
+        const std::deque<Queued>& lane = lanes_[size_t(i)];
+        if (!lane.empty() && now - lane.front().queuedNs > limit
+            && lane.front().queuedNs < lanes_[size_t(oldest)].front().queuedNs) {
+            oldest = i;
+        }
+    }
+    *starved = oldest != highest;
+    return oldest;
+}
+
+void QudevMonitor::deliverFromLanes()
+{
+    QUDEV_TRACE_SCOPE_NAMED(span, "qudev", "monitor.lanes");
+    QUDEV_TRACE_COUNTER(delivered);
+
+    // A slot connected to deviceFound() may stop the monitor; the socket
+    // is read empty again before every event, so urgent ones that arrive
+    // meanwhile go first.
+    while (source_)
+    {
+        drainIntoLanes();
+
+        bool starved = false;
+        const int lane = nextLane(&starved);
+        if (lane < 0) {
+            break;
+        }
+
+        Queued q = std::move(lanes_[size_t(lane)].front());
+        lanes_[size_t(lane)].pop_front();
+        --queued_;
+        const auto it = pending_.find(q.device.syspath);
+        if (it != pending_.end() && --it->count == 0) {
+            pending_.erase(it);
+        }
+        QUDEV_TRACE_COUNT(delivered);
+
+        QudevStatsCollector* stats = backend_.stats();
+        if (!stats) {
+            emit deviceFound(QudevSharedDevice(std::move(q.device)));
+            continue;
+        }
+
+        const quint64 t1 = QudevStatsCollector::nowNs();
+        QudevStatsCollector::Lane& laneStats = stats->lanes[lane];
+        QudevStatsCollector::add(laneStats.delivered);
+        if (starved) {
+            QudevStatsCollector::add(laneStats.starved);
+        }
+        laneStats.queue.record(t1 - q.queuedNs);
+
+        stampTiming(q.device, q.receivedNs, q.socketTimestamp, t1, *stats);
+        emit deviceFound(QudevSharedDevice(std::move(q.device)));
+        stats->emit_.record(QudevStatsCollector::nowNs() - t1);
+        QudevStatsCollector::add(stats->eventsDelivered);
+    }
+
+    QUDEV_TRACE_ARG(span, "events", delivered);
+}
@@ -8,26 +8,34 @@
 
 #pragma once
 
+#include <QHash>
 #include <QObject>
+#include <array>
+#include <deque>
+#include <memory>
 #include <optional>
 
-#include "qudev_context.h"
+#include "qudev_backend.h"
+#include "qudev_device.h"
 #include "qudev_filters.h"
+#include "qudev_priority.h"
+#include "qudev_stats.h"
 
-struct udev_monitor;
 class QSocketNotifier;
-struct QudevDevice;
+class QudevEventRecorder;
+class QudevStatsCollector;
 
 /**
  * @file qudev_monitor.h
- * @brief Internal event monitor for libudev devices.
+ * @brief Internal event monitor for devices.
  */
 
 /**
- * @brief Event monitor for libudev devices.
+ * @brief Event monitor for devices.
  *
- * QudevMonitor encapsulates a libudev monitor instance and exposes
- * device events via the @ref deviceFound() signal. It is an internal
+ * QudevMonitor encapsulates a backend event stream (a libudev monitor
+ * by default) and exposes device events via the @ref deviceFound()
+ * signal. It is an internal
  * helper used by @ref Qudev and is not meant to be used directly by
  * library consumers.
  */
@@ -35,23 +43,20 @@ class QudevMonitor : public QObject
 {
     Q_OBJECT
 public:
-    /**
-     * @brief Supported channels for device events.
-     *
-     * See libudev documentation for details.
-     */
-    enum class Channel {
-        Kernel,
-        Udev
-    };
+    /// Supported channels for device events.
+    using Channel = QudevBackend::MonitorChannel;
 
     /**
-     * @brief Construct a QudevMonitor using @p channel.
+     * @brief Construct a QudevMonitor using @p channel of @p backend.
+     *
+     * The monitor never takes ownership of the backend; it must outlive
+     * this object.
      *
+     * @param backend Backend providing the event stream.
      * @param channel Channel type to use for monitoring.
      * @param parent  Optional QObject parent.
      */
-    explicit QudevMonitor(Channel channel, QObject* parent = nullptr) noexcept;
+    QudevMonitor(QudevBackend& backend, Channel channel, QObject* parent = nullptr) noexcept;
 
     /// Destroys the monitor and releases system resources.
     ~QudevMonitor() override;
@@ -59,7 +64,7 @@ public:
     /**
      * @brief Start monitoring for events.
      *
-     * This will create and configure the underlying libudev monitor and
+     * This will open and configure the backend's event stream and
      * arrange for @ref onReadyRead() to be called when new events arrive.
      *
      * @param filters The @ref QudevFilters to be applied.
@@ -68,6 +73,16 @@ public:
      */
     bool start(const QudevFilters& filters) noexcept;
 
+    /**
+     * @brief Start monitoring, first delivering the events after @p seqnum.
+     *
+     * See @ref QudevBackend::resumeMonitor(); @p complete is @c false if
+     * events after @p seqnum may have been lost.
+     *
+     * @return @c true on success, @c false on failure.
+     */
+    bool resume(const QudevFilters& filters, quint64 seqnum, bool* complete) noexcept;
+
     /**
      * @brief Stop monitoring for events.
      *
@@ -75,23 +90,136 @@ public:
      */
     void stop() noexcept;
 
+    /**
+     * @brief Replace the filters of a running monitor in place.
+     *
+     * The netlink socket stays open, so no events are lost while the
+     * kernel-side filter is swapped. If monitoring is not active, the
+     * filters are only stored.
+     *
+     * @param filters The new @ref QudevFilters to be applied.
+     *
+     * @return @c true on success, @c false if the socket filter could not
+     *         be updated.
+     */
+    bool setFilters(const QudevFilters& filters) noexcept;
+
+    /**
+     * @brief Check whether @p device passes the user-space part of @p filters.
+     *
+     * Applied to every received event after the kernel-side socket filter.
+     *
+     * @return @c true if @p device matches all criteria in @p filters.
+     */
+    static bool applyPostFilters(const QudevDevice& device, const QudevFilters& filters) noexcept;
+
+    /**
+     * @brief Record every received event to @p recorder.
+     *
+     * Events are recorded before post-filtering. The monitor does not
+     * take ownership; pass @c nullptr to stop recording.
+     */
+    void setRecorder(QudevEventRecorder* recorder) noexcept;
+
+    /**
+     * @brief Correlate events with their kernel uevents.
+     *
+     * When enabled, a second, kernel-channel stream is opened next to the
+     * udev one; the time each kernel uevent is seen is matched by seqnum
+     * to fill @ref QudevEventTiming::kernelNs. Costs one extra socket and
+     * receiving every matching event twice.
+     */
+    void setKernelLatencyTracking(bool enabled) noexcept;
+
+    /**
+     * @brief Deliver events by priority lane instead of in arrival order.
+     *
+     * Applies from the next socket read. Events already queued are still
+     * delivered when lanes are disabled; @ref stop() discards them.
+     */
+    void setPriorityLanes(const QudevPriorityLanes& lanes) noexcept;
+
+    /**
+     * @brief Timing of the event being emitted.
+     *
+     * Only meaningful inside slots directly connected to
+     * @ref deviceFound(), and only if the backend has a statistics
+     * collector attached.
+     */
+    const QudevEventTiming& timing() const noexcept { return timing_; }
+
 signals:
     /**
      * @brief Emitted when a device event is received and passes all filters.
      *
-     * @param device A fully populated @ref QudevDevice.
+     * @param device A fully populated, shared @ref QudevDevice.
      */
-    void deviceFound(const QudevDevice& device);
+    void deviceFound(const QudevSharedDevice& device);
 
 private:
-    bool applyPreFilters(const QudevFilters& filters) const noexcept;
-    bool applyPostFilters(const QudevDevice& device, const QudevFilters& filters) const noexcept;
+    bool attach(std::unique_ptr<QudevBackend::MonitorSource> source) noexcept;
     void onReadyRead();
+    void onKernelReadyRead();
+    bool startKernelSource() noexcept;
+    void stopKernelSource() noexcept;
+    void stampTiming(const QudevDevice& device, quint64 receivedNs, bool socketTimestamp,
+                     quint64 deliveredNs, QudevStatsCollector& stats) noexcept;
+
+    // One event off the socket, recorded, counted and filtered.
+    struct Received
+    {
+        QudevDevice device;
+        bool accepted = false;
+        quint64 receivedNs = 0;     // accepted, with stats: socket or dequeue time
+        bool socketTimestamp = false;
+        quint64 filteredNs = 0;     // with stats: when filtering finished
+    };
+    std::optional<Received> receiveOne(QudevStatsCollector* stats);
+
+    // Priority lanes: read the socket into the lanes, deliver from them.
+    void drainIntoLanes();
+    void deliverFromLanes();
+    void enqueue(QudevDevice&& device, quint64 receivedNs, bool socketTimestamp);
+    int nextLane(bool* starved) const noexcept;
 
 private:
-    udev_monitor* monitor_ = nullptr;
-    std::optional<QudevContext> context_;
+    QudevBackend& backend_;
+    std::unique_ptr<QudevBackend::MonitorSource> source_;
     QSocketNotifier* socket_ = nullptr;
     Channel channel_;
     QudevFilters filters_;
+    QudevEventRecorder* recorder_ = nullptr;
+
+    // Kernel latency tracking: when each recent kernel seqnum was seen,
+    // in a direct-mapped table indexed by seqnum.
+    struct KernelSeen
+    {
+        quint64 seqnum = 0;
+        quint64 ns = 0;
+    };
+    bool kernelTracking_ = false;
+    std::unique_ptr<QudevBackend::MonitorSource> kernelSource_;
+    QSocketNotifier* kernelSocket_ = nullptr;
+    std::array<KernelSeen, 1024> kernelSeen_{};
+
+    // An event waiting in a priority lane.
+    struct Queued
+    {
+        QudevDevice device;
+        quint64 queuedNs = 0;
+        quint64 receivedNs = 0;
+        bool socketTimestamp = false;
+    };
+    // Queued events of one device, all in one lane to keep their order.
+    struct Pending
+    {
+        int lane = 0;
+        qsizetype count = 0;
+    };
+    QudevPriorityLanes priority_;
+    std::array<std::deque<Queued>, QudevPriorityLanes::LaneCount> lanes_;
+    QHash<QString, Pending> pending_;
+    qsizetype queued_ = 0;
+
+    QudevEventTiming timing_;
 };
@@ -0,0 +1,318 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include "qudev_monitor_hub.h"
+#include "qudev_backend.h"
+#include "qudev_enumerator.h"
+#include "qudev_monitor.h"
+#include "qudev_trace.h"
+
+#include <qudev_device.h>
+
+#include <QDebug>
+#include <QHash>
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+
+namespace {
+
+struct Subscriber
+{
+    quint64 id = 0;
+    QudevFilters filters;
+    QudevMonitorHub::Handler handler;
+    bool removed = false;
+};
+
+using SubscriberPtr = std::shared_ptr<Subscriber>;
+using Bucket = std::vector<SubscriberPtr>;
+
+void removeFrom(Bucket& bucket, const Subscriber* s)
+{
+    const auto it = std::find_if(bucket.begin(), bucket.end(), [s](const SubscriberPtr& p) { return p.get() == s; });
+    if (it != bucket.end()) {
+        *it = std::move(bucket.back());
+        bucket.pop_back();
+    }
+}
+
+} // namespace
+
+struct QudevMonitorHub::Private
+{
+    QudevMonitorHub* q = nullptr;
+    std::unique_ptr<QudevBackend> backend;
+    std::unique_ptr<QudevMonitor> mon;
+    QudevFilters monitorFilters;
+
+    quint64 nextId = 1;
+    std::unordered_map<quint64, SubscriberPtr> subscribers;
+
+    // Each subscriber is in exactly one of these, so a device never
+    // reaches the same subscriber twice.
+    QHash<QString, Bucket> bySubsystem;
+    QHash<QString, Bucket> byTag;
+    QHash<QString, Bucket> byAction;     // one entry per listed action
+    Bucket unkeyed;
+
+    quint64 dispatched = 0;
+    quint64 delivered = 0;
+
+    void file(const SubscriberPtr& s);
+    void unfile(const Subscriber* s);
+    bool updateMonitor(const QudevFilters* added = nullptr);
+    void dispatch(const QudevSharedDevice& device);
+};
+
+void QudevMonitorHub::Private::file(const SubscriberPtr& s)
+{
+    const QudevFilters& f = s->filters;
+    if (!f.subsystem.isEmpty()) {
+        bySubsystem[f.subsystem].push_back(s);
+    } else if (!f.tags.isEmpty()) {
+        byTag[f.tags.first()].push_back(s);
+    } else if (!f.actions.isEmpty()) {
+        for (const QString& action : f.actions) {
+            Bucket& bucket = byAction[action];
+            if (std::find(bucket.cbegin(), bucket.cend(), s) == bucket.cend()) {
+                bucket.push_back(s);
+            }
+        }
+    } else {
+        unkeyed.push_back(s);
+    }
+}
+
+void QudevMonitorHub::Private::unfile(const Subscriber* s)
+{
+    const auto from = [s](QHash<QString, Bucket>& buckets, const QString& key) {
+        const auto it = buckets.find(key);
+        if (it != buckets.end()) {
+            removeFrom(*it, s);
+            if (it->empty()) {
+                buckets.erase(it);
+            }
+        }
+    };
+
+    const QudevFilters& f = s->filters;
+    if (!f.subsystem.isEmpty()) {
+        from(bySubsystem, f.subsystem);
+    } else if (!f.tags.isEmpty()) {
+        from(byTag, f.tags.first());
+    } else if (!f.actions.isEmpty()) {
+        for (const QString& action : f.actions) {
+            from(byAction, action);
+        }
+    } else {
+        removeFrom(unkeyed, s);
+    }
+}
+
+bool QudevMonitorHub::Private::updateMonitor(const QudevFilters* added)
+{
+    if (subscribers.empty()) {
+        if (mon) {
+            // The last subscriber may leave from a handler, inside the monitor.
+            mon->stop();
+            mon.release()->deleteLater();
+        }
+        monitorFilters = {};
+        return true;
+    }
+
+    // A new subscriber can only take criteria away from the shared ones.
+    QList<QudevFilters> all;
+    if (added && mon) {
+        all << monitorFilters << *added;
+    } else {
+        all.reserve(qsizetype(subscribers.size()));
+        for (const auto& [id, s] : subscribers) {
+            all << s->filters;
+        }
+    }
+    const QudevFilters common = QudevEnumerator::commonFilters(all);
+
+    if (!backend && !(backend = QudevBackend::createLibudev())) {
+        qWarning() << "[QudevMonitorHub] Failed to create libudev backend";
+        return false;
+    }
+
+    if (mon && common == monitorFilters) {
+        return true;
+    }
+    if (mon && mon->setFilters(common)) {
+        monitorFilters = common;
+        return true;
+    }
+
+    if (mon) {
+        qWarning() << "[QudevMonitorHub] Failed to update monitor filters in place, restarting monitor";
+        mon->stop();
+    } else {
+        mon = std::make_unique<QudevMonitor>(*backend, QudevMonitor::Channel::Udev, q);
+        QObject::connect(mon.get(), &QudevMonitor::deviceFound, q,
+                         [this](const QudevSharedDevice& device) { dispatch(device); });
+    }
+    if (!mon->start(common)) {
+        qWarning() << "[QudevMonitorHub] Failed to start monitor";
+        mon.reset();
+        monitorFilters = {};
+        return false;
+    }
+    monitorFilters = common;
+    return true;
+}
+
+void QudevMonitorHub::Private::dispatch(const QudevSharedDevice& device)
+{
+    QUDEV_TRACE_SCOPE_NAMED(span, "qudev", "hub.dispatch");
+    const QudevDevice& d = device.get();
+    ++dispatched;
+
+    // Collected first: handlers may subscribe and unsubscribe.
+    std::vector<SubscriberPtr> matching;
+    const auto collect = [&](const Bucket& bucket) {
+        for (const SubscriberPtr& s : bucket) {
+            if (QudevMonitor::applyPostFilters(d, s->filters)) {
+                matching.push_back(s);
+            }
+        }
+    };
+    const auto collectKey = [&](const QHash<QString, Bucket>& buckets, const QString& key) {
+        const auto it = buckets.constFind(key);
+        if (it != buckets.cend()) {
+            collect(*it);
+        }
+    };
+
+    collectKey(bySubsystem, d.subsystem);
+    if (!byTag.isEmpty()) {
+        for (const QString& tag : d.tags) {
+            collectKey(byTag, tag);
+        }
+    }
+    collectKey(byAction, d.action);
+    collect(unkeyed);
+
+    for (const SubscriberPtr& s : matching) {
+        if (!s->removed) {
+            ++delivered;
+            s->handler(device);
+        }
+    }
+    QUDEV_TRACE_ARG(span, "subscribers", qint64(matching.size()));
+}
+
+QudevMonitorHub::QudevMonitorHub(QObject* parent)
+    : QObject(parent),
+    d_{std::make_unique<Private>()}
+{
+    d_->q = this;
+    QudevSharedDevice::registerMetaType();
+}
+
+QudevMonitorHub::QudevMonitorHub(std::unique_ptr<QudevBackend> backend, QObject* parent)
+    : QudevMonitorHub(parent)
+{
+    d_->backend = std::move(backend);
+}
+
+QudevMonitorHub::~QudevMonitorHub()
+{
+    if (d_->mon) {
+        d_->mon->stop();
+        d_->mon.reset();
+    }
+}
+
+quint64 QudevMonitorHub::subscribe(const QudevFilters& filters, Handler handler)
+{
+    if (!handler) {
+        return 0;
+    }
+
+    auto s = std::make_shared<Subscriber>();
+    s->id = d_->nextId++;
+    s->filters = filters;
+    s->handler = std::move(handler);
+    d_->subscribers.emplace(s->id, s);
+    d_->file(s);
+
+    if (!d_->updateMonitor(&s->filters)) {
+        unsubscribe(s->id);
+        return 0;
+    }
+    return s->id;
+}
+
+quint64 QudevMonitorHub::subscribe(const QudevFilters& filters, QObject* context, Handler handler)
+{
+    const quint64 id = subscribe(filters, std::move(handler));
+    if (id && context) {
+        connect(context, &QObject::destroyed, this, [this, id] { unsubscribe(id); });
+    }
+    return id;
+}
+
+bool QudevMonitorHub::setFilters(quint64 id, const QudevFilters& filters)
+{
+    const auto it = d_->subscribers.find(id);
+    if (it == d_->subscribers.end()) {
+        return false;
+    }
+
+    const SubscriberPtr& s = it->second;
+    d_->unfile(s.get());
+    s->filters = filters;
+    d_->file(s);
+    return d_->updateMonitor();
+}
+
+bool QudevMonitorHub::unsubscribe(quint64 id)
+{
+    const auto it = d_->subscribers.find(id);
+    if (it == d_->subscribers.end()) {
+        return false;
+    }
+
+    // A dispatch in progress may still hold it.
+    it->second->removed = true;
+    d_->unfile(it->second.get());
+    d_->subscribers.erase(it);
+    d_->updateMonitor();
+    return true;
+}
+
+qsizetype QudevMonitorHub::subscriberCount() const noexcept
+{
+    return qsizetype(d_->subscribers.size());
+}
+
+bool QudevMonitorHub::isMonitoring() const noexcept
+{
+    return d_->mon != nullptr;
+}
+
+QudevFilters QudevMonitorHub::monitorFilters() const
+{
+    return d_->monitorFilters;
+}
+
+quint64 QudevMonitorHub::eventsDispatched() const noexcept
+{
+    return d_->dispatched;
+}
+
+quint64 QudevMonitorHub::deliveries() const noexcept
+{
+    return d_->delivered;
+}
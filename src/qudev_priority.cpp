@@ -0,0 +1,51 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include "qudev_priority.h"
+#include "qudev_monitor.h"
+
+#include <qudev_device.h>
+
+#include <algorithm>
+
+
+int QudevPriorityLanes::laneOf(const QudevDevice& device) const noexcept
+{
+    int lane = defaultLane;
+    for (const QudevPriorityRule& rule : rules) {
+        if (QudevMonitor::applyPostFilters(device, rule.filters)) {
+            lane = rule.lane;
+            break;
+        }
+    }
+    return std::clamp(lane, 0, LaneCount - 1);
+}
+
+QudevPriorityLanes QudevPriorityLanes::defaults()
+{
+    QudevPriorityLanes lanes;
+
+    const auto rule = [&lanes](const char* subsystem, QStringList actions, int lane) {
+        QudevPriorityRule r;
+        r.filters.subsystem = QString::fromLatin1(subsystem);
+        r.filters.actions = std::move(actions);
+        r.lane = lane;
+        lanes.rules << r;
+    };
+
+    const QStringList hotplug{ QStringLiteral("add"), QStringLiteral("remove") };
+    const QStringList change{ QStringLiteral("change") };
+    rule("block", hotplug, 0);
+    rule("usb", hotplug, 0);
+    rule("power_supply", change, 2);
+    rule("thermal", change, 2);
+    rule("net", change, 2);
+
+    lanes.defaultLane = 1;
+    return lanes;
+}
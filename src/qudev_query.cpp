@@ -0,0 +1,661 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include "qudev_query.h"
+#include "qudev_text_match.h"
+#include "qudev_trace.h"
+
+#include <qudev_device.h>
+
+#include <QStringList>
+
+#include <vector>
+
+
+namespace {
+
+enum class Kind : quint8 { Term, And, Or, Not };
+enum class Field : quint8 { Subsystem, Devtype, Sysname, Devnode, Syspath, Driver, Action, Tag, Property, Sysattr };
+enum class Op : quint8 { Equal, NotEqual, NotEmpty };
+
+struct Node
+{
+    Kind kind = Kind::Term;
+    // And/Or: children [first, first + count) of Private::children; Not: child node first.
+    qint32 first = -1;
+    qint32 count = 0;
+
+    Field field = Field::Property;
+    Op op = Op::NotEmpty;
+    bool glob = false;
+    QString name;    // property or sysattr
+    QString value;
+};
+
+struct Keyword
+{
+    const char* name;
+    Field field;
+};
+
+constexpr Keyword Keywords[] = {
+    { "subsystem", Field::Subsystem }, { "devtype", Field::Devtype }, { "sysname", Field::Sysname },
+    { "devnode", Field::Devnode }, { "syspath", Field::Syspath }, { "driver", Field::Driver },
+    { "action", Field::Action }, { "tag", Field::Tag },
+};
+
+/// Whether fnmatch() would treat @p s as more than a literal, escapes included.
+bool isGlob(QStringView s) noexcept
+{
+    return s.contains(QLatin1Char('*')) || s.contains(QLatin1Char('?')) || s.contains(QLatin1Char('['))
+           || s.contains(QLatin1Char('\\'));
+}
+
+QString quoted(const QString& value)
+{
+    QString out = value;
+    out.replace(QLatin1Char('\\'), QLatin1String("\\\\"));
+    out.replace(QLatin1Char('"'), QLatin1String("\\\""));
+    return QStringLiteral("\"") + out + QLatin1Char('"');
+}
+
+} // namespace
+
+struct QudevQuery::Private
+{
+    QString text;
+    QString error;
+    qsizetype errorPosition = -1;
+
+    std::vector<Node> nodes;
+    std::vector<qint32> children;
+    qint32 root = -1;        // -1: matches everything
+    qint32 residual = -1;    // the part not covered by filters
+    QudevFilters filters;
+
+    bool eval(qint32 i, const QudevDevice& d) const noexcept;
+    bool term(const Node& n, const QudevDevice& d) const noexcept;
+    QString print(qint32 i) const;
+
+    qint32 add(Node node);
+    qint32 addList(Kind kind, const std::vector<qint32>& items);
+    void pushDown();
+};
+
+qint32 QudevQuery::Private::add(Node node)
+{
+    nodes.push_back(std::move(node));
+    return qint32(nodes.size() - 1);
+}
+
+qint32 QudevQuery::Private::addList(Kind kind, const std::vector<qint32>& items)
+{
+    if (items.size() == 1) {
+        return items.front();
+    }
+    Node n;
+    n.kind = kind;
+    n.first = qint32(children.size());
+    n.count = qint32(items.size());
+    children.insert(children.end(), items.cbegin(), items.cend());
+    return add(std::move(n));
+}
+
+bool QudevQuery::Private::term(const Node& n, const QudevDevice& d) const noexcept
+{
+    const auto compare = [&n](QStringView v) {
+        return n.glob ? qudevGlobMatch(n.value, v) : v == n.value;
+    };
+    const auto lookup = [](const QMap<QString, QString>& map, const QString& key) {
+        const auto it = map.constFind(key);
+        return it != map.cend() ? QStringView(*it) : QStringView();
+    };
+
+    if (n.field == Field::Tag) {
+        bool any = false;
+        for (const QString& tag : d.tags) {
+            if ((any = compare(tag))) {
+                break;
+            }
+        }
+        return any == (n.op == Op::Equal);
+    }
+
+    if (n.field == Field::Devtype) {
+        // As the devtype filter: the field or the DEVTYPE property.
+        const QStringView property = lookup(d.properties, QStringLiteral("DEVTYPE"));
+        if (n.op == Op::NotEmpty) {
+            return !d.devtype.isEmpty() || !property.isEmpty();
+        }
+        return (compare(d.devtype) || compare(property)) == (n.op == Op::Equal);
+    }
+
+    QStringView v;
+    switch (n.field) {
+    case Field::Subsystem: v = d.subsystem; break;
+    case Field::Sysname:   v = d.sysname; break;
+    case Field::Devnode:   v = d.devnode; break;
+    case Field::Syspath:   v = d.syspath; break;
+    case Field::Driver:    v = d.driver; break;
+    case Field::Action:    v = d.action; break;
+    case Field::Property:  v = lookup(d.properties, n.name); break;
+    case Field::Sysattr:   v = lookup(d.sysattrs, n.name); break;
+    case Field::Devtype:
+    case Field::Tag:
+        break;
+    }
+
+    switch (n.op) {
+    case Op::NotEmpty: return !v.isEmpty();
+    case Op::Equal:    return compare(v);
+    case Op::NotEqual: return !compare(v);
+    }
+    return false;
+}
+
+bool QudevQuery::Private::eval(qint32 i, const QudevDevice& d) const noexcept
+{
+    const Node& n = nodes[size_t(i)];
+    switch (n.kind) {
+    case Kind::Term:
+        return term(n, d);
+    case Kind::Not:
+        return !eval(n.first, d);
+    case Kind::And:
+        for (qint32 c = n.first; c < n.first + n.count; ++c) {
+            if (!eval(children[size_t(c)], d)) {
+                return false;
+            }
+        }
+        return true;
+    case Kind::Or:
+        for (qint32 c = n.first; c < n.first + n.count; ++c) {
+            if (eval(children[size_t(c)], d)) {
+                return true;
+            }
+        }
+        return false;
+    }
+    return false;
+}
+
+QString QudevQuery::Private::print(qint32 i) const
+{
+    const Node& n = nodes[size_t(i)];
+    if (n.kind == Kind::Not) {
+        return QStringLiteral("!") + print(n.first);
+    }
+    if (n.kind != Kind::Term) {
+        QStringList parts;
+        for (qint32 c = n.first; c < n.first + n.count; ++c) {
+            parts << print(children[size_t(c)]);
+        }
+        return QStringLiteral("(") + parts.join(n.kind == Kind::And ? QLatin1String(" && ") : QLatin1String(" || "))
+               + QLatin1Char(')');
+    }
+
+    QString field = n.name;
+    if (n.field == Field::Sysattr) {
+        field = QStringLiteral("attr:") + n.name;
+    } else if (n.field != Field::Property) {
+        for (const Keyword& k : Keywords) {
+            if (k.field == n.field) {
+                field = QLatin1String(k.name);
+            }
+        }
+    }
+
+    const QString value = n.glob ? n.value : quoted(n.value);
+    switch (n.op) {
+    case Op::NotEmpty: return field;
+    case Op::Equal:    return n.field == Field::Tag ? QStringLiteral("tag:") + value : field + QLatin1String("==") + value;
+    case Op::NotEqual: return field + QLatin1String("!=") + value;
+    }
+    return QString();
+}
+
+void QudevQuery::Private::pushDown()
+{
+    if (root < 0) {
+        return;
+    }
+
+    std::vector<qint32> conjuncts;
+    const Node& top = nodes[size_t(root)];
+    if (top.kind == Kind::And) {
+        conjuncts.assign(children.cbegin() + top.first, children.cbegin() + top.first + top.count);
+    } else {
+        conjuncts.push_back(root);
+    }
+
+    const auto setOnce = [](QString& slot, const QString& value) {
+        if (!slot.isEmpty()) {
+            return false;
+        }
+        slot = value;
+        return true;
+    };
+
+    // libudev fnmatch()es pushed values, so literals that look like globs
+    // stay in the residual. It also ORs property matches, and devtype is
+    // pushed as a DEVTYPE property: at most one of those goes down.
+    bool propertyPushed = false;
+
+    std::vector<qint32> rest;
+    for (const qint32 c : conjuncts)
+    {
+        const Node& n = nodes[size_t(c)];
+        bool covered = false;
+
+        if (n.kind == Kind::Term && n.op == Op::Equal && !n.value.isEmpty() && !isGlob(n.value)) {
+            switch (n.field) {
+            case Field::Subsystem: covered = setOnce(filters.subsystem, n.value); break;
+            case Field::Devtype:
+                if (!propertyPushed) {
+                    covered = propertyPushed = setOnce(filters.devtype, n.value);
+                }
+                break;
+            case Field::Sysname:   covered = setOnce(filters.sysname, n.value); break;
+            case Field::Devnode:   covered = setOnce(filters.devnode, n.value); break;
+            case Field::Syspath:
+                // Narrows the scan; the exact comparison stays.
+                setOnce(filters.syspathPrefix, n.value);
+                break;
+            case Field::Action:
+                if (filters.actions.isEmpty()) {
+                    filters.actions << n.value;
+                    covered = true;
+                }
+                break;
+            case Field::Tag:
+                if (!filters.tags.contains(n.value)) {
+                    filters.tags << n.value;
+                }
+                covered = true;
+                break;
+            case Field::Property:
+                if (!propertyPushed) {
+                    filters.properties.insert(n.name, n.value);
+                    covered = propertyPushed = true;
+                }
+                break;
+            case Field::Sysattr:
+                if (!filters.sysattrs.contains(n.name)) {
+                    filters.sysattrs.insert(n.name, n.value);
+                    covered = true;
+                }
+                break;
+            case Field::Driver:
+                break;
+            }
+        } else if (n.kind == Kind::Term && n.op == Op::Equal && n.field == Field::Syspath && n.glob
+                   && n.value.endsWith(QLatin1Char('*')) && n.value.size() > 1
+                   && !isGlob(QStringView(n.value).chopped(1))) {
+            covered = setOnce(filters.syspathPrefix, n.value.chopped(1));
+        } else if (n.kind == Kind::Term && n.op == Op::NotEqual && n.field == Field::Sysattr
+                   && !isGlob(n.value) && !n.value.isEmpty() && !filters.nomatchSysattrs.contains(n.name)) {
+            filters.nomatchSysattrs.insert(n.name, n.value);
+            covered = true;
+        } else if (n.kind == Kind::Or && filters.actions.isEmpty()) {
+            // action==add || action==remove
+            QStringList actions;
+            for (qint32 i = n.first; i < n.first + n.count; ++i) {
+                const Node& a = nodes[size_t(children[size_t(i)])];
+                if (a.kind != Kind::Term || a.field != Field::Action || a.op != Op::Equal || a.glob
+                    || a.value.isEmpty()) {
+                    actions.clear();
+                    break;
+                }
+                actions << a.value;
+            }
+            if (!actions.isEmpty()) {
+                filters.actions = actions;
+                covered = true;
+            }
+        }
+
+        if (!covered) {
+            rest.push_back(c);
+        }
+    }
+
+    residual = rest.empty() ? -1 : addList(Kind::And, rest);
+}
+
+namespace {
+
+enum class Tok { End, Word, String, LParen, RParen, And, Or, Not, Equal, NotEqual };
+
+struct Token
+{
+    Tok type = Tok::End;
+    QString text;
+    qsizetype pos = 0;
+};
+
+/// Recursive descent over the query text, building nodes into a Private.
+class Parser
+{
+public:
+    /// Deeper nesting of '!' and '(' is a parse error rather than a stack overflow.
+    static constexpr int MaxDepth = 64;
+
+    Parser(const QString& text, QString* error, qsizetype* errorPosition)
+        : text_(text), error_(error), errorPosition_(errorPosition)
+    {}
+
+    template<typename Build>
+    qint32 parse(Build& build)
+    {
+        next();
+        if (tok_.type == Tok::End) {
+            return -1;
+        }
+        const qint32 root = parseOr(build);
+        if (root >= 0 && tok_.type != Tok::End) {
+            fail(QStringLiteral("Unexpected '%1'").arg(tok_.text));
+        }
+        return failed() ? -1 : root;
+    }
+
+    bool failed() const { return !error_->isEmpty(); }
+
+private:
+    static bool isWordChar(QChar c)
+    {
+        return !c.isSpace() && c != QLatin1Char('(') && c != QLatin1Char(')') && c != QLatin1Char('!')
+               && c != QLatin1Char('&') && c != QLatin1Char('|') && c != QLatin1Char('=')
+               && c != QLatin1Char('"');
+    }
+
+    void fail(const QString& message)
+    {
+        if (!failed()) {
+            *error_ = message;
+            *errorPosition_ = tok_.pos;
+        }
+    }
+
+    void next()
+    {
+        qsizetype i = pos_;
+        while (i < text_.size() && text_[i].isSpace()) {
+            ++i;
+        }
+        tok_ = Token{ Tok::End, QString(), i };
+        if (i >= text_.size()) {
+            pos_ = i;
+            return;
+        }
+
+        const QChar c = text_[i];
+        const QChar n = i + 1 < text_.size() ? text_[i + 1] : QChar();
+        const auto two = [&](Tok type) {
+            tok_.type = type;
+            tok_.text = text_.mid(i, 2);
+            pos_ = i + 2;
+        };
+
+        if (c == QLatin1Char('&') && n == QLatin1Char('&')) {
+            two(Tok::And);
+        } else if (c == QLatin1Char('|') && n == QLatin1Char('|')) {
+            two(Tok::Or);
+        } else if (c == QLatin1Char('=') && n == QLatin1Char('=')) {
+            two(Tok::Equal);
+        } else if (c == QLatin1Char('!') && n == QLatin1Char('=')) {
+            two(Tok::NotEqual);
+        } else if (c == QLatin1Char('!') || c == QLatin1Char('(') || c == QLatin1Char(')')) {
+            tok_.type = c == QLatin1Char('!') ? Tok::Not : c == QLatin1Char('(') ? Tok::LParen : Tok::RParen;
+            tok_.text = c;
+            pos_ = i + 1;
+        } else if (c == QLatin1Char('"')) {
+            tok_.type = Tok::String;
+            for (++i; i < text_.size() && text_[i] != QLatin1Char('"'); ++i) {
+                if (text_[i] == QLatin1Char('\\') && i + 1 < text_.size()) {
+                    ++i;
+                }
+                tok_.text += text_[i];
+            }
+            if (i >= text_.size()) {
+                fail(QStringLiteral("Unterminated string"));
+            }
+            pos_ = i + 1;
+        } else if (isWordChar(c)) {
+            qsizetype end = i;
+            while (end < text_.size() && isWordChar(text_[end])) {
+                ++end;
+            }
+            tok_.type = Tok::Word;
+            tok_.text = text_.mid(i, end - i);
+            pos_ = end;
+        } else {
+            tok_.text = c;
+            fail(QStringLiteral("Unexpected '%1'").arg(c));
+            tok_.type = Tok::End;
+            pos_ = text_.size();
+        }
+    }
+
+    template<typename Build>
+    qint32 parseOr(Build& build)
+    {
+        std::vector<qint32> items{ parseAnd(build) };
+        while (!failed() && tok_.type == Tok::Or) {
+            next();
+            items.push_back(parseAnd(build));
+        }
+        return failed() ? -1 : build.addList(Kind::Or, items);
+    }
+
+    template<typename Build>
+    qint32 parseAnd(Build& build)
+    {
+        std::vector<qint32> items{ parseUnary(build) };
+        while (!failed() && tok_.type == Tok::And) {
+            next();
+            items.push_back(parseUnary(build));
+        }
+        return failed() ? -1 : build.addList(Kind::And, items);
+    }
+
+    template<typename Build>
+    qint32 parseUnary(Build& build)
+    {
+        if (failed()) {
+            return -1;
+        }
+        if ((tok_.type == Tok::Not || tok_.type == Tok::LParen) && depth_ == MaxDepth) {
+            fail(QStringLiteral("Nested too deeply"));
+            return -1;
+        }
+        if (tok_.type == Tok::Not) {
+            next();
+            Node n;
+            n.kind = Kind::Not;
+            ++depth_;
+            n.first = parseUnary(build);
+            --depth_;
+            return failed() ? -1 : build.add(std::move(n));
+        }
+        if (tok_.type == Tok::LParen) {
+            next();
+            ++depth_;
+            const qint32 inner = parseOr(build);
+            --depth_;
+            if (!failed() && tok_.type != Tok::RParen) {
+                fail(QStringLiteral("Expected ')'"));
+            }
+            next();
+            return failed() ? -1 : inner;
+        }
+        return parseTerm(build);
+    }
+
+    template<typename Build>
+    qint32 parseTerm(Build& build)
+    {
+        if (tok_.type != Tok::Word) {
+            fail(tok_.type == Tok::End ? QStringLiteral("Expected a term") : QStringLiteral("Expected a field"));
+            return -1;
+        }
+
+        Node n;
+        const QString word = tok_.text;
+        next();
+
+        if (word.startsWith(QLatin1String("tag:"))) {
+            n.field = Field::Tag;
+            n.op = Op::Equal;
+            n.value = word.mid(4);
+            n.glob = isGlob(n.value);
+            if (n.value.isEmpty() && tok_.type == Tok::String) {
+                n.value = tok_.text;
+                next();
+            }
+            if (n.value.isEmpty()) {
+                fail(QStringLiteral("Expected a tag after 'tag:'"));
+                return -1;
+            }
+            return build.add(std::move(n));
+        }
+
+        if (word.startsWith(QLatin1String("attr:"))) {
+            n.field = Field::Sysattr;
+            n.name = word.mid(5);
+        } else {
+            n.field = Field::Property;
+            n.name = word;
+            for (const Keyword& k : Keywords) {
+                if (word == QLatin1String(k.name)) {
+                    n.field = k.field;
+                    n.name.clear();
+                    break;
+                }
+            }
+        }
+        if (n.field == Field::Sysattr && n.name.isEmpty()) {
+            fail(QStringLiteral("Expected an attribute name after 'attr:'"));
+            return -1;
+        }
+
+        if (tok_.type != Tok::Equal && tok_.type != Tok::NotEqual) {
+            if (n.field == Field::Tag) {
+                fail(QStringLiteral("Expected '==' or '!=' after 'tag'"));
+                return -1;
+            }
+            n.op = Op::NotEmpty;
+            return build.add(std::move(n));
+        }
+
+        n.op = tok_.type == Tok::Equal ? Op::Equal : Op::NotEqual;
+        next();
+        if (tok_.type != Tok::Word && tok_.type != Tok::String) {
+            fail(QStringLiteral("Expected a value"));
+            return -1;
+        }
+        n.value = tok_.text;
+        n.glob = tok_.type == Tok::Word && isGlob(n.value);
+        next();
+        return build.add(std::move(n));
+    }
+
+    const QString& text_;
+    QString* error_;
+    qsizetype* errorPosition_;
+    qsizetype pos_ = 0;
+    int depth_ = 0;
+    Token tok_;
+};
+
+} // namespace
+
+QudevQuery::QudevQuery()
+    : d_{std::make_shared<Private>()}
+{
+}
+
+QudevQuery::QudevQuery(const QString& text)
+{
+    QUDEV_TRACE_SCOPE("qudev", "query.parse");
+
+    auto d = std::make_shared<Private>();
+    d->text = text;
+
+    Parser parser(d->text, &d->error, &d->errorPosition);
+    d->root = parser.parse(*d);
+    if (parser.failed()) {
+        d->nodes.clear();
+        d->children.clear();
+        d->root = -1;
+    } else {
+        d->pushDown();
+    }
+    d_ = std::move(d);
+}
+
+QudevQuery::~QudevQuery() = default;
+
+QudevQuery::QudevQuery(const QudevQuery& other) = default;
+
+QudevQuery& QudevQuery::operator=(const QudevQuery& other) = default;
+
+bool QudevQuery::isValid() const noexcept
+{
+    return d_->error.isEmpty();
+}
+
+QString QudevQuery::errorString() const
+{
+    return d_->error;
+}
+
+qsizetype QudevQuery::errorPosition() const noexcept
+{
+    return d_->errorPosition;
+}
+
+QString QudevQuery::text() const
+{
+    return d_->text;
+}
+
+bool QudevQuery::isEmpty() const noexcept
+{
+    return d_->root < 0;
+}
+
+QString QudevQuery::toString() const
+{
+    return d_->root >= 0 ? d_->print(d_->root) : QString();
+}
+
+const QudevFilters& QudevQuery::filters() const noexcept
+{
+    return d_->filters;
+}
+
+bool QudevQuery::matches(const QudevDevice& device) const noexcept
+{
+    if (!isValid()) {
+        return false;
+    }
+    return d_->root < 0 || d_->eval(d_->root, device);
+}
+
+bool QudevQuery::matchesResidual(const QudevDevice& device) const noexcept
+{
+    if (!isValid()) {
+        return false;
+    }
+    return d_->residual < 0 || d_->eval(d_->residual, device);
+}
+
+bool QudevQuery::hasResidual() const noexcept
+{
+    return d_->residual >= 0;
+}
@@ -0,0 +1,285 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include "qudev_replay_backend.h"
+#include "qudev_event_recorder.h"
+#include "qudev_event_codec.h"
+#include "qudev_stats_collector.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QtEndian>
+
+#include <atomic>
+#include <vector>
+
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+
+struct QudevReplayBackend::Private
+{
+    struct Entry
+    {
+        quint64 timestampNs;
+        qsizetype offset;   // payload offset in data
+        qsizetype size;
+    };
+
+    QByteArray data;
+    std::vector<Entry> entries;
+    QString error;
+    double speed = 1.0;
+    std::atomic<quint64> replayed{0};
+
+    bool load(const QString& path);
+};
+
+namespace {
+
+quint64 monotonicNs() noexcept
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return quint64(ts.tv_sec) * 1000000000ull + quint64(ts.tv_nsec);
+}
+
+/// Replays the backend's entries, paced by a timerfd.
+class ReplayMonitorSource final : public QudevBackend::MonitorSource
+{
+public:
+    ReplayMonitorSource(const QudevBackend& owner, QudevReplayBackend::Private& backend,
+                        int timerFd) noexcept
+        : owner_(owner),
+        backend_(backend),
+        timerFd_(timerFd),
+        speed_(backend.speed),
+        startNs_(monotonicNs())
+    {
+        armAt(startNs_);
+    }
+
+    ~ReplayMonitorSource() override
+    {
+        ::close(timerFd_);
+    }
+
+    int fd() const noexcept override
+    {
+        return timerFd_;
+    }
+
+    std::optional<QudevDevice> receive() noexcept override
+    {
+        const auto& entries = backend_.entries;
+
+        if (next_ >= entries.size()) {
+            disarm();
+            return std::nullopt;
+        }
+
+        // Yield to the event loop now and then, even when events are due.
+        if (burst_ == MaxBurst) {
+            armAt(monotonicNs());
+            return std::nullopt;
+        }
+
+        const auto& entry = entries[next_];
+        if (speed_ > 0) {
+            const quint64 offset = entry.timestampNs - entries.front().timestampNs;
+            const quint64 dueNs = startNs_ + quint64(double(offset) / speed_);
+            if (dueNs > monotonicNs()) {
+                armAt(dueNs);
+                return std::nullopt;
+            }
+        }
+
+        ++next_;
+        ++burst_;
+        backend_.replayed.fetch_add(1, std::memory_order_relaxed);
+
+        // Reading the log is free; decoding is the replay's build stage.
+        QudevStatsCollector* stats = owner_.stats();
+        const quint64 t0 = stats ? QudevStatsCollector::nowNs() : 0;
+        QudevDevice device = qudevDecodeEvent(backend_.data.constData() + entry.offset, entry.size);
+        if (stats) {
+            stats->build.record(QudevStatsCollector::nowNs() - t0);
+        }
+        return device;
+    }
+
+    bool setFilters(const QudevFilters&) noexcept override
+    {
+        // The monitor's post-filter sees every replayed event anyway.
+        return true;
+    }
+
+private:
+    static constexpr int MaxBurst = 256;
+
+    void clear() noexcept
+    {
+        quint64 expirations;
+        while (::read(timerFd_, &expirations, sizeof(expirations)) < 0 && errno == EINTR) {
+        }
+        burst_ = 0;
+    }
+
+    void armAt(quint64 ns) noexcept
+    {
+        clear();
+
+        // An absolute time in the past expires immediately; zero would disarm.
+        itimerspec spec{};
+        spec.it_value.tv_sec  = time_t(ns / 1000000000ull);
+        spec.it_value.tv_nsec = long(ns % 1000000000ull);
+        if (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0) {
+            spec.it_value.tv_nsec = 1;
+        }
+        timerfd_settime(timerFd_, TFD_TIMER_ABSTIME, &spec, nullptr);
+    }
+
+    void disarm() noexcept
+    {
+        clear();
+
+        const itimerspec spec{};
+        timerfd_settime(timerFd_, 0, &spec, nullptr);
+    }
+
+    const QudevBackend& owner_;
+    QudevReplayBackend::Private& backend_;
+    int timerFd_;
+    double speed_;
+    quint64 startNs_;
+    size_t next_ = 0;
+    int burst_ = 0;
+};
+
+} // namespace
+
+bool QudevReplayBackend::Private::load(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        error = file.errorString();
+        return false;
+    }
+
+    data = file.readAll();
+
+    if (data.size() < QudevEventLog::HeaderSize ||
+        memcmp(data.constData(), QudevEventLog::Magic, sizeof(QudevEventLog::Magic)) != 0) {
+        error = QStringLiteral("Not a qudev event log");
+        return false;
+    }
+
+    const quint16 version = qFromLittleEndian<quint16>(data.constData() + 8);
+    if (version != QudevEventRecorder::FormatVersion) {
+        error = QStringLiteral("Unsupported event log version %1").arg(version);
+        return false;
+    }
+
+    const char* base = data.constData();
+    qsizetype pos = QudevEventLog::HeaderSize;
+    while (pos + QudevEventLog::RecordHeaderSize <= data.size())
+    {
+        const quint32 size = qFromLittleEndian<quint32>(base + pos);
+        const quint64 timestamp = qFromLittleEndian<quint64>(base + pos + 12);
+        const qsizetype payload = pos + QudevEventLog::RecordHeaderSize;
+
+        if (payload + qsizetype(size) > data.size()) {
+            break;
+        }
+
+        entries.push_back({ timestamp, payload, qsizetype(size) });
+        pos = payload + size;
+    }
+
+    if (pos != data.size()) {
+        // A recorder that was killed may leave a partial last record.
+        qWarning() << "[QudevReplayBackend] Ignoring truncated record at offset" << pos << "of" << path;
+    }
+
+    return true;
+}
+
+QudevReplayBackend::QudevReplayBackend(const QString& path, double speed)
+    : d_{std::make_unique<Private>()}
+{
+    d_->speed = speed;
+    if (!d_->load(path)) {
+        qWarning() << "[QudevReplayBackend] Failed to load" << path << ":" << d_->error;
+        d_->data.clear();
+        d_->entries.clear();
+    }
+}
+
+QudevReplayBackend::~QudevReplayBackend() = default;
+
+bool QudevReplayBackend::isValid() const noexcept
+{
+    return d_->error.isEmpty();
+}
+
+QString QudevReplayBackend::errorString() const
+{
+    return d_->error;
+}
+
+qsizetype QudevReplayBackend::eventCount() const noexcept
+{
+    return qsizetype(d_->entries.size());
+}
+
+quint64 QudevReplayBackend::durationNs() const noexcept
+{
+    if (d_->entries.empty()) {
+        return 0;
+    }
+    return d_->entries.back().timestampNs - d_->entries.front().timestampNs;
+}
+
+double QudevReplayBackend::speed() const noexcept
+{
+    return d_->speed;
+}
+
+void QudevReplayBackend::setSpeed(double speed) noexcept
+{
+    d_->speed = speed;
+}
+
+quint64 QudevReplayBackend::eventsReplayed() const noexcept
+{
+    return d_->replayed.load(std::memory_order_relaxed);
+}
+
+bool QudevReplayBackend::enumerate(const QudevFilters&, const Visitor&) noexcept
+{
+    return isValid();
+}
+
+std::unique_ptr<QudevBackend::MonitorSource>
+QudevReplayBackend::createMonitor(MonitorChannel, const QudevFilters&) noexcept
+{
+    if (!isValid()) {
+        return nullptr;
+    }
+
+    const int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd < 0) {
+        qWarning() << "[QudevReplayBackend] timerfd_create() failed:" << strerror(errno);
+        return nullptr;
+    }
+
+    return std::make_unique<ReplayMonitorSource>(*this, *d_, fd);
+}
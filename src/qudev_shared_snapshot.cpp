@@ -0,0 +1,416 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include "qudev_shared_snapshot.h"
+#include "qudev_broker_protocol.h"
+#include "qudev_trace.h"
+
+#include <QDebug>
+#include <QtEndian>
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+
+namespace Proto = QudevBrokerProtocol;
+
+#ifndef F_SEAL_FUTURE_WRITE
+#define F_SEAL_FUTURE_WRITE 0x0010
+#endif
+
+namespace {
+
+constexpr char Magic[8] = { 'Q', 'U', 'D', 'E', 'V', 'S', 'H', 'M' };
+constexpr quint32 LayoutVersion = 1;
+constexpr int SlotCount = 2;
+constexpr qsizetype CacheLine = 64;
+constexpr int BrokerTimeoutSec = 10;
+
+static_assert(std::atomic<quint64>::is_always_lock_free,
+              "seqlock counters are shared between processes and must be lock-free");
+
+struct RegionHeader
+{
+    char magic[8];
+    quint32 version;
+    quint32 slotCount;
+    quint64 slotCapacity;
+    quint64 slotOffset[SlotCount];
+    alignas(CacheLine) std::atomic<quint64> generation;
+};
+
+struct alignas(CacheLine) SlotHeader
+{
+    std::atomic<quint64> sequence;
+    std::atomic<quint64> size;
+    std::atomic<quint64> generation;
+};
+
+static_assert(std::is_standard_layout_v<RegionHeader> && std::is_standard_layout_v<SlotHeader>);
+static_assert(sizeof(SlotHeader) == CacheLine);
+
+qsizetype pageAlign(qsizetype n)
+{
+    const qsizetype page = qsizetype(::sysconf(_SC_PAGESIZE));
+    return (n + page - 1) / page * page;
+}
+
+QString systemError(const char* what)
+{
+    return QStringLiteral("%1: %2").arg(QLatin1String(what), QString::fromLocal8Bit(strerror(errno)));
+}
+
+} // namespace
+
+struct QudevSharedSnapshotWriter::Private
+{
+    int fd = -1;
+    int readFd = -1;    // handed to readers; fd itself once write-sealed
+    char* base = nullptr;
+    qsizetype size = 0;
+    qsizetype capacity = 0;
+    QString error;
+
+    RegionHeader* header() const { return reinterpret_cast<RegionHeader*>(base); }
+    SlotHeader* slot(int i) const { return reinterpret_cast<SlotHeader*>(base + header()->slotOffset[i]); }
+};
+
+QudevSharedSnapshotWriter::QudevSharedSnapshotWriter(qsizetype slotCapacity)
+    : d_{std::make_unique<Private>()}
+{
+    d_->capacity = slotCapacity;
+    const qsizetype headerSize = pageAlign(sizeof(RegionHeader));
+    const qsizetype slotSize = pageAlign(sizeof(SlotHeader) + slotCapacity);
+    d_->size = headerSize + SlotCount * slotSize;
+
+    d_->fd = ::memfd_create("qudev-snapshot", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (d_->fd < 0) {
+        d_->error = systemError("memfd_create");
+        return;
+    }
+
+    if (::ftruncate(d_->fd, off_t(d_->size)) < 0) {
+        d_->error = systemError("Cannot size memfd");
+        ::close(d_->fd);
+        d_->fd = -1;
+        return;
+    }
+
+    void* map = ::mmap(nullptr, size_t(d_->size), PROT_READ | PROT_WRITE, MAP_SHARED, d_->fd, 0);
+    if (map == MAP_FAILED) {
+        d_->error = systemError("mmap");
+        ::close(d_->fd);
+        d_->fd = -1;
+        return;
+    }
+
+    // Fixed size, so a reader's mapping can never be cut short, and no
+    // writable mapping or write() beyond the one just made. Kernels before
+    // 5.1 lack the future-write seal; readers then get a read-only reopen.
+    constexpr int Sizing = F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL;
+    if (::fcntl(d_->fd, F_ADD_SEALS, Sizing | F_SEAL_FUTURE_WRITE) == 0) {
+        d_->readFd = d_->fd;
+    } else if (::fcntl(d_->fd, F_ADD_SEALS, Sizing) == 0) {
+        // Also keep other users from reopening it writable through /proc.
+        const QByteArray proc = "/proc/self/fd/" + QByteArray::number(d_->fd);
+        d_->readFd = ::open(proc.constData(), O_RDONLY | O_CLOEXEC);
+        ::fchmod(d_->fd, S_IRUSR);
+    }
+    if (d_->readFd < 0) {
+        d_->error = systemError("Cannot seal memfd against readers writing");
+        ::munmap(map, size_t(d_->size));
+        ::close(d_->fd);
+        d_->fd = -1;
+        return;
+    }
+    d_->base = static_cast<char*>(map);
+
+    // The memfd starts zeroed: generation and sequences are 0.
+    RegionHeader* h = new (d_->base) RegionHeader;
+    std::memcpy(h->magic, Magic, sizeof(Magic));
+    h->version = LayoutVersion;
+    h->slotCount = SlotCount;
+    h->slotCapacity = quint64(slotCapacity);
+    for (int i = 0; i < SlotCount; ++i) {
+        h->slotOffset[i] = quint64(headerSize + i * slotSize);
+        new (d_->base + h->slotOffset[i]) SlotHeader;
+    }
+    h->generation.store(0, std::memory_order_release);
+}
+
+QudevSharedSnapshotWriter::~QudevSharedSnapshotWriter()
+{
+    if (d_->base) {
+        ::munmap(d_->base, size_t(d_->size));
+    }
+    if (d_->readFd >= 0 && d_->readFd != d_->fd) {
+        ::close(d_->readFd);
+    }
+    if (d_->fd >= 0) {
+        ::close(d_->fd);
+    }
+}
+
+bool QudevSharedSnapshotWriter::isValid() const noexcept
+{
+    return d_->base != nullptr;
+}
+
+QString QudevSharedSnapshotWriter::errorString() const
+{
+    return d_->error;
+}
+
+int QudevSharedSnapshotWriter::fd() const noexcept
+{
+    return d_->readFd;
+}
+
+qsizetype QudevSharedSnapshotWriter::slotCapacity() const noexcept
+{
+    return d_->capacity;
+}
+
+quint64 QudevSharedSnapshotWriter::generation() const noexcept
+{
+    return d_->base ? d_->header()->generation.load(std::memory_order_relaxed) : 0;
+}
+
+bool QudevSharedSnapshotWriter::publish(const QByteArray& snapshot)
+{
+    QUDEV_TRACE_SCOPE("qudev", "publishSharedSnapshot");
+
+    if (!d_->base) {
+        return false;
+    }
+    if (snapshot.size() > d_->capacity) {
+        d_->error = QStringLiteral("Snapshot of %1 bytes exceeds the slot capacity of %2")
+                        .arg(snapshot.size()).arg(d_->capacity);
+        return false;
+    }
+
+    RegionHeader* h = d_->header();
+    const quint64 next = h->generation.load(std::memory_order_relaxed) + 1;
+    const int index = int(next % SlotCount);
+    SlotHeader* s = d_->slot(index);
+    char* data = reinterpret_cast<char*>(s) + sizeof(SlotHeader);
+
+    // Odd while filling: readers still in this slot see the change.
+    const quint64 sequence = s->sequence.load(std::memory_order_relaxed);
+    s->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    std::memcpy(data, snapshot.constData(), size_t(snapshot.size()));
+    s->size.store(quint64(snapshot.size()), std::memory_order_relaxed);
+    s->generation.store(next, std::memory_order_relaxed);
+
+    s->sequence.store(sequence + 2, std::memory_order_release);
+    h->generation.store(next, std::memory_order_release);
+    return true;
+}
+
+struct QudevSharedSnapshotReader::Private
+{
+    const char* base = nullptr;
+    qsizetype size = 0;
+    qsizetype capacity = 0;
+    QString error;
+
+    // Resolved once from the validated header.
+    const SlotHeader* slots[SlotCount] = {};
+
+    const RegionHeader* header() const { return reinterpret_cast<const RegionHeader*>(base); }
+    const SlotHeader* slot(int i) const { return slots[i]; }
+};
+
+QudevSharedSnapshotReader::QudevSharedSnapshotReader(int fd)
+    : d_{std::make_unique<Private>()}
+{
+    struct stat st{};
+    if (::fstat(fd, &st) < 0) {
+        d_->error = systemError("fstat");
+        return;
+    }
+
+    // Without the seal the writer could shrink the file under our mapping.
+    const int seals = ::fcntl(fd, F_GET_SEALS);
+    if (seals < 0 || !(seals & F_SEAL_SHRINK)) {
+        d_->error = QStringLiteral("Shared snapshot is not sealed against shrinking");
+        return;
+    }
+
+    const qsizetype size = qsizetype(st.st_size);
+    if (size < qsizetype(sizeof(RegionHeader))) {
+        d_->error = QStringLiteral("Shared snapshot region too small");
+        return;
+    }
+
+    void* map = ::mmap(nullptr, size_t(size), PROT_READ, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        d_->error = systemError("mmap");
+        return;
+    }
+    d_->base = static_cast<const char*>(map);
+    d_->size = size;
+
+    // The header is written once before the memfd is handed out.
+    const RegionHeader* h = d_->header();
+    bool ok = std::memcmp(h->magic, Magic, sizeof(Magic)) == 0 && h->version == LayoutVersion
+              && h->slotCount == SlotCount && h->slotCapacity <= quint64(size);
+    for (int i = 0; ok && i < SlotCount; ++i) {
+        const quint64 offset = h->slotOffset[i];
+        ok = offset % CacheLine == 0 && offset >= sizeof(RegionHeader)
+             && offset + sizeof(SlotHeader) + h->slotCapacity <= quint64(size);
+    }
+    if (!ok) {
+        d_->error = QStringLiteral("Not a qudev shared snapshot (or unsupported layout)");
+        ::munmap(const_cast<char*>(d_->base), size_t(size));
+        d_->base = nullptr;
+        return;
+    }
+    d_->capacity = qsizetype(h->slotCapacity);
+    for (int i = 0; i < SlotCount; ++i) {
+        d_->slots[i] = reinterpret_cast<const SlotHeader*>(d_->base + h->slotOffset[i]);
+    }
+}
+
+QudevSharedSnapshotReader::~QudevSharedSnapshotReader()
+{
+    current_.snapshot.reset();
+    if (d_->base) {
+        ::munmap(const_cast<char*>(d_->base), size_t(d_->size));
+    }
+}
+
+std::unique_ptr<QudevSharedSnapshotReader> QudevSharedSnapshotReader::fromBroker(const QString& socketPath)
+{
+    const int sock = Proto::connectTo(socketPath);
+    if (sock < 0) {
+        qWarning() << "[QudevSharedSnapshotReader] Cannot connect to" << socketPath << ":" << strerror(errno);
+        return nullptr;
+    }
+
+    const timeval timeout{ BrokerTimeoutSec, 0 };
+    ::setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    char version[2];
+    qToLittleEndian(Proto::Version, version);
+    QByteArray request;
+    Proto::appendFrame(request, Proto::FrameType::MapShared, version, sizeof(version));
+
+    int memfd = -1;
+    QByteArray in;
+    std::optional<Proto::Frame> frame;
+    bool error = !Proto::writeAll(sock, request.constData(), request.size());
+    while (!error && !frame) {
+        char chunk[4096];
+        const qsizetype n = Proto::receiveWithFd(sock, chunk, sizeof(chunk), &memfd);
+        if (n <= 0) {
+            error = true;
+            break;
+        }
+        in.append(chunk, n);
+        frame = Proto::nextFrame(in.constData(), in.size(), &error);
+    }
+    ::close(sock);
+
+    std::unique_ptr<QudevSharedSnapshotReader> reader;
+    if (error || !frame) {
+        qWarning() << "[QudevSharedSnapshotReader] No reply from broker at" << socketPath;
+    } else if (frame->type == Proto::FrameType::Error) {
+        qWarning() << "[QudevSharedSnapshotReader] Broker error:"
+                   << QString::fromUtf8(frame->payload, frame->size);
+    } else if (frame->type != Proto::FrameType::Shared || memfd < 0) {
+        qWarning() << "[QudevSharedSnapshotReader] Unexpected reply from broker at" << socketPath;
+    } else {
+        reader = std::make_unique<QudevSharedSnapshotReader>(memfd);
+        if (!reader->isValid()) {
+            qWarning() << "[QudevSharedSnapshotReader]" << reader->errorString();
+            reader.reset();
+        }
+    }
+
+    if (memfd >= 0) {
+        ::close(memfd);
+    }
+    return reader;
+}
+
+bool QudevSharedSnapshotReader::isValid() const noexcept
+{
+    return d_->base != nullptr;
+}
+
+QString QudevSharedSnapshotReader::errorString() const
+{
+    return d_->error;
+}
+
+quint64 QudevSharedSnapshotReader::generation() const noexcept
+{
+    return d_->base ? d_->header()->generation.load(std::memory_order_acquire) : 0;
+}
+
+std::optional<quint64> QudevSharedSnapshotReader::begin(const QudevSnapshotReader** snapshot)
+{
+    if (!d_->base) {
+        return std::nullopt;
+    }
+
+    for (;;)
+    {
+        const quint64 generation = d_->header()->generation.load(std::memory_order_acquire);
+        if (generation == 0) {
+            return std::nullopt;
+        }
+
+        const int index = int(generation % SlotCount);
+        const SlotHeader* s = d_->slot(index);
+        const quint64 sequence = s->sequence.load(std::memory_order_acquire);
+        if ((sequence & 1) || s->generation.load(std::memory_order_relaxed) != generation) {
+            ++retries_;   // the writer already moved past this generation
+            continue;
+        }
+
+        // Same fill as last time: the validated reader still applies.
+        if (current_.slot != index || current_.sequence != sequence) {
+            const qsizetype size = qMin(qsizetype(s->size.load(std::memory_order_relaxed)), d_->capacity);
+            const char* data = reinterpret_cast<const char*>(s) + sizeof(SlotHeader);
+            current_.snapshot.emplace(data, size);
+            current_.generation = generation;
+            current_.sequence = sequence;
+            current_.slot = index;
+        }
+
+        *snapshot = &*current_.snapshot;
+        return sequence;
+    }
+}
+
+bool QudevSharedSnapshotReader::validate(quint64 sequence) noexcept
+{
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (d_->slot(current_.slot)->sequence.load(std::memory_order_relaxed) == sequence) {
+        return true;
+    }
+
+    ++retries_;
+    current_.slot = -1;
+    current_.snapshot.reset();
+    return false;
+}
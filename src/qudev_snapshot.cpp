@@ -0,0 +1,590 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include "qudev_snapshot.h"
+#include "qudev_trace.h"
+
+#include <QDebug>
+#include <QHash>
+#include <QStringEncoder>
+#include <QtEndian>
+
+#include <cstring>
+#include <limits>
+
+
+namespace {
+
+constexpr char Magic[8] = { 'Q', 'U', 'D', 'E', 'V', 'S', 'N', 'P' };
+constexpr qsizetype HeaderSize = 32;
+constexpr quint16 CompatVersion = 1;
+constexpr quint8 DataStreamVersion = 1;
+
+enum HeaderOffset : qsizetype {
+    VersionAt = 8,
+    CompatVersionAt = 10,
+    DeviceCountAt = 12,
+    KeyCountAt = 16,
+    KeyTableAt = 20,
+    DeviceTableAt = 24,
+    TotalSizeAt = 28,
+};
+
+void appendVarint(QByteArray& out, quint64 value)
+{
+    char buf[10];
+    int n = 0;
+    do {
+        buf[n] = char(value & 0x7f);
+        value >>= 7;
+        if (value) {
+            buf[n] |= char(0x80);
+        }
+        ++n;
+    } while (value);
+    out.append(buf, n);
+}
+
+void appendU32(QByteArray& out, quint32 value)
+{
+    char buf[4];
+    qToLittleEndian(value, buf);
+    out.append(buf, 4);
+}
+
+/// Builds the key dictionary and encodes strings without temporaries.
+class Encoder
+{
+public:
+    Encoder()
+    {
+        key(QString());   // index 0: empty value
+    }
+
+    quint32 key(const QString& s)
+    {
+        const auto it = index_.constFind(s);
+        if (it != index_.cend()) {
+            return *it;
+        }
+        const quint32 i = quint32(keys_.size());
+        index_.insert(s, i);
+        keys_ << s;
+        return i;
+    }
+
+    void appendString(QByteArray& out, const QString& s)
+    {
+        scratch_.resize(encoder_.requiredSpace(s.size()));
+        const char* end = encoder_.appendToBuffer(scratch_.data(), s);
+        const qsizetype n = end - scratch_.constData();
+        appendVarint(out, quint64(n));
+        out.append(scratch_.constData(), n);
+    }
+
+    const QStringList& keys() const noexcept { return keys_; }
+
+private:
+    QHash<QString, quint32> index_;
+    QStringList keys_;
+    QStringEncoder encoder_{ QStringEncoder::Utf8, QStringConverter::Flag::Stateless };
+    QByteArray scratch_;
+};
+
+/// Bounds-checked reader over a byte range; @c ok turns false on overrun.
+struct Cursor
+{
+    const char* p;
+    const char* end;
+    bool ok = true;
+
+    quint64 varint() noexcept
+    {
+        quint64 value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (p >= end) {
+                break;
+            }
+            const quint8 b = quint8(*p++);
+            value |= quint64(b & 0x7f) << shift;
+            if (!(b & 0x80)) {
+                return value;
+            }
+        }
+        ok = false;
+        return 0;
+    }
+
+    QUtf8StringView string() noexcept
+    {
+        const quint64 n = varint();
+        if (!ok || n > quint64(end - p)) {
+            ok = false;
+            return {};
+        }
+        const QUtf8StringView s(p, qsizetype(n));
+        p += n;
+        return s;
+    }
+
+    quint32 key(qsizetype keyCount) noexcept
+    {
+        const quint64 i = varint();
+        if (i >= quint64(keyCount)) {
+            ok = false;
+            return 0;
+        }
+        return quint32(i);
+    }
+};
+
+bool equals(QUtf8StringView a, QUtf8StringView b) noexcept
+{
+    return a.size() == b.size()
+        && (a.isEmpty() || std::memcmp(a.data(), b.data(), size_t(a.size())) == 0);
+}
+
+QString toQString(QUtf8StringView s)
+{
+    return QString::fromUtf8(s.data(), s.size());
+}
+
+/// @p Devices is a list of anything convertible to <tt>const QudevDevice&</tt>.
+template <typename Devices>
+QByteArray encodeSnapshot(const Devices& devices)
+{
+    QUDEV_TRACE_SCOPE("qudev", "encodeSnapshot");
+
+    Encoder enc;
+    QByteArray records;
+    records.reserve(devices.size() * 512);
+    QList<quint32> recordOffsets;
+    recordOffsets.reserve(devices.size());
+
+    for (const auto& item : devices)
+    {
+        const QudevDevice& d = item;
+        recordOffsets << quint32(records.size());
+
+        records.append(char((d.isBlock ? 1 : 0) | (d.isChar ? 2 : 0)));
+        appendVarint(records, d.major);
+        appendVarint(records, d.minor);
+        appendVarint(records, d.seqnum);
+
+        enc.appendString(records, d.syspath);
+        enc.appendString(records, d.devnode);
+        enc.appendString(records, d.sysname);
+        enc.appendString(records, d.parent_syspath);
+
+        appendVarint(records, enc.key(d.subsystem));
+        appendVarint(records, enc.key(d.devtype));
+        appendVarint(records, enc.key(d.driver));
+        appendVarint(records, enc.key(d.action));
+        appendVarint(records, enc.key(d.parent_subsystem));
+
+        appendVarint(records, quint64(d.properties.size()));
+        for (auto it = d.properties.cbegin(); it != d.properties.cend(); ++it) {
+            appendVarint(records, enc.key(it.key()));
+            enc.appendString(records, it.value());
+        }
+        appendVarint(records, quint64(d.sysattrs.size()));
+        for (auto it = d.sysattrs.cbegin(); it != d.sysattrs.cend(); ++it) {
+            appendVarint(records, enc.key(it.key()));
+            enc.appendString(records, it.value());
+        }
+        appendVarint(records, quint64(d.devlinks.size()));
+        for (const QString& link : d.devlinks) {
+            enc.appendString(records, link);
+        }
+        appendVarint(records, quint64(d.tags.size()));
+        for (const QString& tag : d.tags) {
+            appendVarint(records, enc.key(tag));
+        }
+    }
+
+    QByteArray out;
+    out.reserve(HeaderSize + records.size() + devices.size() * 4 + enc.keys().size() * 24);
+    out.resize(HeaderSize, '\0');
+
+    QList<quint32> keyOffsets;
+    keyOffsets.reserve(enc.keys().size());
+    for (const QString& k : enc.keys()) {
+        keyOffsets << quint32(out.size());
+        enc.appendString(out, k);
+    }
+
+    const qsizetype keyTable = out.size();
+    for (quint32 offset : keyOffsets) {
+        appendU32(out, offset);
+    }
+
+    const qsizetype base = out.size();
+    out.append(records);
+    records = QByteArray();
+
+    const qsizetype deviceTable = out.size();
+    if (deviceTable + devices.size() * 4 > std::numeric_limits<quint32>::max()) {
+        qWarning() << "[qudevEncodeSnapshot] Snapshot exceeds 4 GiB";
+        return {};
+    }
+    for (quint32 offset : recordOffsets) {
+        appendU32(out, quint32(base) + offset);
+    }
+
+    char* h = out.data();
+    std::memcpy(h, Magic, sizeof(Magic));
+    qToLittleEndian(QudevSnapshotReader::FormatVersion, h + VersionAt);
+    qToLittleEndian(CompatVersion, h + CompatVersionAt);
+    qToLittleEndian(quint32(devices.size()), h + DeviceCountAt);
+    qToLittleEndian(quint32(enc.keys().size()), h + KeyCountAt);
+    qToLittleEndian(quint32(keyTable), h + KeyTableAt);
+    qToLittleEndian(quint32(deviceTable), h + DeviceTableAt);
+    qToLittleEndian(quint32(out.size()), h + TotalSizeAt);
+
+    return out;
+}
+
+} // namespace
+
+QByteArray qudevEncodeSnapshot(const QList<QudevDevice>& devices)
+{
+    return encodeSnapshot(devices);
+}
+
+QByteArray qudevEncodeSnapshot(const QList<QudevSharedDevice>& devices)
+{
+    return encodeSnapshot(devices);
+}
+
+QudevSnapshotReader::QudevSnapshotReader(const QByteArray& data)
+    : data_(data)
+{
+    open();
+}
+
+QudevSnapshotReader::QudevSnapshotReader(const char* data, qsizetype size)
+    : data_(QByteArray::fromRawData(data, size))
+{
+    open();
+}
+
+void QudevSnapshotReader::open()
+{
+    QUDEV_TRACE_SCOPE("qudev", "openSnapshot");
+
+    const char* base = data_.constData();
+    const qsizetype size = data_.size();
+
+    if (size < HeaderSize || std::memcmp(base, Magic, sizeof(Magic)) != 0) {
+        error_ = QStringLiteral("Not a qudev snapshot");
+        return;
+    }
+
+    version_ = qFromLittleEndian<quint16>(base + VersionAt);
+    const quint16 compat = qFromLittleEndian<quint16>(base + CompatVersionAt);
+    if (compat > FormatVersion) {
+        error_ = QStringLiteral("Unsupported snapshot version %1 (requires reader version %2)")
+                     .arg(version_).arg(compat);
+        return;
+    }
+
+    const quint32 deviceCount = qFromLittleEndian<quint32>(base + DeviceCountAt);
+    const quint32 keyCount = qFromLittleEndian<quint32>(base + KeyCountAt);
+    const quint32 keyTable = qFromLittleEndian<quint32>(base + KeyTableAt);
+    const quint32 deviceTable = qFromLittleEndian<quint32>(base + DeviceTableAt);
+    const quint32 totalSize = qFromLittleEndian<quint32>(base + TotalSizeAt);
+
+    if (totalSize > quint64(size) || keyTable < HeaderSize
+        || quint64(keyTable) + quint64(keyCount) * 4 > deviceTable
+        || quint64(deviceTable) + quint64(deviceCount) * 4 > totalSize
+        || keyCount == 0) {
+        error_ = QStringLiteral("Truncated or inconsistent snapshot header");
+        return;
+    }
+
+    // Keys: each offset must point at a string that ends before the table.
+    keyViews_.reserve(keyCount);
+    keys_.reserve(keyCount);
+    const char* keysEnd = base + keyTable;
+    for (quint32 i = 0; i < keyCount; ++i) {
+        const quint32 offset = qFromLittleEndian<quint32>(base + keyTable + i * 4);
+        Cursor c{ base + offset, keysEnd, offset >= HeaderSize && offset < keyTable };
+        const QUtf8StringView k = c.ok ? c.string() : QUtf8StringView();
+        if (!c.ok) {
+            error_ = QStringLiteral("Corrupt key %1").arg(i);
+            keyViews_.clear();
+            keys_.clear();
+            return;
+        }
+        keyViews_ << k;
+        keys_ << toQString(k);
+    }
+
+    // Records: ordered, inside the record area, and fully parseable.
+    deviceTable_ = reinterpret_cast<const uchar*>(base + deviceTable);
+    const quint32 recordsBegin = keyTable + keyCount * 4;
+    quint32 previous = recordsBegin;
+    for (quint32 i = 0; i < deviceCount; ++i) {
+        const quint32 offset = qFromLittleEndian<quint32>(deviceTable_ + i * 4);
+        if (offset < previous || offset >= deviceTable) {
+            error_ = QStringLiteral("Corrupt device table entry %1").arg(i);
+            return;
+        }
+        previous = offset;
+    }
+
+    deviceCount_ = deviceCount;
+    for (quint32 i = 0; i < deviceCount; ++i) {
+        const DeviceView view = device(i);
+        Cursor c{ view.sections_, view.end_, view.reader_ != nullptr };
+        for (int section = 0; section < 2 && c.ok; ++section) {
+            for (quint64 n = c.varint(); c.ok && n; --n) {
+                c.key(keyCount);
+                c.string();
+            }
+        }
+        for (quint64 n = c.varint(); c.ok && n; --n) {
+            c.string();
+        }
+        for (quint64 n = c.varint(); c.ok && n; --n) {
+            c.key(keyCount);
+        }
+        if (!c.ok) {
+            error_ = QStringLiteral("Corrupt device record %1").arg(i);
+            deviceCount_ = 0;
+            return;
+        }
+    }
+}
+
+QUtf8StringView QudevSnapshotReader::key(quint32 index) const noexcept
+{
+    return index < quint32(keyViews_.size()) ? keyViews_.at(index) : QUtf8StringView();
+}
+
+QString QudevSnapshotReader::keyString(quint32 index) const
+{
+    return index < quint32(keys_.size()) ? keys_.at(index) : QString();
+}
+
+QudevSnapshotReader::DeviceView QudevSnapshotReader::device(qsizetype index) const noexcept
+{
+    DeviceView v;
+
+    if (index < 0 || index >= deviceCount_) {
+        return v;
+    }
+
+    // Offsets are re-checked on every access: a shared snapshot may be
+    // rewritten underneath a reader, which must then see garbage, not crash.
+    const char* base = data_.constData();
+    const quint32 tableAt = quint32(reinterpret_cast<const char*>(deviceTable_) - base);
+    const quint32 offset = qFromLittleEndian<quint32>(deviceTable_ + index * 4);
+    const quint32 end = index + 1 < deviceCount_
+                            ? qFromLittleEndian<quint32>(deviceTable_ + (index + 1) * 4)
+                            : tableAt;
+
+    if (offset >= end || end > tableAt) {
+        return v;
+    }
+    Cursor c{ base + offset, base + end };
+    v.flags_ = quint8(*c.p++);
+    v.major_ = quint32(c.varint());
+    v.minor_ = quint32(c.varint());
+    v.seqnum_ = c.varint();
+    v.syspath_ = c.string();
+    v.devnode_ = c.string();
+    v.sysname_ = c.string();
+    v.parentSyspath_ = c.string();
+
+    const qsizetype keyCount = keyViews_.size();
+    v.subsystem_ = c.key(keyCount);
+    v.devtype_ = c.key(keyCount);
+    v.driver_ = c.key(keyCount);
+    v.action_ = c.key(keyCount);
+    v.parentSubsystem_ = c.key(keyCount);
+
+    if (c.ok) {
+        v.reader_ = this;
+        v.sections_ = c.p;
+        v.end_ = c.end;
+    }
+    return v;
+}
+
+QList<QudevDevice> QudevSnapshotReader::devices() const
+{
+    QUDEV_TRACE_SCOPE("qudev", "decodeSnapshot");
+
+    QList<QudevDevice> out;
+    out.reserve(deviceCount());
+    for (qsizetype i = 0; i < deviceCount(); ++i) {
+        out << device(i).toDevice();
+    }
+    return out;
+}
+
+QUtf8StringView QudevSnapshotReader::DeviceView::subsystem() const noexcept
+{
+    return reader_ ? reader_->key(subsystem_) : QUtf8StringView();
+}
+
+QUtf8StringView QudevSnapshotReader::DeviceView::devtype() const noexcept
+{
+    return reader_ ? reader_->key(devtype_) : QUtf8StringView();
+}
+
+QUtf8StringView QudevSnapshotReader::DeviceView::driver() const noexcept
+{
+    return reader_ ? reader_->key(driver_) : QUtf8StringView();
+}
+
+QUtf8StringView QudevSnapshotReader::DeviceView::action() const noexcept
+{
+    return reader_ ? reader_->key(action_) : QUtf8StringView();
+}
+
+QUtf8StringView QudevSnapshotReader::DeviceView::parentSubsystem() const noexcept
+{
+    return reader_ ? reader_->key(parentSubsystem_) : QUtf8StringView();
+}
+
+QUtf8StringView QudevSnapshotReader::DeviceView::property(QUtf8StringView key) const noexcept
+{
+    if (!reader_) {
+        return {};
+    }
+
+    Cursor c{ sections_, end_ };
+    for (quint64 n = c.varint(); c.ok && n; --n) {
+        const quint32 k = quint32(c.varint());
+        const QUtf8StringView value = c.string();
+        if (equals(reader_->key(k), key)) {
+            return value;
+        }
+    }
+    return {};
+}
+
+QUtf8StringView QudevSnapshotReader::DeviceView::sysattr(QUtf8StringView key) const noexcept
+{
+    if (!reader_) {
+        return {};
+    }
+
+    Cursor c{ sections_, end_ };
+    for (quint64 n = c.varint(); c.ok && n; --n) {
+        c.varint();
+        c.string();
+    }
+    for (quint64 n = c.varint(); c.ok && n; --n) {
+        const quint32 k = quint32(c.varint());
+        const QUtf8StringView value = c.string();
+        if (equals(reader_->key(k), key)) {
+            return value;
+        }
+    }
+    return {};
+}
+
+bool QudevSnapshotReader::DeviceView::hasTag(QUtf8StringView tag) const noexcept
+{
+    if (!reader_) {
+        return false;
+    }
+
+    Cursor c{ sections_, end_ };
+    for (int section = 0; section < 2 && c.ok; ++section) {
+        for (quint64 n = c.varint(); c.ok && n; --n) {
+            c.varint();
+            c.string();
+        }
+    }
+    for (quint64 n = c.varint(); c.ok && n; --n) {
+        c.string();
+    }
+    for (quint64 n = c.varint(); c.ok && n; --n) {
+        if (equals(reader_->key(quint32(c.varint())), tag)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+QudevDevice QudevSnapshotReader::DeviceView::toDevice() const
+{
+    QudevDevice d;
+    if (!reader_) {
+        return d;
+    }
+
+    d.syspath = toQString(syspath_);
+    d.devnode = toQString(devnode_);
+    d.sysname = toQString(sysname_);
+    d.parent_syspath = toQString(parentSyspath_);
+    d.subsystem = reader_->keyString(subsystem_);
+    d.devtype = reader_->keyString(devtype_);
+    d.driver = reader_->keyString(driver_);
+    d.action = reader_->keyString(action_);
+    d.parent_subsystem = reader_->keyString(parentSubsystem_);
+    d.major = major_;
+    d.minor = minor_;
+    d.seqnum = seqnum_;
+    d.isBlock = isBlock();
+    d.isChar = isChar();
+
+    // Encoded in key order, so inserting at the end never searches.
+    Cursor c{ sections_, end_ };
+    for (quint64 n = c.varint(); c.ok && n; --n) {
+        const quint32 k = quint32(c.varint());
+        d.properties.insert(d.properties.cend(), reader_->keyString(k), toQString(c.string()));
+    }
+    for (quint64 n = c.varint(); c.ok && n; --n) {
+        const quint32 k = quint32(c.varint());
+        d.sysattrs.insert(d.sysattrs.cend(), reader_->keyString(k), toQString(c.string()));
+    }
+    for (quint64 n = c.varint(); c.ok && n; --n) {
+        d.devlinks << toQString(c.string());
+    }
+    for (quint64 n = c.varint(); c.ok && n; --n) {
+        d.tags << reader_->keyString(quint32(c.varint()));
+    }
+
+    return d;
+}
+
+QDataStream& operator<<(QDataStream& out, const QudevDevice& d)
+{
+    out << DataStreamVersion
+        << d.syspath << d.devnode << d.subsystem << d.devtype << d.sysname << d.driver
+        << d.major << d.minor
+        << d.properties << d.sysattrs << d.devlinks << d.tags
+        << d.parent_syspath << d.parent_subsystem
+        << d.action << d.seqnum
+        << d.isBlock << d.isChar;
+    return out;
+}
+
+QDataStream& operator>>(QDataStream& in, QudevDevice& d)
+{
+    quint8 version = 0;
+    in >> version;
+    if (version != DataStreamVersion) {
+        in.setStatus(QDataStream::ReadCorruptData);
+        d = QudevDevice();
+        return in;
+    }
+
+    in >> d.syspath >> d.devnode >> d.subsystem >> d.devtype >> d.sysname >> d.driver
+       >> d.major >> d.minor
+       >> d.properties >> d.sysattrs >> d.devlinks >> d.tags
+       >> d.parent_syspath >> d.parent_subsystem
+       >> d.action >> d.seqnum
+       >> d.isBlock >> d.isChar;
+    return in;
+}
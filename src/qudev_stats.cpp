@@ -0,0 +1,117 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include "qudev_stats.h"
+#include "qudev_stats_collector.h"
+
+#include <cmath>
+
+
+int QudevLatencyHistogram::bucketIndex(quint64 ns) noexcept
+{
+    if (ns < quint64(SubBuckets)) {
+        return int(ns);
+    }
+
+    // Exponent, then the next two bits below the leading one.
+    const int e = 63 - __builtin_clzll(ns);
+    const int sub = int((ns >> (e - 2)) & (SubBuckets - 1));
+    const int index = (e - 1) * SubBuckets + sub;
+    return index < BucketCount ? index : BucketCount - 1;
+}
+
+quint64 QudevLatencyHistogram::bucketUpperBound(int index) noexcept
+{
+    if (index < SubBuckets) {
+        return quint64(index);
+    }
+
+    const int e = index / SubBuckets + 1;
+    const quint64 sub = quint64(index % SubBuckets);
+    return ((SubBuckets + sub + 1) << (e - 2)) - 1;
+}
+
+quint64 QudevLatencyHistogram::percentileNs(double percentile) const noexcept
+{
+    if (count == 0) {
+        return 0;
+    }
+
+    const double clamped = percentile < 0 ? 0 : (percentile > 100 ? 100 : percentile);
+    const quint64 rank = qMax<quint64>(1, quint64(std::ceil(clamped / 100.0 * double(count))));
+
+    quint64 seen = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return qMin(bucketUpperBound(i), maxNs);
+        }
+    }
+    return maxNs;
+}
+
+double QudevLatencyHistogram::meanNs() const noexcept
+{
+    return count ? double(sumNs) / double(count) : 0.0;
+}
+
+void QudevStatsCollector::Histogram::snapshot(QudevLatencyHistogram& out) const noexcept
+{
+    out.count = count.load(std::memory_order_relaxed);
+    out.sumNs = sum.load(std::memory_order_relaxed);
+    out.maxNs = max.load(std::memory_order_relaxed);
+    for (int i = 0; i < QudevLatencyHistogram::BucketCount; ++i) {
+        out.buckets[i] = buckets[i].load(std::memory_order_relaxed);
+    }
+}
+
+QudevStats QudevStatsCollector::snapshot() const noexcept
+{
+    const auto load = [](const std::atomic<quint64>& v) {
+        return v.load(std::memory_order_relaxed);
+    };
+
+    QudevStats s;
+    s.scans           = load(scans);
+    s.scanNs          = load(scanNs);
+    s.lastScanNs      = load(lastScanNs);
+    s.devicesBuilt    = load(devicesBuilt);
+    s.sysattrReads    = load(sysattrReads);
+    s.sysattrBytes    = load(sysattrBytes);
+    s.sysattrCacheHits = load(sysattrCacheHits);
+    s.sysattrsDenied  = load(sysattrsDenied);
+    s.sysattrsOversized = load(sysattrsOversized);
+    s.sysattrsSlow    = load(sysattrsSlow);
+    s.eventsReceived  = load(eventsReceived);
+    s.eventsFiltered  = load(eventsFiltered);
+    s.eventsCoalesced = load(eventsCoalesced);
+    s.eventsDelivered = load(eventsDelivered);
+    s.cacheBytes      = load(cacheBytes);
+
+    receive.snapshot(s.receiveLatency);
+    build.snapshot(s.buildLatency);
+    filter.snapshot(s.filterLatency);
+    emit_.snapshot(s.emitLatency);
+    kernelToUdevd.snapshot(s.kernelToUdevdLatency);
+    udevdToReceive.snapshot(s.udevdToReceiveLatency);
+    receiveToDelivery.snapshot(s.receiveToDeliveryLatency);
+
+    for (int i = 0; i < QudevStats::PriorityLaneCount; ++i) {
+        s.lanes[i].delivered = load(lanes[i].delivered);
+        s.lanes[i].starved   = load(lanes[i].starved);
+        s.lanes[i].maxDepth  = load(lanes[i].maxDepth);
+        lanes[i].queue.snapshot(s.lanes[i].queueLatency);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(slowSysattrsMutex);
+        s.slowSysattrs = slowSysattrs;
+    }
+
+    return s;
+}
@@ -0,0 +1,135 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#pragma once
+
+#include <atomic>
+#include <ctime>
+#include <mutex>
+
+#include "qudev_stats.h"
+
+/**
+ * @file qudev_stats_collector.h
+ * @brief Internal lock-free accumulation of @ref QudevStats.
+ */
+
+/**
+ * @brief Accumulates the counters behind @ref QudevStats.
+ *
+ * Every update is a relaxed atomic add, cheap enough to stay enabled on the
+ * event path; @ref snapshot() aggregates on read. A snapshot taken while
+ * other threads update is not a consistent cut across counters, but each
+ * counter is exact.
+ */
+class QudevStatsCollector
+{
+public:
+    /// Lock-free counterpart of @ref QudevLatencyHistogram.
+    struct Histogram
+    {
+        void record(quint64 ns) noexcept
+        {
+            buckets[QudevLatencyHistogram::bucketIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+            count.fetch_add(1, std::memory_order_relaxed);
+            sum.fetch_add(ns, std::memory_order_relaxed);
+
+            quint64 prev = max.load(std::memory_order_relaxed);
+            while (prev < ns && !max.compare_exchange_weak(prev, ns, std::memory_order_relaxed)) {
+            }
+        }
+
+        void snapshot(QudevLatencyHistogram& out) const noexcept;
+
+        std::atomic<quint64> buckets[QudevLatencyHistogram::BucketCount] = {};
+        std::atomic<quint64> count{0};
+        std::atomic<quint64> sum{0};
+        std::atomic<quint64> max{0};
+    };
+
+    /// Lock-free counterpart of @ref QudevLaneStats.
+    struct Lane
+    {
+        void recordDepth(quint64 depth) noexcept
+        {
+            quint64 prev = maxDepth.load(std::memory_order_relaxed);
+            while (prev < depth && !maxDepth.compare_exchange_weak(prev, depth, std::memory_order_relaxed)) {
+            }
+        }
+
+        std::atomic<quint64> delivered{0};
+        std::atomic<quint64> starved{0};
+        std::atomic<quint64> maxDepth{0};
+        Histogram queue;
+    };
+
+    /// Monotonic clock in nanoseconds, for stage timings.
+    static quint64 nowNs() noexcept
+    {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return quint64(ts.tv_sec) * 1000000000ull + quint64(ts.tv_nsec);
+    }
+
+    static void add(std::atomic<quint64>& counter, quint64 n = 1) noexcept
+    {
+        counter.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    void recordScan(quint64 ns) noexcept
+    {
+        add(scans);
+        add(scanNs, ns);
+        lastScanNs.store(ns, std::memory_order_relaxed);
+    }
+
+    void recordSysattr(quint64 bytes) noexcept
+    {
+        add(sysattrReads);
+        add(sysattrBytes, bytes);
+    }
+
+    /// Remember an attribute learned to be slow, as "subsystem/attribute".
+    void addSlowSysattr(const QString& name)
+    {
+        std::lock_guard<std::mutex> lock(slowSysattrsMutex);
+        slowSysattrs << name;
+    }
+
+    /// Aggregate all counters.
+    QudevStats snapshot() const noexcept;
+
+    std::atomic<quint64> scans{0};
+    std::atomic<quint64> scanNs{0};
+    std::atomic<quint64> lastScanNs{0};
+    std::atomic<quint64> devicesBuilt{0};
+    std::atomic<quint64> sysattrReads{0};
+    std::atomic<quint64> sysattrBytes{0};
+    std::atomic<quint64> sysattrCacheHits{0};
+    std::atomic<quint64> sysattrsDenied{0};
+    std::atomic<quint64> sysattrsOversized{0};
+    std::atomic<quint64> sysattrsSlow{0};
+    std::atomic<quint64> eventsReceived{0};
+    std::atomic<quint64> eventsFiltered{0};
+    std::atomic<quint64> eventsCoalesced{0};
+    std::atomic<quint64> eventsDelivered{0};
+    std::atomic<quint64> cacheBytes{0};
+
+    Histogram receive;
+    Histogram build;
+    Histogram filter;
+    Histogram emit_;   // "emit" is a Qt keyword
+    Histogram kernelToUdevd;
+    Histogram udevdToReceive;
+    Histogram receiveToDelivery;
+    Lane lanes[QudevStats::PriorityLaneCount];
+
+    // Rarely written; the only state not updated lock-free.
+    mutable std::mutex slowSysattrsMutex;
+    QStringList slowSysattrs;
+};
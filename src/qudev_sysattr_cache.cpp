@@ -0,0 +1,213 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include "qudev_sysattr_cache.h"
+#include "qudev_stats_collector.h"
+
+#include <QDebug>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+
+void QudevSysattrCache::setPolicy(const QudevSysattrPolicy& policy)
+{
+    policy_ = policy;
+    strikes_.clear();
+    slow_.clear();
+    clear();
+}
+
+bool QudevSysattrCache::isSkipped(const QString& subsystem, const QString& attribute) const
+{
+    if (policy_.isDenied(subsystem, attribute)) {
+        return true;
+    }
+
+    const auto sub = slow_.constFind(subsystem);
+    return sub != slow_.cend() && sub->contains(attribute);
+}
+
+bool QudevSysattrCache::recordReadTime(const QString& subsystem, const QString& attribute, quint64 ns)
+{
+    if (policy_.slowReadBudgetUs <= 0 || ns <= quint64(policy_.slowReadBudgetUs) * 1000) {
+        return false;
+    }
+
+    int& strikes = strikes_[subsystem][attribute];
+    if (++strikes < policy_.slowReadStrikes) {
+        return false;
+    }
+
+    slow_[subsystem].insert(attribute);
+    qWarning().nospace() << "[QudevSysattrCache] Skipping slow sysattr " << subsystem << '/' << attribute
+                         << " (" << double(ns) / 1e6 << " ms)";
+    if (stats_) {
+        stats_->addSlowSysattr(subsystem + QLatin1Char('/') + attribute);
+    }
+    return true;
+}
+
+QudevSysattrCache::Device* QudevSysattrCache::device(const QString& syspath, const QString& subsystem,
+                                                     const QString& initialized, const QString& action)
+{
+    if (!policy_.enabled || syspath.isEmpty()) {
+        return nullptr;
+    }
+
+    const bool lifecycle = action == QLatin1String("add") || action == QLatin1String("remove");
+    if (lifecycle) {
+        invalidate(syspath);
+    }
+    if (action == QLatin1String("remove")) {
+        return nullptr;
+    }
+
+    auto it = devices_.find(syspath);
+    if (it != devices_.end() && it->initialized != initialized) {
+        // Same syspath, different device instance.
+        invalidate(syspath);
+        it = devices_.end();
+    }
+
+    if (it == devices_.end()) {
+        if (policy_.maxDevices > 0 && devices_.size() >= policy_.maxDevices) {
+            evictLeastRecent();
+        }
+        it = devices_.insert(syspath, Device{});
+        it->initialized = initialized;
+        it->subsystem = subsystem;
+    }
+
+    it->used = ++tick_;
+    if (scan_) {
+        it->scan = scan_;
+    }
+    return &it.value();
+}
+
+void QudevSysattrCache::beginScan() noexcept
+{
+    scan_ = ++scans_;
+}
+
+void QudevSysattrCache::endScan(bool completed)
+{
+    const quint64 scan = std::exchange(scan_, 0);
+    if (!completed || !scan) {
+        return;
+    }
+
+    for (auto it = devices_.begin(); it != devices_.end(); ) {
+        if (it->scan == scan) {
+            ++it;
+            continue;
+        }
+        for (auto v = it->values.cbegin(); v != it->values.cend(); ++v) {
+            bytes_ -= entryBytes(v.key(), v->value);
+        }
+        it = devices_.erase(it);
+    }
+    updateStats();
+}
+
+void QudevSysattrCache::evictLeastRecent()
+{
+    // Drop an eighth at a time so that filling a full cache stays linear.
+    std::vector<quint64> ticks;
+    ticks.reserve(size_t(devices_.size()));
+    for (const Device& device : std::as_const(devices_)) {
+        ticks.push_back(device.used);
+    }
+    const auto nth = ticks.begin() + qMax<qsizetype>(1, qsizetype(ticks.size()) / 8) - 1;
+    std::nth_element(ticks.begin(), nth, ticks.end());
+    const quint64 oldest = *nth;
+
+    for (auto it = devices_.begin(); it != devices_.end(); ) {
+        if (it->used > oldest) {
+            ++it;
+            continue;
+        }
+        for (auto v = it->values.cbegin(); v != it->values.cend(); ++v) {
+            bytes_ -= entryBytes(v.key(), v->value);
+        }
+        it = devices_.erase(it);
+    }
+    updateStats();
+}
+
+const QString* QudevSysattrCache::lookup(const Device& device, const QString& attribute, qint64 nowNs) const
+{
+    const auto it = device.values.constFind(attribute);
+    if (it == device.values.cend()) {
+        return nullptr;
+    }
+
+    if (it->ttlNs >= 0 && nowNs - it->readAtNs > it->ttlNs) {
+        return nullptr;
+    }
+
+    return &it->value;
+}
+
+void QudevSysattrCache::store(Device& device, const QString& attribute, const QString& value, qint64 nowNs)
+{
+    const qint64 ttlMs = policy_.ttlMs(device.subsystem, attribute);
+    if (ttlMs == QudevSysattrPolicy::Uncached) {
+        return;
+    }
+
+    auto it = device.values.find(attribute);
+    if (it != device.values.end()) {
+        bytes_ -= entryBytes(attribute, it->value);
+    } else {
+        it = device.values.insert(attribute, {});
+    }
+
+    it->value = value;
+    it->readAtNs = nowNs;
+    it->ttlNs = ttlMs < 0 ? -1 : ttlMs * 1000 * 1000;
+
+    bytes_ += entryBytes(attribute, value);
+    updateStats();
+}
+
+void QudevSysattrCache::invalidate(const QString& syspath)
+{
+    const auto it = devices_.constFind(syspath);
+    if (it == devices_.cend()) {
+        return;
+    }
+
+    for (auto v = it->values.cbegin(); v != it->values.cend(); ++v) {
+        bytes_ -= entryBytes(v.key(), v->value);
+    }
+    devices_.erase(it);
+    updateStats();
+}
+
+void QudevSysattrCache::clear()
+{
+    devices_.clear();
+    bytes_ = 0;
+    updateStats();
+}
+
+quint64 QudevSysattrCache::entryBytes(const QString& attribute, const QString& value) noexcept
+{
+    // UTF-16 payloads plus a rough allowance for hash node and headers.
+    return quint64(attribute.size() + value.size()) * sizeof(QChar) + 64;
+}
+
+void QudevSysattrCache::updateStats() noexcept
+{
+    if (stats_) {
+        stats_->cacheBytes.store(bytes_, std::memory_order_relaxed);
+    }
+}
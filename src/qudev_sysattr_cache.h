@@ -0,0 +1,143 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#pragma once
+
+#include <QHash>
+#include <QSet>
+#include <QString>
+
+#include "qudev_sysattr_policy.h"
+
+class QudevStatsCollector;
+
+/**
+ * @file qudev_sysattr_cache.h
+ * @brief Internal cache of sysfs attribute values.
+ */
+
+/**
+ * @brief Sysfs attribute values keyed by device syspath and attribute.
+ *
+ * Each device's entries are tied to its @c USEC_INITIALIZED value, which
+ * udevd renews whenever the device is (re-)added; a device replugged at
+ * the same syspath while nobody was monitoring therefore never sees the
+ * previous device's values. @c add and @c remove events drop a device's
+ * entries explicitly. Devices a complete unfiltered enumeration no longer
+ * finds are dropped at its end, and beyond
+ * @ref QudevSysattrPolicy::maxDevices the least recently built ones are.
+ *
+ * Also remembers which attributes were learned to be slow, per subsystem
+ * (see @ref QudevSysattrPolicy::slowReadBudgetUs).
+ *
+ * Not thread-safe; owned by a backend and used from its thread.
+ */
+class QudevSysattrCache
+{
+public:
+    /// Cached values of one device.
+    struct Device
+    {
+        struct Value
+        {
+            QString value;
+            qint64 readAtNs = 0;
+            qint64 ttlNs = 0;   // < 0: static
+        };
+
+        QString initialized;
+        QString subsystem;
+        QHash<QString, Value> values;
+        quint64 used = 0;   // tick of the last device() call
+        quint64 scan = 0;   // last scan that built the device
+    };
+
+    /// Replace the policy; drops every cached value and learned slow attribute.
+    void setPolicy(const QudevSysattrPolicy& policy);
+
+    /// The current policy.
+    const QudevSysattrPolicy& policy() const noexcept { return policy_; }
+
+    /// Counters for hits, misses and memory use, or @c nullptr.
+    void setStats(QudevStatsCollector* stats) noexcept { stats_ = stats; }
+
+    /**
+     * @brief Cache entry to use while building one device.
+     *
+     * @param syspath     Device syspath.
+     * @param subsystem   Device subsystem, for the policy.
+     * @param initialized The device's @c USEC_INITIALIZED property.
+     * @param action      Event action, empty for enumeration.
+     * @return The entry, or @c nullptr if values must not be cached (cache
+     *         disabled, or a @c remove event).
+     */
+    Device* device(const QString& syspath, const QString& subsystem,
+                   const QString& initialized, const QString& action);
+
+    /**
+     * @brief Cached value of @p attribute, if still fresh.
+     *
+     * @param nowNs Current @c CLOCK_MONOTONIC time.
+     */
+    const QString* lookup(const Device& device, const QString& attribute, qint64 nowNs) const;
+
+    /// Store a value just read from sysfs, if the policy allows caching it.
+    void store(Device& device, const QString& attribute, const QString& value, qint64 nowNs);
+
+    /**
+     * @brief Whether @p attribute of @p subsystem devices must not be read,
+     *        because the policy denies it or it was learned to be slow.
+     */
+    bool isSkipped(const QString& subsystem, const QString& attribute) const;
+
+    /**
+     * @brief Account one read of @p attribute that took @p ns.
+     *
+     * @return true if this read made the attribute slow, i.e. later calls
+     *         to @ref isSkipped() return true for it.
+     */
+    bool recordReadTime(const QString& subsystem, const QString& attribute, quint64 ns);
+
+    /// Start a sweep: devices not built before @ref endScan() are dropped by it.
+    void beginScan() noexcept;
+
+    /**
+     * @brief End the sweep started by @ref beginScan().
+     *
+     * @param completed Whether every device was visited; devices are only
+     *        dropped after a completed scan.
+     */
+    void endScan(bool completed);
+
+    /// Number of devices with an entry.
+    qsizetype deviceCount() const noexcept { return devices_.size(); }
+
+    /// Drop everything cached for @p syspath.
+    void invalidate(const QString& syspath);
+
+    /// Drop every cached value.
+    void clear();
+
+    /// Approximate memory held by cached values, in bytes.
+    quint64 bytes() const noexcept { return bytes_; }
+
+private:
+    static quint64 entryBytes(const QString& attribute, const QString& value) noexcept;
+    void updateStats() noexcept;
+    void evictLeastRecent();
+
+    QudevSysattrPolicy policy_ = QudevSysattrPolicy::defaults();
+    QHash<QString, Device> devices_;
+    QHash<QString, QHash<QString, int>> strikes_;   // subsystem → attribute → over-budget reads
+    QHash<QString, QSet<QString>> slow_;            // subsystem → attributes
+    quint64 bytes_ = 0;
+    quint64 tick_ = 0;
+    quint64 scan_ = 0;                              // running sweep, 0 if none
+    quint64 scans_ = 0;
+    QudevStatsCollector* stats_ = nullptr;
+};
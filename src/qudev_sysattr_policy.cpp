@@ -0,0 +1,95 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include "qudev_sysattr_policy.h"
+
+
+qint64 QudevSysattrPolicy::ttlMs(const QString& subsystem, const QString& attribute) const
+{
+    const auto sub = subsystems.constFind(subsystem);
+    if (sub != subsystems.cend()) {
+        const auto it = sub->constFind(attribute);
+        if (it != sub->cend()) {
+            return *it;
+        }
+    }
+
+    const auto it = attributes.constFind(attribute);
+    return it != attributes.cend() ? *it : defaultTtlMs;
+}
+
+bool QudevSysattrPolicy::isDenied(const QString& subsystem, const QString& attribute) const
+{
+    if (deniedAttributes.contains(attribute)) {
+        return true;
+    }
+
+    const auto sub = deniedSubsystemAttributes.constFind(subsystem);
+    return sub != deniedSubsystemAttributes.cend() && sub->contains(attribute);
+}
+
+QudevSysattrPolicy QudevSysattrPolicy::defaults()
+{
+    QudevSysattrPolicy policy;
+
+    // Identity and topology: fixed until the device goes away. Names like
+    // speed, version, type or name mean other things elsewhere, so bus
+    // identities are only static on their own subsystem.
+    static const char* const usbAttributes[] = {
+        "idVendor", "idProduct", "manufacturer", "product", "serial",
+        "bcdDevice", "bDeviceClass", "bDeviceSubClass", "bDeviceProtocol",
+        "bNumConfigurations", "bNumInterfaces", "bMaxPacketSize0", "bMaxPower",
+        "bInterfaceClass", "bInterfaceSubClass", "bInterfaceProtocol",
+        "bInterfaceNumber", "bAlternateSetting", "bNumEndpoints",
+        "busnum", "devnum", "devpath", "speed", "version", "maxchild",
+    };
+    static const char* const pciAttributes[] = {
+        "vendor", "device", "subsystem_vendor", "subsystem_device",
+        "class", "revision", "numa_node", "local_cpus", "local_cpulist",
+    };
+    static const char* const netAttributes[] = {
+        "type", "dev_id", "dev_port",
+    };
+    static const char* const genericAttributes[] = {
+        "dev", "modalias", "removable", "size", "ext_range", "range",
+    };
+
+    const auto markStatic = [](QHash<QString, qint64>& ttls, const auto& names) {
+        for (const char* name : names) {
+            ttls.insert(QString::fromLatin1(name), Static);
+        }
+    };
+    markStatic(policy.subsystems[QStringLiteral("usb")], usbAttributes);
+    markStatic(policy.subsystems[QStringLiteral("pci")], pciAttributes);
+    markStatic(policy.subsystems[QStringLiteral("net")], netAttributes);
+    policy.subsystems[QStringLiteral("input")].insert(QStringLiteral("name"), Static);
+    markStatic(policy.attributes, genericAttributes);
+
+    // Resizes and media changes are announced with change events.
+    auto& block = policy.subsystems[QStringLiteral("block")];
+    block.insert(QStringLiteral("size"), Uncached);
+    block.insert(QStringLiteral("ro"), Uncached);
+
+    // Config space and VPD reads go to the device and can take seconds on
+    // misbehaving hardware; option ROM reads enable and copy the ROM.
+    policy.deniedSubsystemAttributes[QStringLiteral("pci")]
+        << QStringLiteral("config") << QStringLiteral("rom") << QStringLiteral("vpd");
+    // Every PCR is a TPM command.
+    policy.deniedSubsystemAttributes[QStringLiteral("tpm")] << QStringLiteral("pcrs");
+
+    return policy;
+}
+
+QudevSysattrPolicy QudevSysattrPolicy::disabled()
+{
+    QudevSysattrPolicy policy = defaults();
+    policy.enabled = false;
+    policy.attributes.clear();
+    policy.subsystems.clear();
+    return policy;
+}
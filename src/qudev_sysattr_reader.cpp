@@ -0,0 +1,450 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include "qudev_sysattr_reader.h"
+
+#include <QDebug>
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <vector>
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+
+void QudevSysattrReader::finish(Request& request, qsizetype length)
+{
+    if (length > MaxValueSize) {
+        request.error = EFBIG;
+        length = -1;
+    }
+    if (length < 0) {
+        request.value.clear();
+        return;
+    }
+
+    // libudev hands out C strings: stop at the first NUL, drop trailing newlines.
+    length = qsizetype(::strnlen(request.value.constData(), size_t(length)));
+    while (length > 0 && (request.value[length - 1] == '\n' || request.value[length - 1] == '\r')) {
+        --length;
+    }
+    request.value.truncate(length);
+}
+
+namespace {
+
+constexpr int OpenFlags = O_RDONLY | O_CLOEXEC | O_NOFOLLOW;
+
+quint64 monotonicNs() noexcept
+{
+    timespec t;
+    ::clock_gettime(CLOCK_MONOTONIC, &t);
+    return quint64(t.tv_sec) * 1000000000ull + quint64(t.tv_nsec);
+}
+
+/// Blocking open/read/close of one request.
+void readBlocking(QudevSysattrReader::Request& request, qsizetype& length)
+{
+    const quint64 t0 = monotonicNs();
+    const auto elapsed = [t0]() { return monotonicNs() - t0; };
+
+    length = -1;
+    const int fd = ::open(request.path.constData(), OpenFlags);
+    if (fd < 0) {
+        request.error = errno;
+        request.elapsedNs = elapsed();
+        return;
+    }
+
+    // One byte more than allowed, to tell a full page from an oversized file.
+    request.value.resize(QudevSysattrReader::MaxValueSize + 1);
+    ssize_t n;
+    do {
+        n = ::read(fd, request.value.data(), size_t(request.value.size()));
+    } while (n < 0 && errno == EINTR);
+
+    if (n < 0) {
+        request.error = errno;
+    } else {
+        request.error = 0;
+        length = qsizetype(n);
+    }
+    ::close(fd);
+    request.elapsedNs = elapsed();
+}
+
+// ---------------------------------------------------------------------------
+// Sequential
+// ---------------------------------------------------------------------------
+
+class SequentialReader final : public QudevSysattrReader
+{
+public:
+    void read(Request* requests, qsizetype count) override
+    {
+        for (qsizetype i = 0; i < count; ++i) {
+            qsizetype length;
+            readBlocking(requests[i], length);
+            finish(requests[i], length);
+        }
+    }
+
+    const char* name() const noexcept override { return "sequential"; }
+};
+
+// ---------------------------------------------------------------------------
+// Thread pool
+// ---------------------------------------------------------------------------
+
+/// Spreads blocking reads over a private thread pool; the caller helps out.
+class ThreadPoolReader final : public QudevSysattrReader
+{
+public:
+    ThreadPoolReader()
+    {
+        pool_.setMaxThreadCount(qBound(2, QThread::idealThreadCount(), 8));
+    }
+
+    ~ThreadPoolReader() override
+    {
+        pool_.waitForDone();
+    }
+
+    void read(Request* requests, qsizetype count) override
+    {
+        std::atomic<qsizetype> next{0};
+        const auto work = [&]() {
+            for (qsizetype begin; (begin = next.fetch_add(Chunk, std::memory_order_relaxed)) < count;) {
+                const qsizetype end = qMin(begin + Chunk, count);
+                for (qsizetype i = begin; i < end; ++i) {
+                    qsizetype length;
+                    readBlocking(requests[i], length);
+                    finish(requests[i], length);
+                }
+            }
+        };
+
+        // Small batches are not worth the handoff.
+        const int helpers = qMin(pool_.maxThreadCount(), int((count - 1) / Chunk));
+        QSemaphore done;
+        for (int i = 0; i < helpers; ++i) {
+            pool_.start([&]() {
+                work();
+                done.release();
+            });
+        }
+        work();
+        done.acquire(helpers);
+    }
+
+    const char* name() const noexcept override { return "thread-pool"; }
+
+private:
+    static constexpr qsizetype Chunk = 16;
+
+    QThreadPool pool_;
+};
+
+// ---------------------------------------------------------------------------
+// io_uring
+// ---------------------------------------------------------------------------
+
+int ioUringSetup(unsigned entries, io_uring_params* params)
+{
+    return int(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+int ioUringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags)
+{
+    return int(::syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+int ioUringRegister(int fd, unsigned opcode, const void* arg, unsigned count)
+{
+    return int(::syscall(__NR_io_uring_register, fd, opcode, arg, count));
+}
+
+/**
+ * Every attribute is an openat → read → close chain on a registered
+ * ("direct") file slot, so one io_uring_enter() submits the whole batch
+ * and no file descriptor is ever installed in the process table. Needs
+ * Linux 5.15 for direct openat/close; create() requires a kernel that
+ * reports IORING_FEAT_CQE_SKIP (5.17) as a conservative proxy.
+ */
+class IoUringReader final : public QudevSysattrReader
+{
+public:
+    static std::unique_ptr<IoUringReader> create()
+    {
+        auto reader = std::unique_ptr<IoUringReader>(new IoUringReader);
+        if (!reader->setup()) {
+            return nullptr;
+        }
+        return reader;
+    }
+
+    ~IoUringReader() override
+    {
+        if (sqes_ != MAP_FAILED) {
+            ::munmap(sqes_, sqesSize_);
+        }
+        if (cqRing_ != MAP_FAILED && cqRing_ != sqRing_) {
+            ::munmap(cqRing_, cqRingSize_);
+        }
+        if (sqRing_ != MAP_FAILED) {
+            ::munmap(sqRing_, sqRingSize_);
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+    void read(Request* requests, qsizetype count) override
+    {
+        std::vector<qsizetype> lengths;
+        for (qsizetype begin = 0; begin < count; begin += Slots) {
+            const qsizetype n = qMin<qsizetype>(Slots, count - begin);
+            lengths.assign(size_t(n), -1);
+            if (!submit(requests + begin, n, lengths.data())) {
+                // The ring is unusable; finish the batch the slow way.
+                for (qsizetype i = 0; i < n; ++i) {
+                    readBlocking(requests[begin + i], lengths[size_t(i)]);
+                }
+            }
+            for (qsizetype i = 0; i < n; ++i) {
+                finish(requests[begin + i], lengths[size_t(i)]);
+            }
+        }
+    }
+
+    const char* name() const noexcept override { return "io_uring"; }
+
+private:
+    /// Attributes in flight per submission; one registered file slot each.
+    static constexpr unsigned Slots = 256;
+    /// openat + read + close per attribute.
+    static constexpr unsigned Entries = 1024;
+
+    enum Stage : quint64 { Open, Read, Close };
+
+    IoUringReader() = default;
+
+    bool setup()
+    {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        fd_ = ioUringSetup(Entries, &params);
+        if (fd_ < 0) {
+            return false;
+        }
+        if (!(params.features & IORING_FEAT_SINGLE_MMAP) || !(params.features & IORING_FEAT_CQE_SKIP)) {
+            return false;
+        }
+
+        sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        sqRingSize_ = cqRingSize_ = qMax(sqRingSize_, cqRingSize_);
+
+        sqRing_ = ::mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                         fd_, IORING_OFF_SQ_RING);
+        if (sqRing_ == MAP_FAILED) {
+            return false;
+        }
+        cqRing_ = sqRing_;
+
+        sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = static_cast<io_uring_sqe*>(::mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE,
+                                                  MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES));
+        if (sqes_ == MAP_FAILED) {
+            return false;
+        }
+
+        auto* sq = static_cast<char*>(sqRing_);
+        sqTail_  = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask_  = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+        auto* cq = static_cast<char*>(cqRing_);
+        cqHead_  = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail_  = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask_  = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes_    = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+        // Empty direct-descriptor table for the chains to open into.
+        io_uring_rsrc_register files;
+        std::memset(&files, 0, sizeof(files));
+        files.nr = Slots;
+        files.flags = IORING_RSRC_REGISTER_SPARSE;
+        return ioUringRegister(fd_, IORING_REGISTER_FILES2, &files, sizeof(files)) == 0;
+    }
+
+    io_uring_sqe* push(unsigned& tail, quint64 userData, quint8 opcode, quint8 flags)
+    {
+        const unsigned index = tail & sqMask_;
+        io_uring_sqe* sqe = &sqes_[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = opcode;
+        sqe->flags = flags;
+        sqe->user_data = userData;
+        sqArray_[index] = index;
+        ++tail;
+        return sqe;
+    }
+
+    bool submit(Request* requests, qsizetype count, qsizetype* lengths)
+    {
+        unsigned tail = __atomic_load_n(sqTail_, __ATOMIC_RELAXED);
+
+        for (qsizetype i = 0; i < count; ++i)
+        {
+            Request& r = requests[i];
+            r.error = 0;
+            r.value.resize(MaxValueSize + 1);
+            const unsigned slot = unsigned(i);
+            const quint64 tag = quint64(i) << 2;
+
+            io_uring_sqe* open = push(tail, tag | Open, IORING_OP_OPENAT, IOSQE_IO_LINK);
+            open->fd = AT_FDCWD;
+            open->addr = quint64(reinterpret_cast<quintptr>(r.path.constData()));
+            open->open_flags = OpenFlags & ~O_CLOEXEC;   // rejected for direct descriptors
+            open->file_index = slot + 1;
+
+            // Hard link: the slot is closed even if the read fails.
+            io_uring_sqe* read = push(tail, tag | Read, IORING_OP_READ, IOSQE_FIXED_FILE | IOSQE_IO_HARDLINK);
+            read->fd = int(slot);
+            read->addr = quint64(reinterpret_cast<quintptr>(r.value.data()));
+            read->len = unsigned(r.value.size());
+
+            io_uring_sqe* close = push(tail, tag | Close, IORING_OP_CLOSE, 0);
+            close->file_index = slot + 1;
+        }
+
+        __atomic_store_n(sqTail_, tail, __ATOMIC_RELEASE);
+        submittedNs_ = monotonicNs();
+
+        unsigned toSubmit = unsigned(count) * 3;
+        unsigned pending = toSubmit;
+        while (pending > 0)
+        {
+            // Wake for every completion rather than the whole batch, so
+            // reap() timestamps each chain close to when it finished.
+            const int rc = ioUringEnter(fd_, toSubmit, 1, IORING_ENTER_GETEVENTS);
+            if (rc < 0 && errno != EINTR) {
+                qWarning() << "[QudevSysattrReader] io_uring_enter failed:" << strerror(errno);
+                drain(requests, lengths, pending);
+                return false;
+            }
+            if (rc > 0) {
+                toSubmit -= unsigned(qMin<int>(rc, int(toSubmit)));
+            }
+            pending -= reap(requests, lengths);
+        }
+        return true;
+    }
+
+    /// Consume available completions; returns how many were consumed.
+    unsigned reap(Request* requests, qsizetype* lengths)
+    {
+        unsigned head = __atomic_load_n(cqHead_, __ATOMIC_RELAXED);
+        const unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+        unsigned consumed = 0;
+
+        for (; head != tail; ++head, ++consumed)
+        {
+            const io_uring_cqe& cqe = cqes_[head & cqMask_];
+            const qsizetype i = qsizetype(cqe.user_data >> 2);
+            Request& r = requests[i];
+
+            switch (Stage(cqe.user_data & 3))
+            {
+            case Open:
+                if (cqe.res < 0) {
+                    r.error = -cqe.res;
+                }
+                break;
+            case Read:
+                if (cqe.res >= 0) {
+                    lengths[i] = cqe.res;
+                } else if (r.error == 0) {
+                    r.error = -cqe.res;
+                }
+                break;
+            case Close:
+                // Last of the chain, posted even when open or read failed.
+                r.elapsedNs = monotonicNs() - submittedNs_;
+                break;
+            }
+        }
+
+        __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+        return consumed;
+    }
+
+    /// Wait out whatever the kernel already accepted before giving up on the ring.
+    void drain(Request* requests, qsizetype* lengths, unsigned pending)
+    {
+        for (int spins = 0; pending > 0 && spins < 1000; ++spins) {
+            ioUringEnter(fd_, 0, 1, IORING_ENTER_GETEVENTS);
+            pending -= qMin(pending, reap(requests, lengths));
+        }
+    }
+
+    int fd_ = -1;
+    quint64 submittedNs_ = 0;   // when the batch in flight was submitted
+
+    void* sqRing_ = MAP_FAILED;
+    std::size_t sqRingSize_ = 0;
+    void* cqRing_ = MAP_FAILED;
+    std::size_t cqRingSize_ = 0;
+    io_uring_sqe* sqes_ = static_cast<io_uring_sqe*>(MAP_FAILED);
+    std::size_t sqesSize_ = 0;
+
+    unsigned* sqTail_ = nullptr;
+    unsigned sqMask_ = 0;
+    unsigned* sqArray_ = nullptr;
+
+    unsigned* cqHead_ = nullptr;
+    unsigned* cqTail_ = nullptr;
+    unsigned cqMask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+};
+
+} // namespace
+
+std::unique_ptr<QudevSysattrReader> QudevSysattrReader::create(QudevSysattrReadMode mode)
+{
+    switch (mode)
+    {
+    case QudevSysattrReadMode::Libudev:
+        return nullptr;
+    case QudevSysattrReadMode::IoUring:
+        return IoUringReader::create();
+    case QudevSysattrReadMode::Batched:
+        if (auto reader = IoUringReader::create()) {
+            return reader;
+        }
+        return std::make_unique<ThreadPoolReader>();
+    case QudevSysattrReadMode::ThreadPool:
+        return std::make_unique<ThreadPoolReader>();
+    }
+    return nullptr;
+}
+
+std::unique_ptr<QudevSysattrReader> QudevSysattrReader::createSequential()
+{
+    return std::make_unique<SequentialReader>();
+}
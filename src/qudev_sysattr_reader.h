@@ -0,0 +1,69 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#pragma once
+
+#include <QByteArray>
+
+#include <memory>
+
+#include "qudev_sysattr_policy.h"
+
+/**
+ * @file qudev_sysattr_reader.h
+ * @brief Internal bulk reader of sysfs attribute files.
+ */
+
+/**
+ * @brief Reads many sysfs attribute files with one submission.
+ *
+ * Implementations open, read and close every requested file and return
+ * once all of them completed. Files are opened with @c O_NOFOLLOW, so
+ * symlinked attributes fail with @c ELOOP like libudev's lookup does.
+ * Files longer than @ref MaxValueSize fail with @c EFBIG.
+ *
+ * Not thread-safe; owned by a backend and used from its thread.
+ */
+class QudevSysattrReader
+{
+public:
+    /// Largest value read per attribute; libudev uses the same limit.
+    static constexpr int MaxValueSize = 4096;
+
+    /// One attribute file to read.
+    struct Request
+    {
+        QByteArray path;    ///< Absolute path of the attribute file.
+        QByteArray value;   ///< Value read, newline-stripped like libudev.
+        int error = 0;      ///< 0, or the errno of the failed operation.
+        quint64 elapsedNs = 0; ///< Time taken, where measured per request.
+    };
+
+    /**
+     * @brief Create a reader for @p mode.
+     *
+     * @return The reader, or @c nullptr for @ref QudevSysattrReadMode::Libudev
+     *         and when io_uring was requested but is not available.
+     */
+    static std::unique_ptr<QudevSysattrReader> create(QudevSysattrReadMode mode);
+
+    /// Reader doing one blocking read after another; the reference for the others.
+    static std::unique_ptr<QudevSysattrReader> createSequential();
+
+    virtual ~QudevSysattrReader() = default;
+
+    /// Read @p count requests, filling @c value and @c error of each.
+    virtual void read(Request* requests, qsizetype count) = 0;
+
+    /// Implementation name, for logs and benchmarks.
+    virtual const char* name() const noexcept = 0;
+
+protected:
+    /// Turn @p length raw bytes in @p request's value into libudev's form.
+    static void finish(Request& request, qsizetype length);
+};
@@ -0,0 +1,368 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include "qudev_text_match.h"
+
+#include <QVarLengthArray>
+
+#include <atomic>
+
+#if defined(__SSE2__) && (defined(__GNUC__) || defined(__clang__))
+#  define QUDEV_TEXT_MATCH_X86 1
+#  include <immintrin.h>
+#else
+#  define QUDEV_TEXT_MATCH_X86 0
+#endif
+
+namespace {
+
+using FindFn = bool (*)(const char16_t* h, qsizetype hn, const char16_t* n, qsizetype nn);
+
+constexpr char16_t foldAscii(char16_t c) noexcept
+{
+    return (c >= u'A' && c <= u'Z') ? char16_t(c | 0x20) : c;
+}
+
+bool isAsciiScalar(const char16_t* p, qsizetype n) noexcept
+{
+    char16_t acc = 0;
+    for (qsizetype i = 0; i < n; ++i) {
+        acc |= p[i];
+    }
+    return acc < 0x80;
+}
+
+/// Compare @p len code units of @p h (folded on the fly) against folded @p n.
+bool equalsFolded(const char16_t* h, const char16_t* n, qsizetype len) noexcept
+{
+    for (qsizetype i = 0; i < len; ++i) {
+        if (foldAscii(h[i]) != n[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Scalar search of folded needle @p n in @p h, starting at offset @p from.
+bool findFoldedFrom(const char16_t* h, qsizetype hn, const char16_t* n, qsizetype nn, qsizetype from) noexcept
+{
+    const char16_t first = n[0];
+    for (qsizetype i = from; i + nn <= hn; ++i) {
+        if (foldAscii(h[i]) == first && equalsFolded(h + i + 1, n + 1, nn - 1)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool findFoldedScalar(const char16_t* h, qsizetype hn, const char16_t* n, qsizetype nn) noexcept
+{
+    return findFoldedFrom(h, hn, n, nn, 0);
+}
+
+#if QUDEV_TEXT_MATCH_X86
+
+// The vectorized searches compare the first and the last needle code unit
+// against two shifted haystack blocks at once, and only verify the middle
+// part of the needle for lanes where both ends matched.
+
+inline __m128i foldAscii128(__m128i v) noexcept
+{
+    const __m128i upper = _mm_and_si128(_mm_cmpgt_epi16(v, _mm_set1_epi16('A' - 1)),
+                                        _mm_cmplt_epi16(v, _mm_set1_epi16('Z' + 1)));
+    return _mm_or_si128(v, _mm_and_si128(upper, _mm_set1_epi16(0x20)));
+}
+
+bool isAsciiSse2(const char16_t* p, qsizetype n) noexcept
+{
+    __m128i acc = _mm_setzero_si128();
+    qsizetype i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc = _mm_or_si128(acc, _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i)));
+    }
+
+    const __m128i high = _mm_and_si128(acc, _mm_set1_epi16(static_cast<short>(0xff80)));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi16(high, _mm_setzero_si128())) != 0xffff) {
+        return false;
+    }
+
+    return isAsciiScalar(p + i, n - i);
+}
+
+bool findFoldedSse2(const char16_t* h, qsizetype hn, const char16_t* n, qsizetype nn) noexcept
+{
+    const __m128i first = _mm_set1_epi16(static_cast<short>(n[0]));
+    const __m128i last  = _mm_set1_epi16(static_cast<short>(n[nn - 1]));
+    const qsizetype middle = nn > 2 ? nn - 2 : 0;
+
+    qsizetype i = 0;
+    for (; i + nn - 1 + 8 <= hn; i += 8) {
+        const __m128i blockFirst = foldAscii128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(h + i)));
+        const __m128i blockLast  = foldAscii128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(h + i + nn - 1)));
+        const __m128i eq = _mm_and_si128(_mm_cmpeq_epi16(first, blockFirst),
+                                         _mm_cmpeq_epi16(last, blockLast));
+
+        // Two mask bits per 16-bit lane.
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(eq));
+        while (mask) {
+            const int bit = __builtin_ctz(mask);
+            if (equalsFolded(h + i + bit / 2 + 1, n + 1, middle)) {
+                return true;
+            }
+            mask &= ~(3u << bit);
+        }
+    }
+
+    return findFoldedFrom(h, hn, n, nn, i);
+}
+
+__attribute__((target("avx2")))
+inline __m256i foldAscii256(__m256i v) noexcept
+{
+    const __m256i upper = _mm256_and_si256(_mm256_cmpgt_epi16(v, _mm256_set1_epi16('A' - 1)),
+                                           _mm256_cmpgt_epi16(_mm256_set1_epi16('Z' + 1), v));
+    return _mm256_or_si256(v, _mm256_and_si256(upper, _mm256_set1_epi16(0x20)));
+}
+
+__attribute__((target("avx2")))
+bool findFoldedAvx2(const char16_t* h, qsizetype hn, const char16_t* n, qsizetype nn) noexcept
+{
+    const __m256i first = _mm256_set1_epi16(static_cast<short>(n[0]));
+    const __m256i last  = _mm256_set1_epi16(static_cast<short>(n[nn - 1]));
+    const qsizetype middle = nn > 2 ? nn - 2 : 0;
+
+    qsizetype i = 0;
+    for (; i + nn - 1 + 16 <= hn; i += 16) {
+        const __m256i blockFirst = foldAscii256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(h + i)));
+        const __m256i blockLast  = foldAscii256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(h + i + nn - 1)));
+        const __m256i eq = _mm256_and_si256(_mm256_cmpeq_epi16(first, blockFirst),
+                                            _mm256_cmpeq_epi16(last, blockLast));
+
+        quint32 mask = static_cast<quint32>(_mm256_movemask_epi8(eq));
+        while (mask) {
+            const int bit = __builtin_ctz(mask);
+            if (equalsFolded(h + i + bit / 2 + 1, n + 1, middle)) {
+                return true;
+            }
+            mask &= ~(3u << bit);
+        }
+    }
+
+    return findFoldedFrom(h, hn, n, nn, i);
+}
+
+QudevTextMatchPath bestPath() noexcept
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? QudevTextMatchPath::Avx2 : QudevTextMatchPath::Sse2;
+}
+
+FindFn findFor(QudevTextMatchPath path) noexcept
+{
+    switch (path) {
+    case QudevTextMatchPath::Scalar: return findFoldedScalar;
+    case QudevTextMatchPath::Sse2:   return findFoldedSse2;
+    case QudevTextMatchPath::Avx2:   return bestPath() == QudevTextMatchPath::Avx2 ? findFoldedAvx2 : nullptr;
+    case QudevTextMatchPath::Auto:   break;
+    }
+    return nullptr;
+}
+
+inline bool isAscii(const char16_t* p, qsizetype n) noexcept { return isAsciiSse2(p, n); }
+
+#else
+
+QudevTextMatchPath bestPath() noexcept { return QudevTextMatchPath::Scalar; }
+
+FindFn findFor(QudevTextMatchPath path) noexcept
+{
+    return path == QudevTextMatchPath::Scalar ? findFoldedScalar : nullptr;
+}
+
+inline bool isAscii(const char16_t* p, qsizetype n) noexcept { return isAsciiScalar(p, n); }
+
+#endif
+
+// Resolved once at load time; CPU features do not change at runtime.
+// Only qudevSetTextMatchPath() changes it afterwards, possibly while other
+// threads search, so both are atomic; any path gives the same results.
+std::atomic<QudevTextMatchPath> currentPath{ bestPath() };
+std::atomic<FindFn> findFolded{ findFor(currentPath.load()) };
+
+/// Match the bracket expression at @p p[@p start] against @p c; @c false if unterminated.
+bool matchClass(QStringView p, qsizetype start, QChar c, qsizetype* end, bool* hit) noexcept
+{
+    qsizetype i = start + 1;
+    const bool negate = i < p.size() && (p[i] == QLatin1Char('!') || p[i] == QLatin1Char('^'));
+    i += negate ? 1 : 0;
+
+    // One member character, taken literally after a backslash.
+    const auto take = [&](QChar* out) {
+        if (p[i] == QLatin1Char('\\')) {
+            if (++i == p.size()) {
+                return false;
+            }
+        }
+        *out = p[i++];
+        return true;
+    };
+
+    bool matched = false;
+    for (bool first = true; i < p.size(); first = false)
+    {
+        if (p[i] == QLatin1Char(']') && !first) {
+            *end = i + 1;
+            *hit = matched != negate;
+            return true;
+        }
+        QChar lo;
+        if (!take(&lo)) {
+            return false;
+        }
+        QChar hi = lo;
+        if (i + 1 < p.size() && p[i] == QLatin1Char('-') && p[i + 1] != QLatin1Char(']')) {
+            ++i;
+            if (!take(&hi)) {
+                return false;
+            }
+        }
+        matched = matched || (c >= lo && c <= hi);
+    }
+    return false;
+}
+
+} // namespace
+
+bool qudevSetTextMatchPath(QudevTextMatchPath path) noexcept
+{
+    if (path == QudevTextMatchPath::Auto) {
+        path = bestPath();
+    }
+    const FindFn find = findFor(path);
+    if (!find) {
+        return false;
+    }
+    currentPath.store(path, std::memory_order_relaxed);
+    findFolded.store(find, std::memory_order_relaxed);
+    return true;
+}
+
+QudevTextMatchPath qudevTextMatchPath() noexcept
+{
+    return currentPath.load(std::memory_order_relaxed);
+}
+
+QudevTextMatcher::QudevTextMatcher(const QString& pattern)
+{
+    setPattern(pattern);
+}
+
+void QudevTextMatcher::setPattern(const QString& pattern)
+{
+    const QStringView view(pattern);
+
+    pattern_ = pattern;
+    asciiPattern_ = isAscii(view.utf16(), view.size());
+    // For ASCII input toLower() is exactly the fold used by the fast path.
+    folded_ = asciiPattern_ ? pattern.toLower() : pattern;
+}
+
+bool QudevTextMatcher::matches(QStringView haystack) const noexcept
+{
+    if (pattern_.isEmpty()) {
+        return true;
+    }
+
+    const char16_t* h = haystack.utf16();
+    const qsizetype hn = haystack.size();
+
+    if (!asciiPattern_ || !isAscii(h, hn)) {
+        return haystack.contains(pattern_, Qt::CaseInsensitive);
+    }
+
+    const QStringView n(folded_);
+    if (hn < n.size()) {
+        return false;
+    }
+
+    return findFolded.load(std::memory_order_relaxed)(h, hn, n.utf16(), n.size());
+}
+
+bool qudevContainsCaseInsensitive(QStringView haystack, QStringView needle) noexcept
+{
+    if (needle.isEmpty()) {
+        return true;
+    }
+
+    const char16_t* h = haystack.utf16();
+    const qsizetype hn = haystack.size();
+
+    if (!isAscii(needle.utf16(), needle.size()) || !isAscii(h, hn)) {
+        return haystack.contains(needle, Qt::CaseInsensitive);
+    }
+
+    if (hn < needle.size()) {
+        return false;
+    }
+
+    QVarLengthArray<char16_t, 256> folded(needle.size());
+    for (qsizetype i = 0; i < needle.size(); ++i) {
+        folded[i] = foldAscii(needle.utf16()[i]);
+    }
+
+    return findFolded.load(std::memory_order_relaxed)(h, hn, folded.constData(), folded.size());
+}
+
+bool qudevGlobMatch(QStringView p, QStringView s) noexcept
+{
+    qsizetype pi = 0;
+    qsizetype si = 0;
+    qsizetype starP = -1;
+    qsizetype starS = 0;
+
+    while (si < s.size())
+    {
+        if (pi < p.size()) {
+            const QChar c = p[pi];
+            if (c == QLatin1Char('*')) {
+                starP = pi++;
+                starS = si;
+                continue;
+            }
+            qsizetype next = pi + 1;
+            bool hit;
+            if (c == QLatin1Char('?')) {
+                hit = true;
+            } else if (c == QLatin1Char('\\')) {
+                // The next character is literal; a trailing '\' matches nothing.
+                if (next == p.size()) {
+                    return false;
+                }
+                hit = p[next++] == s[si];
+            } else if (c != QLatin1Char('[') || !matchClass(p, pi, s[si], &next, &hit)) {
+                hit = c == s[si];   // an unterminated '[' is literal
+            }
+            if (hit) {
+                pi = next;
+                ++si;
+                continue;
+            }
+        }
+        // Let the last '*' swallow one more character.
+        if (starP < 0) {
+            return false;
+        }
+        pi = starP + 1;
+        si = ++starS;
+    }
+
+    while (pi < p.size() && p[pi] == QLatin1Char('*')) {
+        ++pi;
+    }
+    return pi == p.size();
+}
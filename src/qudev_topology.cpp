@@ -0,0 +1,381 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include "qudev_topology.h"
+#include "qudev_enumerator.h"
+#include "qudev_monitor.h"
+#include "qudev_trace.h"
+
+#include <qudev_filters.h>
+
+#include <QHash>
+
+#include <vector>
+
+
+namespace {
+
+constexpr qint32 None = -1;
+constexpr qint32 Root = 0;   // path "", above "/sys"
+
+} // namespace
+
+struct QudevTopology::Private
+{
+    // One slot per node; links are slot indices, None if absent.
+    std::vector<qint32> parent;
+    std::vector<qint32> firstChild;
+    std::vector<qint32> lastChild;
+    std::vector<qint32> prevSibling;
+    std::vector<qint32> nextSibling;
+    std::vector<QString> syspath;
+    std::vector<QudevSharedDevice> device;   // null for path-only nodes
+
+    std::vector<qint32> freeSlots;
+    QHash<QString, qint32> bySyspath;
+    qsizetype devices = 0;
+
+    Private() { reset(); }
+
+    void reset();
+    qint32 find(const QString& path) const;
+    qint32 node(const QString& path);
+    void link(qint32 n, qint32 p);
+    void unlink(qint32 n);
+    void release(qint32 n);
+    qint32 deviceAbove(qint32 n) const;
+
+    /// Call @p fn for @p top and every node below it, depth-first.
+    template<typename Fn>
+    bool walk(qint32 top, Fn&& fn) const;
+
+    /// Call @p fn for the devices in the subtree of @p top, depth-first.
+    template<typename Fn>
+    bool walkDevices(qint32 top, bool includeTop, Fn&& fn) const
+    {
+        return walk(top, [&](qint32 n) {
+            return (n == top && !includeTop) || device[size_t(n)].isNull() || fn(device[size_t(n)]);
+        });
+    }
+};
+
+void QudevTopology::Private::reset()
+{
+    parent.assign(1, None);
+    firstChild.assign(1, None);
+    lastChild.assign(1, None);
+    prevSibling.assign(1, None);
+    nextSibling.assign(1, None);
+    syspath.assign(1, QString());
+    device.assign(1, QudevSharedDevice());
+    freeSlots.clear();
+    bySyspath.clear();
+    devices = 0;
+}
+
+qint32 QudevTopology::Private::find(const QString& path) const
+{
+    return bySyspath.value(path, None);
+}
+
+qint32 QudevTopology::Private::node(const QString& path)
+{
+    if (const qint32 n = find(path); n != None) {
+        return n;
+    }
+
+    const qsizetype slash = path.lastIndexOf(QLatin1Char('/'));
+    const qint32 p = slash > 0 ? node(path.left(slash)) : Root;
+
+    qint32 n;
+    if (!freeSlots.empty()) {
+        n = freeSlots.back();
+        freeSlots.pop_back();
+        syspath[size_t(n)] = path;
+    } else {
+        n = qint32(syspath.size());
+        parent.push_back(None);
+        firstChild.push_back(None);
+        lastChild.push_back(None);
+        prevSibling.push_back(None);
+        nextSibling.push_back(None);
+        syspath.push_back(path);
+        device.emplace_back();
+    }
+    bySyspath.insert(path, n);
+    link(n, p);
+    return n;
+}
+
+void QudevTopology::Private::link(qint32 n, qint32 p)
+{
+    const size_t i = size_t(n);
+    parent[i] = p;
+    prevSibling[i] = lastChild[size_t(p)];
+    nextSibling[i] = None;
+    if (lastChild[size_t(p)] != None) {
+        nextSibling[size_t(lastChild[size_t(p)])] = n;
+    } else {
+        firstChild[size_t(p)] = n;
+    }
+    lastChild[size_t(p)] = n;
+}
+
+void QudevTopology::Private::unlink(qint32 n)
+{
+    const size_t i = size_t(n);
+    const size_t p = size_t(parent[i]);
+    if (prevSibling[i] != None) {
+        nextSibling[size_t(prevSibling[i])] = nextSibling[i];
+    } else {
+        firstChild[p] = nextSibling[i];
+    }
+    if (nextSibling[i] != None) {
+        prevSibling[size_t(nextSibling[i])] = prevSibling[i];
+    } else {
+        lastChild[p] = prevSibling[i];
+    }
+    parent[i] = prevSibling[i] = nextSibling[i] = None;
+}
+
+void QudevTopology::Private::release(qint32 n)
+{
+    // Drop path-only nodes left without anything below them.
+    while (n != Root && device[size_t(n)].isNull() && firstChild[size_t(n)] == None) {
+        const qint32 p = parent[size_t(n)];
+        unlink(n);
+        bySyspath.remove(syspath[size_t(n)]);
+        syspath[size_t(n)].clear();
+        freeSlots.push_back(n);
+        n = p;
+    }
+}
+
+qint32 QudevTopology::Private::deviceAbove(qint32 n) const
+{
+    for (n = parent[size_t(n)]; n != None && n != Root; n = parent[size_t(n)]) {
+        if (!device[size_t(n)].isNull()) {
+            return n;
+        }
+    }
+    return None;
+}
+
+template<typename Fn>
+bool QudevTopology::Private::walk(qint32 top, Fn&& fn) const
+{
+    // Iterative pre-order over the links: no stack, no recursion.
+    qint32 n = top;
+    for (;;)
+    {
+        if (!fn(n)) {
+            return false;
+        }
+        if (firstChild[size_t(n)] != None) {
+            n = firstChild[size_t(n)];
+            continue;
+        }
+        while (n != top && nextSibling[size_t(n)] == None) {
+            n = parent[size_t(n)];
+        }
+        if (n == top) {
+            return true;
+        }
+        n = nextSibling[size_t(n)];
+    }
+}
+
+QudevTopology::QudevTopology()
+    : d_{std::make_unique<Private>()}
+{
+}
+
+QudevTopology::~QudevTopology() = default;
+
+void QudevTopology::clear()
+{
+    d_->reset();
+}
+
+bool QudevTopology::insert(const QudevSharedDevice& device)
+{
+    if (device->syspath.isEmpty()) {
+        return false;
+    }
+
+    const qint32 n = d_->node(device->syspath);
+    if (d_->device[size_t(n)].isNull()) {
+        ++d_->devices;
+    }
+    d_->device[size_t(n)] = device;
+    return true;
+}
+
+bool QudevTopology::remove(const QString& syspath)
+{
+    const qint32 n = d_->find(syspath);
+    if (n == None || d_->device[size_t(n)].isNull()) {
+        return false;
+    }
+
+    d_->device[size_t(n)] = QudevSharedDevice();
+    --d_->devices;
+    d_->release(n);
+    return true;
+}
+
+void QudevTopology::apply(const QudevSharedDevice& event)
+{
+    if (event->action == QLatin1String("remove")) {
+        remove(event->syspath);
+        return;
+    }
+    if (event->action == QLatin1String("move")) {
+        remove(QStringLiteral("/sys") + event->properties.value(QStringLiteral("DEVPATH_OLD")));
+    }
+    insert(event);
+}
+
+qsizetype QudevTopology::size() const noexcept
+{
+    return d_->devices;
+}
+
+bool QudevTopology::contains(const QString& syspath) const
+{
+    const qint32 n = d_->find(syspath);
+    return n != None && !d_->device[size_t(n)].isNull();
+}
+
+QudevSharedDevice QudevTopology::device(const QString& syspath) const
+{
+    const qint32 n = d_->find(syspath);
+    return n != None ? d_->device[size_t(n)] : QudevSharedDevice();
+}
+
+QudevSharedDevice QudevTopology::parent(const QString& syspath) const
+{
+    const qint32 n = d_->find(syspath);
+    const qint32 p = n != None ? d_->deviceAbove(n) : None;
+    return p != None ? d_->device[size_t(p)] : QudevSharedDevice();
+}
+
+QList<QudevSharedDevice> QudevTopology::ancestors(const QString& syspath) const
+{
+    QList<QudevSharedDevice> out;
+    qint32 n = d_->find(syspath);
+    while (n != None && (n = d_->deviceAbove(n)) != None) {
+        out << d_->device[size_t(n)];
+    }
+    return out;
+}
+
+QList<QudevSharedDevice> QudevTopology::children(const QString& syspath) const
+{
+    QList<QudevSharedDevice> out;
+    const qint32 top = d_->find(syspath);
+    if (top == None) {
+        return out;
+    }
+
+    // Through path-only nodes, but not into the devices' own subtrees.
+    for (qint32 c = d_->firstChild[size_t(top)]; c != None;)
+    {
+        if (!d_->device[size_t(c)].isNull()) {
+            out << d_->device[size_t(c)];
+        } else if (d_->firstChild[size_t(c)] != None) {
+            c = d_->firstChild[size_t(c)];
+            continue;
+        }
+        while (c != top && d_->nextSibling[size_t(c)] == None) {
+            c = d_->parent[size_t(c)];
+        }
+        c = c != top ? d_->nextSibling[size_t(c)] : None;
+    }
+    return out;
+}
+
+QList<QudevSharedDevice> QudevTopology::descendants(const QString& syspath) const
+{
+    QList<QudevSharedDevice> out;
+    if (const qint32 top = d_->find(syspath); top != None) {
+        d_->walkDevices(top, false, [&](const QudevSharedDevice& d) {
+            out << d;
+            return true;
+        });
+    }
+    return out;
+}
+
+QList<QudevSharedDevice> QudevTopology::subtree(const QString& syspath, const QudevFilters& filters) const
+{
+    QList<QudevSharedDevice> out;
+    if (const qint32 top = d_->find(syspath); top != None) {
+        d_->walkDevices(top, true, [&](const QudevSharedDevice& d) {
+            if (QudevEnumerator::matches(d, filters)) {
+                out << d;
+            }
+            return true;
+        });
+    }
+    return out;
+}
+
+QList<QudevSharedDevice> QudevTopology::devices() const
+{
+    QList<QudevSharedDevice> out;
+    out.reserve(d_->devices);
+    d_->walkDevices(Root, false, [&](const QudevSharedDevice& d) {
+        out << d;
+        return true;
+    });
+    return out;
+}
+
+bool QudevTopology::visitPrefix(const QString& prefix, const Visitor& visit) const
+{
+    QUDEV_TRACE_SCOPE("qudev", "topology.prefix");
+
+    if (prefix.isEmpty()) {
+        return d_->walkDevices(Root, false, visit);
+    }
+
+    // Any path starting with "<dir>/<partial name>" lies below a child of
+    // <dir> whose name starts with the partial name, as every path prefix
+    // has its node. So only the children of <dir> are compared.
+    const qsizetype slash = prefix.lastIndexOf(QLatin1Char('/'));
+    const qint32 dir = slash > 0 ? d_->find(prefix.left(slash)) : Root;
+    if (dir == None) {
+        return true;
+    }
+
+    for (qint32 c = d_->firstChild[size_t(dir)]; c != None; c = d_->nextSibling[size_t(c)]) {
+        if (d_->syspath[size_t(c)].startsWith(prefix) && !d_->walkDevices(c, true, visit)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+QList<QudevSharedDevice> QudevTopology::select(const QudevFilters& filters) const
+{
+    QUDEV_TRACE_SCOPE("qudev", "topology.select");
+
+    // The walk already guarantees the prefix.
+    QudevFilters rest = filters;
+    rest.syspathPrefix.clear();
+
+    QList<QudevSharedDevice> out;
+    visitPrefix(filters.syspathPrefix, [&](const QudevSharedDevice& d) {
+        if (QudevMonitor::applyPostFilters(d, rest)) {
+            out << d;
+        }
+        return true;
+    });
+    return out;
+}
@@ -0,0 +1,222 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include "qudev_trace.h"
+
+#include <QDebug>
+#include <QSaveFile>
+
+#include <cstdlib>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+
+std::atomic<bool> QudevTrace::enabled_{false};
+
+namespace {
+
+struct Span
+{
+    const char* category;
+    const char* name;
+    quint64 beginNs;
+    quint64 endNs;
+    const char* argKey;
+    QByteArray argValue;
+};
+
+/// Spans of one thread. The owning thread appends; stop() drains.
+struct ThreadBuffer
+{
+    std::mutex mutex;   // uncontended except while stopping
+    std::vector<Span> spans;
+    long tid = 0;
+    quint64 session = 0;
+};
+
+struct Registry
+{
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    QString path;
+    std::atomic<quint64> session{0};
+};
+
+Registry& registry()
+{
+    static Registry r;
+    return r;
+}
+
+ThreadBuffer& threadBuffer()
+{
+    // Buffers outlive their threads, so spans of finished threads are kept.
+    thread_local std::shared_ptr<ThreadBuffer> buffer = []() {
+        auto b = std::make_shared<ThreadBuffer>();
+        b->tid = long(::syscall(SYS_gettid));
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.buffers.push_back(b);
+        return b;
+    }();
+    return *buffer;
+}
+
+void appendJsonString(QByteArray& out, const char* s)
+{
+    out.append('"');
+    for (; *s; ++s) {
+        const char c = *s;
+        if (c == '"' || c == '\\') {
+            out.append('\\').append(c);
+        } else if (uchar(c) < 0x20) {
+            out.append("\\u00").append(QByteArray::number(uchar(c), 16).rightJustified(2, '0'));
+        } else {
+            out.append(c);
+        }
+    }
+    out.append('"');
+}
+
+void appendMicros(QByteArray& out, quint64 ns)
+{
+    out.append(QByteArray::number(ns / 1000)).append('.')
+       .append(QByteArray::number(ns % 1000).rightJustified(3, '0'));
+}
+
+} // namespace
+
+quint64 QudevTrace::nowNs() noexcept
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return quint64(ts.tv_sec) * 1000000000ull + quint64(ts.tv_nsec);
+}
+
+bool QudevTrace::start(const QString& path)
+{
+#ifdef QUDEV_NO_TRACING
+    Q_UNUSED(path);
+    return false;
+#else
+    Registry& r = registry();
+    {
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.path = path;
+        ++r.session;
+    }
+
+    enabled_.store(true, std::memory_order_relaxed);
+    return true;
+#endif
+}
+
+void QudevTrace::record(const char* category, const char* name, quint64 beginNs, quint64 endNs,
+                        const char* argKey, QByteArray&& argValue)
+{
+    ThreadBuffer& b = threadBuffer();
+    const quint64 session = registry().session.load(std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(b.mutex);
+    if (b.session != session) {
+        // Leftovers from an earlier session.
+        b.spans.clear();
+        b.session = session;
+    }
+    b.spans.push_back({ category, name, beginNs, endNs, argKey, std::move(argValue) });
+}
+
+bool QudevTrace::stop()
+{
+    if (!enabled_.exchange(false)) {
+        return false;
+    }
+
+    Registry& r = registry();
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    QString path;
+    quint64 session;
+    {
+        std::lock_guard<std::mutex> lock(r.mutex);
+        buffers = r.buffers;
+        path = r.path;
+        session = r.session.load(std::memory_order_relaxed);
+    }
+
+    const QByteArray pid = QByteArray::number(qint64(::getpid()));
+
+    QByteArray out;
+    out.reserve(1 << 20);
+    out.append("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+
+    bool first = true;
+    for (const auto& b : buffers)
+    {
+        std::vector<Span> spans;
+        {
+            std::lock_guard<std::mutex> lock(b->mutex);
+            if (b->session == session) {
+                spans.swap(b->spans);
+            }
+        }
+
+        const QByteArray tid = QByteArray::number(qint64(b->tid));
+        for (const Span& s : spans)
+        {
+            out.append(first ? "\n" : ",\n");
+            first = false;
+
+            out.append("{\"ph\":\"X\",\"pid\":").append(pid).append(",\"tid\":").append(tid);
+            out.append(",\"cat\":");
+            appendJsonString(out, s.category);
+            out.append(",\"name\":");
+            appendJsonString(out, s.name);
+            out.append(",\"ts\":");
+            appendMicros(out, s.beginNs);
+            out.append(",\"dur\":");
+            appendMicros(out, s.endNs - s.beginNs);
+            if (s.argKey) {
+                out.append(",\"args\":{");
+                appendJsonString(out, s.argKey);
+                out.append(':');
+                appendJsonString(out, s.argValue.constData());
+                out.append('}');
+            }
+            out.append('}');
+        }
+    }
+    out.append("\n]}\n");
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(out) != out.size() || !file.commit()) {
+        qWarning() << "[QudevTrace] Failed to write" << path << ":" << file.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+void QudevTrace::startFromEnvironment()
+{
+#ifndef QUDEV_NO_TRACING
+    static const bool started = []() {
+        const QString path = qEnvironmentVariable("QUDEV_TRACE");
+        if (path.isEmpty() || !start(path)) {
+            return false;
+        }
+        std::atexit([]() { stop(); });
+        return true;
+    }();
+    Q_UNUSED(started);
+#endif
+}
@@ -0,0 +1,408 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include <QTest>
+#include <QFileInfo>
+#include <QSemaphore>
+#include <QRegularExpression>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QThread>
+
+#include <qudev.h>
+#include <qudev_broker.h>
+#include <qudev_broker_backend.h>
+#include <qudev_device.h>
+#include <qudev_memory_backend.h>
+#include <qudev_shared_snapshot.h>
+
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+
+/// Runs a broker over synthetic devices on its own event loop, as qudevd would.
+class BrokerThread : public QThread
+{
+public:
+    BrokerThread(const QString& path, int devices)
+        : path_(path), devices_(devices)
+    {}
+
+    ~BrokerThread() override
+    {
+        quit();
+        wait();
+    }
+
+    bool startAndWait()
+    {
+        start();
+        ready_.acquire();
+        return listening_;
+    }
+
+    /// Thread-safe for inject().
+    QudevMemoryBackend* backend() const { return backend_; }
+
+protected:
+    void run() override
+    {
+        auto owned = std::make_unique<QudevMemoryBackend>(QudevMemoryBackend::Options{ devices_ });
+        backend_ = owned.get();
+
+        QudevBroker broker(std::move(owned));
+        listening_ = broker.setSharedSnapshotEnabled(true) && broker.listen(path_);
+        ready_.release();
+        if (listening_) {
+            exec();
+        }
+    }
+
+private:
+    QString path_;
+    int devices_;
+    QudevMemoryBackend* backend_ = nullptr;
+    bool listening_ = false;
+    QSemaphore ready_;
+};
+
+class TestBroker : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void enumeratesSnapshot();
+    void forwardsMatchingEvents();
+    void tracksDeviceChanges();
+    void switchesFiltersInPlace();
+    void unreachableBroker();
+    void refusesLiveSocket();
+    void setsSocketAccess();
+    void dropsOversizedRequests();
+    void sharesSnapshotMemory();
+    void resumesFromSeqnum();
+    void reconnectsAfterRestart();
+
+private:
+    static QudevDevice event(const QudevDevice& device, const QString& action);
+
+    QTemporaryDir dir_;
+    QString path_;
+    std::unique_ptr<BrokerThread> broker_;
+};
+
+void TestBroker::init()
+{
+    QVERIFY(dir_.isValid());
+    path_ = dir_.filePath(QStringLiteral("qudevd.sock"));
+    broker_ = std::make_unique<BrokerThread>(path_, 200);
+    QVERIFY(broker_->startAndWait());
+}
+
+void TestBroker::cleanup()
+{
+    broker_.reset();
+}
+
+QudevDevice TestBroker::event(const QudevDevice& device, const QString& action)
+{
+    QudevDevice e = device;
+    e.action = action;
+    e.seqnum = 0;
+    return e;
+}
+
+void TestBroker::enumeratesSnapshot()
+{
+    Qudev qudev(std::make_unique<QudevBrokerBackend>(path_));
+    QCOMPARE(qudev.enumerate().size(), broker_->backend()->devices().size());
+
+    QudevFilters filters;
+    filters.subsystem = QStringLiteral("block");
+    qudev.setFilters(filters);
+
+    QStringList expected;
+    for (const auto& d : broker_->backend()->devices()) {
+        if (d.subsystem == filters.subsystem) {
+            expected << d.syspath;
+        }
+    }
+    QStringList actual;
+    for (const auto& d : qudev.enumerate()) {
+        QCOMPARE(d.subsystem, filters.subsystem);
+        QVERIFY(!d.properties.isEmpty());
+        actual << d.syspath;
+    }
+    expected.sort();
+    actual.sort();
+    QVERIFY(!expected.isEmpty());
+    QCOMPARE(actual, expected);
+
+    // Matched as a libudev scan: globs, and actions ignored.
+    filters.subsystem = QStringLiteral("bl?c*");
+    filters.actions << QStringLiteral("add");
+    qudev.setFilters(filters);
+    actual.clear();
+    for (const auto& d : qudev.enumerate()) {
+        actual << d.syspath;
+    }
+    actual.sort();
+    QCOMPARE(actual, expected);
+}
+
+void TestBroker::forwardsMatchingEvents()
+{
+    Qudev qudev(std::make_unique<QudevBrokerBackend>(path_));
+    QudevFilters filters;
+    filters.subsystem = QStringLiteral("block");
+    qudev.setFilters(filters);
+
+    // Two clients: one filtered, one taking everything.
+    Qudev all(std::make_unique<QudevBrokerBackend>(path_));
+
+    QSignalSpy spy(&qudev, &Qudev::deviceFound);
+    QSignalSpy allSpy(&all, &Qudev::deviceFound);
+    QVERIFY(qudev.startMonitoring());
+    QVERIFY(all.startMonitoring());
+    QTest::qWait(50);   // subscriptions reach the broker
+
+    int expected = 0;
+    const auto devices = broker_->backend()->devices();
+    for (const auto& d : devices) {
+        broker_->backend()->inject(event(d, QStringLiteral("change")));
+        expected += d.subsystem == QLatin1String("block") ? 1 : 0;
+    }
+
+    QTRY_COMPARE(spy.size(), expected);
+    QTRY_COMPARE(allSpy.size(), devices.size());
+    for (const auto& args : spy) {
+        const auto d = args.first().value<QudevDevice>();
+        QCOMPARE(d.subsystem, QStringLiteral("block"));
+        QCOMPARE(d.action, QStringLiteral("change"));
+        QVERIFY(d.seqnum != 0);
+    }
+}
+
+void TestBroker::tracksDeviceChanges()
+{
+    Qudev qudev(std::make_unique<QudevBrokerBackend>(path_));
+    const qsizetype before = qudev.enumerate().size();
+
+    QudevDevice added = broker_->backend()->devices().first();
+    added.syspath += QStringLiteral("/hotplugged");
+    added.properties.insert(QStringLiteral("ID_TEST"), QStringLiteral("1"));
+    broker_->backend()->inject(event(added, QStringLiteral("add")));
+    QTRY_COMPARE(qudev.enumerate().size(), before + 1);
+
+    QudevFilters filters;
+    filters.properties.insert(QStringLiteral("ID_TEST"), QStringLiteral("1"));
+    qudev.setFilters(filters);
+    const QList<QudevDevice> found = qudev.enumerate();
+    QCOMPARE(found.size(), qsizetype(1));
+    QCOMPARE(found.first().syspath, added.syspath);
+    QVERIFY(found.first().action.isEmpty());
+
+    broker_->backend()->inject(event(added, QStringLiteral("remove")));
+    QTRY_VERIFY(qudev.enumerate().isEmpty());
+}
+
+void TestBroker::switchesFiltersInPlace()
+{
+    Qudev qudev(std::make_unique<QudevBrokerBackend>(path_));
+    QudevFilters filters;
+    filters.subsystem = QStringLiteral("block");
+    qudev.setFilters(filters);
+
+    QSignalSpy spy(&qudev, &Qudev::deviceFound);
+    QVERIFY(qudev.startMonitoring());
+
+    filters.subsystem = QStringLiteral("tty");
+    qudev.setFilters(filters);
+    QTest::qWait(50);
+
+    int expected = 0;
+    for (const auto& d : broker_->backend()->devices()) {
+        broker_->backend()->inject(event(d, QStringLiteral("change")));
+        expected += d.subsystem == QLatin1String("tty") ? 1 : 0;
+    }
+
+    QTRY_COMPARE(spy.size(), expected);
+    for (const auto& args : spy) {
+        QCOMPARE(args.first().value<QudevDevice>().subsystem, QStringLiteral("tty"));
+    }
+}
+
+void TestBroker::unreachableBroker()
+{
+    QudevBrokerBackend backend(dir_.filePath(QStringLiteral("nobody.sock")));
+    QVERIFY(!backend.isReachable());
+
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression(QStringLiteral("Cannot connect")));
+    QVERIFY(!backend.enumerate({}, [](QudevDevice&&) { return true; }));
+}
+
+void TestBroker::refusesLiveSocket()
+{
+    QudevBroker second(std::make_unique<QudevMemoryBackend>(QudevMemoryBackend::Options{ 10 }));
+    QVERIFY(!second.listen(path_));
+    QVERIFY(!second.errorString().isEmpty());
+
+    // The first broker still serves.
+    QVERIFY(QudevBrokerBackend(path_).isReachable());
+}
+
+void TestBroker::setsSocketAccess()
+{
+    const QString path = dir_.filePath(QStringLiteral("private.sock"));
+    QudevBroker broker(std::make_unique<QudevMemoryBackend>(QudevMemoryBackend::Options{ 10 }));
+    QCOMPARE(broker.socketMode(), 0660u);
+
+    broker.setSocketGroup(QStringLiteral("no-such-group-qudev"));
+    QVERIFY(!broker.listen(path));
+    QVERIFY(broker.errorString().contains(QStringLiteral("no-such-group-qudev")));
+    QVERIFY(!QFileInfo::exists(path));
+
+    // Our own group, by number; the mode is applied whatever the umask.
+    broker.setSocketGroup(QString::number(::getegid()));
+    broker.setSocketMode(0600);
+    QVERIFY(broker.listen(path));
+    struct stat st{};
+    QCOMPARE(::stat(QFile::encodeName(path).constData(), &st), 0);
+    QCOMPARE(uint(st.st_mode & 0777), 0600u);
+    QCOMPARE(st.st_gid, ::getegid());
+    broker.close();
+}
+
+void TestBroker::dropsOversizedRequests()
+{
+    const QByteArray native = QFile::encodeName(path_);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, native.constData(), size_t(native.size()));
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    QVERIFY(fd >= 0);
+    QCOMPARE(::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)), 0);
+    const timeval timeout{ 5, 0 };
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    // The header of a 1 MiB Enumerate is enough to be dropped.
+    const char header[] = { 0, 0, 0x10, 0, 1 };
+    QCOMPARE(::send(fd, header, sizeof(header), MSG_NOSIGNAL), ssize_t(sizeof(header)));
+    char byte;
+    QCOMPARE(::recv(fd, &byte, 1, 0), ssize_t(0));
+    ::close(fd);
+
+    // Other clients are still served.
+    QVERIFY(QudevBrokerBackend(path_).isReachable());
+}
+
+void TestBroker::sharesSnapshotMemory()
+{
+    auto shared = QudevSharedSnapshotReader::fromBroker(path_);
+    QVERIFY(shared);
+
+    qsizetype count = 0;
+    const quint64 generation = shared->read([&](const QudevSnapshotReader& snapshot) {
+        count = snapshot.deviceCount();
+    });
+    QVERIFY(generation > 0);
+    QCOMPARE(count, broker_->backend()->devices().size());
+
+    // Events reach the mapping without another request.
+    QudevDevice added = broker_->backend()->devices().first();
+    added.syspath += QStringLiteral("/hotplugged");
+    broker_->backend()->inject(event(added, QStringLiteral("add")));
+    QTRY_VERIFY(shared->generation() > generation);
+
+    const QByteArray syspath = added.syspath.toUtf8();
+    bool found = false;
+    shared->read([&](const QudevSnapshotReader& snapshot) {
+        count = snapshot.deviceCount();
+        found = false;
+        for (qsizetype i = 0; i < count; ++i) {
+            found = found || snapshot.device(i).syspath() == QUtf8StringView(syspath);
+        }
+    });
+    QCOMPARE(count, broker_->backend()->devices().size() + 1);
+    QVERIFY(found);
+}
+
+void TestBroker::resumesFromSeqnum()
+{
+    Qudev live(std::make_unique<QudevBrokerBackend>(path_));
+    QSignalSpy liveSpy(&live, &Qudev::deviceFound);
+    QVERIFY(live.startMonitoring());
+    QTest::qWait(50);
+
+    const auto devices = broker_->backend()->devices().first(10);
+    for (const auto& d : devices) {
+        broker_->backend()->inject(event(d, QStringLiteral("change")));
+    }
+    QTRY_COMPARE(liveSpy.size(), devices.size());
+    const quint64 seen = liveSpy.at(4).first().value<QudevDevice>().seqnum;
+
+    // A client that stopped after the fifth event gets exactly the rest.
+    Qudev resumed(std::make_unique<QudevBrokerBackend>(path_));
+    QSignalSpy spy(&resumed, &Qudev::deviceFound);
+    QSignalSpy rescan(&resumed, &Qudev::rescanRequired);
+    QVERIFY(resumed.resumeMonitoring(seen));
+    QTRY_COMPARE(spy.size(), qsizetype(5));
+    for (qsizetype i = 0; i < spy.size(); ++i) {
+        QCOMPARE(spy.at(i).first().value<QudevDevice>().seqnum, seen + quint64(i) + 1);
+    }
+    QCOMPARE(rescan.size(), 0);
+
+    // Live events follow the replayed ones.
+    broker_->backend()->inject(event(devices.first(), QStringLiteral("change")));
+    QTRY_COMPARE(spy.size(), qsizetype(6));
+
+    // Seqnums the journal never saw cannot be caught up on.
+    Qudev unknown(std::make_unique<QudevBrokerBackend>(path_));
+    QSignalSpy unknownRescan(&unknown, &Qudev::rescanRequired);
+    QVERIFY(unknown.resumeMonitoring(seen + 1000));
+    QCOMPARE(unknownRescan.size(), 1);
+}
+
+void TestBroker::reconnectsAfterRestart()
+{
+    Qudev qudev(std::make_unique<QudevBrokerBackend>(path_));
+    QSignalSpy spy(&qudev, &Qudev::deviceFound);
+    QVERIFY(qudev.startMonitoring());
+    QTest::qWait(50);
+
+    const QudevDevice device = broker_->backend()->devices().first();
+    broker_->backend()->inject(event(device, QStringLiteral("change")));
+    QTRY_COMPARE(spy.size(), qsizetype(1));
+
+    // Broker goes away; the monitor keeps retrying meanwhile.
+    broker_.reset();
+    QTest::qWait(300);
+
+    broker_ = std::make_unique<BrokerThread>(path_, 200);
+    QVERIFY(broker_->startAndWait());
+
+    // Events injected before the client is back are not delivered to it,
+    // so keep injecting until one arrives.
+    QTRY_VERIFY_WITH_TIMEOUT((broker_->backend()->inject(event(device, QStringLiteral("change"))),
+                              spy.size() > 1), 10000);
+    for (const auto& args : spy) {
+        const auto d = args.first().value<QudevDevice>();
+        QCOMPARE(d.syspath, device.syspath);
+        QCOMPARE(d.action, QStringLiteral("change"));
+    }
+}
+
+QTEST_GUILESS_MAIN(TestBroker)
+
+#include "test_broker.moc"
@@ -0,0 +1,182 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include <QTest>
+#include <QSet>
+#include <QSignalSpy>
+
+#include "qudev_device_model.h"
+
+#include <qudev_memory_backend.h>
+
+
+// Progressive population of the viewer's device model: queued devices are
+// inserted in budgeted slices from the event loop.
+class TestDeviceModel : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void insertsInBatches();
+    void boundsEachSlice();
+    void keepsArrivalOrder();
+    void reportsAfterDraining();
+    void beginDropsQueued();
+
+private:
+    static QList<QudevSharedDevice> shared(QList<QudevDevice> devices);
+    static int deviceCount(const QudevDeviceModel& model);
+    static QStringList syspaths(const QudevDeviceModel& model, const QString& subsystem);
+};
+
+QList<QudevSharedDevice> TestDeviceModel::shared(QList<QudevDevice> devices)
+{
+    QList<QudevSharedDevice> out;
+    out.reserve(devices.size());
+    for (QudevDevice& d : devices) {
+        out.append(QudevSharedDevice(std::move(d)));
+    }
+    return out;
+}
+
+int TestDeviceModel::deviceCount(const QudevDeviceModel& model)
+{
+    int devices = 0;
+    for (int r = 0; r < model.rowCount(); ++r) {
+        devices += model.rowCount(model.index(r, 0, {}));
+    }
+    return devices;
+}
+
+QStringList TestDeviceModel::syspaths(const QudevDeviceModel& model, const QString& subsystem)
+{
+    QStringList out;
+    const QudevDeviceModel::Node* sub = model.subsystems_.value(subsystem);
+    for (const QudevDeviceModel::Node* n : sub ? sub->children : QVector<QudevDeviceModel::Node*>{}) {
+        out << n->device->syspath;
+    }
+    return out;
+}
+
+void TestDeviceModel::insertsInBatches()
+{
+    const QList<QudevDevice> devices = QudevMemoryBackend::generateDevices(300);
+    QSet<QString> subsystems;
+    for (const QudevDevice& d : devices) {
+        subsystems.insert(d.subsystem);
+    }
+
+    QudevDeviceModel model;
+    model.setFrameBudget(60000);
+    QSignalSpy inserted(&model, &QAbstractItemModel::rowsInserted);
+
+    // Nothing is inserted until the event loop runs.
+    model.appendDevices(shared(devices));
+    QCOMPARE(model.rowCount(), 0);
+
+    // New subsystems are filled while detached: one notification for all.
+    model.drainPending();
+    QCOMPARE(deviceCount(model), int(devices.size()));
+    QCOMPARE(model.rowCount(), int(subsystems.size()));
+    QCOMPARE(inserted.count(), 1);
+
+    // Known subsystems get one notification each per slice.
+    inserted.clear();
+    model.appendDevices(shared(devices));
+    model.drainPending();
+    QCOMPARE(deviceCount(model), 2 * int(devices.size()));
+    QCOMPARE(inserted.count(), int(subsystems.size()));
+    QVERIFY(model.pending_.isEmpty());
+    QVERIFY(!model.insertTimer_.isActive());
+}
+
+void TestDeviceModel::boundsEachSlice()
+{
+    const QList<QudevDevice> devices = QudevMemoryBackend::generateDevices(20000);
+
+    QudevDeviceModel model;
+    model.setFrameBudget(1);
+    model.appendDevices(shared(devices));
+
+    // Building 20000 devices takes far longer than 1 ms: the slice stops
+    // early, having inserted at least one device, and stays scheduled.
+    model.drainPending();
+    const int first = deviceCount(model);
+    QVERIFY(first > 0);
+    QVERIFY(first < devices.size());
+    QCOMPARE(model.pending_.size(), devices.size() - first);
+    QVERIFY(model.insertTimer_.isActive());
+
+    QTRY_COMPARE_WITH_TIMEOUT(deviceCount(model), int(devices.size()), 60000);
+    QVERIFY(!model.insertTimer_.isActive());
+}
+
+void TestDeviceModel::keepsArrivalOrder()
+{
+    const QList<QudevDevice> devices = QudevMemoryBackend::generateDevices(2000);
+
+    QudevDeviceModel model;
+    model.setFrameBudget(1);
+    for (qsizetype i = 0; i < devices.size(); i += 100) {
+        model.appendDevices(shared(devices.mid(i, 100)));
+    }
+    QTRY_COMPARE_WITH_TIMEOUT(deviceCount(model), int(devices.size()), 60000);
+
+    QStringList expected;
+    for (const QudevDevice& d : devices) {
+        if (d.subsystem == QLatin1String("tty")) {
+            expected << d.syspath;
+        }
+    }
+    QVERIFY(!expected.isEmpty());
+    QCOMPARE(syspaths(model, QStringLiteral("tty")), expected);
+}
+
+void TestDeviceModel::reportsAfterDraining()
+{
+    QudevDeviceModel model;
+    model.setFrameBudget(60000);
+    QSignalSpy stats(&model, &QudevDeviceModel::populationStatsChanged);
+
+    model.beginPopulation();
+    QCOMPARE(stats.count(), 1);
+    QCOMPARE(model.timeToFirstRowMs(), -1.0);
+
+    // Ending with rows still queued reports only once they are in.
+    model.appendDevices(shared(QudevMemoryBackend::generateDevices(100)));
+    model.endPopulation();
+    QCOMPARE(stats.count(), 1);
+
+    QTRY_COMPARE(stats.count(), 2);
+    QCOMPARE(deviceCount(model), 100);
+    QVERIFY(model.timeToFirstRowMs() >= 0);
+    QVERIFY(model.maxStallMs() > 0);
+
+    // Ending with nothing queued reports at once.
+    model.beginPopulation();
+    model.endPopulation();
+    QCOMPARE(stats.count(), 4);
+    QCOMPARE(model.timeToFirstRowMs(), -1.0);
+}
+
+void TestDeviceModel::beginDropsQueued()
+{
+    QudevDeviceModel model;
+    model.appendDevices(shared(QudevMemoryBackend::generateDevices(100)));
+    model.beginPopulation();
+    QVERIFY(model.pending_.isEmpty());
+    QVERIFY(!model.insertTimer_.isActive());
+    QCOMPARE(model.rowCount(), 0);
+
+    model.appendDevices(shared(QudevMemoryBackend::generateDevices(10)));
+    QTRY_COMPARE(deviceCount(model), 10);
+}
+
+QTEST_GUILESS_MAIN(TestDeviceModel)
+
+#include "test_device_model.moc"
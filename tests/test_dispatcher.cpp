@@ -0,0 +1,390 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include <QTest>
+#include <QSemaphore>
+#include <QSet>
+
+#include <qudev.h>
+#include <qudev_device.h>
+#include <qudev_dispatcher.h>
+#include <qudev_memory_backend.h>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+
+class TestDispatcher : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+
+    void keysBySubtree();
+    void ordersPerWorker();
+    void ordersPerDevice_data();
+    void ordersPerDevice();
+    void runsInParallel();
+    void dropsOldest();
+    void coalescesChanges();
+    void blocksWhenFull();
+    void servesQudev();
+    void countsCoalescedForQudev();
+
+private:
+    static QudevSharedDevice event(const QString& syspath, const QString& action, quint64 seqnum);
+
+    /// Handler recording seqnums in delivery order; blocks on @ref gate_ for @p blockOn.
+    QudevDispatcher::Handler recorder(quint64 blockOn = 0);
+
+    QList<QudevDevice> devices_;
+    std::mutex mutex_;
+    QList<quint64> delivered_;
+    QSemaphore entered_;
+    QSemaphore gate_;
+};
+
+void TestDispatcher::init()
+{
+    devices_ = QudevMemoryBackend::generateDevices(120);
+    delivered_.clear();
+    entered_.acquire(entered_.available());
+    gate_.acquire(gate_.available());
+}
+
+QudevSharedDevice TestDispatcher::event(const QString& syspath, const QString& action, quint64 seqnum)
+{
+    QudevDevice d;
+    d.syspath = syspath;
+    d.action = action;
+    d.seqnum = seqnum;
+    return QudevSharedDevice(std::move(d));
+}
+
+QudevDispatcher::Handler TestDispatcher::recorder(quint64 blockOn)
+{
+    return [this, blockOn](const QudevSharedDevice& e) {
+        if (e->seqnum == blockOn) {
+            entered_.release();
+            gate_.acquire();
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        delivered_ << e->seqnum;
+    };
+}
+
+void TestDispatcher::keysBySubtree()
+{
+    QudevDispatcher::Options options;
+    options.workers = 64;
+    QudevDispatcher dispatcher([](const QudevSharedDevice&) {}, options);
+    QCOMPARE(dispatcher.workerCount(), 64);
+
+    // A USB interface runs with its port, hub and controller.
+    const QString controller = QStringLiteral("/sys/devices/pci0000:00/0000:00:14.0");
+    const int worker = dispatcher.workerOf(controller);
+    QCOMPARE(dispatcher.workerOf(controller + QStringLiteral("/usb1")), worker);
+    QCOMPARE(dispatcher.workerOf(controller + QStringLiteral("/usb1/1-1/1-1:1.0")), worker);
+    QCOMPARE(dispatcher.workerOf(controller + QStringLiteral("/usb1/1-1/1-1:1.0/host0/target0:0:0")), worker);
+
+    // Different controllers spread over the workers.
+    QSet<int> workers;
+    for (int fn = 0; fn < 32; ++fn) {
+        workers << dispatcher.workerOf(QStringLiteral("/sys/devices/pci0000:00/0000:00:%1.0").arg(fn, 2, 16, QLatin1Char('0')));
+    }
+    QVERIFY(workers.size() > 8);
+}
+
+void TestDispatcher::ordersPerWorker()
+{
+    QudevDispatcher::Options options;
+    options.workers = 4;
+    options.queueCapacity = 16;
+
+    QHash<int, QList<quint64>> received;
+    QudevDispatcher* self = nullptr;
+    QudevDispatcher dispatcher([&](const QudevSharedDevice& e) {
+        const int worker = self->workerOf(e->syspath);
+        std::lock_guard<std::mutex> lock(mutex_);
+        received[worker] << e->seqnum;
+    }, options);
+    self = &dispatcher;
+
+    static const QString actions[] = { QStringLiteral("add"), QStringLiteral("change"), QStringLiteral("remove") };
+    QHash<int, QList<quint64>> expected;
+    quint64 seqnum = 0;
+    for (int round = 0; round < 10; ++round) {
+        for (const QudevDevice& d : std::as_const(devices_)) {
+            ++seqnum;
+            QVERIFY(dispatcher.post(event(d.syspath, actions[seqnum % 3], seqnum)));
+            expected[dispatcher.workerOf(d.syspath)] << seqnum;
+        }
+    }
+    QVERIFY(dispatcher.waitForIdle(5000));
+
+    // Every worker delivered its devices and subtrees in posting order.
+    QCOMPARE(received, expected);
+    QVERIFY(expected.size() > 1);
+    const QudevDispatcher::Counters c = dispatcher.counters();
+    QCOMPARE(c.posted, seqnum);
+    QCOMPARE(c.delivered, seqnum);
+    QCOMPARE(c.dropped, quint64(0));
+    QVERIFY(c.maxDepth <= 16);
+}
+
+void TestDispatcher::ordersPerDevice_data()
+{
+    QTest::addColumn<QudevDispatcher::Overflow>("overflow");
+
+    QTest::newRow("block") << QudevDispatcher::Overflow::Block;
+    QTest::newRow("drop-oldest") << QudevDispatcher::Overflow::DropOldest;
+    QTest::newRow("coalesce") << QudevDispatcher::Overflow::Coalesce;
+}
+
+void TestDispatcher::ordersPerDevice()
+{
+    QFETCH(QudevDispatcher::Overflow, overflow);
+
+    QudevDispatcher::Options options;
+    options.workers = 4;
+    options.queueCapacity = 4;
+    options.overflow = overflow;
+
+    QHash<QString, QList<quint64>> received;
+    QudevDispatcher dispatcher([&](const QudevSharedDevice& e) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        received[e->syspath] << e->seqnum;
+    }, options);
+
+    // Queues this small overflow all the time.
+    constexpr int Rounds = 20;
+    quint64 seqnum = 0;
+    for (int round = 0; round < Rounds; ++round) {
+        const QString action = round == 0           ? QStringLiteral("add")
+                               : round == Rounds - 1 ? QStringLiteral("remove")
+                                                     : QStringLiteral("change");
+        for (const QudevDevice& d : std::as_const(devices_)) {
+            QVERIFY(dispatcher.post(event(d.syspath, action, ++seqnum)));
+        }
+    }
+    QVERIFY(dispatcher.waitForIdle(5000));
+
+    // Whatever each policy skips, a device never sees its events reordered.
+    for (auto it = received.cbegin(); it != received.cend(); ++it) {
+        QVERIFY2(std::is_sorted(it->cbegin(), it->cend()), qPrintable(it.key()));
+    }
+    const QudevDispatcher::Counters c = dispatcher.counters();
+    QCOMPARE(c.posted, seqnum);
+    QCOMPARE(c.delivered + c.dropped + c.coalesced, seqnum);
+
+    if (overflow == QudevDispatcher::Overflow::DropOldest) {
+        QCOMPARE(c.coalesced, quint64(0));
+        return;
+    }
+
+    // Nothing is lost, and only changes are merged: every add and remove arrives.
+    QCOMPARE(c.dropped, quint64(0));
+    QCOMPARE(received.size(), devices_.size());
+    const quint64 lastRound = quint64(Rounds - 1) * quint64(devices_.size());
+    for (auto it = received.cbegin(); it != received.cend(); ++it) {
+        QVERIFY(it->first() <= quint64(devices_.size()));
+        QVERIFY(it->last() > lastRound);
+        if (overflow == QudevDispatcher::Overflow::Block) {
+            QCOMPARE(it->size(), qsizetype(Rounds));
+        }
+    }
+    if (overflow == QudevDispatcher::Overflow::Block) {
+        QCOMPARE(c.coalesced, quint64(0));
+    }
+}
+
+void TestDispatcher::runsInParallel()
+{
+    QudevDispatcher::Options options;
+    options.workers = 4;
+
+    std::atomic<int> fast{0};
+    QudevDispatcher dispatcher([&](const QudevSharedDevice& e) {
+        if (e->seqnum == 1) {
+            gate_.acquire();
+        } else {
+            ++fast;
+        }
+    }, options);
+
+    const QString slow = devices_.first().syspath;
+    QString other;
+    for (const QudevDevice& d : std::as_const(devices_)) {
+        if (dispatcher.workerOf(d.syspath) != dispatcher.workerOf(slow)) {
+            other = d.syspath;
+            break;
+        }
+    }
+    QVERIFY(!other.isEmpty());
+
+    // A stuck handler holds up its own worker only.
+    QVERIFY(dispatcher.post(event(slow, QStringLiteral("add"), 1)));
+    for (int i = 0; i < 50; ++i) {
+        QVERIFY(dispatcher.post(event(other, QStringLiteral("change"), 2 + i)));
+    }
+    QTRY_COMPARE(fast.load(), 50);
+    QVERIFY(!dispatcher.waitForIdle(10));
+
+    gate_.release();
+    QVERIFY(dispatcher.waitForIdle(5000));
+    QCOMPARE(dispatcher.counters().delivered, quint64(51));
+}
+
+void TestDispatcher::dropsOldest()
+{
+    QudevDispatcher::Options options;
+    options.workers = 1;
+    options.queueCapacity = 4;
+    options.overflow = QudevDispatcher::Overflow::DropOldest;
+    QudevDispatcher dispatcher(recorder(1), options);
+
+    const QString syspath = devices_.first().syspath;
+    QVERIFY(dispatcher.post(event(syspath, QStringLiteral("add"), 1)));
+    entered_.acquire();
+    for (quint64 seqnum = 2; seqnum <= 11; ++seqnum) {
+        QVERIFY(dispatcher.post(event(syspath, QStringLiteral("change"), seqnum)));
+    }
+    QCOMPARE(dispatcher.counters().dropped, quint64(6));
+
+    gate_.release();
+    QVERIFY(dispatcher.waitForIdle(5000));
+    QCOMPARE(delivered_, (QList<quint64>{ 1, 8, 9, 10, 11 }));
+    QCOMPARE(dispatcher.counters().maxDepth, qsizetype(4));
+}
+
+void TestDispatcher::coalescesChanges()
+{
+    QudevDispatcher::Options options;
+    options.workers = 1;
+    options.queueCapacity = 2;
+    options.overflow = QudevDispatcher::Overflow::Coalesce;
+    QudevDispatcher dispatcher(recorder(1), options);
+
+    const QString a = devices_.at(0).syspath;
+    const QString b = devices_.at(1).syspath;
+    const QString change = QStringLiteral("change");
+    QVERIFY(dispatcher.post(event(a, QStringLiteral("add"), 1)));
+    entered_.acquire();
+    QVERIFY(dispatcher.post(event(a, change, 2)));
+    QVERIFY(dispatcher.post(event(b, change, 3)));
+
+    // Full: newer changes replace the queued ones, in place.
+    QVERIFY(dispatcher.post(event(a, change, 4)));
+    QVERIFY(dispatcher.post(event(b, change, 5)));
+    QCOMPARE(dispatcher.counters().coalesced, quint64(2));
+
+    // Anything else waits for room.
+    std::thread poster([&] { dispatcher.post(event(a, QStringLiteral("remove"), 6)); });
+    QTRY_COMPARE(dispatcher.counters().blocked, quint64(1));
+
+    gate_.release();
+    poster.join();
+    QVERIFY(dispatcher.waitForIdle(5000));
+    QCOMPARE(delivered_, (QList<quint64>{ 1, 4, 5, 6 }));
+    QCOMPARE(dispatcher.counters().dropped, quint64(0));
+}
+
+void TestDispatcher::blocksWhenFull()
+{
+    QudevDispatcher::Options options;
+    options.workers = 1;
+    options.queueCapacity = 1;
+    QudevDispatcher dispatcher(recorder(1), options);
+
+    const QString syspath = devices_.first().syspath;
+    QVERIFY(dispatcher.post(event(syspath, QStringLiteral("add"), 1)));
+    entered_.acquire();
+    QVERIFY(dispatcher.post(event(syspath, QStringLiteral("change"), 2)));
+
+    std::atomic<bool> posted{false};
+    std::thread poster([&] {
+        dispatcher.post(event(syspath, QStringLiteral("change"), 3));
+        posted = true;
+    });
+    QTRY_COMPARE(dispatcher.counters().blocked, quint64(1));
+    QTest::qWait(20);
+    QVERIFY(!posted);
+
+    gate_.release();
+    poster.join();
+    QVERIFY(posted);
+    QVERIFY(dispatcher.waitForIdle(5000));
+    QCOMPARE(delivered_, (QList<quint64>{ 1, 2, 3 }));
+    QCOMPARE(dispatcher.counters().maxDepth, qsizetype(1));
+}
+
+void TestDispatcher::servesQudev()
+{
+    auto owned = std::make_unique<QudevMemoryBackend>(devices_);
+    QudevMemoryBackend* backend = owned.get();
+    Qudev qudev(std::move(owned));
+
+    std::atomic<int> received{0};
+    QudevDispatcher dispatcher([&received](const QudevSharedDevice&) { ++received; });
+    QVERIFY(dispatcher.attach(&qudev));
+    QVERIFY(qudev.startMonitoring());
+
+    for (QudevDevice e : std::as_const(devices_)) {
+        e.action = QStringLiteral("change");
+        e.seqnum = 0;
+        backend->inject(e);
+    }
+    QTRY_COMPARE(dispatcher.counters().posted, quint64(devices_.size()));
+    QVERIFY(dispatcher.waitForIdle(5000));
+    QCOMPARE(received.load(), int(devices_.size()));
+}
+
+void TestDispatcher::countsCoalescedForQudev()
+{
+    auto owned = std::make_unique<QudevMemoryBackend>(devices_);
+    QudevMemoryBackend* backend = owned.get();
+    Qudev qudev(std::move(owned));
+
+    QudevDispatcher::Options options;
+    options.workers = 1;
+    options.queueCapacity = 1;
+    options.overflow = QudevDispatcher::Overflow::Coalesce;
+    std::atomic<bool> first{true};
+    QudevDispatcher dispatcher([this, &first](const QudevSharedDevice&) {
+        if (first.exchange(false)) {
+            entered_.release();
+            gate_.acquire();
+        }
+    }, options);
+    QVERIFY(dispatcher.attach(&qudev));
+    QVERIFY(qudev.startMonitoring());
+
+    // The first change holds the worker, the second fills the queue and
+    // the other two are merged into it, without stalling this thread.
+    QudevDevice e = devices_.first();
+    e.action = QStringLiteral("change");
+    backend->inject(e);
+    QTRY_VERIFY(entered_.tryAcquire());
+    for (int i = 0; i < 3; ++i) {
+        backend->inject(e);
+    }
+    QTRY_COMPARE(dispatcher.counters().posted, quint64(4));
+    QCOMPARE(dispatcher.counters().coalesced, quint64(2));
+    QCOMPARE(qudev.stats().eventsCoalesced, quint64(2));
+
+    gate_.release();
+    QVERIFY(dispatcher.waitForIdle(5000));
+    QCOMPARE(dispatcher.counters().delivered, quint64(2));
+}
+
+QTEST_GUILESS_MAIN(TestDispatcher)
+
+#include "test_dispatcher.moc"
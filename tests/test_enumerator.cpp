@@ -0,0 +1,187 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include <QTest>
+
+#include <algorithm>
+
+#include <qudev.h>
+#include <qudev_device.h>
+#include <qudev_memory_backend.h>
+#include <qudev_query.h>
+#include <qudev_stats.h>
+
+
+// Enumeration against the in-memory backend, so results do not depend on
+// the host's hardware.
+class TestEnumerator : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void enumeratesAllDevices();
+    void appliesFilters();
+    void chunkedMatchesSnapshot();
+    void sharedScanMatchesSeparateScans();
+    void sharedScanOfQueries();
+    void sharedScanMatchesGlobs();
+};
+
+void TestEnumerator::enumeratesAllDevices()
+{
+    Qudev qudev(std::make_unique<QudevMemoryBackend>(QudevMemoryBackend::Options{ 500 }));
+    QCOMPARE(qudev.enumerate().size(), 500);
+}
+
+void TestEnumerator::appliesFilters()
+{
+    const QList<QudevDevice> devices = QudevMemoryBackend::generateDevices(500);
+    Qudev qudev(std::make_unique<QudevMemoryBackend>(devices));
+
+    QudevFilters filters;
+    filters.subsystem = QStringLiteral("block");
+    qudev.setFilters(filters);
+
+    const auto expected = std::count_if(devices.cbegin(), devices.cend(), [](const QudevDevice& d) {
+        return d.subsystem == QLatin1String("block");
+    });
+    const QList<QudevDevice> result = qudev.enumerate();
+
+    QVERIFY(expected > 0);
+    QCOMPARE(result.size(), qsizetype(expected));
+    for (const auto& d : result) {
+        QCOMPARE(d.subsystem, QStringLiteral("block"));
+    }
+}
+
+void TestEnumerator::chunkedMatchesSnapshot()
+{
+    Qudev qudev(std::make_unique<QudevMemoryBackend>(QudevMemoryBackend::Options{ 300 }));
+
+    QList<QudevDevice> chunked;
+    QVERIFY(qudev.enumerate(64, [&chunked](QList<QudevDevice> chunk) {
+        chunked.append(std::move(chunk));
+        return true;
+    }));
+
+    const QList<QudevDevice> snapshot = qudev.enumerate();
+    QCOMPARE(chunked.size(), snapshot.size());
+    for (qsizetype i = 0; i < snapshot.size(); ++i) {
+        QCOMPARE(chunked.at(i).syspath, snapshot.at(i).syspath);
+    }
+}
+
+void TestEnumerator::sharedScanMatchesSeparateScans()
+{
+    Qudev qudev(std::make_unique<QudevMemoryBackend>(QudevMemoryBackend::Options{ 500 }));
+
+    QList<QudevFilters> sets(5);
+    sets[0].subsystem = QStringLiteral("block");
+    sets[1].subsystem = QStringLiteral("block");
+    sets[1].devtype = QStringLiteral("partition");
+    sets[1].tags << QStringLiteral("uaccess");
+    sets[2].properties.insert(QStringLiteral("ID_BUS"), QStringLiteral("usb"));
+    sets[3].syspathPrefix = QStringLiteral("/sys/devices/pci0000:00/0000:00:1");
+    sets[4].actions << QStringLiteral("change");
+
+    const quint64 builtBefore = qudev.stats().devicesBuilt;
+    const QList<QList<QudevSharedDevice>> shared = qudev.enumerate(sets);
+    QCOMPARE(shared.size(), sets.size());
+
+    // Sets 3 and 4 have nothing in common with the others: one full pass.
+    QCOMPARE(qudev.stats().devicesBuilt - builtBefore, quint64(500));
+
+    for (qsizetype i = 0; i < sets.size(); ++i) {
+        qudev.setFilters(sets.at(i));
+        const QList<QudevDevice> separate = qudev.enumerate();
+        QVERIFY(!separate.isEmpty());
+        QCOMPARE(shared.at(i).size(), separate.size());
+        for (qsizetype j = 0; j < separate.size(); ++j) {
+            QCOMPARE(shared.at(i).at(j)->syspath, separate.at(j).syspath);
+        }
+    }
+
+    // A device matched by two sets is stored once.
+    QCOMPARE(&shared.at(1).first().get(),
+             &std::find_if(shared.at(0).cbegin(), shared.at(0).cend(), [&](const QudevSharedDevice& d) {
+                 return d->syspath == shared.at(1).first()->syspath;
+             })->get());
+}
+
+void TestEnumerator::sharedScanOfQueries()
+{
+    const QList<QudevDevice> devices = QudevMemoryBackend::generateDevices(500);
+    Qudev qudev(std::make_unique<QudevMemoryBackend>(devices));
+
+    const QList<QudevQuery> queries = {
+        QudevQuery(QStringLiteral("subsystem==block || subsystem==tty")),
+        QudevQuery(QStringLiteral("subsystem==tty && sysname==tty1*")),
+        QudevQuery(QStringLiteral("subsystem==")),
+    };
+    const QList<QList<QudevSharedDevice>> shared = qudev.enumerate(queries);
+    QCOMPARE(shared.size(), queries.size());
+
+    for (qsizetype i = 0; i < queries.size(); ++i) {
+        const auto expected = std::count_if(devices.cbegin(), devices.cend(), [&](const QudevDevice& d) {
+            return queries.at(i).matches(d);
+        });
+        QCOMPARE(shared.at(i).size(), qsizetype(expected));
+    }
+    QVERIFY(!shared.at(0).isEmpty());
+    QVERIFY(shared.at(2).isEmpty());
+
+    // An invalid query gets an empty list and does not widen the scan.
+    const quint64 builtBefore = qudev.stats().devicesBuilt;
+    const QList<QList<QudevSharedDevice>> withInvalid = qudev.enumerate(QList<QudevQuery>{
+        QudevQuery(QStringLiteral("subsystem==tty")),
+        QudevQuery(QStringLiteral("subsystem==")),
+    });
+    QCOMPARE(withInvalid.size(), 2);
+    QVERIFY(!withInvalid.at(0).isEmpty());
+    QVERIFY(withInvalid.at(1).isEmpty());
+    QCOMPARE(qudev.stats().devicesBuilt - builtBefore, quint64(withInvalid.at(0).size()));
+}
+
+void TestEnumerator::sharedScanMatchesGlobs()
+{
+    const QList<QudevDevice> devices = QudevMemoryBackend::generateDevices(500);
+    Qudev qudev(std::make_unique<QudevMemoryBackend>(devices));
+
+    // libudev fnmatch()es these values, for one set as for several.
+    QList<QudevFilters> sets(4);
+    sets[0].sysname = QStringLiteral("sd*");
+    sets[1].subsystem = QStringLiteral("[bt]*");
+    sets[1].devtype = QStringLiteral("?isk");
+    sets[2].properties.insert(QStringLiteral("ID_BUS"), QStringLiteral("us?"));
+    sets[3].sysattrs.insert(QStringLiteral("removable"), QStringLiteral("[1]"));
+    sets[3].nomatchSysattrs.insert(QStringLiteral("uevent"), QStringLiteral("DEVTYPE=p*"));
+
+    const QList<QList<QudevSharedDevice>> shared = qudev.enumerate(sets);
+    QCOMPARE(shared.size(), sets.size());
+
+    for (qsizetype i = 0; i < sets.size(); ++i) {
+        const QList<QList<QudevSharedDevice>> alone = qudev.enumerate(QList<QudevFilters>{ sets.at(i) });
+        qudev.setFilters(sets.at(i));
+        const QList<QudevDevice> separate = qudev.enumerate();
+        QVERIFY(!separate.isEmpty());
+        QCOMPARE(shared.at(i).size(), separate.size());
+        QCOMPARE(alone.first().size(), separate.size());
+    }
+
+    const auto disks = std::count_if(devices.cbegin(), devices.cend(), [](const QudevDevice& d) {
+        return d.sysname.startsWith(QLatin1String("sd"));
+    });
+    QCOMPARE(shared.at(0).size(), qsizetype(disks));
+    for (const QudevSharedDevice& d : shared.at(1)) {
+        QCOMPARE(d->devtype, QStringLiteral("disk"));
+    }
+}
+
+QTEST_GUILESS_MAIN(TestEnumerator)
+
+#include "test_enumerator.moc"
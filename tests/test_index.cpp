@@ -0,0 +1,228 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include <QTest>
+
+#include <qudev_device.h>
+#include <qudev_filters.h>
+#include <qudev_index.h>
+#include <qudev_memory_backend.h>
+
+#include <algorithm>
+
+
+namespace {
+
+QStringList syspaths(const QList<QudevSharedDevice>& devices)
+{
+    QStringList out;
+    for (const auto& d : devices) {
+        out << d->syspath;
+    }
+    out.sort();
+    return out;
+}
+
+} // namespace
+
+class TestIndex : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+
+    void findsByField();
+    void selectMatchesScan_data();
+    void selectMatchesScan();
+    void picksMostSelective();
+    void updatesIncrementally();
+    void indexesLate();
+
+private:
+    /// Reference for select(): the same devices without indexes, scanned.
+    QStringList scan(const QudevFilters& filters) const;
+
+    QList<QudevDevice> devices_;
+    QudevIndex index_;
+    QudevIndex unindexed_;
+};
+
+void TestIndex::init()
+{
+    devices_ = QudevMemoryBackend::generateDevices(2000);
+    index_.clear();
+    if (!index_.hasIndex(QudevIndex::Field::Devnode)) {
+        index_.addDefaultIndexes();
+        index_.addIndex(QudevIndex::Field::Devtype);
+    }
+    unindexed_.clear();
+    for (const auto& d : devices_) {
+        const QudevSharedDevice shared(d);
+        QVERIFY(index_.insert(shared));
+        QVERIFY(unindexed_.insert(shared));
+    }
+    QCOMPARE(index_.size(), devices_.size());
+}
+
+QStringList TestIndex::scan(const QudevFilters& filters) const
+{
+    return syspaths(unindexed_.select(filters));
+}
+
+void TestIndex::findsByField()
+{
+    const QudevDevice& disk = *std::find_if(devices_.cbegin(), devices_.cend(), [](const QudevDevice& d) {
+        return d.devtype == QLatin1String("disk");
+    });
+
+    QCOMPARE(index_.findDevnode(disk.devnode)->syspath, disk.syspath);
+    QVERIFY(syspaths(index_.findDevNumber(disk.major, disk.minor)).contains(disk.syspath));
+    QCOMPARE(syspaths(index_.findProperty(QStringLiteral("ID_SERIAL"), disk.properties.value(QStringLiteral("ID_SERIAL")))),
+             QStringList{ disk.syspath });
+    QVERIFY(index_.findDevnode(QStringLiteral("/dev/nothing")).isNull());
+    QVERIFY(index_.find(QudevIndex::Field::Devnode, QString()).isEmpty());
+
+    // Broad indexes, checked against a scan.
+    QudevFilters uaccess;
+    uaccess.tags << QStringLiteral("uaccess");
+    QCOMPARE(syspaths(index_.find(QudevIndex::Field::Tag, QStringLiteral("uaccess"))), scan(uaccess));
+    QCOMPARE(index_.find(QudevIndex::Field::Driver, QStringLiteral("drv_block")).size(),
+             qsizetype(std::count_if(devices_.cbegin(), devices_.cend(), [](const QudevDevice& d) {
+                 return d.driver == QLatin1String("drv_block");
+             })));
+
+    // Not indexed: scanned.
+    QVERIFY(!index_.hasIndex(QudevIndex::Field::Sysname));
+    QCOMPARE(syspaths(index_.find(QudevIndex::Field::Sysname, disk.sysname)), QStringList{ disk.syspath });
+}
+
+void TestIndex::selectMatchesScan_data()
+{
+    QTest::addColumn<QudevFilters>("filters");
+
+    QudevFilters f;
+    QTest::newRow("empty") << f;
+
+    f.subsystem = QStringLiteral("block");
+    QTest::newRow("subsystem") << f;
+
+    f.devtype = QStringLiteral("partition");
+    f.tags << QStringLiteral("uaccess");
+    QTest::newRow("subsystem+devtype+tag") << f;
+
+    f = {};
+    f.properties.insert(QStringLiteral("ID_PATH"), QStringLiteral("pci-0000:00:7.0"));
+    f.properties.insert(QStringLiteral("ID_BUS"), QStringLiteral("usb"));
+    QTest::newRow("properties") << f;
+
+    f = {};
+    f.sysname = QStringLiteral("tty12");
+    f.syspathPrefix = QStringLiteral("/sys/devices/pci0000:00/");
+    QTest::newRow("unindexed") << f;
+
+    f = {};
+    f.subsystem = QStringLiteral("nothing");
+    f.tags << QStringLiteral("systemd");
+    QTest::newRow("no-match") << f;
+}
+
+void TestIndex::selectMatchesScan()
+{
+    QFETCH(QudevFilters, filters);
+    QCOMPARE(syspaths(index_.select(filters)), scan(filters));
+}
+
+void TestIndex::picksMostSelective()
+{
+    QudevFilters filters;
+    filters.subsystem = QStringLiteral("block");
+    filters.tags << QStringLiteral("systemd");
+    const qsizetype blocks = index_.find(QudevIndex::Field::Subsystem, filters.subsystem).size();
+    QCOMPARE(index_.candidateCount(filters), blocks);
+
+    // A serial is unique, so it decides.
+    filters.properties.insert(QStringLiteral("ID_SERIAL"), devices_.at(7).properties.value(QStringLiteral("ID_SERIAL")));
+    QCOMPARE(index_.candidateCount(filters), qsizetype(1));
+
+    // Nothing indexed: everything is examined.
+    QudevFilters unindexed;
+    unindexed.sysname = QStringLiteral("sda3");
+    QCOMPARE(index_.candidateCount(unindexed), index_.size());
+
+    // A glob may match devices filed under other values: never looked up.
+    QudevFilters glob;
+    glob.subsystem = QStringLiteral("bl*");
+    QCOMPARE(index_.candidateCount(glob), index_.size());
+    QCOMPARE(index_.candidates(glob).size(), index_.size());
+    QCOMPARE(index_.candidates(filters).size(), qsizetype(1));
+}
+
+void TestIndex::updatesIncrementally()
+{
+    QudevDevice changed = devices_.at(3);
+    const QString oldSerial = changed.properties.value(QStringLiteral("ID_SERIAL"));
+    changed.action = QStringLiteral("change");
+    changed.properties.insert(QStringLiteral("ID_SERIAL"), QStringLiteral("Replaced"));
+    changed.tags << QStringLiteral("seat");
+    index_.apply(QudevSharedDevice(changed));
+
+    QCOMPARE(index_.size(), devices_.size());
+    QVERIFY(index_.findProperty(QStringLiteral("ID_SERIAL"), oldSerial).isEmpty());
+    QCOMPARE(syspaths(index_.findProperty(QStringLiteral("ID_SERIAL"), QStringLiteral("Replaced"))),
+             QStringList{ changed.syspath });
+    QCOMPARE(syspaths(index_.find(QudevIndex::Field::Tag, QStringLiteral("seat"))), QStringList{ changed.syspath });
+
+    changed.action = QStringLiteral("remove");
+    index_.apply(QudevSharedDevice(changed));
+    QCOMPARE(index_.size(), devices_.size() - 1);
+    QVERIFY(index_.device(changed.syspath).isNull());
+    QVERIFY(index_.find(QudevIndex::Field::Tag, QStringLiteral("seat")).isEmpty());
+    QVERIFY(!index_.remove(changed.syspath));
+
+    // The freed slot is reused.
+    QudevDevice added = devices_.at(3);
+    added.syspath += QStringLiteral("/hotplugged");
+    added.devnode = QStringLiteral("/dev/hotplugged");
+    added.action = QStringLiteral("add");
+    index_.apply(QudevSharedDevice(added));
+    QCOMPARE(index_.size(), devices_.size());
+    QCOMPARE(index_.findDevnode(added.devnode)->syspath, added.syspath);
+    QCOMPARE(index_.devices().size(), devices_.size());
+
+    // A renamed device is found under its new path only.
+    QudevDevice moved = added;
+    moved.syspath = added.syspath + QStringLiteral("-renamed");
+    moved.action = QStringLiteral("move");
+    moved.properties.insert(QStringLiteral("DEVPATH_OLD"), added.syspath.mid(4));
+    index_.apply(QudevSharedDevice(moved));
+    QCOMPARE(index_.size(), devices_.size());
+    QVERIFY(index_.device(added.syspath).isNull());
+    QCOMPARE(index_.findDevnode(added.devnode)->syspath, moved.syspath);
+}
+
+void TestIndex::indexesLate()
+{
+    QudevIndex index;
+    for (const auto& d : devices_) {
+        index.insert(QudevSharedDevice(d));
+    }
+    QVERIFY(!index.hasIndex(QudevIndex::Field::Property, QStringLiteral("ID_BUS")));
+
+    index.addIndex(QudevIndex::Field::Property, QStringLiteral("ID_BUS"));
+    QVERIFY(index.hasIndex(QudevIndex::Field::Property, QStringLiteral("ID_BUS")));
+
+    QudevFilters filters;
+    filters.properties.insert(QStringLiteral("ID_BUS"), QStringLiteral("ata"));
+    QCOMPARE(index.candidateCount(filters), qsizetype(scan(filters).size()));
+    QCOMPARE(syspaths(index.select(filters)), scan(filters));
+}
+
+QTEST_GUILESS_MAIN(TestIndex)
+
+#include "test_index.moc"
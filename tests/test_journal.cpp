@@ -0,0 +1,192 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include <QTest>
+#include <QTemporaryDir>
+
+#include <qudev_device.h>
+#include <qudev_journal.h>
+#include <qudev_memory_backend.h>
+
+
+class TestJournal : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void replaysAfterSeqnum();
+    void evictsOldest();
+    void detectsGaps();
+    void rejectsOutOfOrder();
+    void survivesInFile();
+
+private:
+    /// Event @p seqnum, built from one of the generated devices.
+    QudevDevice event(quint64 seqnum) const;
+    static QList<quint64> seqnumsAfter(const QudevJournal& journal, quint64 seqnum);
+
+    QList<QudevDevice> devices_;
+};
+
+void TestJournal::initTestCase()
+{
+    devices_ = QudevMemoryBackend::generateDevices(50);
+}
+
+QudevDevice TestJournal::event(quint64 seqnum) const
+{
+    QudevDevice e = devices_.at(qsizetype(seqnum % quint64(devices_.size())));
+    e.action = QStringLiteral("change");
+    e.seqnum = seqnum;
+    return e;
+}
+
+QList<quint64> TestJournal::seqnumsAfter(const QudevJournal& journal, quint64 seqnum)
+{
+    QList<quint64> seqnums;
+    journal.replay(seqnum, [&](QudevDevice&& e) {
+        seqnums << e.seqnum;
+        return true;
+    });
+    return seqnums;
+}
+
+void TestJournal::replaysAfterSeqnum()
+{
+    QudevJournal journal;
+    QVERIFY(!journal.covers(0));   // nothing known yet
+
+    for (quint64 s = 1; s <= 20; ++s) {
+        QVERIFY(journal.append(event(s)));
+    }
+    QCOMPARE(journal.size(), qsizetype(20));
+    QCOMPARE(journal.firstSeqnum(), quint64(1));
+    QCOMPARE(journal.lastSeqnum(), quint64(20));
+
+    QVERIFY(journal.covers(0));
+    QCOMPARE(seqnumsAfter(journal, 17), (QList<quint64>{ 18, 19, 20 }));
+    QVERIFY(journal.covers(20));
+    QVERIFY(seqnumsAfter(journal, 20).isEmpty());
+    QVERIFY(!journal.covers(21));
+
+    // Replayed events are complete.
+    QudevDevice replayed;
+    journal.replay(4, [&](QudevDevice&& e) {
+        replayed = std::move(e);
+        return false;
+    });
+    const QudevDevice expected = event(5);
+    QCOMPARE(replayed.syspath, expected.syspath);
+    QCOMPARE(replayed.action, expected.action);
+    QCOMPARE(replayed.properties, expected.properties);
+}
+
+void TestJournal::evictsOldest()
+{
+    QudevJournal journal(16 * 1024);
+    for (quint64 s = 1; s <= 500; ++s) {
+        QVERIFY(journal.append(event(s)));
+    }
+
+    QVERIFY(journal.evicted() > 0);
+    QCOMPARE(journal.size() + qsizetype(journal.evicted()), qsizetype(500));
+    QCOMPARE(journal.lastSeqnum(), quint64(500));
+
+    // Records wrap around the ring; every one still decodes in order.
+    const quint64 first = journal.firstSeqnum();
+    QVERIFY(!journal.covers(first - 2));
+    QVERIFY(journal.covers(first - 1));
+    const QList<quint64> kept = seqnumsAfter(journal, first - 1);
+    QCOMPARE(kept.size(), journal.size());
+    for (qsizetype i = 0; i < kept.size(); ++i) {
+        QCOMPARE(kept.at(i), first + quint64(i));
+    }
+}
+
+void TestJournal::detectsGaps()
+{
+    QudevJournal journal;
+
+    // Started late: events before the first one went unseen.
+    QVERIFY(journal.append(event(100)));
+    QVERIFY(!journal.covers(98));
+    QVERIFY(journal.covers(99));
+
+    journal.markDiscontinuity();
+    QVERIFY(!journal.covers(99));
+
+    // Directly following: nothing was missed after all.
+    QVERIFY(journal.append(event(101)));
+    QVERIFY(journal.covers(99));
+
+    journal.markDiscontinuity();
+    QVERIFY(journal.append(event(110)));
+    QVERIFY(!journal.covers(105));
+    QVERIFY(journal.covers(109));
+    QCOMPARE(seqnumsAfter(journal, 109), (QList<quint64>{ 110 }));
+
+    // A restarted sequence (reboot) replaces the history.
+    journal.markDiscontinuity();
+    QVERIFY(journal.append(event(3)));
+    QCOMPARE(journal.size(), qsizetype(1));
+    QVERIFY(!journal.covers(1));
+    QVERIFY(journal.covers(2));
+}
+
+void TestJournal::rejectsOutOfOrder()
+{
+    QudevJournal journal(16 * 1024);
+    QVERIFY(journal.append(event(5)));
+    QVERIFY(!journal.append(event(5)));
+    QVERIFY(!journal.append(event(4)));
+    QVERIFY(!journal.append(event(0)));
+
+    // Larger than the whole ring.
+    QudevDevice huge = event(6);
+    huge.properties.insert(QStringLiteral("BLOB"), QString(32 * 1024, QLatin1Char('x')));
+    QVERIFY(!journal.append(huge));
+    QCOMPARE(journal.lastSeqnum(), quint64(5));
+}
+
+void TestJournal::survivesInFile()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("events.journal"));
+
+    {
+        QudevJournal journal(64 * 1024);
+        QVERIFY(journal.append(event(1)));   // carried into the file
+        QVERIFY2(journal.openFile(path), qPrintable(journal.errorString()));
+        QVERIFY(journal.isFileBacked());
+        for (quint64 s = 2; s <= 300; ++s) {
+            QVERIFY(journal.append(event(s)));
+        }
+    }
+
+    QudevJournal reopened(64 * 1024);
+    QVERIFY(reopened.openFile(path));
+    QCOMPARE(reopened.lastSeqnum(), quint64(300));
+    QVERIFY(reopened.size() > 0);
+
+    // Unknown what happened while closed, until the next event tells.
+    QVERIFY(!reopened.covers(299));
+    QVERIFY(reopened.append(event(301)));
+    QCOMPARE(seqnumsAfter(reopened, 298), (QList<quint64>{ 299, 300, 301 }));
+
+    // A different capacity does not reuse the file.
+    QudevJournal other(128 * 1024);
+    QVERIFY(other.openFile(path));
+    QCOMPARE(other.size(), qsizetype(0));
+}
+
+QTEST_GUILESS_MAIN(TestJournal)
+
+#include "test_journal.moc"
@@ -0,0 +1,203 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include <QTest>
+#include <QRegularExpression>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+
+#include <qudev.h>
+#include <qudev_memory_backend.h>
+#include <qudev_replay_backend.h>
+
+
+// Monitoring against the in-memory backend: events travel through a real
+// socket and QSocketNotifier, but their content and timing are controlled.
+class TestMonitor : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void deliversInjectedEvents();
+    void appliesFilters();
+    void deliversGeneratedEvents();
+    void replaysRecordedEvents();
+    void skipsTruncatedEvents();
+    void sourceOutlivesBackend();
+
+private:
+    static QudevDevice event(const QudevDevice& device, const QString& action);
+};
+
+QudevDevice TestMonitor::event(const QudevDevice& device, const QString& action)
+{
+    QudevDevice e = device;
+    e.action = action;
+    e.properties.insert(QStringLiteral("ACTION"), action);
+    return e;
+}
+
+void TestMonitor::deliversInjectedEvents()
+{
+    auto owned = std::make_unique<QudevMemoryBackend>(QudevMemoryBackend::Options{ 10 });
+    QudevMemoryBackend* backend = owned.get();
+    Qudev qudev(std::move(owned));
+
+    QSignalSpy spy(&qudev, &Qudev::deviceFound);
+    QVERIFY(qudev.startMonitoring());
+
+    const QudevDevice& source = backend->devices().first();
+    QVERIFY(backend->inject(event(source, QStringLiteral("change"))));
+
+    QTRY_COMPARE(spy.size(), 1);
+    const auto received = spy.first().first().value<QudevDevice>();
+    QCOMPARE(received.syspath, source.syspath);
+    QCOMPARE(received.action, QStringLiteral("change"));
+    QCOMPARE(received.properties, event(source, QStringLiteral("change")).properties);
+    QVERIFY(received.seqnum != 0);
+}
+
+void TestMonitor::appliesFilters()
+{
+    auto owned = std::make_unique<QudevMemoryBackend>(QudevMemoryBackend::Options{ 200 });
+    QudevMemoryBackend* backend = owned.get();
+    Qudev qudev(std::move(owned));
+
+    QudevFilters filters;
+    filters.subsystem = QStringLiteral("block");
+    filters.actions = { QStringLiteral("add") };
+    qudev.setFilters(filters);
+
+    QSignalSpy spy(&qudev, &Qudev::deviceFound);
+    QVERIFY(qudev.startMonitoring());
+
+    int expected = 0;
+    for (const auto& d : backend->devices()) {
+        for (const auto& action : { QStringLiteral("add"), QStringLiteral("change") }) {
+            backend->inject(event(d, action));
+            expected += (d.subsystem == QLatin1String("block") && action == QLatin1String("add")) ? 1 : 0;
+        }
+    }
+
+    QVERIFY(expected > 0);
+    QTRY_COMPARE(spy.size(), expected);
+    for (const auto& args : spy) {
+        const auto d = args.first().value<QudevDevice>();
+        QCOMPARE(d.subsystem, QStringLiteral("block"));
+        QCOMPARE(d.action, QStringLiteral("add"));
+    }
+}
+
+void TestMonitor::deliversGeneratedEvents()
+{
+    auto owned = std::make_unique<QudevMemoryBackend>(QudevMemoryBackend::Options{ 100 });
+    QudevMemoryBackend* backend = owned.get();
+    Qudev qudev(std::move(owned));
+
+    QSignalSpy spy(&qudev, &Qudev::deviceFound);
+    QVERIFY(qudev.startMonitoring());
+
+    backend->startEvents(0, 5000);
+    QTRY_COMPARE(spy.size(), 5000);
+    QCOMPARE(backend->eventsDropped(), quint64(0));
+
+    qudev.stopMonitoring();
+}
+
+void TestMonitor::replaysRecordedEvents()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString log = dir.filePath(QStringLiteral("events.qudevlog"));
+
+    QList<QudevDevice> recorded;
+    {
+        auto owned = std::make_unique<QudevMemoryBackend>(QudevMemoryBackend::Options{ 50 });
+        QudevMemoryBackend* backend = owned.get();
+        Qudev qudev(std::move(owned));
+
+        // Recording happens before filtering: the log must hold all events.
+        QudevFilters filters;
+        filters.actions = { QStringLiteral("add") };
+        qudev.setFilters(filters);
+
+        QVERIFY(qudev.startRecording(log));
+        QVERIFY(qudev.startMonitoring());
+
+        for (const auto& d : backend->devices()) {
+            recorded << event(d, QStringLiteral("change"));
+            QVERIFY(backend->inject(recorded.last()));
+        }
+
+        QSignalSpy spy(&qudev, &Qudev::deviceFound);
+        QVERIFY(backend->inject(event(backend->devices().first(), QStringLiteral("add"))));
+        QTRY_COMPARE(spy.size(), 1);
+        recorded << spy.first().first().value<QudevDevice>();
+    }
+
+    // Two replays at maximum speed yield the recorded stream, identically.
+    for (int run = 0; run < 2; ++run)
+    {
+        auto owned = std::make_unique<QudevReplayBackend>(log, 0);
+        QVERIFY2(owned->isValid(), qPrintable(owned->errorString()));
+        QCOMPARE(owned->eventCount(), recorded.size());
+
+        Qudev qudev(std::move(owned));
+        QSignalSpy spy(&qudev, &Qudev::deviceFound);
+        QVERIFY(qudev.startMonitoring());
+
+        QTRY_COMPARE(spy.size(), recorded.size());
+        for (qsizetype i = 0; i < recorded.size(); ++i) {
+            const auto d = spy.at(i).first().value<QudevDevice>();
+            QCOMPARE(d.syspath, recorded.at(i).syspath);
+            QCOMPARE(d.action, recorded.at(i).action);
+            QCOMPARE(d.properties, recorded.at(i).properties);
+            QVERIFY(d.seqnum != 0);
+        }
+    }
+}
+
+void TestMonitor::skipsTruncatedEvents()
+{
+    auto owned = std::make_unique<QudevMemoryBackend>(QudevMemoryBackend::Options{ 10 });
+    QudevMemoryBackend* backend = owned.get();
+    Qudev qudev(std::move(owned));
+
+    QSignalSpy spy(&qudev, &Qudev::deviceFound);
+    QVERIFY(qudev.startMonitoring());
+
+    // Larger than a monitor's receive buffer: dropped, not half-decoded.
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression(QStringLiteral("Dropped an event larger than")));
+    QudevDevice huge = event(backend->devices().first(), QStringLiteral("change"));
+    huge.properties.insert(QStringLiteral("ID_HUGE"), QString(64 * 1024, QLatin1Char('x')));
+    QVERIFY(backend->inject(huge));
+    QVERIFY(backend->inject(event(backend->devices().last(), QStringLiteral("change"))));
+
+    QTRY_COMPARE(spy.size(), 1);
+    QCOMPARE(spy.first().first().value<QudevDevice>().syspath, backend->devices().last().syspath);
+    QCOMPARE(backend->eventsDropped(), quint64(1));
+}
+
+void TestMonitor::sourceOutlivesBackend()
+{
+    auto backend = std::make_unique<QudevMemoryBackend>(QudevMemoryBackend::Options{ 10 });
+    std::unique_ptr<QudevBackend::MonitorSource> source =
+        backend->createMonitor(QudevBackend::MonitorChannel::Udev, {});
+    QVERIFY(source);
+    QVERIFY(backend->inject(event(backend->devices().first(), QStringLiteral("change"))));
+
+    // What was queued is still readable; nothing new arrives.
+    backend.reset();
+    QVERIFY(source->receive().has_value());
+    QVERIFY(!source->receive().has_value());
+    QVERIFY(source->setFilters({}));
+}
+
+QTEST_GUILESS_MAIN(TestMonitor)
+
+#include "test_monitor.moc"
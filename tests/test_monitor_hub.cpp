@@ -0,0 +1,251 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include <QTest>
+#include <QSignalSpy>
+
+#include <qudev.h>
+#include <qudev_device.h>
+#include <qudev_memory_backend.h>
+#include <qudev_monitor_hub.h>
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+
+
+class TestMonitorHub : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void deliversToMatching();
+    void sharesCommonFilters();
+    void unsubscribesFromHandler();
+    void dropsWithContext();
+    void servesQudev();
+
+private:
+    /// Inject every device once as @p action, or as @ref actionAt().
+    qsizetype injectAll(const QString& action = {});
+    static QString actionAt(qsizetype i);
+
+    QList<QudevDevice> devices_;
+    QudevMemoryBackend* backend_ = nullptr;
+    std::unique_ptr<QudevMonitorHub> hub_;
+};
+
+void TestMonitorHub::init()
+{
+    devices_ = QudevMemoryBackend::generateDevices(120);
+    auto backend = std::make_unique<QudevMemoryBackend>(devices_);
+    backend_ = backend.get();
+    hub_ = std::make_unique<QudevMonitorHub>(std::move(backend));
+}
+
+void TestMonitorHub::cleanup()
+{
+    hub_.reset();
+    backend_ = nullptr;
+}
+
+QString TestMonitorHub::actionAt(qsizetype i)
+{
+    static const QString actions[] = { QStringLiteral("add"), QStringLiteral("change"), QStringLiteral("remove") };
+    return actions[i % 3];
+}
+
+qsizetype TestMonitorHub::injectAll(const QString& action)
+{
+    for (qsizetype i = 0; i < devices_.size(); ++i) {
+        QudevDevice e = devices_.at(i);
+        e.action = action.isEmpty() ? actionAt(i) : action;
+        e.seqnum = 0;
+        backend_->inject(e);
+    }
+    return devices_.size();
+}
+
+void TestMonitorHub::deliversToMatching()
+{
+    QList<QudevFilters> sets(7);
+    sets[0].subsystem = QStringLiteral("block");
+    sets[1].subsystem = QStringLiteral("block");
+    sets[1].properties.insert(QStringLiteral("ID_BUS"), QStringLiteral("usb"));
+    sets[2].tags << QStringLiteral("uaccess");
+    sets[3].actions << QStringLiteral("remove") << QStringLiteral("change");
+    sets[4].syspathPrefix = QStringLiteral("/sys/devices/pci0000:00/0000:00:1");
+    sets[5].subsystem = QStringLiteral("tty");
+    sets[5].actions << QStringLiteral("add");
+    // sets[6]: everything
+
+    QList<QStringList> received(sets.size());
+    for (qsizetype i = 0; i < sets.size(); ++i) {
+        QVERIFY(hub_->subscribe(sets.at(i), [&received, i](const QudevSharedDevice& d) {
+            received[i] << d->syspath + QLatin1Char(' ') + d->action;
+        }));
+    }
+    QCOMPARE(hub_->subscriberCount(), sets.size());
+    QVERIFY(hub_->isMonitoring());
+
+    const qsizetype injected = injectAll();
+    QTRY_COMPARE(hub_->eventsDispatched(), quint64(injected));
+
+    // Each subscriber got exactly what its filters describe, in order.
+    qsizetype deliveries = 0;
+    for (qsizetype i = 0; i < sets.size(); ++i) {
+        const QudevFilters& f = sets.at(i);
+        QStringList expected;
+        for (qsizetype j = 0; j < devices_.size(); ++j) {
+            const QudevDevice& d = devices_.at(j);
+            const QString action = actionAt(j);
+            const bool match = (f.subsystem.isEmpty() || d.subsystem == f.subsystem)
+                               && (f.actions.isEmpty() || f.actions.contains(action))
+                               && (f.syspathPrefix.isEmpty() || d.syspath.startsWith(f.syspathPrefix))
+                               && std::all_of(f.tags.cbegin(), f.tags.cend(),
+                                              [&d](const QString& t) { return d.tags.contains(t); })
+                               && std::all_of(f.properties.keyBegin(), f.properties.keyEnd(), [&](const QString& k) {
+                                      return d.properties.value(k) == f.properties.value(k);
+                                  });
+            if (match) {
+                expected << d.syspath + QLatin1Char(' ') + action;
+            }
+        }
+        QVERIFY(!expected.isEmpty());
+        QCOMPARE(received.at(i), expected);
+        deliveries += expected.size();
+    }
+    QCOMPARE(hub_->deliveries(), quint64(deliveries));
+}
+
+void TestMonitorHub::sharesCommonFilters()
+{
+    QVERIFY(!hub_->isMonitoring());
+
+    QudevFilters disks;
+    disks.subsystem = QStringLiteral("block");
+    disks.devtype = QStringLiteral("disk");
+    disks.tags << QStringLiteral("systemd");
+    QudevFilters partitions = disks;
+    partitions.devtype = QStringLiteral("partition");
+
+    const quint64 a = hub_->subscribe(disks, [](const QudevSharedDevice&) {});
+    const quint64 b = hub_->subscribe(partitions, [](const QudevSharedDevice&) {});
+    QVERIFY(a && b && a != b);
+    QCOMPARE(hub_->monitorFilters().subsystem, QStringLiteral("block"));
+    QVERIFY(hub_->monitorFilters().devtype.isEmpty());
+    QCOMPARE(hub_->monitorFilters().tags, QStringList{ QStringLiteral("systemd") });
+
+    // Anything unfiltered widens the socket filter to everything.
+    const quint64 all = hub_->subscribe({}, [](const QudevSharedDevice&) {});
+    QVERIFY(hub_->monitorFilters().empty());
+    QVERIFY(hub_->unsubscribe(all));
+    QCOMPARE(hub_->monitorFilters().subsystem, QStringLiteral("block"));
+
+    // Re-filtering moves the subscription between dispatch buckets.
+    QudevFilters ttys;
+    ttys.subsystem = QStringLiteral("tty");
+    QVERIFY(hub_->setFilters(b, ttys));
+    QVERIFY(hub_->monitorFilters().subsystem.isEmpty());
+
+    QVERIFY(hub_->unsubscribe(a));
+    QVERIFY(hub_->unsubscribe(b));
+    QVERIFY(!hub_->unsubscribe(b));
+    QCOMPARE(hub_->subscriberCount(), 0);
+    QVERIFY(!hub_->isMonitoring());
+}
+
+void TestMonitorHub::unsubscribesFromHandler()
+{
+    QudevFilters block;
+    block.subsystem = QStringLiteral("block");
+
+    qsizetype first = 0;
+    qsizetype second = 0;
+    quint64 secondId = 0;
+    quint64 firstId = 0;
+    firstId = hub_->subscribe(block, [&](const QudevSharedDevice&) {
+        ++first;
+        hub_->unsubscribe(firstId);
+        hub_->unsubscribe(secondId);
+    });
+    secondId = hub_->subscribe(block, [&](const QudevSharedDevice&) { ++second; });
+    QVERIFY(firstId && secondId);
+
+    injectAll(QStringLiteral("change"));
+    QTRY_VERIFY(!hub_->isMonitoring());
+    QTest::qWait(50);
+
+    // The first handler ran once; the second, already dropped, never.
+    QCOMPARE(first, qsizetype(1));
+    QCOMPARE(second, qsizetype(0));
+    QCOMPARE(hub_->subscriberCount(), 0);
+}
+
+void TestMonitorHub::dropsWithContext()
+{
+    auto context = std::make_unique<QObject>();
+    QVERIFY(hub_->subscribe({}, context.get(), [](const QudevSharedDevice&) {}));
+    QVERIFY(hub_->subscribe({}, [](const QudevSharedDevice&) {}));
+    QCOMPARE(hub_->subscriberCount(), 2);
+
+    context.reset();
+    QCOMPARE(hub_->subscriberCount(), 1);
+}
+
+void TestMonitorHub::servesQudev()
+{
+    Qudev blocks(std::make_unique<QudevMemoryBackend>(devices_));
+    Qudev ttys(std::make_unique<QudevMemoryBackend>(devices_));
+    blocks.setMonitorHub(hub_.get());
+    ttys.setMonitorHub(hub_.get());
+    QCOMPARE(blocks.monitorHub(), hub_.get());
+
+    QudevFilters filters;
+    filters.subsystem = QStringLiteral("block");
+    blocks.setFilters(filters);
+    QVERIFY(ttys.setQuery(QStringLiteral("subsystem==tty && sysname==tty1*")));
+
+    QSignalSpy blockSpy(&blocks, &Qudev::deviceFound);
+    QSignalSpy ttySpy(&ttys, &Qudev::deviceFound);
+    QVERIFY(blocks.startMonitoring());
+    QVERIFY(ttys.startMonitoring());
+    QCOMPARE(hub_->subscriberCount(), 2);
+
+    // No history to resume from.
+    QSignalSpy rescan(&blocks, &Qudev::rescanRequired);
+    QVERIFY(blocks.resumeMonitoring(1));
+    QCOMPARE(rescan.size(), 1);
+    QCOMPARE(hub_->subscriberCount(), 2);
+
+    const qsizetype injected = injectAll(QStringLiteral("change"));
+    QTRY_COMPARE(hub_->eventsDispatched(), quint64(injected));
+
+    const auto expected = [this](const std::function<bool(const QudevDevice&)>& match) {
+        return qsizetype(std::count_if(devices_.cbegin(), devices_.cend(), match));
+    };
+    QCOMPARE(blockSpy.size(), expected([](const QudevDevice& d) { return d.subsystem == QLatin1String("block"); }));
+    QCOMPARE(ttySpy.size(), expected([](const QudevDevice& d) {
+        return d.subsystem == QLatin1String("tty") && d.sysname.startsWith(QLatin1String("tty1"));
+    }));
+
+    blocks.stopMonitoring();
+    QCOMPARE(hub_->subscriberCount(), 1);
+
+    // Destroying the hub first is fine.
+    hub_.reset();
+    ttys.stopMonitoring();
+    QVERIFY(!ttys.monitorHub());
+}
+
+QTEST_GUILESS_MAIN(TestMonitorHub)
+
+#include "test_monitor_hub.moc"
@@ -0,0 +1,228 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include <QTest>
+
+#include <qudev.h>
+#include <qudev_device.h>
+#include <qudev_memory_backend.h>
+#include <qudev_priority.h>
+
+#include <memory>
+
+
+// Priority lanes on the in-memory backend: everything injected before the
+// event loop runs sits in the socket together, so the first read sees the
+// whole burst and delivery order depends on the lanes only.
+class TestPriority : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void classifiesByRules();
+    void arrivalOrderWithoutLanes();
+    void prefersHigherLanes();
+    void keepsDeviceOrder();
+    void promotesStarvedEvents();
+    void deliversWithoutQueueRoom();
+
+private:
+    static QudevDevice event(const char* subsystem, const QString& sysname, const char* action);
+    void inject(const char* subsystem, const QString& sysname, const char* action);
+    void startMonitoring(int starvationMs);
+
+    QudevMemoryBackend* backend_ = nullptr;
+    std::unique_ptr<Qudev> qudev_;
+    QStringList delivered_;   // "sysname action"
+};
+
+void TestPriority::init()
+{
+    auto backend = std::make_unique<QudevMemoryBackend>(QList<QudevDevice>{});
+    backend_ = backend.get();
+    qudev_ = std::make_unique<Qudev>(std::move(backend));
+    delivered_.clear();
+    connect(qudev_.get(), &Qudev::deviceFound, this, [this](const QudevSharedDevice& d) {
+        delivered_ << d->sysname + QLatin1Char(' ') + d->action;
+    });
+}
+
+void TestPriority::cleanup()
+{
+    qudev_.reset();
+    backend_ = nullptr;
+}
+
+QudevDevice TestPriority::event(const char* subsystem, const QString& sysname, const char* action)
+{
+    QudevDevice d;
+    d.subsystem = QString::fromLatin1(subsystem);
+    d.sysname = sysname;
+    d.syspath = QStringLiteral("/sys/devices/test/%1/%2").arg(d.subsystem, sysname);
+    d.action = QString::fromLatin1(action);
+    return d;
+}
+
+void TestPriority::inject(const char* subsystem, const QString& sysname, const char* action)
+{
+    QVERIFY(backend_->inject(event(subsystem, sysname, action)));
+}
+
+void TestPriority::startMonitoring(int starvationMs)
+{
+    QudevPriorityLanes lanes = QudevPriorityLanes::defaults();
+    lanes.starvationMs = starvationMs;
+    qudev_->setPriorityLanes(lanes);
+    QVERIFY(qudev_->startMonitoring());
+}
+
+void TestPriority::classifiesByRules()
+{
+    QudevPriorityLanes lanes = QudevPriorityLanes::defaults();
+    QVERIFY(lanes.isEnabled());
+    QCOMPARE(lanes.laneOf(event("block", QStringLiteral("sda"), "add")), 0);
+    QCOMPARE(lanes.laneOf(event("usb", QStringLiteral("1-1"), "remove")), 0);
+    QCOMPARE(lanes.laneOf(event("power_supply", QStringLiteral("BAT0"), "change")), 2);
+    QCOMPARE(lanes.laneOf(event("net", QStringLiteral("eth0"), "change")), 2);
+    QCOMPARE(lanes.laneOf(event("net", QStringLiteral("eth0"), "add")), 1);
+    QCOMPARE(lanes.laneOf(event("block", QStringLiteral("sda"), "change")), 1);
+
+    // Out-of-range lanes are clamped.
+    QudevPriorityRule rule;
+    rule.filters.subsystem = QStringLiteral("tty");
+    rule.lane = 9;
+    lanes.rules.prepend(rule);
+    lanes.defaultLane = -1;
+    QCOMPARE(lanes.laneOf(event("tty", QStringLiteral("ttyS0"), "add")), QudevPriorityLanes::LaneCount - 1);
+    QCOMPARE(lanes.laneOf(event("input", QStringLiteral("event0"), "add")), 0);
+
+    QVERIFY(!QudevPriorityLanes().isEnabled());
+}
+
+void TestPriority::arrivalOrderWithoutLanes()
+{
+    QVERIFY(qudev_->startMonitoring());
+    QStringList expected;
+    for (int i = 0; i < 10; ++i) {
+        const QString bat = QStringLiteral("BAT%1").arg(i);
+        inject("power_supply", bat, "change");
+        expected << bat + QStringLiteral(" change");
+    }
+    inject("block", QStringLiteral("sda"), "add");
+    expected << QStringLiteral("sda add");
+
+    QTRY_COMPARE(delivered_, expected);
+    QCOMPARE(qudev_->stats().lanes[0].delivered, quint64(0));
+}
+
+void TestPriority::prefersHigherLanes()
+{
+    startMonitoring(0);
+
+    QStringList noise;
+    for (int i = 0; i < 60; ++i) {
+        const QString bat = QStringLiteral("BAT%1").arg(i);
+        inject("power_supply", bat, "change");
+        noise << bat + QStringLiteral(" change");
+    }
+    QStringList urgent;
+    for (const char* disk : { "sda", "sdb", "sdc", "sdd" }) {
+        inject("block", QString::fromLatin1(disk), "add");
+        urgent << QString::fromLatin1(disk) + QStringLiteral(" add");
+    }
+
+    QTRY_COMPARE(delivered_.size(), 64);
+    QCOMPARE(delivered_.mid(0, 4), urgent);
+    QCOMPARE(delivered_.mid(4), noise);
+
+    const QudevStats stats = qudev_->stats();
+    QCOMPARE(stats.lanes[0].delivered, quint64(4));
+    QCOMPARE(stats.lanes[1].delivered, quint64(0));
+    QCOMPARE(stats.lanes[2].delivered, quint64(60));
+    QCOMPARE(stats.lanes[2].maxDepth, quint64(60));
+    QCOMPARE(stats.lanes[2].queueLatency.count, quint64(60));
+    QCOMPARE(stats.lanes[2].starved, quint64(0));
+    QCOMPARE(stats.eventsDelivered, quint64(64));
+}
+
+void TestPriority::keepsDeviceOrder()
+{
+    startMonitoring(0);
+
+    inject("block", QStringLiteral("sdx"), "change");     // lane 1
+    for (int i = 0; i < 10; ++i) {
+        inject("power_supply", QStringLiteral("BAT%1").arg(i), "change");
+    }
+    inject("block", QStringLiteral("sdx"), "remove");     // lane 0, pulls the change along
+    inject("block", QStringLiteral("sdy"), "add");        // lane 0
+    inject("block", QStringLiteral("sdy"), "change");     // lane 1, joins the add
+    inject("net", QStringLiteral("eth0"), "change");      // lane 2
+
+    QStringList expected{
+        QStringLiteral("sdx change"), QStringLiteral("sdx remove"),
+        QStringLiteral("sdy add"), QStringLiteral("sdy change"),
+    };
+    for (int i = 0; i < 10; ++i) {
+        expected << QStringLiteral("BAT%1 change").arg(i);
+    }
+    expected << QStringLiteral("eth0 change");
+
+    QTRY_COMPARE(delivered_, expected);
+}
+
+void TestPriority::promotesStarvedEvents()
+{
+    startMonitoring(30);
+    connect(qudev_.get(), &Qudev::deviceFound, this, [](const QudevSharedDevice& d) {
+        if (d->subsystem == QLatin1String("block")) {
+            QTest::qSleep(10);
+        }
+    });
+
+    inject("power_supply", QStringLiteral("BAT0"), "change");
+    for (int i = 0; i < 10; ++i) {
+        inject("block", QStringLiteral("sd%1").arg(QChar(u'a' + i)), "add");
+    }
+
+    // BAT0 overtakes the disks still queued once it waited 30 ms.
+    QTRY_COMPARE(delivered_.size(), 11);
+    const qsizetype position = delivered_.indexOf(QStringLiteral("BAT0 change"));
+    QVERIFY2(position > 0 && position < 10, qPrintable(delivered_.join(QLatin1String(", "))));
+
+    const QudevStats stats = qudev_->stats();
+    QCOMPARE(stats.lanes[2].starved, quint64(1));
+    QVERIFY(stats.lanes[2].queueLatency.maxNs >= 30000000ull);
+}
+
+void TestPriority::deliversWithoutQueueRoom()
+{
+    // No room is treated as room for one event, read and delivered in turn.
+    QudevPriorityLanes lanes = QudevPriorityLanes::defaults();
+    lanes.maxQueued = 0;
+    qudev_->setPriorityLanes(lanes);
+    QVERIFY(qudev_->startMonitoring());
+
+    QStringList expected;
+    for (int i = 0; i < 5; ++i) {
+        const QString bat = QStringLiteral("BAT%1").arg(i);
+        inject("power_supply", bat, "change");
+        expected << bat + QStringLiteral(" change");
+    }
+    inject("block", QStringLiteral("sda"), "add");
+    expected << QStringLiteral("sda add");
+
+    QTRY_COMPARE(delivered_, expected);
+    QCOMPARE(qudev_->stats().lanes[2].maxDepth, quint64(1));
+}
+
+QTEST_GUILESS_MAIN(TestPriority)
+
+#include "test_priority.moc"
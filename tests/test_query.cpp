@@ -0,0 +1,369 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include <QTest>
+#include <QSignalSpy>
+
+#include <qudev.h>
+#include <qudev_device.h>
+#include <qudev_filters.h>
+#include <qudev_index.h>
+#include <qudev_memory_backend.h>
+#include <qudev_query.h>
+
+#include <algorithm>
+#include <functional>
+
+
+namespace {
+
+using Predicate = std::function<bool(const QudevDevice&)>;
+
+QudevDevice named(const QString& sysname)
+{
+    QudevDevice d;
+    d.syspath = QStringLiteral("/sys/devices/virtual/tty/") + sysname;
+    d.sysname = sysname;
+    d.subsystem = QStringLiteral("tty");
+    return d;
+}
+
+} // namespace
+Q_DECLARE_METATYPE(Predicate)
+
+class TestQuery : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void parses_data();
+    void parses();
+    void reportsErrors_data();
+    void reportsErrors();
+    void matchesGlobs_data();
+    void matchesGlobs();
+    void evaluates_data();
+    void evaluates();
+    void pushesDown();
+    void residualCompletesFilters_data();
+    void residualCompletesFilters();
+    void appliesToQudev();
+
+private:
+    QList<QudevDevice> devices_;
+    QudevIndex unindexed_;
+};
+
+void TestQuery::initTestCase()
+{
+    devices_ = QudevMemoryBackend::generateDevices(2000);
+    for (const auto& d : devices_) {
+        unindexed_.insert(QudevSharedDevice(d));
+    }
+}
+
+void TestQuery::parses_data()
+{
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<QString>("printed");
+
+    QTest::newRow("empty") << QString() << QString();
+    QTest::newRow("blank") << QStringLiteral("  ") << QString();
+    QTest::newRow("term") << QStringLiteral("subsystem==block") << QStringLiteral("subsystem==\"block\"");
+    QTest::newRow("precedence") << QStringLiteral("a && b || !c") << QStringLiteral("((a && b) || !c)");
+    QTest::newRow("parentheses") << QStringLiteral("a && (b || c) && d") << QStringLiteral("(a && (b || c) && d)");
+    QTest::newRow("tag+glob") << QStringLiteral("tag:systemd&&sysname==tty*")
+                              << QStringLiteral("(tag:\"systemd\" && sysname==tty*)");
+    QTest::newRow("attr") << QStringLiteral("attr:removable != \"1\"") << QStringLiteral("attr:removable!=\"1\"");
+    QTest::newRow("escapes") << QStringLiteral("ID_MODEL==\"a \\\"b\\\" \\\\\"")
+                             << QStringLiteral("ID_MODEL==\"a \\\"b\\\" \\\\\"");
+    QTest::newRow("not-tag") << QStringLiteral("!!tag!=seat") << QStringLiteral("!!tag!=\"seat\"");
+}
+
+void TestQuery::parses()
+{
+    QFETCH(QString, text);
+    QFETCH(QString, printed);
+
+    const QudevQuery query(text);
+    QVERIFY2(query.isValid(), qPrintable(query.errorString()));
+    QCOMPARE(query.errorPosition(), qsizetype(-1));
+    QCOMPARE(query.text(), text);
+    QCOMPARE(query.isEmpty(), printed.isEmpty());
+    QCOMPARE(query.toString(), printed);
+
+    // The printed form parses to the same query.
+    QCOMPARE(QudevQuery(printed).toString(), printed);
+}
+
+void TestQuery::reportsErrors_data()
+{
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<qsizetype>("position");
+
+    QTest::newRow("no-value") << QStringLiteral("subsystem==") << qsizetype(11);
+    QTest::newRow("unclosed") << QStringLiteral("(subsystem==block") << qsizetype(17);
+    QTest::newRow("single-and") << QStringLiteral("a & b") << qsizetype(2);
+    QTest::newRow("unterminated") << QStringLiteral("sysname==\"tty") << qsizetype(9);
+    QTest::newRow("juxtaposed") << QStringLiteral("a b") << qsizetype(2);
+    QTest::newRow("bare-tag") << QStringLiteral("tag") << qsizetype(3);
+    QTest::newRow("leading-operator") << QStringLiteral("&& a") << qsizetype(0);
+    QTest::newRow("trailing-operator") << QStringLiteral("a ||") << qsizetype(4);
+    QTest::newRow("empty-attr") << QStringLiteral("attr:==1") << qsizetype(5);
+    QTest::newRow("deep-not") << QString(100000, QLatin1Char('!')) + QStringLiteral("a") << qsizetype(64);
+    QTest::newRow("deep-parentheses") << QString(100000, QLatin1Char('(')) + QStringLiteral("a") << qsizetype(64);
+}
+
+void TestQuery::reportsErrors()
+{
+    QFETCH(QString, text);
+    QFETCH(qsizetype, position);
+
+    const QudevQuery query(text);
+    QVERIFY(!query.isValid());
+    QVERIFY(!query.errorString().isEmpty());
+    QCOMPARE(query.errorPosition(), position);
+    QVERIFY(!query.matches(devices_.first()));
+    QVERIFY(!query.matchesResidual(devices_.first()));
+}
+
+void TestQuery::matchesGlobs_data()
+{
+    QTest::addColumn<QString>("value");
+    QTest::addColumn<QString>("sysname");
+    QTest::addColumn<bool>("match");
+
+    QTest::newRow("star") << QStringLiteral("tty*") << QStringLiteral("tty12") << true;
+    QTest::newRow("star-empty") << QStringLiteral("tty*") << QStringLiteral("tty") << true;
+    QTest::newRow("question") << QStringLiteral("tty?") << QStringLiteral("tty12") << false;
+    QTest::newRow("questions") << QStringLiteral("tty??") << QStringLiteral("tty12") << true;
+    QTest::newRow("range") << QStringLiteral("tty[0-9]*") << QStringLiteral("tty12") << true;
+    QTest::newRow("negated") << QStringLiteral("tty[!0-9]*") << QStringLiteral("ttyS0") << true;
+    QTest::newRow("negated-miss") << QStringLiteral("tty[^0-9]*") << QStringLiteral("tty1") << false;
+    QTest::newRow("set") << QStringLiteral("sd[abc]") << QStringLiteral("sdb") << true;
+    QTest::newRow("bracket-member") << QStringLiteral("x[]]") << QStringLiteral("x]") << true;
+    QTest::newRow("backtrack") << QStringLiteral("*1*2") << QStringLiteral("tty1212") << true;
+    QTest::newRow("backtrack-miss") << QStringLiteral("*1*2") << QStringLiteral("tty121") << false;
+    QTest::newRow("unterminated-bracket") << QStringLiteral("x[a") << QStringLiteral("x[a") << true;
+    QTest::newRow("escaped-star") << QStringLiteral("tty\\*") << QStringLiteral("tty*") << true;
+    QTest::newRow("escaped-star-literal") << QStringLiteral("tty\\*") << QStringLiteral("tty12") << false;
+    QTest::newRow("escaped-letter") << QStringLiteral("tt\\y1") << QStringLiteral("tty1") << true;
+    QTest::newRow("escaped-in-bracket") << QStringLiteral("x[\\]a]") << QStringLiteral("x]") << true;
+    QTest::newRow("escaped-in-set") << QStringLiteral("x[\\^a]") << QStringLiteral("x\\") << false;
+    QTest::newRow("trailing-backslash") << QStringLiteral("tty\\") << QStringLiteral("tty\\") << false;
+    QTest::newRow("quoted-literal") << QStringLiteral("\"tty*\"") << QStringLiteral("tty12") << false;
+    QTest::newRow("quoted-exact") << QStringLiteral("\"tty*\"") << QStringLiteral("tty*") << true;
+}
+
+void TestQuery::matchesGlobs()
+{
+    QFETCH(QString, value);
+    QFETCH(QString, sysname);
+    QFETCH(bool, match);
+
+    const QudevQuery query(QStringLiteral("sysname==") + value);
+    QVERIFY2(query.isValid(), qPrintable(query.errorString()));
+    QCOMPARE(query.matches(named(sysname)), match);
+    QCOMPARE(QudevQuery(QStringLiteral("sysname!=") + value).matches(named(sysname)), !match);
+}
+
+void TestQuery::evaluates_data()
+{
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<Predicate>("expected");
+
+    QTest::newRow("or-not") << QStringLiteral("subsystem==block && (ID_BUS==usb || ID_BUS==ata) && !tag:uaccess")
+                            << Predicate([](const QudevDevice& d) {
+                                   const QString bus = d.properties.value(QStringLiteral("ID_BUS"));
+                                   return d.subsystem == QLatin1String("block")
+                                          && (bus == QLatin1String("usb") || bus == QLatin1String("ata"))
+                                          && !d.tags.contains(QStringLiteral("uaccess"));
+                               });
+    QTest::newRow("not-or") << QStringLiteral("!(subsystem==tty || subsystem==net) && driver")
+                            << Predicate([](const QudevDevice& d) {
+                                   return d.subsystem != QLatin1String("tty") && d.subsystem != QLatin1String("net")
+                                          && !d.driver.isEmpty();
+                               });
+    QTest::newRow("attr-or-glob") << QStringLiteral("attr:removable==1 || devnode==/dev/sd*")
+                                  << Predicate([](const QudevDevice& d) {
+                                         return d.sysattrs.value(QStringLiteral("removable")) == QLatin1String("1")
+                                                || d.devnode.startsWith(QLatin1String("/dev/sd"));
+                                     });
+    QTest::newRow("devtype-property") << QStringLiteral("devtype==partition")
+                                      << Predicate([](const QudevDevice& d) {
+                                             return d.devtype == QLatin1String("partition");
+                                         });
+    QTest::newRow("missing-property") << QStringLiteral("ID_NOTHING!=x && !ID_NOTHING")
+                                      << Predicate([](const QudevDevice&) { return true; });
+    QTest::newRow("empty") << QString() << Predicate([](const QudevDevice&) { return true; });
+}
+
+void TestQuery::evaluates()
+{
+    QFETCH(QString, text);
+    QFETCH(Predicate, expected);
+
+    const QudevQuery query(text);
+    QVERIFY2(query.isValid(), qPrintable(query.errorString()));
+
+    qsizetype matched = 0;
+    for (const QudevDevice& d : devices_) {
+        QCOMPARE(query.matches(d), expected(d));
+        matched += query.matches(d) ? 1 : 0;
+    }
+    QVERIFY(matched > 0);
+}
+
+void TestQuery::pushesDown()
+{
+    const QudevQuery all(QStringLiteral(
+        "subsystem==block && tag:uaccess && ID_BUS==usb && attr:removable==1"
+        " && attr:size!=0 && syspath==/sys/devices/pci0000:00/* && (action==add || action==change)"));
+    QVERIFY(all.isValid());
+    QVERIFY(!all.hasResidual());
+    const QudevFilters& f = all.filters();
+    QCOMPARE(f.subsystem, QStringLiteral("block"));
+    QCOMPARE(f.tags, QStringList{ QStringLiteral("uaccess") });
+    QCOMPARE(f.properties.value(QStringLiteral("ID_BUS")), QStringLiteral("usb"));
+    QCOMPARE(f.sysattrs.value(QStringLiteral("removable")), QStringLiteral("1"));
+    QCOMPARE(f.nomatchSysattrs.value(QStringLiteral("size")), QStringLiteral("0"));
+    QCOMPARE(f.syspathPrefix, QStringLiteral("/sys/devices/pci0000:00/"));
+    QCOMPARE(f.actions, (QStringList{ QStringLiteral("add"), QStringLiteral("change") }));
+
+    // Only the conjuncts QudevFilters can express are pushed.
+    const QudevQuery partial(QStringLiteral("subsystem==block && (ID_BUS==usb || driver==x) && sysname==sd*"));
+    QCOMPARE(partial.filters().subsystem, QStringLiteral("block"));
+    QVERIFY(partial.filters().properties.isEmpty());
+    QVERIFY(partial.filters().sysname.isEmpty());
+    QVERIFY(partial.hasResidual());
+
+    // Nothing is common to both branches of an OR.
+    const QudevQuery either(QStringLiteral("subsystem==block || subsystem==tty"));
+    QVERIFY(either.filters().subsystem.isEmpty());
+    QVERIFY(either.hasResidual());
+
+    // A second comparison of the same field stays in the residual.
+    const QudevQuery twice(QStringLiteral("subsystem==block && subsystem==tty"));
+    QCOMPARE(twice.filters().subsystem, QStringLiteral("block"));
+    QVERIFY(twice.hasResidual());
+
+    // An exact syspath narrows by prefix and is still compared.
+    const QudevQuery exact(QStringLiteral("syspath==/sys/devices/x"));
+    QCOMPARE(exact.filters().syspathPrefix, QStringLiteral("/sys/devices/x"));
+    QVERIFY(exact.hasResidual());
+    QVERIFY(!exact.matches(named(QStringLiteral("x"))));
+
+    // libudev globs what it is given, so quoted glob characters stay here.
+    const QudevQuery quoted(QStringLiteral("sysname==\"sd*\" && syspath==\"/sys/x*\" && attr:size!=\"[0]\""));
+    QVERIFY(quoted.filters().sysname.isEmpty());
+    QVERIFY(quoted.filters().syspathPrefix.isEmpty());
+    QVERIFY(quoted.filters().nomatchSysattrs.isEmpty());
+    QVERIFY(quoted.hasResidual());
+
+    // libudev ORs property matches, devtype among them: only one is pushed.
+    const QudevQuery properties(QStringLiteral("devtype==disk && ID_BUS==usb && ID_TYPE==disk"));
+    QCOMPARE(properties.filters().devtype, QStringLiteral("disk"));
+    QVERIFY(properties.filters().properties.isEmpty());
+    QVERIFY(properties.hasResidual());
+    const QudevQuery twoProperties(QStringLiteral("ID_BUS==usb && ID_TYPE==disk"));
+    QCOMPARE(twoProperties.filters().properties.size(), 1);
+    QVERIFY(twoProperties.hasResidual());
+}
+
+void TestQuery::residualCompletesFilters_data()
+{
+    QTest::addColumn<QString>("text");
+
+    QTest::newRow("pushed") << QStringLiteral("subsystem==block && tag:uaccess && ID_BUS==usb");
+    QTest::newRow("mixed") << QStringLiteral("subsystem==tty && (attr:removable==1 || sysname==tty1*) && !driver");
+    QTest::newRow("prefix") << QStringLiteral("syspath==/sys/devices/pci0000:00/0000:00:1* && devtype==partition");
+    QTest::newRow("nomatch") << QStringLiteral("attr:removable!=1 && (action==add || action==remove)");
+    QTest::newRow("or-only") << QStringLiteral("subsystem==net || tag:uaccess");
+}
+
+void TestQuery::residualCompletesFilters()
+{
+    QFETCH(QString, text);
+
+    const QudevQuery query(text);
+    QVERIFY2(query.isValid(), qPrintable(query.errorString()));
+
+    // What libudev would return for filters(), finished by the residual.
+    QStringList split;
+    for (const QudevSharedDevice& d : unindexed_.select(query.filters())) {
+        if (query.matchesResidual(d)) {
+            split << d->syspath;
+        }
+    }
+    QStringList whole;
+    for (const QudevDevice& d : devices_) {
+        if (query.matches(d)) {
+            whole << d.syspath;
+        }
+    }
+    split.sort();
+    whole.sort();
+    QVERIFY(!whole.isEmpty());
+    QCOMPARE(split, whole);
+}
+
+void TestQuery::appliesToQudev()
+{
+    auto backend = std::make_unique<QudevMemoryBackend>(devices_);
+    QudevMemoryBackend* source = backend.get();
+    Qudev qudev(std::move(backend));
+
+    const QString text = QStringLiteral("subsystem==tty && (sysname==tty1* || attr:removable==1)");
+    const QudevQuery query(text);
+    const qsizetype expected = std::count_if(devices_.cbegin(), devices_.cend(),
+                                             [&query](const QudevDevice& d) { return query.matches(d); });
+
+    QVERIFY(qudev.setQuery(text));
+    QCOMPARE(qudev.query(), text);
+    QCOMPARE(qudev.filters().subsystem, QStringLiteral("tty"));
+    QCOMPARE(qudev.enumerate().size(), expected);
+
+    qsizetype chunked = 0;
+    QVERIFY(qudev.enumerate(7, [&chunked](QList<QudevDevice> chunk) {
+        chunked += chunk.size();
+        return true;
+    }));
+    QCOMPARE(chunked, expected);
+
+    // A bad query leaves the configuration alone.
+    QVERIFY(!qudev.setQuery(QStringLiteral("subsystem==")));
+    QCOMPARE(qudev.query(), text);
+
+    // Events are filtered the same way.
+    QSignalSpy spy(&qudev, &Qudev::deviceFound);
+    QVERIFY(qudev.startMonitoring());
+    for (const QudevDevice& d : devices_) {
+        if (d.subsystem == QLatin1String("tty")) {
+            QudevDevice e = d;
+            e.action = QStringLiteral("change");
+            source->inject(e);
+        }
+    }
+    QTRY_COMPARE(spy.size(), expected);
+
+    // Filters replace the query.
+    QudevFilters filters;
+    filters.subsystem = QStringLiteral("tty");
+    qudev.setFilters(filters);
+    QVERIFY(qudev.query().isEmpty());
+    QCOMPARE(qudev.enumerate().size(),
+             qsizetype(std::count_if(devices_.cbegin(), devices_.cend(), [](const QudevDevice& d) {
+                 return d.subsystem == QLatin1String("tty");
+             })));
+}
+
+QTEST_GUILESS_MAIN(TestQuery)
+
+#include "test_query.moc"
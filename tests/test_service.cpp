@@ -0,0 +1,93 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include <QTest>
+#include <QSignalSpy>
+
+#include "qudev_service.h"
+
+
+// Exercises the latest-wins scan handling of the viewer's QudevService and
+// reports how much enumeration work is thrown away by superseded scans.
+class TestService : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void rapidScansCoalesce();
+    void filterChangesCancelScan();
+
+private:
+    static void report(const char* name, const QudevService::ScanStats& stats);
+};
+
+void TestService::report(const char* name, const QudevService::ScanStats& stats)
+{
+    qInfo().nospace() << "[" << name << "] requested=" << stats.requested
+                      << " run=" << stats.run
+                      << " coalesced=" << stats.coalesced()
+                      << " cancelled=" << stats.cancelled
+                      << " devicesDelivered=" << stats.devicesDelivered
+                      << " devicesWasted=" << stats.devicesWasted;
+}
+
+void TestService::rapidScansCoalesce()
+{
+    constexpr int Requests = 50;
+
+    QudevService service;
+    QSignalSpy finished(&service, &QudevService::scanFinished);
+
+    for (int i = 0; i < Requests; ++i) {
+        QVERIFY(service.scan());
+    }
+
+    QTRY_COMPARE_WITH_TIMEOUT(finished.count(), 1, 60000);
+    QVERIFY(!service.scanning());
+
+    const QudevService::ScanStats stats = service.scanStats();
+    report("rapidScansCoalesce", stats);
+
+    QCOMPARE(stats.requested, quint64(Requests));
+    // Only the first request may start before the rest supersede it.
+    QVERIFY(stats.run <= 2);
+    QVERIFY(stats.cancelled + 1 == stats.run);
+}
+
+void TestService::filterChangesCancelScan()
+{
+    constexpr int Edits = 20;
+
+    QudevService service;
+    QSignalSpy finished(&service, &QudevService::scanFinished);
+
+    QVERIFY(service.scan());
+
+    QudevFilters last;
+    for (int i = 0; i < Edits; ++i) {
+        last.sysname = QStringLiteral("qudev-test-%1").arg(i);
+        service.setFilters(last);
+    }
+
+    QTRY_COMPARE_WITH_TIMEOUT(finished.count(), 1, 60000);
+    QVERIFY(!service.scanning());
+    QCOMPARE(service.filters(), last);
+
+    const QudevService::ScanStats stats = service.scanStats();
+    report("filterChangesCancelScan", stats);
+
+    // One explicit scan plus one restart per filter edit.
+    QCOMPARE(stats.requested, quint64(Edits + 1));
+    QVERIFY(stats.run <= 2);
+    // The surviving scan used the last filter, which matches nothing.
+    QCOMPARE(stats.devicesDelivered, quint64(0));
+}
+
+QTEST_GUILESS_MAIN(TestService)
+
+#include "test_service.moc"
@@ -0,0 +1,218 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include <QTest>
+#include <QThread>
+
+#include <qudev_memory_backend.h>
+#include <qudev_shared_snapshot.h>
+
+#include <atomic>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+class TestSharedSnapshot : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void readsPublication();
+    void followsNewPublications();
+    void consistentUnderConcurrentWriter();
+    void rejectsOversizedSnapshot();
+    void rejectsUnsealedRegion();
+    void readersCannotWrite();
+
+private:
+    /// The first @p count devices, all carrying @p seqnum.
+    QList<QudevDevice> batch(qsizetype count, quint64 seqnum) const;
+
+    QList<QudevDevice> devices_;
+};
+
+void TestSharedSnapshot::initTestCase()
+{
+    devices_ = QudevMemoryBackend::generateDevices(200);
+}
+
+QList<QudevDevice> TestSharedSnapshot::batch(qsizetype count, quint64 seqnum) const
+{
+    QList<QudevDevice> out = devices_.first(count);
+    for (QudevDevice& d : out) {
+        d.seqnum = seqnum;
+    }
+    return out;
+}
+
+void TestSharedSnapshot::readsPublication()
+{
+    QudevSharedSnapshotWriter writer;
+    QVERIFY2(writer.isValid(), qPrintable(writer.errorString()));
+
+    QudevSharedSnapshotReader reader(writer.fd());
+    QVERIFY2(reader.isValid(), qPrintable(reader.errorString()));
+
+    // Nothing published yet.
+    bool ran = false;
+    QCOMPARE(reader.read([&](const QudevSnapshotReader&) { ran = true; }), quint64(0));
+    QVERIFY(!ran);
+
+    QVERIFY(writer.publish(qudevEncodeSnapshot(devices_)));
+    QCOMPARE(reader.generation(), quint64(1));
+
+    QList<QudevDevice> seen;
+    QCOMPARE(reader.read([&](const QudevSnapshotReader& snapshot) { seen = snapshot.devices(); }),
+             quint64(1));
+    QCOMPARE(seen.size(), devices_.size());
+    for (qsizetype i = 0; i < seen.size(); ++i) {
+        QCOMPARE(seen.at(i).syspath, devices_.at(i).syspath);
+        QCOMPARE(seen.at(i).properties, devices_.at(i).properties);
+    }
+}
+
+void TestSharedSnapshot::followsNewPublications()
+{
+    QudevSharedSnapshotWriter writer;
+    QudevSharedSnapshotReader reader(writer.fd());
+    QVERIFY(reader.isValid());
+
+    for (quint64 g = 1; g <= 5; ++g) {
+        QVERIFY(writer.publish(qudevEncodeSnapshot(batch(qsizetype(g) * 10, g))));
+
+        qsizetype count = 0;
+        quint64 seqnum = 0;
+        QCOMPARE(reader.read([&](const QudevSnapshotReader& snapshot) {
+            count = snapshot.deviceCount();
+            seqnum = snapshot.device(0).seqnum();
+        }), g);
+        QCOMPARE(count, qsizetype(g) * 10);
+        QCOMPARE(seqnum, g);
+    }
+
+    // Without a writer in between nothing is ever retried.
+    QCOMPARE(reader.retries(), quint64(0));
+}
+
+void TestSharedSnapshot::consistentUnderConcurrentWriter()
+{
+    QudevSharedSnapshotWriter writer(256 * 1024);
+    QVERIFY(writer.isValid());
+
+    // Publication k of the cycle holds k + 1 devices, all with seqnum k.
+    QList<QByteArray> encoded;
+    for (quint64 g = 0; g < 50; ++g) {
+        encoded << qudevEncodeSnapshot(batch(qsizetype(g) + 1, g));
+    }
+    QVERIFY(writer.publish(encoded.first()));
+
+    QudevSharedSnapshotReader reader(writer.fd());
+    QVERIFY(reader.isValid());
+
+    std::atomic<bool> stop{ false };
+    std::unique_ptr<QThread> thread(QThread::create([&] {
+        for (quint64 g = 2; !stop.load(std::memory_order_relaxed); ++g) {
+            writer.publish(encoded.at(qsizetype(g % 50)));
+        }
+    }));
+    thread->start();
+
+    // Checked after the writer stopped: it must not outlive a failed QVERIFY.
+    int inconsistent = 0;
+    for (int i = 0; i < 20000; ++i) {
+        qsizetype count = 0;
+        bool uniform = true;
+        quint64 seqnum = 0;
+        reader.read([&](const QudevSnapshotReader& snapshot) {
+            count = snapshot.deviceCount();
+            seqnum = count ? snapshot.device(0).seqnum() : 0;
+            uniform = snapshot.isValid() && count > 0;
+            for (qsizetype j = 0; j < count; ++j) {
+                uniform = uniform && snapshot.device(j).seqnum() == seqnum;
+            }
+        });
+        if (!uniform || count != qsizetype(seqnum) + 1) {
+            ++inconsistent;
+        }
+    }
+
+    stop = true;
+    thread->wait();
+    QCOMPARE(inconsistent, 0);
+    qInfo() << "[TestSharedSnapshot]" << reader.retries() << "retries over 20000 reads";
+}
+
+void TestSharedSnapshot::rejectsOversizedSnapshot()
+{
+    QudevSharedSnapshotWriter writer(1024);
+    QVERIFY(writer.isValid());
+    QVERIFY(writer.publish(qudevEncodeSnapshot(devices_.first(1))));
+
+    QVERIFY(!writer.publish(qudevEncodeSnapshot(devices_)));
+    QVERIFY(!writer.errorString().isEmpty());
+    QCOMPARE(writer.generation(), quint64(1));
+
+    QudevSharedSnapshotReader reader(writer.fd());
+    qsizetype count = 0;
+    QCOMPARE(reader.read([&](const QudevSnapshotReader& snapshot) { count = snapshot.deviceCount(); }),
+             quint64(1));
+    QCOMPARE(count, qsizetype(1));
+}
+
+void TestSharedSnapshot::rejectsUnsealedRegion()
+{
+    const int fd = ::memfd_create("unsealed", MFD_CLOEXEC);
+    QVERIFY(fd >= 0);
+    QCOMPARE(::ftruncate(fd, 1 << 20), 0);
+
+    QudevSharedSnapshotReader reader(fd);
+    QVERIFY(!reader.isValid());
+    QVERIFY(!reader.errorString().isEmpty());
+    QCOMPARE(reader.read([](const QudevSnapshotReader&) {}), quint64(0));
+    ::close(fd);
+}
+
+void TestSharedSnapshot::readersCannotWrite()
+{
+    QudevSharedSnapshotWriter writer(4096);
+    QVERIFY2(writer.isValid(), qPrintable(writer.errorString()));
+    QVERIFY(writer.publish(qudevEncodeSnapshot(devices_.first(1))));
+
+    // The descriptor the broker passes to clients.
+    const int fd = writer.fd();
+    struct stat st;
+    QCOMPARE(::fstat(fd, &st), 0);
+    const size_t size = size_t(st.st_size);
+
+    QVERIFY(::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) == MAP_FAILED);
+
+    void* map = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    QVERIFY(map != MAP_FAILED);
+    QVERIFY(::mprotect(map, size, PROT_READ | PROT_WRITE) < 0);
+    ::munmap(map, size);
+
+    const char byte = 0;
+    QVERIFY(::pwrite(fd, &byte, 1, 0) < 0);
+    QVERIFY(::ftruncate(fd, 0) < 0);
+
+    // The writer itself keeps publishing.
+    QVERIFY(writer.publish(qudevEncodeSnapshot(devices_.first(2))));
+    QudevSharedSnapshotReader reader(fd);
+    qsizetype count = 0;
+    QCOMPARE(reader.read([&](const QudevSnapshotReader& snapshot) { count = snapshot.deviceCount(); }),
+             quint64(2));
+    QCOMPARE(count, qsizetype(2));
+}
+
+QTEST_GUILESS_MAIN(TestSharedSnapshot)
+
+#include "test_shared_snapshot.moc"
@@ -0,0 +1,227 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include <QTest>
+#include <QDataStream>
+
+#include <qudev_memory_backend.h>
+#include <qudev_snapshot.h>
+
+
+class TestSnapshot : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void roundTrip();
+    void emptySnapshot();
+    void views();
+    void rawData();
+    void rejectsCorruptData();
+    void dataStreamRoundTrip();
+    void dataStreamRejectsUnknownVersion();
+
+private:
+    static void compareDevices(const QudevDevice& actual, const QudevDevice& expected);
+
+    QList<QudevDevice> devices_;
+};
+
+void TestSnapshot::initTestCase()
+{
+    devices_ = QudevMemoryBackend::generateDevices(300);
+
+    // Non-ASCII values, empty strings and every flag must survive too.
+    QudevDevice d;
+    d.syspath = QStringLiteral("/sys/devices/virtual/misc/tést");
+    d.subsystem = QStringLiteral("misc");
+    d.properties.insert(QStringLiteral("ID_MODEL"), QStringLiteral("日本"));
+    d.properties.insert(QStringLiteral("EMPTY"), QString());
+    d.tags << QStringLiteral("seat") << QStringLiteral("uaccess");
+    d.major = 0xffffffffu;
+    d.seqnum = ~quint64(0);
+    d.isBlock = true;
+    d.isChar = true;
+    devices_ << d;
+}
+
+void TestSnapshot::compareDevices(const QudevDevice& actual, const QudevDevice& expected)
+{
+    QCOMPARE(actual.syspath, expected.syspath);
+    QCOMPARE(actual.devnode, expected.devnode);
+    QCOMPARE(actual.subsystem, expected.subsystem);
+    QCOMPARE(actual.devtype, expected.devtype);
+    QCOMPARE(actual.sysname, expected.sysname);
+    QCOMPARE(actual.driver, expected.driver);
+    QCOMPARE(actual.major, expected.major);
+    QCOMPARE(actual.minor, expected.minor);
+    QCOMPARE(actual.properties, expected.properties);
+    QCOMPARE(actual.sysattrs, expected.sysattrs);
+    QCOMPARE(actual.devlinks, expected.devlinks);
+    QCOMPARE(actual.tags, expected.tags);
+    QCOMPARE(actual.parent_syspath, expected.parent_syspath);
+    QCOMPARE(actual.parent_subsystem, expected.parent_subsystem);
+    QCOMPARE(actual.action, expected.action);
+    QCOMPARE(actual.seqnum, expected.seqnum);
+    QCOMPARE(actual.isBlock, expected.isBlock);
+    QCOMPARE(actual.isChar, expected.isChar);
+}
+
+void TestSnapshot::roundTrip()
+{
+    const QByteArray data = qudevEncodeSnapshot(devices_);
+    const QudevSnapshotReader reader(data);
+    QVERIFY2(reader.isValid(), qPrintable(reader.errorString()));
+    QCOMPARE(reader.version(), QudevSnapshotReader::FormatVersion);
+    QCOMPARE(reader.deviceCount(), devices_.size());
+
+    const QList<QudevDevice> decoded = reader.devices();
+    QCOMPARE(decoded.size(), devices_.size());
+    for (qsizetype i = 0; i < decoded.size(); ++i) {
+        compareDevices(decoded.at(i), devices_.at(i));
+        if (QTest::currentTestFailed()) {
+            qWarning() << "device" << i;
+            return;
+        }
+    }
+}
+
+void TestSnapshot::emptySnapshot()
+{
+    const QudevSnapshotReader reader(qudevEncodeSnapshot({}));
+    QVERIFY(reader.isValid());
+    QCOMPARE(reader.deviceCount(), qsizetype(0));
+    QVERIFY(reader.devices().isEmpty());
+}
+
+void TestSnapshot::views()
+{
+    const QByteArray data = qudevEncodeSnapshot(devices_);
+    const QudevSnapshotReader reader(data);
+    QVERIFY(reader.isValid());
+
+    for (qsizetype i = 0; i < reader.deviceCount(); ++i)
+    {
+        const QudevDevice& expected = devices_.at(i);
+        const QudevSnapshotReader::DeviceView view = reader.device(i);
+
+        QCOMPARE(view.syspath().toString(), expected.syspath);
+        QCOMPARE(view.subsystem().toString(), expected.subsystem);
+        QCOMPARE(view.driver().toString(), expected.driver);
+        QCOMPARE(view.major(), expected.major);
+        QCOMPARE(view.seqnum(), expected.seqnum);
+        QCOMPARE(view.isBlock(), expected.isBlock);
+
+        // Views point into the encoded data.
+        if (!view.syspath().isEmpty()) {
+            QVERIFY(view.syspath().data() >= data.constData());
+            QVERIFY(view.syspath().data() < data.constData() + data.size());
+        }
+
+        for (auto it = expected.properties.cbegin(); it != expected.properties.cend(); ++it) {
+            const QByteArray key = it.key().toUtf8();
+            QCOMPARE(view.property(QUtf8StringView(key)).toString(), it.value());
+        }
+        for (auto it = expected.sysattrs.cbegin(); it != expected.sysattrs.cend(); ++it) {
+            const QByteArray key = it.key().toUtf8();
+            QCOMPARE(view.sysattr(QUtf8StringView(key)).toString(), it.value());
+        }
+        for (const QString& tag : expected.tags) {
+            const QByteArray t = tag.toUtf8();
+            QVERIFY(view.hasTag(QUtf8StringView(t)));
+        }
+
+        QVERIFY(view.property(u8"NO_SUCH_PROPERTY").isNull());
+        QVERIFY(!view.hasTag(u8"no-such-tag"));
+    }
+}
+
+void TestSnapshot::rawData()
+{
+    const QByteArray data = qudevEncodeSnapshot(devices_);
+    const QudevSnapshotReader reader(data.constData(), data.size());
+    QVERIFY(reader.isValid());
+    QCOMPARE(reader.deviceCount(), devices_.size());
+    compareDevices(reader.device(0).toDevice(), devices_.first());
+}
+
+void TestSnapshot::rejectsCorruptData()
+{
+    const QByteArray data = qudevEncodeSnapshot(devices_);
+
+    QVERIFY(!QudevSnapshotReader(QByteArray()).isValid());
+    QVERIFY(!QudevSnapshotReader(QByteArray("QUDEVSNX") + data.mid(8)).isValid());
+
+    // Truncation anywhere is detected.
+    for (qsizetype size : { qsizetype(16), data.size() / 2, data.size() - 1 }) {
+        const QudevSnapshotReader reader(data.left(size));
+        QVERIFY(!reader.isValid());
+        QVERIFY(!reader.errorString().isEmpty());
+        QCOMPARE(reader.deviceCount(), qsizetype(0));
+    }
+
+    // A reader refuses data that needs a newer reader...
+    QByteArray newer = data;
+    newer[10] = char(QudevSnapshotReader::FormatVersion + 1);
+    QVERIFY(!QudevSnapshotReader(newer).isValid());
+
+    // ...but reads newer data that stays compatible.
+    QByteArray compatible = data;
+    compatible[8] = char(QudevSnapshotReader::FormatVersion + 1);
+    QVERIFY(QudevSnapshotReader(compatible).isValid());
+
+    // Flipping bytes never crashes; most flips are caught.
+    for (qsizetype i = 32; i < data.size(); i += 97) {
+        QByteArray flipped = data;
+        flipped[i] = char(~flipped.at(i));
+        const QudevSnapshotReader reader(flipped);
+        if (reader.isValid()) {
+            reader.devices();
+        }
+    }
+}
+
+void TestSnapshot::dataStreamRoundTrip()
+{
+    QByteArray data;
+    {
+        QDataStream out(&data, QIODevice::WriteOnly);
+        out << devices_;
+    }
+
+    QList<QudevDevice> decoded;
+    QDataStream in(data);
+    in >> decoded;
+    QCOMPARE(in.status(), QDataStream::Ok);
+    QCOMPARE(decoded.size(), devices_.size());
+    for (qsizetype i = 0; i < decoded.size(); ++i) {
+        compareDevices(decoded.at(i), devices_.at(i));
+    }
+}
+
+void TestSnapshot::dataStreamRejectsUnknownVersion()
+{
+    QByteArray data;
+    {
+        QDataStream out(&data, QIODevice::WriteOnly);
+        out << devices_.first();
+    }
+    data[0] = char(0x7f);
+
+    QudevDevice decoded;
+    QDataStream in(data);
+    in >> decoded;
+    QCOMPARE(in.status(), QDataStream::ReadCorruptData);
+    QVERIFY(decoded.syspath.isEmpty());
+}
+
+QTEST_GUILESS_MAIN(TestSnapshot)
+
+#include "test_snapshot.moc"
@@ -0,0 +1,196 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include <QTest>
+#include <QSignalSpy>
+
+#include <qudev.h>
+#include <qudev_memory_backend.h>
+#include <qudev_stats.h>
+
+
+class TestStats : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void histogramBuckets();
+    void histogramPercentiles();
+    void countsScans();
+    void countsEvents();
+    void measuresEventLatency();
+    void kernelChannelKeepsStageStats();
+    void periodicSignal();
+};
+
+void TestStats::histogramBuckets()
+{
+    // Every value lies within its bucket, and buckets are contiguous.
+    quint64 previousUpper = 0;
+    for (int i = 0; i < QudevLatencyHistogram::BucketCount - 1; ++i) {
+        const quint64 upper = QudevLatencyHistogram::bucketUpperBound(i);
+        QCOMPARE(QudevLatencyHistogram::bucketIndex(upper), i);
+        QCOMPARE(QudevLatencyHistogram::bucketIndex(upper + 1), i + 1);
+        if (i > 0) {
+            QVERIFY(upper > previousUpper);
+        }
+        previousUpper = upper;
+    }
+
+    QCOMPARE(QudevLatencyHistogram::bucketIndex(~quint64(0)), QudevLatencyHistogram::BucketCount - 1);
+}
+
+void TestStats::histogramPercentiles()
+{
+    QudevLatencyHistogram h;
+    QCOMPARE(h.percentileNs(50), quint64(0));
+
+    for (quint64 ns = 1; ns <= 1000; ++ns) {
+        ++h.buckets[QudevLatencyHistogram::bucketIndex(ns * 1000)];
+        ++h.count;
+        h.sumNs += ns * 1000;
+        h.maxNs = ns * 1000;
+    }
+
+    // Log-linear buckets over-estimate by at most a quarter.
+    for (double p : { 50.0, 90.0, 99.0 }) {
+        const double exact = p * 10 * 1000;
+        const double reported = double(h.percentileNs(p));
+        QVERIFY2(reported >= exact && reported <= exact * 1.25, qPrintable(QString::number(p)));
+    }
+    QCOMPARE(h.percentileNs(100), quint64(1000 * 1000));
+    QCOMPARE(h.meanNs(), 500.5 * 1000);
+}
+
+void TestStats::countsScans()
+{
+    Qudev qudev(std::make_unique<QudevMemoryBackend>(QudevMemoryBackend::Options{ 200 }));
+
+    QudevFilters filters;
+    filters.subsystem = QStringLiteral("block");
+    qudev.setFilters(filters);
+
+    const auto found = qudev.enumerate().size();
+    qudev.enumerate(16, [](QList<QudevDevice>) { return true; });
+
+    const QudevStats stats = qudev.stats();
+    QCOMPARE(stats.scans, quint64(2));
+    QVERIFY(stats.scanNs >= stats.lastScanNs);
+    QVERIFY(stats.devicesBuilt >= quint64(2 * found));
+}
+
+void TestStats::countsEvents()
+{
+    auto owned = std::make_unique<QudevMemoryBackend>(QudevMemoryBackend::Options{ 100 });
+    QudevMemoryBackend* backend = owned.get();
+    Qudev qudev(std::move(owned));
+
+    QudevFilters filters;
+    filters.actions = { QStringLiteral("change") };
+    qudev.setFilters(filters);
+
+    QSignalSpy spy(&qudev, &Qudev::deviceFound);
+    QVERIFY(qudev.startMonitoring());
+
+    for (const auto& d : backend->devices()) {
+        for (const auto& action : { QStringLiteral("add"), QStringLiteral("change") }) {
+            QudevDevice e = d;
+            e.action = action;
+            backend->inject(e);
+        }
+    }
+
+    QTRY_COMPARE(spy.size(), backend->devices().size());
+
+    const QudevStats stats = qudev.stats();
+    QCOMPARE(stats.eventsReceived, quint64(2 * backend->devices().size()));
+    QCOMPARE(stats.eventsFiltered, quint64(backend->devices().size()));
+    QCOMPARE(stats.eventsDelivered, quint64(backend->devices().size()));
+    QCOMPARE(stats.receiveLatency.count, stats.eventsReceived);
+    QCOMPARE(stats.buildLatency.count, stats.eventsReceived);
+    QCOMPARE(stats.filterLatency.count, stats.eventsReceived);
+    QCOMPARE(stats.emitLatency.count, stats.eventsDelivered);
+}
+
+void TestStats::measuresEventLatency()
+{
+    auto owned = std::make_unique<QudevMemoryBackend>(QudevMemoryBackend::Options{ 100 });
+    QudevMemoryBackend* backend = owned.get();
+    Qudev qudev(std::move(owned));
+
+    quint64 delivered = 0;
+    quint64 adds = 0;
+    bool consistent = true;
+    connect(&qudev, &Qudev::deviceFound, this, [&](const QudevDevice& d) {
+        const QudevEventTiming& t = qudev.eventTiming();
+        consistent = consistent && t.seqnum == d.seqnum && t.receivedNs != 0
+                     && t.deliveredNs >= t.receivedNs && t.initializedNs != 0;
+        ++delivered;
+        adds += d.action == QLatin1String("add") ? 1 : 0;
+    });
+    QVERIFY(qudev.startMonitoring());
+
+    backend->startEvents(0, 500);
+    QTRY_COMPARE(delivered, quint64(500));
+    QVERIFY(consistent);
+
+    const QudevStats stats = qudev.stats();
+    QCOMPARE(stats.receiveToDeliveryLatency.count, delivered);
+    // Only add events measure udevd; clock conversion may drop a sample.
+    QVERIFY(adds > 0);
+    QVERIFY(stats.udevdToReceiveLatency.count > 0);
+    QVERIFY(stats.udevdToReceiveLatency.count <= adds);
+    QCOMPARE(stats.kernelToUdevdLatency.count, quint64(0));
+}
+
+void TestStats::kernelChannelKeepsStageStats()
+{
+    auto owned = std::make_unique<QudevMemoryBackend>(QudevMemoryBackend::Options{ 50 });
+    QudevMemoryBackend* backend = owned.get();
+    Qudev qudev(std::move(owned));
+    qudev.setKernelLatencyTracking(true);
+
+    QSignalSpy spy(&qudev, &Qudev::deviceFound);
+    QVERIFY(qudev.startMonitoring());
+
+    for (const auto& d : backend->devices()) {
+        QudevDevice e = d;
+        e.action = QStringLiteral("change");
+        backend->inject(e);
+    }
+    QTRY_COMPARE(spy.size(), backend->devices().size());
+
+    // The kernel channel sees every event too, but only for its seqnum:
+    // nothing is built or timed for it.
+    const QudevStats stats = qudev.stats();
+    QCOMPARE(stats.eventsReceived, quint64(backend->devices().size()));
+    QCOMPARE(stats.receiveLatency.count, stats.eventsReceived);
+    QCOMPARE(stats.buildLatency.count, stats.eventsReceived);
+    QCOMPARE(stats.devicesBuilt, stats.eventsReceived);
+}
+
+void TestStats::periodicSignal()
+{
+    Qudev qudev(std::make_unique<QudevMemoryBackend>(QudevMemoryBackend::Options{ 10 }));
+    QCOMPARE(qudev.statsInterval(), 0);
+
+    QSignalSpy spy(&qudev, &Qudev::statsUpdated);
+    qudev.setStatsInterval(10);
+    QCOMPARE(qudev.statsInterval(), 10);
+    qudev.enumerate();
+
+    QTRY_VERIFY(spy.size() >= 2);
+    QCOMPARE(spy.last().first().value<QudevStats>().scans, quint64(1));
+
+    qudev.setStatsInterval(0);
+    QCOMPARE(qudev.statsInterval(), 0);
+}
+
+QTEST_GUILESS_MAIN(TestStats)
+
+#include "test_stats.moc"
@@ -0,0 +1,250 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include <QTest>
+
+#include <qudev_sysattr_policy.h>
+
+#include "qudev_sysattr_cache.h"
+
+
+namespace {
+
+constexpr qint64 Ms = 1000 * 1000;
+
+const QString UsbDevice = QStringLiteral("/sys/devices/pci0000:00/0000:00:14.0/usb1/1-1");
+const QString Disk = QStringLiteral("/sys/devices/pci0000:00/0000:00:17.0/ata1/host0/target0:0:0/0:0:0:0/block/sda");
+
+} // namespace
+
+class TestSysattrCache : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void hitAndMiss();
+    void ttlExpiry();
+    void replugInvalidates();
+    void addRemoveInvalidate();
+    void blockOverrides();
+    void identityIsPerSubsystem();
+    void disabledKeepsProtections();
+    void sweepDropsUnseen();
+    void incompleteSweepKeepsAll();
+    void capsDevices();
+};
+
+void TestSysattrCache::hitAndMiss()
+{
+    QudevSysattrCache cache;
+
+    auto* device = cache.device(UsbDevice, QStringLiteral("usb"), QStringLiteral("100"), QString());
+    QVERIFY(device);
+    QVERIFY(!cache.lookup(*device, QStringLiteral("idVendor"), 0));
+
+    cache.store(*device, QStringLiteral("idVendor"), QStringLiteral("1d6b"), 0);
+    const QString* value = cache.lookup(*device, QStringLiteral("idVendor"), 0);
+    QVERIFY(value);
+    QCOMPARE(*value, QStringLiteral("1d6b"));
+    QVERIFY(cache.bytes() > 0);
+
+    // Uncached attributes are never stored.
+    cache.store(*device, QStringLiteral("authorized"), QStringLiteral("1"), 0);
+    QVERIFY(!cache.lookup(*device, QStringLiteral("authorized"), 0));
+
+    // A later build of the same device instance sees the value.
+    device = cache.device(UsbDevice, QStringLiteral("usb"), QStringLiteral("100"), QStringLiteral("change"));
+    QVERIFY(device);
+    QVERIFY(cache.lookup(*device, QStringLiteral("idVendor"), 1000 * Ms));
+}
+
+void TestSysattrCache::ttlExpiry()
+{
+    QudevSysattrPolicy policy = QudevSysattrPolicy::defaults();
+    policy.attributes.insert(QStringLiteral("temp"), 50);
+
+    QudevSysattrCache cache;
+    cache.setPolicy(policy);
+
+    auto* device = cache.device(QStringLiteral("/sys/devices/virtual/thermal/thermal_zone0"),
+                                QStringLiteral("thermal"), QStringLiteral("1"), QString());
+    QVERIFY(device);
+    cache.store(*device, QStringLiteral("temp"), QStringLiteral("42000"), 10 * Ms);
+
+    QVERIFY(cache.lookup(*device, QStringLiteral("temp"), 10 * Ms));
+    QVERIFY(cache.lookup(*device, QStringLiteral("temp"), 60 * Ms));
+    QVERIFY(!cache.lookup(*device, QStringLiteral("temp"), 61 * Ms));
+
+    // Re-storing renews the value.
+    cache.store(*device, QStringLiteral("temp"), QStringLiteral("43000"), 61 * Ms);
+    const QString* value = cache.lookup(*device, QStringLiteral("temp"), 100 * Ms);
+    QVERIFY(value);
+    QCOMPARE(*value, QStringLiteral("43000"));
+}
+
+void TestSysattrCache::replugInvalidates()
+{
+    QudevSysattrCache cache;
+
+    auto* device = cache.device(UsbDevice, QStringLiteral("usb"), QStringLiteral("100"), QString());
+    cache.store(*device, QStringLiteral("serial"), QStringLiteral("A"), 0);
+    const quint64 bytes = cache.bytes();
+
+    // Replugged while nobody was monitoring: same syspath, new instance.
+    device = cache.device(UsbDevice, QStringLiteral("usb"), QStringLiteral("200"), QString());
+    QVERIFY(device);
+    QVERIFY(!cache.lookup(*device, QStringLiteral("serial"), 0));
+    QVERIFY(cache.bytes() < bytes);
+
+    cache.store(*device, QStringLiteral("serial"), QStringLiteral("B"), 0);
+    QCOMPARE(*cache.lookup(*device, QStringLiteral("serial"), 0), QStringLiteral("B"));
+    QCOMPARE(cache.bytes(), bytes);
+}
+
+void TestSysattrCache::addRemoveInvalidate()
+{
+    QudevSysattrCache cache;
+
+    auto* device = cache.device(UsbDevice, QStringLiteral("usb"), QStringLiteral("100"), QString());
+    cache.store(*device, QStringLiteral("serial"), QStringLiteral("A"), 0);
+
+    // remove drops the entry and yields nothing to fill.
+    QVERIFY(!cache.device(UsbDevice, QStringLiteral("usb"), QStringLiteral("100"), QStringLiteral("remove")));
+    QCOMPARE(cache.deviceCount(), 0);
+    QCOMPARE(cache.bytes(), quint64(0));
+
+    device = cache.device(UsbDevice, QStringLiteral("usb"), QStringLiteral("100"), QString());
+    cache.store(*device, QStringLiteral("serial"), QStringLiteral("A"), 0);
+
+    // add starts over even with an unchanged USEC_INITIALIZED.
+    device = cache.device(UsbDevice, QStringLiteral("usb"), QStringLiteral("100"), QStringLiteral("add"));
+    QVERIFY(device);
+    QVERIFY(!cache.lookup(*device, QStringLiteral("serial"), 0));
+}
+
+void TestSysattrCache::blockOverrides()
+{
+    QudevSysattrCache cache;
+
+    auto* disk = cache.device(Disk, QStringLiteral("block"), QStringLiteral("1"), QString());
+    cache.store(*disk, QStringLiteral("size"), QStringLiteral("1000"), 0);
+    cache.store(*disk, QStringLiteral("ro"), QStringLiteral("0"), 0);
+    cache.store(*disk, QStringLiteral("removable"), QStringLiteral("0"), 0);
+    QVERIFY(!cache.lookup(*disk, QStringLiteral("size"), 0));
+    QVERIFY(!cache.lookup(*disk, QStringLiteral("ro"), 0));
+    QVERIFY(cache.lookup(*disk, QStringLiteral("removable"), 0));
+
+    // size stays static elsewhere.
+    auto* other = cache.device(QStringLiteral("/sys/devices/virtual/mem/zero"), QStringLiteral("mem"),
+                               QStringLiteral("1"), QString());
+    cache.store(*other, QStringLiteral("size"), QStringLiteral("0"), 0);
+    QVERIFY(cache.lookup(*other, QStringLiteral("size"), 0));
+}
+
+void TestSysattrCache::identityIsPerSubsystem()
+{
+    const QudevSysattrPolicy policy = QudevSysattrPolicy::defaults();
+
+    QCOMPARE(policy.ttlMs(QStringLiteral("usb"), QStringLiteral("speed")), QudevSysattrPolicy::Static);
+    QCOMPARE(policy.ttlMs(QStringLiteral("usb"), QStringLiteral("version")), QudevSysattrPolicy::Static);
+    QCOMPARE(policy.ttlMs(QStringLiteral("pci"), QStringLiteral("vendor")), QudevSysattrPolicy::Static);
+    QCOMPARE(policy.ttlMs(QStringLiteral("net"), QStringLiteral("type")), QudevSysattrPolicy::Static);
+    QCOMPARE(policy.ttlMs(QStringLiteral("input"), QStringLiteral("name")), QudevSysattrPolicy::Static);
+    QCOMPARE(policy.ttlMs(QStringLiteral("tty"), QStringLiteral("dev")), QudevSysattrPolicy::Static);
+
+    // The same names mean other, changing things on other subsystems.
+    QCOMPARE(policy.ttlMs(QStringLiteral("net"), QStringLiteral("speed")), QudevSysattrPolicy::Uncached);
+    QCOMPARE(policy.ttlMs(QStringLiteral("power_supply"), QStringLiteral("type")), QudevSysattrPolicy::Uncached);
+    QCOMPARE(policy.ttlMs(QStringLiteral("hwmon"), QStringLiteral("name")), QudevSysattrPolicy::Uncached);
+    QCOMPARE(policy.ttlMs(QStringLiteral("drm"), QStringLiteral("device")), QudevSysattrPolicy::Uncached);
+}
+
+void TestSysattrCache::disabledKeepsProtections()
+{
+    QudevSysattrCache cache;
+    cache.setPolicy(QudevSysattrPolicy::disabled());
+
+    QVERIFY(!cache.device(UsbDevice, QStringLiteral("usb"), QStringLiteral("100"), QString()));
+    QVERIFY(cache.isSkipped(QStringLiteral("pci"), QStringLiteral("config")));
+    QVERIFY(cache.isSkipped(QStringLiteral("tpm"), QStringLiteral("pcrs")));
+    QVERIFY(!cache.isSkipped(QStringLiteral("usb"), QStringLiteral("config")));
+    QVERIFY(cache.policy().maxValueSize > 0);
+    QVERIFY(cache.policy().slowReadBudgetUs > 0);
+}
+
+void TestSysattrCache::sweepDropsUnseen()
+{
+    QudevSysattrCache cache;
+
+    auto* usb = cache.device(UsbDevice, QStringLiteral("usb"), QStringLiteral("100"), QString());
+    cache.store(*usb, QStringLiteral("serial"), QStringLiteral("A"), 0);
+    auto* disk = cache.device(Disk, QStringLiteral("block"), QStringLiteral("1"), QString());
+    cache.store(*disk, QStringLiteral("removable"), QStringLiteral("0"), 0);
+    QCOMPARE(cache.deviceCount(), 2);
+    const quint64 bytes = cache.bytes();
+
+    // The USB device went away without an event anybody saw.
+    cache.beginScan();
+    disk = cache.device(Disk, QStringLiteral("block"), QStringLiteral("1"), QString());
+    QVERIFY(cache.lookup(*disk, QStringLiteral("removable"), 0));
+    cache.endScan(true);
+
+    QCOMPARE(cache.deviceCount(), 1);
+    QVERIFY(cache.bytes() < bytes);
+    usb = cache.device(UsbDevice, QStringLiteral("usb"), QStringLiteral("100"), QString());
+    QVERIFY(!cache.lookup(*usb, QStringLiteral("serial"), 0));
+}
+
+void TestSysattrCache::incompleteSweepKeepsAll()
+{
+    QudevSysattrCache cache;
+
+    auto* usb = cache.device(UsbDevice, QStringLiteral("usb"), QStringLiteral("100"), QString());
+    cache.store(*usb, QStringLiteral("serial"), QStringLiteral("A"), 0);
+
+    cache.beginScan();
+    cache.device(Disk, QStringLiteral("block"), QStringLiteral("1"), QString());
+    cache.endScan(false);
+    QCOMPARE(cache.deviceCount(), 2);
+
+    // Without a running sweep, endScan() drops nothing.
+    cache.endScan(true);
+    QCOMPARE(cache.deviceCount(), 2);
+}
+
+void TestSysattrCache::capsDevices()
+{
+    QudevSysattrPolicy policy = QudevSysattrPolicy::defaults();
+    policy.maxDevices = 64;
+
+    QudevSysattrCache cache;
+    cache.setPolicy(policy);
+
+    const auto path = [](int i) { return QStringLiteral("/sys/devices/virtual/misc/dev%1").arg(i); };
+
+    for (int i = 0; i < 1000; ++i) {
+        auto* device = cache.device(path(i), QStringLiteral("misc"), QStringLiteral("1"), QString());
+        QVERIFY(device);
+        cache.store(*device, QStringLiteral("dev"), QString::number(i), 0);
+
+        // Device 0 stays in use and must survive.
+        device = cache.device(path(0), QStringLiteral("misc"), QStringLiteral("1"), QString());
+        QVERIFY(device);
+        QVERIFY(cache.deviceCount() <= policy.maxDevices);
+    }
+
+    auto* first = cache.device(path(0), QStringLiteral("misc"), QStringLiteral("1"), QString());
+    QVERIFY(cache.lookup(*first, QStringLiteral("dev"), 0));
+    auto* last = cache.device(path(999), QStringLiteral("misc"), QStringLiteral("1"), QString());
+    QVERIFY(cache.lookup(*last, QStringLiteral("dev"), 0));
+    auto* evicted = cache.device(path(1), QStringLiteral("misc"), QStringLiteral("1"), QString());
+    QVERIFY(!cache.lookup(*evicted, QStringLiteral("dev"), 0));
+}
+
+QTEST_GUILESS_MAIN(TestSysattrCache)
+#include "test_sysattr_cache.moc"
@@ -0,0 +1,171 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include <QTest>
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+
+#include <cerrno>
+#include <vector>
+
+#include "qudev_sysattr_reader.h"
+
+
+// The bulk readers must return exactly what one blocking read after
+// another returns, values and errors alike.
+class TestSysattrReader : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void sequential();
+
+    void matchesSequential_data();
+    void matchesSequential();
+
+    void batchedAlwaysReads();
+
+private:
+    using Requests = std::vector<QudevSysattrReader::Request>;
+
+    Requests requests(qsizetype count) const;
+    QByteArray path(const char* name) const;
+
+    QTemporaryDir dir_;
+    QList<QByteArray> names_;
+};
+
+void TestSysattrReader::initTestCase()
+{
+    QVERIFY(dir_.isValid());
+
+    const auto write = [this](const char* name, const QByteArray& content) {
+        QFile file(dir_.filePath(QString::fromLatin1(name)));
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        QCOMPARE(file.write(content), content.size());
+        names_ << name;
+    };
+
+    write("plain", "value\n");
+    write("crlf", "a\r\n\n");
+    write("nul", QByteArray("ab\0cd\n", 6));
+    write("empty", "");
+    write("page", QByteArray(QudevSysattrReader::MaxValueSize, 'x'));
+    write("oversized", QByteArray(QudevSysattrReader::MaxValueSize + 1, 'y'));
+    write("large", QByteArray(3 * QudevSysattrReader::MaxValueSize, 'z'));
+
+    QVERIFY(QFile::link(dir_.filePath(QStringLiteral("plain")), dir_.filePath(QStringLiteral("link"))));
+    QVERIFY(QDir(dir_.path()).mkdir(QStringLiteral("dir")));
+    names_ << "link" << "dir" << "missing";
+}
+
+QByteArray TestSysattrReader::path(const char* name) const
+{
+    return QFile::encodeName(dir_.filePath(QString::fromLatin1(name)));
+}
+
+TestSysattrReader::Requests TestSysattrReader::requests(qsizetype count) const
+{
+    Requests out(size_t(count));
+    for (qsizetype i = 0; i < count; ++i) {
+        out[size_t(i)].path = path(names_[i % names_.size()].constData());
+    }
+    return out;
+}
+
+void TestSysattrReader::sequential()
+{
+    auto reader = QudevSysattrReader::createSequential();
+    QVERIFY(reader);
+
+    Requests batch = requests(names_.size());
+    reader->read(batch.data(), qsizetype(batch.size()));
+
+    const auto check = [&](const char* name, const QByteArray& value, int error) {
+        const qsizetype i = names_.indexOf(name);
+        QVERIFY(i >= 0);
+        QCOMPARE(batch[size_t(i)].error, error);
+        QCOMPARE(batch[size_t(i)].value, value);
+    };
+
+    check("plain", "value", 0);
+    check("crlf", "a", 0);
+    check("nul", "ab", 0);
+    check("empty", "", 0);
+    check("page", QByteArray(QudevSysattrReader::MaxValueSize, 'x'), 0);
+    check("oversized", "", EFBIG);
+    check("large", "", EFBIG);
+    check("link", "", ELOOP);
+    check("dir", "", EISDIR);
+    check("missing", "", ENOENT);
+}
+
+void TestSysattrReader::matchesSequential_data()
+{
+    QTest::addColumn<QudevSysattrReadMode>("mode");
+    QTest::addColumn<int>("count");
+
+    // More than one io_uring submission and several thread pool chunks.
+    for (int count : { 10, 600 }) {
+        const QByteArray suffix = '/' + QByteArray::number(count);
+        QTest::newRow(("io_uring" + suffix).constData())    << QudevSysattrReadMode::IoUring << count;
+        QTest::newRow(("thread-pool" + suffix).constData()) << QudevSysattrReadMode::ThreadPool << count;
+        QTest::newRow(("batched" + suffix).constData())     << QudevSysattrReadMode::Batched << count;
+    }
+}
+
+void TestSysattrReader::matchesSequential()
+{
+    QFETCH(QudevSysattrReadMode, mode);
+    QFETCH(int, count);
+
+    auto reader = QudevSysattrReader::create(mode);
+    if (!reader) {
+        QSKIP("io_uring is not available");
+    }
+
+    Requests expected = requests(count);
+    QudevSysattrReader::createSequential()->read(expected.data(), qsizetype(expected.size()));
+
+    // Stale values and errors from an earlier read must be overwritten.
+    Requests actual = requests(count);
+    for (auto& request : actual) {
+        request.value = "stale";
+        request.error = EIO;
+        request.elapsedNs = 0;
+    }
+    reader->read(actual.data(), qsizetype(actual.size()));
+
+    for (size_t i = 0; i < expected.size(); ++i) {
+        const QByteArray where = reader->name() + QByteArray(": ") + actual[i].path;
+        QVERIFY2(actual[i].error == expected[i].error, where.constData());
+        QVERIFY2(actual[i].value == expected[i].value, where.constData());
+        // Slow-attribute learning needs a time for every read, failed or not.
+        QVERIFY2(actual[i].elapsedNs > 0, where.constData());
+    }
+}
+
+void TestSysattrReader::batchedAlwaysReads()
+{
+    // Without io_uring, Batched falls back to the thread pool.
+    auto batched = QudevSysattrReader::create(QudevSysattrReadMode::Batched);
+    QVERIFY(batched);
+    const QByteArray name = batched->name();
+    QVERIFY(name == "io_uring" || name == "thread-pool");
+    if (!QudevSysattrReader::create(QudevSysattrReadMode::IoUring)) {
+        QCOMPARE(name, QByteArray("thread-pool"));
+    }
+
+    QVERIFY(!QudevSysattrReader::create(QudevSysattrReadMode::Libudev));
+}
+
+QTEST_GUILESS_MAIN(TestSysattrReader)
+#include "test_sysattr_reader.moc"
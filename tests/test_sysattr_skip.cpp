@@ -0,0 +1,245 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include <QTest>
+#include <QFileInfo>
+#include <QHash>
+
+#include <libudev.h>
+
+#include <qudev_device.h>
+
+#include "qudev_context.h"
+#include "qudev_stats_collector.h"
+#include "qudev_sysattr_cache.h"
+#include "qudev_sysattr_reader.h"
+
+
+namespace {
+
+// Present on every Linux system; its sysattrs are "dev" and "uevent".
+constexpr const char* NullDevice = "/sys/devices/virtual/mem/null";
+
+/// Bulk reader answering from a table instead of sysfs.
+class FakeReader final : public QudevSysattrReader
+{
+public:
+    void read(Request* requests, qsizetype count) override
+    {
+        for (qsizetype i = 0; i < count; ++i) {
+            Request& r = requests[i];
+            const QByteArray attribute = r.path.mid(r.path.lastIndexOf('/') + 1);
+            reads << attribute;
+
+            const auto it = results.constFind(attribute);
+            r.value = it != results.cend() ? it->value : QByteArray("1:3");
+            r.error = it != results.cend() ? it->error : 0;
+            r.elapsedNs = it != results.cend() ? it->elapsedNs : 0;
+        }
+    }
+
+    const char* name() const noexcept override { return "fake"; }
+
+    QHash<QByteArray, Request> results;
+    QList<QByteArray> reads;
+};
+
+QudevSysattrReader::Request result(const QByteArray& value, int error = 0, quint64 elapsedNs = 0)
+{
+    QudevSysattrReader::Request r;
+    r.value = value;
+    r.error = error;
+    r.elapsedNs = elapsedNs;
+    return r;
+}
+
+} // namespace
+
+// Attributes skipped while building devices, on the one-at-a-time libudev
+// path and on the batched path, and how each skip is counted.
+class TestSysattrSkip : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void init();
+
+    void denied_data();
+    void denied();
+
+    void pageSizedIsNotOversized();
+    void oversizedInBatch();
+
+    void slowIsLearned_data();
+    void slowIsLearned();
+
+private:
+    QudevDevice build();
+
+    std::optional<QudevContext> ctx_;
+    QudevSysattrCache cache_;
+    QudevStatsCollector stats_;
+    FakeReader reader_;
+};
+
+void TestSysattrSkip::initTestCase()
+{
+    if (!QFileInfo::exists(QString::fromLatin1(NullDevice))) {
+        QSKIP("no sysfs");
+    }
+    ctx_ = QudevContext::create();
+    QVERIFY(ctx_);
+    ctx_->setStats(&stats_);
+    ctx_->setSysattrCache(&cache_);
+    cache_.setStats(&stats_);
+}
+
+void TestSysattrSkip::init()
+{
+    cache_.setPolicy(QudevSysattrPolicy::defaults());
+    ctx_->setSysattrReader(nullptr);
+    reader_.results.clear();
+    reader_.reads.clear();
+
+    stats_.sysattrReads = 0;
+    stats_.sysattrsDenied = 0;
+    stats_.sysattrsOversized = 0;
+    stats_.sysattrsSlow = 0;
+    stats_.slowSysattrs.clear();
+}
+
+QudevDevice TestSysattrSkip::build()
+{
+    udev_device* d = udev_device_new_from_syspath(ctx_->get(), NullDevice);
+    if (!d) {
+        return {};
+    }
+    QudevDevice device = buildDevice(*ctx_, d);
+    udev_device_unref(d);
+    return device;
+}
+
+void TestSysattrSkip::denied_data()
+{
+    QTest::addColumn<bool>("batched");
+    QTest::addColumn<bool>("cacheEnabled");
+
+    QTest::newRow("libudev")          << false << true;
+    QTest::newRow("libudev/disabled") << false << false;
+    QTest::newRow("batched")          << true  << true;
+    QTest::newRow("batched/disabled") << true  << false;
+}
+
+void TestSysattrSkip::denied()
+{
+    QFETCH(bool, batched);
+    QFETCH(bool, cacheEnabled);
+
+    QudevSysattrPolicy policy = cacheEnabled ? QudevSysattrPolicy::defaults() : QudevSysattrPolicy::disabled();
+    policy.deniedSubsystemAttributes[QStringLiteral("mem")] << QStringLiteral("uevent");
+    cache_.setPolicy(policy);
+    if (batched) {
+        ctx_->setSysattrReader(&reader_);
+    }
+
+    const QudevDevice device = build();
+    QCOMPARE(device.subsystem, QStringLiteral("mem"));
+    QVERIFY(device.sysattrs.contains(QStringLiteral("dev")));
+    QVERIFY(!device.sysattrs.contains(QStringLiteral("uevent")));
+    QCOMPARE(stats_.sysattrsDenied.load(), quint64(1));
+    QVERIFY(!reader_.reads.contains("uevent"));
+
+    // Denied on another subsystem only: read as usual.
+    policy.deniedSubsystemAttributes.clear();
+    policy.deniedSubsystemAttributes[QStringLiteral("pci")] << QStringLiteral("uevent");
+    cache_.setPolicy(policy);
+    QVERIFY(build().sysattrs.contains(QStringLiteral("uevent")));
+    QCOMPARE(stats_.sysattrsDenied.load(), quint64(1));
+}
+
+void TestSysattrSkip::pageSizedIsNotOversized()
+{
+    // Text attributes report one page however short they are.
+    QudevSysattrPolicy policy = QudevSysattrPolicy::disabled();
+    policy.maxValueSize = 1;
+    cache_.setPolicy(policy);
+
+    const QudevDevice device = build();
+    QVERIFY(!device.sysattrs.value(QStringLiteral("dev")).isEmpty());
+    QCOMPARE(stats_.sysattrsOversized.load(), quint64(0));
+}
+
+void TestSysattrSkip::oversizedInBatch()
+{
+    QudevSysattrPolicy policy = QudevSysattrPolicy::disabled();
+    policy.maxValueSize = 8;
+    cache_.setPolicy(policy);
+    ctx_->setSysattrReader(&reader_);
+
+    // Cut off by the reader, and longer than the policy allows.
+    reader_.results.insert("uevent", result(QByteArray(), EFBIG));
+    reader_.results.insert("dev", result(QByteArray(16, 'x')));
+
+    QudevDevice device = build();
+    QVERIFY(!device.sysattrs.contains(QStringLiteral("uevent")));
+    QVERIFY(!device.sysattrs.contains(QStringLiteral("dev")));
+    QCOMPARE(stats_.sysattrsOversized.load(), quint64(2));
+
+    // Within the limit.
+    reader_.results.insert("dev", result("1:3"));
+    device = build();
+    QCOMPARE(device.sysattrs.value(QStringLiteral("dev")), QStringLiteral("1:3"));
+    QCOMPARE(stats_.sysattrsOversized.load(), quint64(3));
+}
+
+void TestSysattrSkip::slowIsLearned_data()
+{
+    QTest::addColumn<bool>("cacheEnabled");
+
+    QTest::newRow("defaults") << true;
+    QTest::newRow("disabled") << false;
+}
+
+void TestSysattrSkip::slowIsLearned()
+{
+    QFETCH(bool, cacheEnabled);
+
+    QudevSysattrPolicy policy = cacheEnabled ? QudevSysattrPolicy::defaults() : QudevSysattrPolicy::disabled();
+    policy.slowReadBudgetUs = 1000;
+    policy.slowReadStrikes = 2;
+    cache_.setPolicy(policy);
+    ctx_->setSysattrReader(&reader_);
+
+    // uevent is never cached, so every build reads it again.
+    reader_.results.insert("uevent", result("MAJOR=1", 0, 5 * 1000 * 1000));
+
+    QVERIFY(build().sysattrs.contains(QStringLiteral("uevent")));
+    QCOMPARE(stats_.sysattrsSlow.load(), quint64(0));
+    QVERIFY(build().sysattrs.contains(QStringLiteral("uevent")));
+    QCOMPARE(stats_.slowSysattrs, QStringList{ QStringLiteral("mem/uevent") });
+
+    // Learned after two strikes: no longer read, only counted.
+    reader_.reads.clear();
+    const QudevDevice device = build();
+    QVERIFY(!device.sysattrs.contains(QStringLiteral("uevent")));
+    QVERIFY(device.sysattrs.contains(QStringLiteral("dev")));
+    QVERIFY(!reader_.reads.contains("uevent"));
+    QCOMPARE(stats_.sysattrsSlow.load(), quint64(1));
+    QCOMPARE(stats_.sysattrsDenied.load(), quint64(0));
+
+    // Only for this subsystem's devices.
+    QVERIFY(!cache_.isSkipped(QStringLiteral("tty"), QStringLiteral("uevent")));
+
+    // A new policy forgets what was learned.
+    cache_.setPolicy(policy);
+    QVERIFY(build().sysattrs.contains(QStringLiteral("uevent")));
+}
+
+QTEST_GUILESS_MAIN(TestSysattrSkip)
+#include "test_sysattr_skip.moc"
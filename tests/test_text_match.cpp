@@ -0,0 +1,155 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include <QTest>
+
+#include <qudev_text_match.h>
+
+
+Q_DECLARE_METATYPE(QudevTextMatchPath)
+
+// Every search implementation, forced in turn, against Qt's own
+// case-insensitive search. Haystack lengths up to 70 code units put
+// matches before, across and after the 8 (SSE2) and 16 (AVX2) code unit
+// blocks and into the scalar tail.
+class TestTextMatch : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void emptyInputs_data() { paths(); }
+    void emptyInputs();
+    void everyPosition_data() { paths(); }
+    void everyPosition();
+    void nearMisses_data() { paths(); }
+    void nearMisses();
+    void nonAscii_data() { paths(); }
+    void nonAscii();
+
+private:
+    void paths();
+    void usePath();
+
+    /// Both entry points agree with each other and with @p expected.
+    static bool check(const QString& haystack, const QString& needle, bool expected);
+};
+
+void TestTextMatch::paths()
+{
+    QTest::addColumn<QudevTextMatchPath>("path");
+    QTest::newRow("scalar") << QudevTextMatchPath::Scalar;
+    QTest::newRow("sse2") << QudevTextMatchPath::Sse2;
+    QTest::newRow("avx2") << QudevTextMatchPath::Avx2;
+}
+
+void TestTextMatch::init()
+{
+    QVERIFY(qudevSetTextMatchPath(QudevTextMatchPath::Auto));
+}
+
+void TestTextMatch::cleanup()
+{
+    qudevSetTextMatchPath(QudevTextMatchPath::Auto);
+}
+
+void TestTextMatch::usePath()
+{
+    QFETCH(QudevTextMatchPath, path);
+    if (!qudevSetTextMatchPath(path)) {
+        QSKIP("Implementation not available on this build or CPU");
+    }
+    QCOMPARE(qudevTextMatchPath(), path);
+}
+
+bool TestTextMatch::check(const QString& haystack, const QString& needle, bool expected)
+{
+    const bool matcher = QudevTextMatcher(needle).matches(haystack);
+    const bool oneShot = qudevContainsCaseInsensitive(haystack, needle);
+    if (matcher != expected || oneShot != expected) {
+        qWarning().nospace() << "haystack " << haystack << " needle " << needle << ": matcher " << matcher
+                             << ", one-shot " << oneShot << ", expected " << expected;
+        return false;
+    }
+    return true;
+}
+
+void TestTextMatch::emptyInputs()
+{
+    usePath();
+
+    QVERIFY(check(QString(), QString(), true));
+    QVERIFY(check(QStringLiteral("sda"), QString(), true));
+    QVERIFY(check(QString(), QStringLiteral("s"), false));
+    QVERIFY(check(QStringLiteral("sd"), QStringLiteral("sda"), false));
+    QVERIFY(QudevTextMatcher().matches(QStringLiteral("anything")));
+}
+
+void TestTextMatch::everyPosition()
+{
+    usePath();
+
+    // Needles around the block widths; the filler never occurs in them.
+    const QString needles[] = {
+        QStringLiteral("a"), QStringLiteral("Q"), QStringLiteral("b9"), QStringLiteral("Id_"),
+        QStringLiteral("Usb1-1:"), QStringLiteral("DEVNAME="), QStringLiteral("id_vendor"),
+        QStringLiteral("0000:00:14.0/usb"), QStringLiteral("id_model_enc=Kin"),
+    };
+    for (const QString& needle : needles) {
+        // Opposite case in the haystack.
+        QString placed = needle;
+        for (QChar& c : placed) {
+            c = c.isUpper() ? c.toLower() : c.toUpper();
+        }
+
+        for (int length = needle.size(); length <= 70; ++length) {
+            const QString filler(length, QLatin1Char('x'));
+            QVERIFY(check(filler, needle, false));
+            for (int at = 0; at + needle.size() <= length; ++at) {
+                QString haystack = filler;
+                haystack.replace(at, needle.size(), placed);
+                QVERIFY2(check(haystack, needle, true), qPrintable(QStringLiteral("at %1 of %2").arg(at).arg(length)));
+            }
+        }
+    }
+}
+
+void TestTextMatch::nearMisses()
+{
+    usePath();
+
+    // First and last code units match in every lane, the middle never.
+    QVERIFY(check(QString(64, QLatin1Char('a')), QStringLiteral("aba"), false));
+    QVERIFY(check(QStringLiteral("aXa").repeated(24), QStringLiteral("aba"), false));
+    QVERIFY(check(QStringLiteral("aXa").repeated(24) + QStringLiteral("ABA"), QStringLiteral("aba"), true));
+
+    // Only ASCII letters fold: '@' and '[' border 'A' and 'Z'.
+    QVERIFY(check(QString(40, QLatin1Char('@')), QStringLiteral("`"), false));
+    QVERIFY(check(QString(40, QLatin1Char('[')), QStringLiteral("{"), false));
+    QVERIFY(check(QString(40, QLatin1Char('z')) + QLatin1Char('Z'), QStringLiteral("zz"), true));
+}
+
+void TestTextMatch::nonAscii()
+{
+    usePath();
+
+    // Non-ASCII haystacks or needles take Qt's Unicode-aware search.
+    const QString umlauts = QStringLiteral("Hersteller: Ärger Über GmbH");
+    QVERIFY(check(umlauts, QStringLiteral("über"), true));
+    QVERIFY(check(umlauts, QStringLiteral("gmbh"), true));
+    QVERIFY(check(umlauts, QStringLiteral("ärger"), true));
+    QVERIFY(check(umlauts, QStringLiteral("ö"), false));
+    QVERIFY(check(QString(40, QLatin1Char('x')) + QStringLiteral("é"), QStringLiteral("É"), true));
+    QVERIFY(check(QString(40, QLatin1Char('x')), QStringLiteral("é"), false));
+}
+
+QTEST_GUILESS_MAIN(TestTextMatch)
+
+#include "test_text_match.moc"
@@ -0,0 +1,227 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include <QTest>
+
+#include <qudev_device.h>
+#include <qudev_filters.h>
+#include <qudev_memory_backend.h>
+#include <qudev_topology.h>
+
+
+namespace {
+
+const QString Pci   = QStringLiteral("/sys/devices/pci0000:80");
+const QString Xhci  = Pci + QStringLiteral("/0000:80:14.0");
+const QString Hub   = Xhci + QStringLiteral("/usb1");
+const QString Stick = Hub + QStringLiteral("/1-1");
+const QString Iface = Stick + QStringLiteral("/1-1:1.0");
+const QString Scsi  = Iface + QStringLiteral("/host0/target0:0:0/0:0:0:0");
+const QString Disk  = Scsi + QStringLiteral("/block/sda");
+const QString Part  = Disk + QStringLiteral("/sda1");
+const QString Nic   = Pci + QStringLiteral("/0000:80:1f.6");
+const QString Eth   = Nic + QStringLiteral("/net/eth0");
+const QString Lpc   = Pci + QStringLiteral("/0000:80:1f.0");
+
+QudevDevice device(const QString& syspath, const QString& subsystem)
+{
+    QudevDevice d;
+    d.syspath = syspath;
+    d.subsystem = subsystem;
+    d.sysname = syspath.section(QLatin1Char('/'), -1);
+    return d;
+}
+
+QStringList syspaths(const QList<QudevSharedDevice>& devices)
+{
+    QStringList out;
+    for (const auto& d : devices) {
+        out << d->syspath;
+    }
+    return out;
+}
+
+} // namespace
+
+class TestTopology : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+
+    void ancestorsAndChildren();
+    void subtreeWithFilters();
+    void prefixMatchesStartsWith_data();
+    void prefixMatchesStartsWith();
+    void appliesEvents();
+
+private:
+    QList<QudevDevice> devices_;
+    QudevTopology topology_;
+};
+
+void TestTopology::init()
+{
+    // Host and target directories are not devices. The generated devices
+    // live under another PCI root.
+    devices_ = {
+        device(Pci, QStringLiteral("pci")),
+        device(Xhci, QStringLiteral("pci")),
+        device(Hub, QStringLiteral("usb")),
+        device(Stick, QStringLiteral("usb")),
+        device(Iface, QStringLiteral("usb")),
+        device(Scsi, QStringLiteral("scsi")),
+        device(Disk, QStringLiteral("block")),
+        device(Part, QStringLiteral("block")),
+        device(Nic, QStringLiteral("pci")),
+        device(Eth, QStringLiteral("net")),
+        device(Lpc, QStringLiteral("pci")),
+    };
+    devices_ << QudevMemoryBackend::generateDevices(300);
+
+    topology_.clear();
+    for (const auto& d : devices_) {
+        QVERIFY(topology_.insert(QudevSharedDevice(d)));
+    }
+    QCOMPARE(topology_.size(), devices_.size());
+}
+
+void TestTopology::ancestorsAndChildren()
+{
+    QCOMPARE(syspaths(topology_.ancestors(Part)),
+             (QStringList{ Disk, Scsi, Iface, Stick, Hub, Xhci, Pci }));
+    QVERIFY(topology_.ancestors(Pci).isEmpty());
+
+    // Which PCI device backs eth0, through the "net" directory.
+    QCOMPARE(topology_.parent(Eth)->syspath, Nic);
+    QCOMPARE(topology_.parent(Scsi)->syspath, Iface);
+    QVERIFY(topology_.parent(Pci).isNull());
+
+    QCOMPARE(syspaths(topology_.children(Hub)), QStringList{ Stick });
+    QCOMPARE(syspaths(topology_.children(Iface)), QStringList{ Scsi });
+    QCOMPARE(syspaths(topology_.children(Pci)), (QStringList{ Xhci, Nic, Lpc }));
+
+    QCOMPARE(syspaths(topology_.descendants(Stick)), (QStringList{ Iface, Scsi, Disk, Part }));
+    QVERIFY(topology_.descendants(Part).isEmpty());
+    QVERIFY(topology_.descendants(QStringLiteral("/sys/nothing")).isEmpty());
+
+    QCOMPARE(topology_.device(Disk)->subsystem, QStringLiteral("block"));
+    QVERIFY(topology_.device(Scsi + QStringLiteral("/block")).isNull());
+    QVERIFY(!topology_.contains(Iface + QStringLiteral("/host0")));
+}
+
+void TestTopology::subtreeWithFilters()
+{
+    // All block devices under the USB hub.
+    QudevFilters filters;
+    filters.subsystem = QStringLiteral("block");
+    QCOMPARE(syspaths(topology_.subtree(Hub, filters)), (QStringList{ Disk, Part }));
+
+    // As on the enumeration path: globs, actions ignored.
+    filters.subsystem = QStringLiteral("bl*");
+    filters.actions << QStringLiteral("remove");
+    QCOMPARE(syspaths(topology_.subtree(Hub, filters)), (QStringList{ Disk, Part }));
+
+    QCOMPARE(topology_.subtree(Pci, {}).size(), qsizetype(11));
+    QCOMPARE(syspaths(topology_.subtree(Part, {})), QStringList{ Part });
+}
+
+void TestTopology::prefixMatchesStartsWith_data()
+{
+    QTest::addColumn<QString>("prefix");
+
+    QTest::newRow("empty") << QString();
+    QTest::newRow("device") << Hub;
+    QTest::newRow("device-slash") << Hub + QLatin1Char('/');
+    QTest::newRow("partial-name") << Pci + QStringLiteral("/0000:80:1f");
+    QTest::newRow("path-only") << Scsi + QStringLiteral("/block");
+    QTest::newRow("partial-root") << QStringLiteral("/sys/dev");
+    QTest::newRow("root") << QStringLiteral("/");
+    QTest::newRow("missing-dir") << QStringLiteral("/sys/class/net/eth");
+    QTest::newRow("generated") << QStringLiteral("/sys/devices/pci0000:00/0000:00:0");
+}
+
+void TestTopology::prefixMatchesStartsWith()
+{
+    QFETCH(QString, prefix);
+
+    QStringList expected;
+    for (const auto& d : devices_) {
+        if (d.syspath.startsWith(prefix)) {
+            expected << d.syspath;
+        }
+    }
+
+    QStringList actual;
+    topology_.visitPrefix(prefix, [&](const QudevSharedDevice& d) {
+        actual << d->syspath;
+        return true;
+    });
+
+    expected.sort();
+    actual.sort();
+    QCOMPARE(actual, expected);
+
+    QudevFilters filters;
+    filters.syspathPrefix = prefix;
+    filters.subsystem = QStringLiteral("block");
+    for (const auto& d : topology_.select(filters)) {
+        QVERIFY(d->syspath.startsWith(prefix));
+        QCOMPARE(d->subsystem, filters.subsystem);
+    }
+}
+
+void TestTopology::appliesEvents()
+{
+    // Removing an inner device keeps the ones below it reachable.
+    QudevDevice e = device(Hub, QStringLiteral("usb"));
+    e.action = QStringLiteral("remove");
+    topology_.apply(QudevSharedDevice(e));
+    QVERIFY(!topology_.contains(Hub));
+    QCOMPARE(topology_.parent(Stick)->syspath, Xhci);
+    QCOMPARE(syspaths(topology_.children(Xhci)), QStringList{ Stick });
+    QCOMPARE(topology_.size(), devices_.size() - 1);
+
+    // Re-added devices slot back in.
+    e.action = QStringLiteral("add");
+    topology_.apply(QudevSharedDevice(e));
+    QCOMPARE(topology_.parent(Stick)->syspath, Hub);
+
+    // Unplugging the stick, leaf first as the kernel does, prunes the branch.
+    for (const QString& syspath : { Part, Disk, Scsi, Iface, Stick }) {
+        QudevDevice removed = device(syspath, QString());
+        removed.action = QStringLiteral("remove");
+        topology_.apply(QudevSharedDevice(std::move(removed)));
+    }
+    QVERIFY(topology_.descendants(Hub).isEmpty());
+    QVERIFY(topology_.children(Hub).isEmpty());
+    QCOMPARE(topology_.size(), devices_.size() - 5);
+
+    // A renamed interface moves.
+    QudevDevice renamed = device(Nic + QStringLiteral("/net/enp0s31f6"), QStringLiteral("net"));
+    renamed.action = QStringLiteral("move");
+    renamed.properties.insert(QStringLiteral("DEVPATH_OLD"), Eth.mid(4));
+    topology_.apply(QudevSharedDevice(renamed));
+    QVERIFY(!topology_.contains(Eth));
+    QCOMPARE(topology_.parent(renamed.syspath)->syspath, Nic);
+    QCOMPARE(syspaths(topology_.children(Nic)), QStringList{ renamed.syspath });
+
+    QVERIFY(!topology_.remove(Eth));
+    QVERIFY(!topology_.insert(QudevDevice()));
+
+    topology_.clear();
+    QCOMPARE(topology_.size(), qsizetype(0));
+    QVERIFY(topology_.devices().isEmpty());
+    QVERIFY(topology_.insert(device(Eth, QStringLiteral("net"))));
+    QVERIFY(topology_.parent(Eth).isNull());
+}
+
+QTEST_GUILESS_MAIN(TestTopology)
+
+#include "test_topology.moc"
@@ -0,0 +1,88 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include <QTest>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSet>
+#include <QTemporaryDir>
+
+#include <qudev.h>
+#include <qudev_memory_backend.h>
+#include <qudev_trace.h>
+
+
+class TestTrace : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void writesChromeTrace();
+    void disabledRecordsNothing();
+};
+
+void TestTrace::writesChromeTrace()
+{
+#ifdef QUDEV_NO_TRACING
+    QSKIP("Tracing is compiled out");
+#endif
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("trace.json"));
+
+    auto owned = std::make_unique<QudevMemoryBackend>(QudevMemoryBackend::Options{ 50 });
+    QudevMemoryBackend* backend = owned.get();
+    Qudev qudev(std::move(owned));
+
+    int delivered = 0;
+    connect(&qudev, &Qudev::deviceFound, this, [&delivered]() { ++delivered; });
+
+    QVERIFY(QudevTrace::start(path));
+    QVERIFY(QudevTrace::isEnabled());
+
+    QCOMPARE(qudev.enumerate().size(), 50);
+    QVERIFY(qudev.startMonitoring());
+    backend->inject(backend->devices().first());
+    QTRY_COMPARE(delivered, 1);
+
+    QVERIFY(QudevTrace::stop());
+    QVERIFY(!QudevTrace::isEnabled());
+
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QJsonParseError error;
+    const QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &error);
+    QCOMPARE(error.error, QJsonParseError::NoError);
+
+    QSet<QString> names;
+    for (const auto& v : doc.object().value(QStringLiteral("traceEvents")).toArray()) {
+        const QJsonObject e = v.toObject();
+        QCOMPARE(e.value(QStringLiteral("ph")).toString(), QStringLiteral("X"));
+        QVERIFY(e.value(QStringLiteral("dur")).toDouble() >= 0);
+        names.insert(e.value(QStringLiteral("name")).toString());
+    }
+
+    for (const char* expected : { "scan", "monitor.receive", "decodeEvent", "filter" }) {
+        QVERIFY2(names.contains(QLatin1String(expected)), expected);
+    }
+}
+
+void TestTrace::disabledRecordsNothing()
+{
+    QVERIFY(!QudevTrace::isEnabled());
+    QVERIFY(!QudevTrace::stop());
+
+    QudevTraceSpan span("test", "span");
+    QVERIFY(!span.active());
+}
+
+QTEST_GUILESS_MAIN(TestTrace)
+
+#include "test_trace.moc"
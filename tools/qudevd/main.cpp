@@ -0,0 +1,119 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2025 Georgi Georgiev, Samsa Ltd. <georgi@samsa.io>
+//
+// qudev - Qt wrapper around libudev
+//
+// This file is part of the qudev project.
+// See the LICENSE file in the project root for full license text.
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QSocketNotifier>
+
+#include <qudev.h>
+#include <qudev_broker.h>
+#include <qudev_broker_backend.h>
+#include <qudev_journal.h>
+
+#include <csignal>
+#include <sys/signalfd.h>
+#include <unistd.h>
+
+
+// qudevd: one enumeration and one monitor shared by every local qudev
+// client started with Qudev::Source::Broker.
+int main(int argc, char** argv)
+{
+    // Blocked before any thread starts, so only the signalfd sees them.
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setOrganizationName("samsa");
+    QCoreApplication::setApplicationName("qudevd");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Serves udev devices and events to local qudev clients.");
+    parser.addHelpOption();
+    const QCommandLineOption socketOption({ "s", "socket" }, "Listen on <path>.", "path",
+                                          QudevBrokerBackend::defaultSocketPath());
+    const QCommandLineOption modeOption("socket-mode",
+                                        "Permission bits of the socket, in octal.", "mode", "0660");
+    const QCommandLineOption groupOption("group",
+                                         "Give the socket to <group>, by name or number.", "group");
+    const QCommandLineOption pendingOption("max-pending-mib",
+                                           "Disconnect clients with more than <MiB> unsent.", "MiB", "64");
+    const QCommandLineOption readModeOption("batched-sysattrs",
+                                            "Read sysattrs in bulk (io_uring or thread pool).");
+    const QCommandLineOption journalOption("journal-mib",
+                                           "Keep <MiB> of recent events for resuming clients.", "MiB", "4");
+    const QCommandLineOption journalFileOption("journal-file",
+                                               "Keep the event journal in <path> across restarts.", "path");
+    const QCommandLineOption sharedOption("shared-snapshot",
+                                          "Also publish the devices in shared memory.");
+    parser.addOption(socketOption);
+    parser.addOption(modeOption);
+    parser.addOption(groupOption);
+    parser.addOption(pendingOption);
+    parser.addOption(readModeOption);
+    parser.addOption(journalOption);
+    parser.addOption(journalFileOption);
+    parser.addOption(sharedOption);
+    parser.process(app);
+
+    const QString path = parser.value(socketOption);
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    QudevBroker broker;
+
+    // Who may connect: the socket's mode and group, checked again per client.
+    bool modeOk = false;
+    const uint mode = parser.value(modeOption).toUInt(&modeOk, 8);
+    if (!modeOk || mode > 0777) {
+        qCritical() << "[qudevd] Invalid socket mode:" << parser.value(modeOption);
+        return 1;
+    }
+    broker.setSocketMode(mode);
+    broker.setSocketGroup(parser.value(groupOption));
+
+    broker.setMaxPendingBytes(parser.value(pendingOption).toLongLong() * 1024 * 1024);
+    if (parser.isSet(readModeOption)) {
+        broker.qudev().setSysattrReadMode(QudevSysattrReadMode::Batched);
+    }
+
+    broker.setJournalCapacity(parser.value(journalOption).toLongLong() * 1024 * 1024);
+    if (parser.isSet(journalFileOption) && !broker.journal().openFile(parser.value(journalFileOption))) {
+        qWarning() << "[qudevd] Keeping the journal in memory:" << broker.journal().errorString();
+    }
+
+    if (parser.isSet(sharedOption) && !broker.setSharedSnapshotEnabled(true)) {
+        qCritical() << "[qudevd]" << broker.errorString();
+        return 1;
+    }
+
+    if (!broker.listen(path)) {
+        qCritical() << "[qudevd]" << broker.errorString();
+        return 1;
+    }
+    qInfo() << "[qudevd] Serving" << broker.deviceCount() << "devices on" << path;
+
+    const int sfd = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+    QSocketNotifier signalNotifier(sfd, QSocketNotifier::Read);
+    QObject::connect(&signalNotifier, &QSocketNotifier::activated, &app, [sfd] {
+        signalfd_siginfo info;
+        while (::read(sfd, &info, sizeof(info)) > 0) {
+        }
+        QCoreApplication::quit();
+    });
+
+    const int rc = app.exec();
+    broker.close();
+    ::close(sfd);
+    return rc;
+}